@@ -47,6 +47,9 @@
 #define HWCAP2_MTE (1 << 18)
 #define HWCAP2_BTI (1 << 17)
 #endif
+#ifndef HWCAP_CRC32
+#define HWCAP_CRC32 (1 << 7)
+#endif
 
 struct ProcCpuInfo {
   std::string brand;
@@ -363,6 +366,7 @@ void CPU::Initialize(bool require_branding) {
   unsigned long hwcap2 = getauxval(AT_HWCAP2);
   has_mte_ = hwcap2 & HWCAP2_MTE;
   has_bti_ = hwcap2 & HWCAP2_BTI;
+  has_crc32_ = getauxval(AT_HWCAP) & HWCAP_CRC32;
 #endif
 
 #elif BUILDFLAG(IS_WIN)
@@ -370,6 +374,12 @@ void CPU::Initialize(bool require_branding) {
   // user-space.
   has_non_stop_time_stamp_counter_ = true;
 #endif
+
+  // The CRC32 instructions may be part of the baseline of the build, e.g. on
+  // Apple Silicon, in which case there is nothing to detect.
+#if defined(__ARM_FEATURE_CRC32)
+  has_crc32_ = true;
+#endif
 #endif
 }
 
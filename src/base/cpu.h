@@ -102,6 +102,14 @@ class BASE_EXPORT CPU final {
   constexpr bool has_bti() const { return false; }
 #endif
 
+  // Armv8 CRC32 instructions, optional in Armv8.0-A and mandatory since
+  // Armv8.1-A.
+#if defined(ARCH_CPU_ARM_FAMILY)
+  bool has_crc32() const { return has_crc32_; }
+#else
+  constexpr bool has_crc32() const { return false; }
+#endif
+
 #if defined(ARCH_CPU_X86_FAMILY)
   IntelMicroArchitecture GetIntelMicroArchitecture() const;
 #endif
@@ -192,6 +200,7 @@ class BASE_EXPORT CPU final {
 #if defined(ARCH_CPU_ARM_FAMILY)
   bool has_mte_ = false;  // Armv8.5-A MTE (Memory Taggging Extension)
   bool has_bti_ = false;  // Armv8.5-A BTI (Branch Target Identification)
+  bool has_crc32_ = false;  // Armv8 CRC32 instructions
 #endif
   bool has_non_stop_time_stamp_counter_ = false;
   bool is_running_in_vm_ = false;
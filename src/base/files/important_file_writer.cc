@@ -37,12 +37,19 @@
 #include "base/time/time.h"
 #include "build/build_config.h"
 #include "build/chromeos_buildflags.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
 
 namespace base {
 
 namespace {
 
 constexpr auto kDefaultCommitInterval = Seconds(10);
+// Don't write all of the data at once because this can lead to kernel
+// address-space exhaustion on 32-bit Windows (see https://crbug.com/1001022
+// for details).
+constexpr size_t kMaxWriteAmount = 8 * 1024 * 1024;
+// The size of the buffer in which FileDataSink gathers small pieces of data.
+constexpr size_t kDataSinkBufferSize = 64 * 1024;
 #if BUILDFLAG(IS_WIN)
 // This is how many times we will retry ReplaceFile on Windows.
 constexpr int kReplaceRetries = 5;
@@ -53,9 +60,8 @@ static_assert(kReplaceRetryFailure > kReplaceRetries, "No overlap allowed");
 constexpr auto kReplacePauseInterval = Milliseconds(100);
 #endif
 
-void UmaHistogramTimesWithSuffix(const char* histogram_name,
-                                 StringPiece histogram_suffix,
-                                 base::TimeDelta sample) {
+std::string GetHistogramNameWithSuffix(const char* histogram_name,
+                                       StringPiece histogram_suffix) {
   DCHECK(histogram_name);
   std::string histogram_full_name(histogram_name);
   if (!histogram_suffix.empty()) {
@@ -63,7 +69,108 @@ void UmaHistogramTimesWithSuffix(const char* histogram_name,
     histogram_full_name.append(histogram_suffix.data(),
                                histogram_suffix.length());
   }
-  UmaHistogramTimes(histogram_full_name, sample);
+  return histogram_full_name;
+}
+
+void UmaHistogramTimesWithSuffix(const char* histogram_name,
+                                 StringPiece histogram_suffix,
+                                 base::TimeDelta sample) {
+  UmaHistogramTimes(
+      GetHistogramNameWithSuffix(histogram_name, histogram_suffix), sample);
+}
+
+// Writes the data appended to it to |file|, gathering small pieces of data in
+// a buffer so that they are written together.
+class FileDataSink : public ImportantFileWriter::DataSink {
+ public:
+  FileDataSink(File* file, const FilePath& path) : file_(file), path_(path) {}
+  FileDataSink(const FileDataSink&) = delete;
+  FileDataSink& operator=(const FileDataSink&) = delete;
+  ~FileDataSink() override = default;
+
+  // ImportantFileWriter::DataSink:
+  bool Append(StringPiece data) override {
+    if (failed_)
+      return false;
+    if (data.size() < kDataSinkBufferSize - buffer_.size()) {
+      if (buffer_.empty())
+        buffer_.reserve(kDataSinkBufferSize);
+      buffer_.append(data.data(), data.size());
+      return true;
+    }
+    // Large pieces of data are written as-is rather than being copied.
+    return Flush() && Write(data);
+  }
+
+  // Writes the data left in the buffer. Returns false if any of the data
+  // appended could not be written.
+  bool Flush() {
+    if (failed_)
+      return false;
+    if (!buffer_.empty() && !Write(buffer_))
+      return false;
+    buffer_.clear();
+    return true;
+  }
+
+  bool failed() const { return failed_; }
+  size_t bytes_written() const { return bytes_written_; }
+
+ private:
+  bool Write(StringPiece data) {
+    int bytes_written = 0;
+    for (const char *scan = data.data(), *const end = scan + data.length();
+         scan < end; scan += bytes_written) {
+      const int write_amount = static_cast<int>(
+          std::min(kMaxWriteAmount, static_cast<size_t>(end - scan)));
+      bytes_written = file_->WriteAtCurrentPos(scan, write_amount);
+      if (bytes_written != write_amount) {
+        DPLOG(WARNING) << "Failed to write " << write_amount << " bytes to "
+                       << "temp file to update " << path_
+                       << " (bytes_written=" << bytes_written << ")";
+        failed_ = true;
+        return false;
+      }
+      bytes_written_ += static_cast<size_t>(bytes_written);
+    }
+    return true;
+  }
+
+  const raw_ptr<File> file_;
+  const FilePath path_;
+  std::string buffer_;
+  size_t bytes_written_ = 0;
+  bool failed_ = false;
+};
+
+// Returns a callback running |first| then |second|, either of which may be
+// null.
+OnceClosure ChainCallbacks(OnceClosure first, OnceClosure second) {
+  if (!first)
+    return second;
+  if (!second)
+    return first;
+  return BindOnce(
+      [](OnceClosure first, OnceClosure second) {
+        std::move(first).Run();
+        std::move(second).Run();
+      },
+      std::move(first), std::move(second));
+}
+
+OnceCallback<void(bool)> ChainCallbacks(OnceCallback<void(bool)> first,
+                                        OnceCallback<void(bool)> second) {
+  if (!first)
+    return second;
+  if (!second)
+    return first;
+  return BindOnce(
+      [](OnceCallback<void(bool)> first, OnceCallback<void(bool)> second,
+         bool success) {
+        std::move(first).Run(success);
+        std::move(second).Run(success);
+      },
+      std::move(first), std::move(second));
 }
 
 // Deletes the file named |tmp_file_path| (which may be open as |tmp_file|),
@@ -104,50 +211,93 @@ void DeleteTmpFileWithRetry(File tmp_file,
   }
 }
 
+// Returns a callback appending |data| to the DataSink.
+ImportantFileWriter::BackgroundDataStreamerCallback GetStringDataStreamer(
+    StringPiece data) {
+  return BindOnce(
+      [](StringPiece data, ImportantFileWriter::DataSink* sink) {
+        return sink->Append(data);
+      },
+      data);
+}
+
 }  // namespace
 
+struct ImportantFileWriter::WriteRequest {
+  WriteRequest() = default;
+  WriteRequest(WriteRequest&&) = default;
+  WriteRequest& operator=(WriteRequest&&) = default;
+  ~WriteRequest() = default;
+
+  FilePath path;
+
+  // Only one of these is set.
+  BackgroundDataProducerCallback data_producer;
+  BackgroundDataStreamerCallback data_streamer;
+  // The data of |data_producer|, once the ImportantFileWriteCoalescer ran it.
+  absl::optional<std::string> produced_data;
+
+  OnceClosure before_write_callback;
+  OnceCallback<void(bool success)> after_write_callback;
+  std::string histogram_suffix;
+
+  // When the write was requested, to record its latency.
+  TimeTicks request_time;
+};
+
 // static
 bool ImportantFileWriter::WriteFileAtomically(const FilePath& path,
                                               StringPiece data,
                                               StringPiece histogram_suffix) {
   // Calling the impl by way of the public WriteFileAtomically, so
   // |from_instance| is false.
-  return WriteFileAtomicallyImpl(path, data, histogram_suffix,
+  return WriteFileAtomicallyImpl(path, GetStringDataStreamer(data),
+                                 histogram_suffix,
                                  /*from_instance=*/false);
 }
 
 // static
-void ImportantFileWriter::ProduceAndWriteStringToFileAtomically(
-    const FilePath& path,
-    BackgroundDataProducerCallback data_producer_for_background_sequence,
-    OnceClosure before_write_callback,
-    OnceCallback<void(bool success)> after_write_callback,
-    const std::string& histogram_suffix) {
+void ImportantFileWriter::DoWriteRequest(WriteRequest request) {
   // Produce the actual data string on the background sequence.
   std::string data;
-  if (!std::move(data_producer_for_background_sequence).Run(&data)) {
-    DLOG(WARNING) << "Failed to serialize data to be saved in " << path.value();
-    return;
+  if (request.produced_data) {
+    request.data_streamer = GetStringDataStreamer(*request.produced_data);
+  } else if (request.data_producer) {
+    if (!std::move(request.data_producer).Run(&data)) {
+      DLOG(WARNING) << "Failed to serialize data to be saved in "
+                    << request.path.value();
+      return;
+    }
+    request.data_streamer = GetStringDataStreamer(data);
+  }
+  DCHECK(request.data_streamer);
+
+  if (!request.before_write_callback.is_null())
+    std::move(request.before_write_callback).Run();
+
+  // Calling the impl by way of the private DoWriteRequest, which originated
+  // from an ImportantFileWriter instance, so |from_instance| is true.
+  const bool result = WriteFileAtomicallyImpl(
+      request.path, std::move(request.data_streamer), request.histogram_suffix,
+      /*from_instance=*/true);
+
+  if (result) {
+    UmaHistogramMediumTimes(
+        GetHistogramNameWithSuffix("ImportantFile.WriteLatency",
+                                   request.histogram_suffix),
+        TimeTicks::Now() - request.request_time);
   }
 
-  if (!before_write_callback.is_null())
-    std::move(before_write_callback).Run();
-
-  // Calling the impl by way of the private
-  // ProduceAndWriteStringToFileAtomically, which originated from an
-  // ImportantFileWriter instance, so |from_instance| is true.
-  const bool result = WriteFileAtomicallyImpl(path, data, histogram_suffix,
-                                              /*from_instance=*/true);
-
-  if (!after_write_callback.is_null())
-    std::move(after_write_callback).Run(result);
+  if (!request.after_write_callback.is_null())
+    std::move(request.after_write_callback).Run(result);
 }
 
 // static
-bool ImportantFileWriter::WriteFileAtomicallyImpl(const FilePath& path,
-                                                  StringPiece data,
-                                                  StringPiece histogram_suffix,
-                                                  bool from_instance) {
+bool ImportantFileWriter::WriteFileAtomicallyImpl(
+    const FilePath& path,
+    BackgroundDataStreamerCallback data_streamer,
+    StringPiece histogram_suffix,
+    bool from_instance) {
   const TimeTicks write_start = TimeTicks::Now();
   if (!from_instance)
     ImportantFileWriterCleaner::AddDirectory(path.DirName());
@@ -170,7 +320,8 @@ bool ImportantFileWriter::WriteFileAtomicallyImpl(const FilePath& path,
     size_t data_size;
     char path[128];
   } file_info;
-  file_info.data_size = data.size();
+  // Updated once the data is written.
+  file_info.data_size = 0;
   strlcpy(file_info.path, path.value().c_str(), std::size(file_info.path));
   debug::Alias(&file_info);
 #endif
@@ -187,24 +338,19 @@ bool ImportantFileWriter::WriteFileAtomicallyImpl(const FilePath& path,
     return false;
   }
 
-  // Don't write all of the data at once because this can lead to kernel
-  // address-space exhaustion on 32-bit Windows (see https://crbug.com/1001022
-  // for details).
-  constexpr ptrdiff_t kMaxWriteAmount = 8 * 1024 * 1024;
-  int bytes_written = 0;
-  for (const char *scan = data.data(), *const end = scan + data.length();
-       scan < end; scan += bytes_written) {
-    const int write_amount =
-        static_cast<int>(std::min(kMaxWriteAmount, end - scan));
-    bytes_written = tmp_file.WriteAtCurrentPos(scan, write_amount);
-    if (bytes_written != write_amount) {
-      DPLOG(WARNING) << "Failed to write " << write_amount << " bytes to temp "
-                     << "file to update " << path
-                     << " (bytes_written=" << bytes_written << ")";
-      DeleteTmpFileWithRetry(std::move(tmp_file), tmp_file_path);
-      return false;
+  // The data is streamed to the temp file as it is serialized.
+  FileDataSink sink(&tmp_file, path);
+  if (!std::move(data_streamer).Run(&sink) || !sink.Flush()) {
+    if (!sink.failed()) {
+      DLOG(WARNING) << "Failed to serialize data to be saved in "
+                    << path.value();
     }
+    DeleteTmpFileWithRetry(std::move(tmp_file), tmp_file_path);
+    return false;
   }
+#if BUILDFLAG(IS_CHROMEOS_ASH)
+  file_info.data_size = sink.bytes_written();
+#endif
 
   if (!tmp_file.Flush()) {
     DPLOG(WARNING) << "Failed to flush temp file to update " << path;
@@ -265,6 +411,11 @@ bool ImportantFileWriter::WriteFileAtomicallyImpl(const FilePath& path,
   const TimeDelta write_duration = TimeTicks::Now() - write_start;
   UmaHistogramTimesWithSuffix("ImportantFile.WriteDuration", histogram_suffix,
                               write_duration);
+  if (result) {
+    UmaHistogramMemoryKB(
+        GetHistogramNameWithSuffix("ImportantFile.WriteSize", histogram_suffix),
+        saturated_cast<int>(sink.bytes_written() / 1024));
+  }
 
   return result;
 }
@@ -291,6 +442,19 @@ ImportantFileWriter::ImportantFileWriter(
   ImportantFileWriterCleaner::AddDirectory(path.DirName());
 }
 
+ImportantFileWriter::ImportantFileWriter(
+    const FilePath& path,
+    scoped_refptr<ImportantFileWriteCoalescer> coalescer,
+    TimeDelta interval,
+    StringPiece histogram_suffix)
+    : path_(path),
+      task_runner_(coalescer->task_runner()),
+      coalescer_(std::move(coalescer)),
+      commit_interval_(interval),
+      histogram_suffix_(histogram_suffix) {
+  ImportantFileWriterCleaner::AddDirectory(path.DirName());
+}
+
 ImportantFileWriter::~ImportantFileWriter() {
   DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
   // We're usually a member variable of some other object, which also tends
@@ -323,11 +487,35 @@ void ImportantFileWriter::WriteNowWithBackgroundDataProducer(
     BackgroundDataProducerCallback background_data_producer) {
   DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
 
-  auto split_task = SplitOnceCallback(
-      BindOnce(&ProduceAndWriteStringToFileAtomically, path_,
-               std::move(background_data_producer),
-               std::move(before_next_write_callback_),
-               std::move(after_next_write_callback_), histogram_suffix_));
+  WriteRequest request;
+  request.data_producer = std::move(background_data_producer);
+  PostWriteRequest(std::move(request));
+}
+
+void ImportantFileWriter::WriteNowWithBackgroundDataStreamer(
+    BackgroundDataStreamerCallback background_data_streamer) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+
+  WriteRequest request;
+  request.data_streamer = std::move(background_data_streamer);
+  PostWriteRequest(std::move(request));
+}
+
+void ImportantFileWriter::PostWriteRequest(WriteRequest request) {
+  request.path = path_;
+  request.before_write_callback = std::move(before_next_write_callback_);
+  request.after_write_callback = std::move(after_next_write_callback_);
+  request.histogram_suffix = histogram_suffix_;
+  request.request_time = TimeTicks::Now();
+
+  if (coalescer_) {
+    coalescer_->AddWriteRequest(std::move(request));
+    ClearPendingWrite();
+    return;
+  }
+
+  auto split_task =
+      SplitOnceCallback(BindOnce(&DoWriteRequest, std::move(request)));
 
   if (!task_runner_->PostTask(
           FROM_HERE, MakeCriticalClosure("ImportantFileWriter::WriteNow",
@@ -370,12 +558,27 @@ void ImportantFileWriter::ScheduleWriteWithBackgroundDataSerializer(
   }
 }
 
+void ImportantFileWriter::ScheduleWriteWithBackgroundDataStreamer(
+    BackgroundDataStreamer* serializer) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+
+  DCHECK(serializer);
+  serializer_.emplace<BackgroundDataStreamer*>(serializer);
+
+  if (!timer().IsRunning()) {
+    timer().Start(
+        FROM_HERE, commit_interval_,
+        BindOnce(&ImportantFileWriter::DoScheduledWrite, Unretained(this)));
+  }
+}
+
 void ImportantFileWriter::DoScheduledWrite() {
   // One of the serializers should be set.
   DCHECK(!absl::holds_alternative<absl::monostate>(serializer_));
 
   const TimeTicks serialization_start = TimeTicks::Now();
   BackgroundDataProducerCallback data_producer_for_background_sequence;
+  BackgroundDataStreamerCallback data_streamer_for_background_sequence;
 
   if (absl::holds_alternative<DataSerializer*>(serializer_)) {
     std::string data;
@@ -399,12 +602,18 @@ void ImportantFileWriter::DoScheduledWrite() {
           return true;
         },
         std::move(data));
-  } else {
+  } else if (absl::holds_alternative<BackgroundDataSerializer*>(serializer_)) {
     data_producer_for_background_sequence =
         absl::get<BackgroundDataSerializer*>(serializer_)
             ->GetSerializedDataProducerForBackgroundSequence();
 
     DCHECK(data_producer_for_background_sequence);
+  } else {
+    data_streamer_for_background_sequence =
+        absl::get<BackgroundDataStreamer*>(serializer_)
+            ->GetDataStreamerForBackgroundSequence();
+
+    DCHECK(data_streamer_for_background_sequence);
   }
 
   const TimeDelta serialization_duration =
@@ -413,8 +622,13 @@ void ImportantFileWriter::DoScheduledWrite() {
   UmaHistogramTimesWithSuffix("ImportantFile.SerializationDuration",
                               histogram_suffix_, serialization_duration);
 
-  WriteNowWithBackgroundDataProducer(
-      std::move(data_producer_for_background_sequence));
+  if (data_streamer_for_background_sequence) {
+    WriteNowWithBackgroundDataStreamer(
+        std::move(data_streamer_for_background_sequence));
+  } else {
+    WriteNowWithBackgroundDataProducer(
+        std::move(data_producer_for_background_sequence));
+  }
   DCHECK(!HasPendingWrite());
 }
 
@@ -434,4 +648,94 @@ void ImportantFileWriter::SetTimerForTesting(OneShotTimer* timer_override) {
   timer_override_ = timer_override;
 }
 
+ImportantFileWriteCoalescer::ImportantFileWriteCoalescer(
+    scoped_refptr<SequencedTaskRunner> task_runner)
+    : task_runner_(std::move(task_runner)) {
+  DCHECK(task_runner_);
+}
+
+ImportantFileWriteCoalescer::~ImportantFileWriteCoalescer() = default;
+
+void ImportantFileWriteCoalescer::AddWriteRequest(
+    ImportantFileWriter::WriteRequest request) {
+  {
+    AutoLock lock(lock_);
+    pending_requests_.push_back(std::move(request));
+    // A task doing the writes is already posted.
+    if (pending_requests_.size() > 1)
+      return;
+  }
+
+  if (!task_runner_->PostTask(
+          FROM_HERE,
+          MakeCriticalClosure(
+              "ImportantFileWriteCoalescer::DoWriteRequests",
+              BindOnce(&ImportantFileWriteCoalescer::DoWriteRequests, this),
+              /*is_immediate=*/true))) {
+    // Posting the task to background message loop is not expected
+    // to fail, but if it does, avoid losing data and just hit the disk
+    // on the current thread.
+    NOTREACHED();
+
+    DoWriteRequests();
+  }
+}
+
+void ImportantFileWriteCoalescer::DoWriteRequests() {
+  std::vector<ImportantFileWriter::WriteRequest> requests;
+  {
+    AutoLock lock(lock_);
+    requests.swap(pending_requests_);
+  }
+
+  int coalesced_write_count = 0;
+  for (auto it = requests.begin(); it != requests.end(); ++it) {
+    // The data producer of the request failed when it was run to see whether
+    // it could replace an earlier write, which was done instead.
+    if (!it->data_producer && !it->data_streamer && !it->produced_data)
+      continue;
+
+    auto replacing_request =
+        std::find_if(it + 1, requests.end(),
+                     [&](const ImportantFileWriter::WriteRequest& request) {
+                       return request.path == it->path;
+                     });
+    if (replacing_request == requests.end()) {
+      ImportantFileWriter::DoWriteRequest(std::move(*it));
+      continue;
+    }
+
+    // The earlier write can only be skipped if the replacing one has data to
+    // write, so its data is produced now. Streamed data is only known to be
+    // complete once it is written, so the earlier write is not skipped for a
+    // streaming request, whose failure would leave the file older than both.
+    if (replacing_request->data_streamer) {
+      ImportantFileWriter::DoWriteRequest(std::move(*it));
+      continue;
+    }
+    if (!replacing_request->produced_data) {
+      std::string data;
+      if (!std::move(replacing_request->data_producer).Run(&data)) {
+        DLOG(WARNING) << "Failed to serialize data to be saved in "
+                      << replacing_request->path.value();
+        ImportantFileWriter::DoWriteRequest(std::move(*it));
+        continue;
+      }
+      replacing_request->produced_data = std::move(data);
+    }
+
+    // The file would be replaced right after being written, so the write is
+    // skipped and its callbacks are run with the ones of the replacing write.
+    replacing_request->before_write_callback =
+        ChainCallbacks(std::move(it->before_write_callback),
+                       std::move(replacing_request->before_write_callback));
+    replacing_request->after_write_callback =
+        ChainCallbacks(std::move(it->after_write_callback),
+                       std::move(replacing_request->after_write_callback));
+    ++coalesced_write_count;
+  }
+  UmaHistogramCounts100("ImportantFile.CoalescedWriteCount",
+                        coalesced_write_count);
+}
+
 }  // namespace base
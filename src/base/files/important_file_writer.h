@@ -7,19 +7,24 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "base/base_export.h"
 #include "base/callback.h"
 #include "base/files/file_path.h"
 #include "base/memory/raw_ptr.h"
+#include "base/memory/ref_counted.h"
 #include "base/sequence_checker.h"
 #include "base/strings/string_piece.h"
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
 #include "base/time/time.h"
 #include "base/timer/timer.h"
 #include "third_party/abseil-cpp/absl/types/variant.h"
 
 namespace base {
 
+class ImportantFileWriteCoalescer;
 class SequencedTaskRunner;
 
 // Helper for atomically writing a file to ensure that it won't be corrupted by
@@ -43,6 +48,24 @@ class BASE_EXPORT ImportantFileWriter {
   // operations are executed. Returning false indicates an error.
   using BackgroundDataProducerCallback = base::OnceCallback<bool(std::string*)>;
 
+  // Receives the serialized data of a BackgroundDataStreamerCallback, which is
+  // written to the temporary file as it is produced. Small pieces of data are
+  // buffered, so that each doesn't cost a system call.
+  class BASE_EXPORT DataSink {
+   public:
+    // Returns false if |data| could not be written, in which case the callback
+    // should stop and return false.
+    virtual bool Append(StringPiece data) = 0;
+
+   protected:
+    virtual ~DataSink() = default;
+  };
+
+  // Same as BackgroundDataProducerCallback, but streams the serialized data to
+  // the DataSink rather than building a string holding all of it first. The
+  // write is abandoned if the callback returns false.
+  using BackgroundDataStreamerCallback = base::OnceCallback<bool(DataSink*)>;
+
   // Used by ScheduleSave to lazily provide the data to be saved. Allows us
   // to also batch data serializations.
   class BASE_EXPORT DataSerializer {
@@ -71,6 +94,21 @@ class BASE_EXPORT ImportantFileWriter {
     virtual ~BackgroundDataSerializer() = default;
   };
 
+  // Same as BackgroundDataSerializer but the callback streams the serialized
+  // data to the file instead of producing a string.
+  class BASE_EXPORT BackgroundDataStreamer {
+   public:
+    // Returns the callback which will stream the serialized data to the file.
+    // This getter itself will be called on the same thread on which
+    // ImportantFileWriter has been created, but the callback will be invoked
+    // from the sequence where I/O operations are executed.
+    virtual BackgroundDataStreamerCallback
+    GetDataStreamerForBackgroundSequence() = 0;
+
+   protected:
+    virtual ~BackgroundDataStreamer() = default;
+  };
+
   // Save |data| to |path| in an atomic manner. Blocks and writes data on the
   // current thread. Does not guarantee file integrity across system crash (see
   // the class comment above).
@@ -93,6 +131,14 @@ class BASE_EXPORT ImportantFileWriter {
                       TimeDelta interval,
                       StringPiece histogram_suffix = StringPiece());
 
+  // Same as above, but file I/O operations are executed on the task runner of
+  // |coalescer|, where they are coalesced with the ones of the other writers
+  // sharing it (see ImportantFileWriteCoalescer).
+  ImportantFileWriter(const FilePath& path,
+                      scoped_refptr<ImportantFileWriteCoalescer> coalescer,
+                      TimeDelta interval,
+                      StringPiece histogram_suffix = StringPiece());
+
   ImportantFileWriter(const ImportantFileWriter&) = delete;
   ImportantFileWriter& operator=(const ImportantFileWriter&) = delete;
 
@@ -122,6 +168,10 @@ class BASE_EXPORT ImportantFileWriter {
   void ScheduleWriteWithBackgroundDataSerializer(
       BackgroundDataSerializer* serializer);
 
+  // Same as above but uses the BackgroundDataStreamer API.
+  void ScheduleWriteWithBackgroundDataStreamer(
+      BackgroundDataStreamer* serializer);
+
   // Serialize data pending to be saved and execute write on background thread.
   void DoScheduledWrite();
 
@@ -152,6 +202,11 @@ class BASE_EXPORT ImportantFileWriter {
   }
 
  private:
+  friend class ImportantFileWriteCoalescer;
+
+  // A write to be done on the sequence where I/O operations are executed.
+  struct WriteRequest;
+
   const OneShotTimer& timer() const {
     return timer_override_ ? *timer_override_ : timer_;
   }
@@ -162,24 +217,28 @@ class BASE_EXPORT ImportantFileWriter {
   void WriteNowWithBackgroundDataProducer(
       BackgroundDataProducerCallback background_producer);
 
-  // Helper function to call WriteFileAtomically() with a promise-like callback
-  // producing a std::string.
-  static void ProduceAndWriteStringToFileAtomically(
-      const FilePath& path,
-      BackgroundDataProducerCallback data_producer_for_background_sequence,
-      OnceClosure before_write_callback,
-      OnceCallback<void(bool success)> after_write_callback,
-      const std::string& histogram_suffix);
-
-  // Writes |data| to |path|, recording histograms with an optional
-  // |histogram_suffix|. |from_instance| indicates whether the call originates
-  // from an instance of ImportantFileWriter or a direct call to
+  // Same as above but streams the data with |background_streamer|.
+  void WriteNowWithBackgroundDataStreamer(
+      BackgroundDataStreamerCallback background_streamer);
+
+  // Posts |request| to |task_runner_|, or adds it to the writes of
+  // |coalescer_|.
+  void PostWriteRequest(WriteRequest request);
+
+  // Does the write of |request|, producing its data first if it was given a
+  // BackgroundDataProducerCallback.
+  static void DoWriteRequest(WriteRequest request);
+
+  // Streams the data of |data_streamer| to |path|, recording histograms with
+  // an optional |histogram_suffix|. |from_instance| indicates whether the call
+  // originates from an instance of ImportantFileWriter or a direct call to
   // WriteFileAtomically. When false, the directory containing |path| is added
   // to the set cleaned by the ImportantFileWriterCleaner (Windows only).
-  static bool WriteFileAtomicallyImpl(const FilePath& path,
-                                      StringPiece data,
-                                      StringPiece histogram_suffix,
-                                      bool from_instance);
+  static bool WriteFileAtomicallyImpl(
+      const FilePath& path,
+      BackgroundDataStreamerCallback data_streamer,
+      StringPiece histogram_suffix,
+      bool from_instance);
 
   void ClearPendingWrite();
 
@@ -193,6 +252,10 @@ class BASE_EXPORT ImportantFileWriter {
   // TaskRunner for the thread on which file I/O can be done.
   const scoped_refptr<SequencedTaskRunner> task_runner_;
 
+  // Coalesces the writes of this writer with the ones of other writers, if
+  // any. Its task runner is |task_runner_|.
+  const scoped_refptr<ImportantFileWriteCoalescer> coalescer_;
+
   // Timer used to schedule commit after ScheduleWrite.
   OneShotTimer timer_;
 
@@ -200,7 +263,10 @@ class BASE_EXPORT ImportantFileWriter {
   raw_ptr<OneShotTimer> timer_override_ = nullptr;
 
   // Serializer which will provide the data to be saved.
-  absl::variant<absl::monostate, DataSerializer*, BackgroundDataSerializer*>
+  absl::variant<absl::monostate,
+                DataSerializer*,
+                BackgroundDataSerializer*,
+                BackgroundDataStreamer*>
       serializer_;
 
   // Time delta after which scheduled data will be written to disk.
@@ -219,6 +285,48 @@ class BASE_EXPORT ImportantFileWriter {
   WeakPtrFactory<ImportantFileWriter> weak_factory_{this};
 };
 
+// Coalesces the writes of the ImportantFileWriters sharing it, which are all
+// executed on its task runner. Writers writing close together would otherwise
+// each post a task and pay for flushing their file to disk. Instead, the writes
+// requested before the task runner gets to them are done by a single task,
+// which skips a write when a later one of the same task replaces the same file
+// with successfully produced data. Writes streaming their data never replace
+// earlier ones, since they may fail midway. The callbacks registered for a
+// skipped write are run along with the ones of the write replacing it.
+class BASE_EXPORT ImportantFileWriteCoalescer
+    : public RefCountedThreadSafe<ImportantFileWriteCoalescer> {
+ public:
+  explicit ImportantFileWriteCoalescer(
+      scoped_refptr<SequencedTaskRunner> task_runner);
+
+  ImportantFileWriteCoalescer(const ImportantFileWriteCoalescer&) = delete;
+  ImportantFileWriteCoalescer& operator=(const ImportantFileWriteCoalescer&) =
+      delete;
+
+  const scoped_refptr<SequencedTaskRunner>& task_runner() const {
+    return task_runner_;
+  }
+
+ private:
+  friend class ImportantFileWriter;
+  friend class RefCountedThreadSafe<ImportantFileWriteCoalescer>;
+
+  ~ImportantFileWriteCoalescer();
+
+  // Adds |request| to the writes of the next task doing them, posting it if
+  // needed. Can be called from any sequence.
+  void AddWriteRequest(ImportantFileWriter::WriteRequest request);
+
+  // Does the pending writes on |task_runner_|.
+  void DoWriteRequests();
+
+  const scoped_refptr<SequencedTaskRunner> task_runner_;
+
+  Lock lock_;
+  std::vector<ImportantFileWriter::WriteRequest> pending_requests_
+      GUARDED_BY(lock_);
+};
+
 }  // namespace base
 
 #endif  // BASE_FILES_IMPORTANT_FILE_WRITER_H_
@@ -14,6 +14,7 @@
 #include "base/notreached.h"
 #include "base/run_loop.h"
 #include "base/sequence_checker.h"
+#include "base/synchronization/waitable_event.h"
 #include "base/task/single_thread_task_runner.h"
 #include "base/test/bind.h"
 #include "base/test/metrics/histogram_tester.h"
@@ -82,6 +83,27 @@ class BackgroundDataSerializer
   ImportantFileWriter::BackgroundDataProducerCallback data_producer_callback_;
 };
 
+class BackgroundDataStreamer
+    : public ImportantFileWriter::BackgroundDataStreamer {
+ public:
+  explicit BackgroundDataStreamer(
+      ImportantFileWriter::BackgroundDataStreamerCallback
+          data_streamer_callback)
+      : data_streamer_callback_(std::move(data_streamer_callback)) {
+    DCHECK(data_streamer_callback_);
+  }
+
+  ImportantFileWriter::BackgroundDataStreamerCallback
+  GetDataStreamerForBackgroundSequence() override {
+    EXPECT_TRUE(sequence_checker_.CalledOnValidSequence());
+    return std::move(data_streamer_callback_);
+  }
+
+ private:
+  const base::SequenceChecker sequence_checker_;
+  ImportantFileWriter::BackgroundDataStreamerCallback data_streamer_callback_;
+};
+
 enum WriteCallbackObservationState {
   NOT_CALLED,
   CALLED_WITH_ERROR,
@@ -433,6 +455,201 @@ TEST_F(ImportantFileWriterTest,
   histogram_tester.ExpectTotalCount("ImportantFile.WriteDuration", 0);
 }
 
+TEST_F(ImportantFileWriterTest, ScheduleWriteWithBackgroundDataStreamer) {
+  base::HistogramTester histogram_tester;
+  base::Thread file_writer_thread("ImportantFileWriter test thread");
+  file_writer_thread.Start();
+  MockOneShotTimer timer;
+  ImportantFileWriter writer(file_, file_writer_thread.task_runner());
+  writer.SetTimerForTesting(&timer);
+  // Small pieces of data are buffered, unlike the large one.
+  const std::string large_data(100 * 1024, 'l');
+  std::string expected_data;
+  BackgroundDataStreamer streamer(base::BindLambdaForTesting(
+      [&](ImportantFileWriter::DataSink* sink) {
+        EXPECT_TRUE(
+            file_writer_thread.task_runner()->RunsTasksInCurrentSequence());
+        for (int i = 0; i < 1000; ++i) {
+          if (!sink->Append("foo") || !sink->Append(""))
+            return false;
+        }
+        return sink->Append(large_data) && sink->Append("bar");
+      }));
+  for (int i = 0; i < 1000; ++i)
+    expected_data += "foo";
+  expected_data += large_data + "bar";
+
+  write_callback_observer_.ObserveNextWriteCallbacks(&writer);
+  writer.ScheduleWriteWithBackgroundDataStreamer(&streamer);
+  EXPECT_TRUE(writer.HasPendingWrite());
+  timer.Fire();
+  EXPECT_FALSE(writer.HasPendingWrite());
+  file_writer_thread.FlushForTesting();
+
+  EXPECT_EQ(CALLED_WITH_SUCCESS,
+            write_callback_observer_.GetAndResetObservationState());
+  EXPECT_EQ(expected_data, GetFileContent(writer.path()));
+  histogram_tester.ExpectUniqueSample("ImportantFile.WriteSize",
+                                      expected_data.size() / 1024, 1);
+  histogram_tester.ExpectTotalCount("ImportantFile.WriteLatency", 1);
+  histogram_tester.ExpectTotalCount("ImportantFile.WriteDuration", 1);
+}
+
+TEST_F(ImportantFileWriterTest,
+       ScheduleWriteWithBackgroundDataStreamer_FailToSerialize) {
+  base::HistogramTester histogram_tester;
+  MockOneShotTimer timer;
+  ImportantFileWriter writer(file_, ThreadTaskRunnerHandle::Get());
+  writer.SetTimerForTesting(&timer);
+  BackgroundDataStreamer streamer(
+      base::BindOnce([](ImportantFileWriter::DataSink* sink) {
+        EXPECT_TRUE(sink->Append("foo"));
+        return false;
+      }));
+
+  write_callback_observer_.ObserveNextWriteCallbacks(&writer);
+  writer.ScheduleWriteWithBackgroundDataStreamer(&streamer);
+  timer.Fire();
+  RunLoop().RunUntilIdle();
+
+  // The write is abandoned, without leaving the temporary file behind.
+  EXPECT_EQ(CALLED_WITH_ERROR,
+            write_callback_observer_.GetAndResetObservationState());
+  EXPECT_FALSE(PathExists(writer.path()));
+  EXPECT_TRUE(IsDirectoryEmpty(writer.path().DirName()));
+  histogram_tester.ExpectTotalCount("ImportantFile.WriteDuration", 0);
+  histogram_tester.ExpectTotalCount("ImportantFile.WriteSize", 0);
+  histogram_tester.ExpectTotalCount("ImportantFile.WriteLatency", 0);
+}
+
+TEST_F(ImportantFileWriterTest, CoalesceWrites) {
+  base::HistogramTester histogram_tester;
+  base::Thread file_writer_thread("ImportantFileWriter test thread");
+  file_writer_thread.Start();
+  auto coalescer = MakeRefCounted<ImportantFileWriteCoalescer>(
+      file_writer_thread.task_runner());
+  const FilePath other_file = file_.DirName().AppendASCII("other-file");
+  ImportantFileWriter writer(file_, coalescer, Seconds(10));
+  ImportantFileWriter other_writer(other_file, coalescer, Seconds(10));
+
+  // Block |file_writer_thread| so that the writes are done by the same task.
+  base::WaitableEvent wait_helper;
+  file_writer_thread.task_runner()->PostTask(
+      FROM_HERE, base::BindOnce(&base::WaitableEvent::Wait,
+                                base::Unretained(&wait_helper)));
+
+  WriteCallbacksObserver first_write_observer;
+  first_write_observer.ObserveNextWriteCallbacks(&writer);
+  writer.WriteNow(std::make_unique<std::string>("foo"));
+  other_writer.WriteNow(std::make_unique<std::string>("baz"));
+  write_callback_observer_.ObserveNextWriteCallbacks(&writer);
+  writer.WriteNow(std::make_unique<std::string>("bar"));
+  EXPECT_FALSE(writer.HasPendingWrite());
+
+  wait_helper.Signal();
+  file_writer_thread.FlushForTesting();
+
+  // Only the last write of |file_| is done, but the callbacks of the first
+  // one still run.
+  EXPECT_EQ(CALLED_WITH_SUCCESS,
+            first_write_observer.GetAndResetObservationState());
+  EXPECT_EQ(CALLED_WITH_SUCCESS,
+            write_callback_observer_.GetAndResetObservationState());
+  EXPECT_EQ("bar", GetFileContent(file_));
+  EXPECT_EQ("baz", GetFileContent(other_file));
+  histogram_tester.ExpectUniqueSample("ImportantFile.CoalescedWriteCount", 1,
+                                      1);
+  histogram_tester.ExpectTotalCount("ImportantFile.WriteDuration", 2);
+  histogram_tester.ExpectTotalCount("ImportantFile.WriteLatency", 2);
+
+  // Writes requested once the previous ones are done are done by a new task.
+  writer.WriteNow(std::make_unique<std::string>("qux"));
+  file_writer_thread.FlushForTesting();
+  EXPECT_EQ("qux", GetFileContent(file_));
+  histogram_tester.ExpectBucketCount("ImportantFile.CoalescedWriteCount", 0,
+                                     1);
+}
+
+TEST_F(ImportantFileWriterTest, CoalesceWritesReplacingWriteFailsToSerialize) {
+  base::HistogramTester histogram_tester;
+  base::Thread file_writer_thread("ImportantFileWriter test thread");
+  file_writer_thread.Start();
+  auto coalescer = MakeRefCounted<ImportantFileWriteCoalescer>(
+      file_writer_thread.task_runner());
+  ImportantFileWriter writer(file_, coalescer, Seconds(10));
+
+  // Block |file_writer_thread| so that the writes are done by the same task.
+  base::WaitableEvent wait_helper;
+  file_writer_thread.task_runner()->PostTask(
+      FROM_HERE, base::BindOnce(&base::WaitableEvent::Wait,
+                                base::Unretained(&wait_helper)));
+
+  WriteCallbacksObserver first_write_observer;
+  first_write_observer.ObserveNextWriteCallbacks(&writer);
+  writer.WriteNow(std::make_unique<std::string>("foo"));
+  BackgroundDataSerializer serializer(
+      base::BindLambdaForTesting([](std::string* data) { return false; }));
+  write_callback_observer_.ObserveNextWriteCallbacks(&writer);
+  writer.ScheduleWriteWithBackgroundDataSerializer(&serializer);
+  writer.DoScheduledWrite();
+  EXPECT_FALSE(writer.HasPendingWrite());
+
+  wait_helper.Signal();
+  file_writer_thread.FlushForTesting();
+
+  // The write replacing the first one has no data, so the first one is done.
+  EXPECT_TRUE(serializer.producer_callback_obtained());
+  EXPECT_EQ(CALLED_WITH_SUCCESS,
+            first_write_observer.GetAndResetObservationState());
+  EXPECT_EQ(NOT_CALLED, write_callback_observer_.GetAndResetObservationState());
+  EXPECT_EQ("foo", GetFileContent(file_));
+  histogram_tester.ExpectUniqueSample("ImportantFile.CoalescedWriteCount", 0,
+                                      1);
+  histogram_tester.ExpectTotalCount("ImportantFile.WriteDuration", 1);
+}
+
+TEST_F(ImportantFileWriterTest, CoalesceWritesReplacingWriteFailsToStream) {
+  base::HistogramTester histogram_tester;
+  base::Thread file_writer_thread("ImportantFileWriter test thread");
+  file_writer_thread.Start();
+  auto coalescer = MakeRefCounted<ImportantFileWriteCoalescer>(
+      file_writer_thread.task_runner());
+  ImportantFileWriter writer(file_, coalescer, Seconds(10));
+
+  // Block |file_writer_thread| so that the writes are done by the same task.
+  base::WaitableEvent wait_helper;
+  file_writer_thread.task_runner()->PostTask(
+      FROM_HERE, base::BindOnce(&base::WaitableEvent::Wait,
+                                base::Unretained(&wait_helper)));
+
+  WriteCallbacksObserver first_write_observer;
+  first_write_observer.ObserveNextWriteCallbacks(&writer);
+  writer.WriteNow(std::make_unique<std::string>("foo"));
+  BackgroundDataStreamer streamer(
+      base::BindOnce([](ImportantFileWriter::DataSink* sink) {
+        EXPECT_TRUE(sink->Append("bar"));
+        return false;
+      }));
+  write_callback_observer_.ObserveNextWriteCallbacks(&writer);
+  writer.ScheduleWriteWithBackgroundDataStreamer(&streamer);
+  writer.DoScheduledWrite();
+  EXPECT_FALSE(writer.HasPendingWrite());
+
+  wait_helper.Signal();
+  file_writer_thread.FlushForTesting();
+
+  // The streamed write fails after it started, so the first write must have
+  // been done rather than skipped.
+  EXPECT_EQ(CALLED_WITH_SUCCESS,
+            first_write_observer.GetAndResetObservationState());
+  EXPECT_EQ(CALLED_WITH_ERROR,
+            write_callback_observer_.GetAndResetObservationState());
+  EXPECT_EQ("foo", GetFileContent(file_));
+  histogram_tester.ExpectUniqueSample("ImportantFile.CoalescedWriteCount", 0,
+                                      1);
+  histogram_tester.ExpectTotalCount("ImportantFile.WriteDuration", 1);
+}
+
 // Test that the chunking to avoid very large writes works.
 TEST_F(ImportantFileWriterTest, WriteLargeFile) {
   // One byte larger than kMaxWriteAmount.
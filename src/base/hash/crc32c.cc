@@ -0,0 +1,223 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/hash/crc32c.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "base/sys_byteorder.h"
+#include "build/build_config.h"
+
+#if defined(ARCH_CPU_X86_64)
+#include <immintrin.h>
+
+#include "base/cpu.h"
+#elif defined(ARCH_CPU_ARM64)
+#include <arm_acle.h>
+
+#include "base/cpu.h"
+#endif
+
+namespace base {
+
+namespace {
+
+// The CRC-32C polynomial, with its bits reversed as the checksum is computed
+// from the least significant bit of each byte.
+constexpr uint32_t kPolynomial = 0x82f63b78;
+
+// The checksum is computed on the CRC register, which is inverted before and
+// after processing the data, so that leading zero bytes change the checksum.
+//
+// For slicing-by-8, |tables[k][b]| is the register after processing byte b
+// followed by k zero bytes, from a zero register.
+struct SlicingTables {
+  uint32_t tables[8][256];
+};
+
+constexpr SlicingTables MakeSlicingTables() {
+  SlicingTables slicing = {};
+  for (uint32_t byte = 0; byte < 256; ++byte) {
+    uint32_t crc = byte;
+    for (int bit = 0; bit < 8; ++bit)
+      crc = (crc >> 1) ^ (kPolynomial & (0u - (crc & 1)));
+    slicing.tables[0][byte] = crc;
+  }
+  for (size_t k = 1; k < 8; ++k) {
+    for (size_t byte = 0; byte < 256; ++byte) {
+      const uint32_t crc = slicing.tables[k - 1][byte];
+      slicing.tables[k][byte] =
+          (crc >> 8) ^ slicing.tables[0][crc & 0xff];
+    }
+  }
+  return slicing;
+}
+
+constexpr SlicingTables kSlicingTables = MakeSlicingTables();
+
+uint32_t LoadLE32(const uint8_t* data) {
+  uint32_t value;
+  memcpy(&value, data, sizeof(value));
+  return ByteSwapToLE32(value);
+}
+
+uint32_t ExtendPortable(uint32_t crc, const uint8_t* data, size_t size) {
+  const auto& tables = kSlicingTables.tables;
+  for (; size >= 8; data += 8, size -= 8) {
+    const uint32_t low = LoadLE32(data) ^ crc;
+    const uint32_t high = LoadLE32(data + 4);
+    crc = tables[7][low & 0xff] ^ tables[6][(low >> 8) & 0xff] ^
+          tables[5][(low >> 16) & 0xff] ^ tables[4][low >> 24] ^
+          tables[3][high & 0xff] ^ tables[2][(high >> 8) & 0xff] ^
+          tables[1][(high >> 16) & 0xff] ^ tables[0][high >> 24];
+  }
+  for (; size > 0; ++data, --size)
+    crc = (crc >> 8) ^ tables[0][(crc ^ *data) & 0xff];
+  return crc;
+}
+
+#if defined(ARCH_CPU_X86_64) || defined(ARCH_CPU_ARM64)
+
+// A CRC instruction has a latency of 3 cycles but a throughput of 1 per cycle,
+// so the data is processed in three interleaved streams of this many bytes.
+// The registers of the streams are then combined, since processing the data
+// B from the register r gives the register for B from zero, XORed with that
+// for |B| zero bytes from r.
+constexpr size_t kStreamSize = 256;
+
+// |tables[k][b]| is the register after processing |kStreamSize| zero bytes
+// from the register with byte k equal to b and the other bytes zero.
+struct ShiftTables {
+  uint32_t tables[4][256];
+};
+
+constexpr uint32_t ShiftByStreamSize(uint32_t crc) {
+  for (size_t i = 0; i < kStreamSize; ++i)
+    crc = (crc >> 8) ^ kSlicingTables.tables[0][crc & 0xff];
+  return crc;
+}
+
+constexpr ShiftTables MakeShiftTables() {
+  // Processing zero bytes is linear in the register, so the tables follow
+  // from the shifts of each of its bits.
+  uint32_t shifted_bits[32] = {};
+  for (size_t bit = 0; bit < 32; ++bit)
+    shifted_bits[bit] = ShiftByStreamSize(uint32_t{1} << bit);
+  ShiftTables shift = {};
+  for (size_t k = 0; k < 4; ++k) {
+    for (size_t byte = 0; byte < 256; ++byte) {
+      uint32_t crc = 0;
+      for (size_t bit = 0; bit < 8; ++bit) {
+        if (byte & (1u << bit))
+          crc ^= shifted_bits[8 * k + bit];
+      }
+      shift.tables[k][byte] = crc;
+    }
+  }
+  return shift;
+}
+
+constexpr ShiftTables kShiftTables = MakeShiftTables();
+
+uint32_t Shift(uint32_t crc) {
+  const auto& tables = kShiftTables.tables;
+  return tables[0][crc & 0xff] ^ tables[1][(crc >> 8) & 0xff] ^
+         tables[2][(crc >> 16) & 0xff] ^ tables[3][crc >> 24];
+}
+
+uint64_t Load64(const uint8_t* data) {
+  uint64_t value;
+  memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+#endif  // defined(ARCH_CPU_X86_64) || defined(ARCH_CPU_ARM64)
+
+#if defined(ARCH_CPU_X86_64)
+
+bool CanUseSSE42() {
+  static const bool can_use_sse42 = CPU::GetInstanceNoAllocation().has_sse42();
+  return can_use_sse42;
+}
+
+__attribute__((target("sse4.2"))) uint32_t ExtendSSE42(uint32_t crc,
+                                                       const uint8_t* data,
+                                                       size_t size) {
+  for (; size >= 3 * kStreamSize;
+       data += 3 * kStreamSize, size -= 3 * kStreamSize) {
+    uint64_t crc0 = crc;
+    uint64_t crc1 = 0;
+    uint64_t crc2 = 0;
+    for (size_t i = 0; i < kStreamSize; i += 8) {
+      crc0 = _mm_crc32_u64(crc0, Load64(data + i));
+      crc1 = _mm_crc32_u64(crc1, Load64(data + kStreamSize + i));
+      crc2 = _mm_crc32_u64(crc2, Load64(data + 2 * kStreamSize + i));
+    }
+    crc = Shift(Shift(static_cast<uint32_t>(crc0)) ^
+                static_cast<uint32_t>(crc1)) ^
+          static_cast<uint32_t>(crc2);
+  }
+  uint64_t crc64 = crc;
+  for (; size >= 8; data += 8, size -= 8)
+    crc64 = _mm_crc32_u64(crc64, Load64(data));
+  crc = static_cast<uint32_t>(crc64);
+  for (; size > 0; ++data, --size)
+    crc = _mm_crc32_u8(crc, *data);
+  return crc;
+}
+
+#elif defined(ARCH_CPU_ARM64)
+
+bool CanUseCrc32() {
+  static const bool can_use_crc32 = CPU::GetInstanceNoAllocation().has_crc32();
+  return can_use_crc32;
+}
+
+__attribute__((target("crc"))) uint32_t ExtendArmCrc32(uint32_t crc,
+                                                       const uint8_t* data,
+                                                       size_t size) {
+  for (; size >= 3 * kStreamSize;
+       data += 3 * kStreamSize, size -= 3 * kStreamSize) {
+    uint32_t crc0 = crc;
+    uint32_t crc1 = 0;
+    uint32_t crc2 = 0;
+    for (size_t i = 0; i < kStreamSize; i += 8) {
+      crc0 = __crc32cd(crc0, Load64(data + i));
+      crc1 = __crc32cd(crc1, Load64(data + kStreamSize + i));
+      crc2 = __crc32cd(crc2, Load64(data + 2 * kStreamSize + i));
+    }
+    crc = Shift(Shift(crc0) ^ crc1) ^ crc2;
+  }
+  for (; size >= 8; data += 8, size -= 8)
+    crc = __crc32cd(crc, Load64(data));
+  for (; size > 0; ++data, --size)
+    crc = __crc32cb(crc, *data);
+  return crc;
+}
+
+#endif
+
+}  // namespace
+
+uint32_t Crc32c(uint32_t crc, span<const uint8_t> data) {
+#if defined(ARCH_CPU_X86_64)
+  if (CanUseSSE42())
+    return ~ExtendSSE42(~crc, data.data(), data.size());
+#elif defined(ARCH_CPU_ARM64)
+  if (CanUseCrc32())
+    return ~ExtendArmCrc32(~crc, data.data(), data.size());
+#endif
+  return internal::Crc32cPortable(crc, data);
+}
+
+namespace internal {
+
+uint32_t Crc32cPortable(uint32_t crc, span<const uint8_t> data) {
+  return ~ExtendPortable(~crc, data.data(), data.size());
+}
+
+}  // namespace internal
+
+}  // namespace base
@@ -0,0 +1,42 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_HASH_CRC32C_H_
+#define BASE_HASH_CRC32C_H_
+
+#include <stdint.h>
+
+#include "base/base_export.h"
+#include "base/containers/span.h"
+#include "base/strings/string_piece.h"
+
+namespace base {
+
+// Computes the CRC-32C (Castagnoli) checksum of |data|, as used by iSCSI,
+// SCTP, ext4 and LevelDB. |crc| is the checksum of the data preceding |data|,
+// or 0 for none, so that a checksum can be computed incrementally:
+//
+//   Crc32c(Crc32c(0, a), b) == Crc32c(0, a + b)
+//
+// Unlike the CRC-32 of base/metrics/crc32.h, the polynomial has dedicated
+// instructions on x86-64 (SSE4.2) and Armv8, which are used when available.
+// Otherwise, the checksum is computed with slicing-by-8 tables.
+//
+// Unchanging forever: yes
+BASE_EXPORT uint32_t Crc32c(uint32_t crc, span<const uint8_t> data);
+inline uint32_t Crc32c(uint32_t crc, StringPiece data) {
+  return Crc32c(crc, as_bytes(make_span(data)));
+}
+
+namespace internal {
+
+// Computes the same checksum as Crc32c() without the dedicated instructions.
+// Exposed for testing.
+BASE_EXPORT uint32_t Crc32cPortable(uint32_t crc, span<const uint8_t> data);
+
+}  // namespace internal
+
+}  // namespace base
+
+#endif  // BASE_HASH_CRC32C_H_
@@ -0,0 +1,60 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/hash/crc32c.h"
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "base/rand_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+TEST(Crc32cTest, KnownValues) {
+  EXPECT_EQ(0u, Crc32c(0, span<const uint8_t>()));
+  EXPECT_EQ(0xe3069283u, Crc32c(0, "123456789"));
+
+  // From RFC 3720, section B.4.
+  std::vector<uint8_t> data(32, 0);
+  EXPECT_EQ(0x8a9136aau, Crc32c(0, data));
+  data.assign(32, 0xff);
+  EXPECT_EQ(0x62a8ab43u, Crc32c(0, data));
+  for (size_t i = 0; i < 32; ++i)
+    data[i] = static_cast<uint8_t>(i);
+  EXPECT_EQ(0x46dd794eu, Crc32c(0, data));
+  for (size_t i = 0; i < 32; ++i)
+    data[i] = static_cast<uint8_t>(31 - i);
+  EXPECT_EQ(0x113fdb5cu, Crc32c(0, data));
+}
+
+TEST(Crc32cTest, Incremental) {
+  std::vector<uint8_t> data(1000);
+  RandBytes(data.data(), data.size());
+  const uint32_t crc = Crc32c(0, data);
+  for (size_t split : {0, 1, 7, 8, 100, 767, 768, 999, 1000}) {
+    const span<const uint8_t> all(data);
+    EXPECT_EQ(crc, Crc32c(Crc32c(0, all.first(split)), all.subspan(split)))
+        << split;
+  }
+}
+
+// The dedicated instructions, if any, and the tables give the same checksums,
+// whatever the size and alignment of the data.
+TEST(Crc32cTest, MatchesPortable) {
+  std::vector<uint8_t> data(3000);
+  RandBytes(data.data(), data.size());
+  for (size_t size = 0; size < 2000; size += size < 64 ? 1 : 37) {
+    for (size_t offset = 0; offset < 8; ++offset) {
+      const span<const uint8_t> input =
+          span<const uint8_t>(data).subspan(offset, size);
+      EXPECT_EQ(internal::Crc32cPortable(0x12345678, input),
+                Crc32c(0x12345678, input))
+          << size << " " << offset;
+    }
+  }
+}
+
+}  // namespace base
@@ -0,0 +1,371 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/hash/hash64.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "base/sys_byteorder.h"
+#include "build/build_config.h"
+
+#if defined(ARCH_CPU_X86_64)
+#include <immintrin.h>
+
+#include "base/cpu.h"
+#elif defined(ARCH_CPU_ARM64)
+#include <arm_neon.h>
+#endif
+
+namespace base {
+
+namespace {
+
+constexpr uint64_t kPrime64_1 = 0x9e3779b185ebca87;
+constexpr uint64_t kPrime64_2 = 0xc2b2ae3d27d4eb4f;
+constexpr uint64_t kPrime64_3 = 0x165667b19e3779f9;
+constexpr uint64_t kPrime64_4 = 0x85ebca77c2b2ae63;
+constexpr uint32_t kPrime32_1 = 0x9e3779b1;
+
+// Long inputs are hashed in stripes of 32 bytes, each of whose 64-bit lanes
+// is keyed, then multiplied-accumulated into one of 4 accumulators. Stripe s
+// of a block uses the keys s to s + 3, so that the order of the stripes
+// matters. The accumulators are scrambled after each block, so that the bits
+// of the input keep reaching their high bits.
+constexpr size_t kNumLanes = 4;
+constexpr size_t kStripeSize = kNumLanes * sizeof(uint64_t);
+constexpr size_t kStripesPerBlock = 16;
+
+// Inputs of up to this many bytes are too short for the stripes to pay off.
+constexpr size_t kMaxMediumSize = 128;
+
+// The last stripe is keyed past those of the blocks.
+constexpr size_t kNumStripeKeys = kStripesPerBlock + kNumLanes;
+
+// Arbitrary keys, which are the outputs of SplitMix64 from a zero state. The
+// first ones key the stripes, then the scrambling and merging of the
+// accumulators, and short inputs. The seed is added to the stripe keys and
+// subtracted from the scrambling keys.
+struct Secret {
+  uint64_t words[kNumStripeKeys + 2 * kNumLanes + 1];
+};
+
+constexpr Secret MakeSecret() {
+  Secret secret = {};
+  uint64_t state = 0;
+  for (uint64_t& word : secret.words) {
+    state += 0x9e3779b97f4a7c15;
+    uint64_t z = state;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    word = z ^ (z >> 31);
+  }
+  return secret;
+}
+
+constexpr Secret kSecret = MakeSecret();
+constexpr const uint64_t* kScrambleSecret = kSecret.words + kNumStripeKeys;
+constexpr const uint64_t* kMergeSecret = kScrambleSecret + kNumLanes;
+constexpr uint64_t kShortSecret = kMergeSecret[kNumLanes];
+
+uint64_t Load64(const uint8_t* data) {
+  uint64_t value;
+  memcpy(&value, data, sizeof(value));
+  return ByteSwapToLE64(value);
+}
+
+uint64_t Load32(const uint8_t* data) {
+  uint32_t value;
+  memcpy(&value, data, sizeof(value));
+  return ByteSwapToLE32(value);
+}
+
+uint64_t RotateLeft(uint64_t value, int bits) {
+  return (value << bits) | (value >> (64 - bits));
+}
+
+// Mixes |word| into |hash|, as a round of XXH64.
+uint64_t Round(uint64_t hash, uint64_t word) {
+  hash ^= RotateLeft(word * kPrime64_2, 31) * kPrime64_1;
+  return RotateLeft(hash, 27) * kPrime64_1 + kPrime64_4;
+}
+
+uint64_t Avalanche(uint64_t hash) {
+  hash ^= hash >> 33;
+  hash *= kPrime64_2;
+  hash ^= hash >> 29;
+  hash *= kPrime64_3;
+  hash ^= hash >> 32;
+  return hash;
+}
+
+void AccumulateStripe(uint64_t* acc,
+                      const uint8_t* stripe,
+                      const uint64_t* keys,
+                      uint64_t seed) {
+  for (size_t i = 0; i < kNumLanes; ++i) {
+    const uint64_t data = Load64(stripe + i * sizeof(uint64_t));
+    const uint64_t keyed = data ^ (keys[i] + seed);
+    // Adding the data to the neighboring lane keeps it from being lost when
+    // one of the halves of |keyed| is zero.
+    acc[i ^ 1] += data;
+    acc[i] += (keyed & 0xffffffff) * (keyed >> 32);
+  }
+}
+
+void Scramble(uint64_t* acc, uint64_t seed) {
+  for (size_t i = 0; i < kNumLanes; ++i) {
+    acc[i] ^= acc[i] >> 47;
+    acc[i] ^= kScrambleSecret[i] - seed;
+    acc[i] *= kPrime32_1;
+  }
+}
+
+// Accumulates |num_stripes| stripes of |data|, scrambling the accumulators
+// after each block.
+void AccumulatePortable(uint64_t* acc,
+                        const uint8_t* data,
+                        size_t num_stripes,
+                        uint64_t seed) {
+  for (size_t i = 0; i < num_stripes; ++i) {
+    AccumulateStripe(acc, data + i * kStripeSize,
+                     kSecret.words + i % kStripesPerBlock, seed);
+    if ((i + 1) % kStripesPerBlock == 0)
+      Scramble(acc, seed);
+  }
+}
+
+#if defined(ARCH_CPU_X86_64)
+
+bool CanUseAVX2() {
+  static const bool can_use_avx2 = CPU::GetInstanceNoAllocation().has_avx2();
+  return can_use_avx2;
+}
+
+__attribute__((target("avx2"))) void AccumulateAVX2(uint64_t* acc_lanes,
+                                                    const uint8_t* data,
+                                                    size_t num_stripes,
+                                                    uint64_t seed) {
+  __m256i acc =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc_lanes));
+  const __m256i seeds = _mm256_set1_epi64x(static_cast<int64_t>(seed));
+  const __m256i scramble_keys = _mm256_sub_epi64(
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(kScrambleSecret)),
+      seeds);
+  const __m256i prime = _mm256_set1_epi32(static_cast<int>(kPrime32_1));
+  for (size_t i = 0; i < num_stripes; ++i) {
+    const __m256i stripe = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(data + i * kStripeSize));
+    const __m256i stripe_keys =
+        _mm256_add_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+                             kSecret.words + i % kStripesPerBlock)),
+                         seeds);
+    const __m256i keyed = _mm256_xor_si256(stripe, stripe_keys);
+    const __m256i product =
+        _mm256_mul_epu32(keyed, _mm256_srli_epi64(keyed, 32));
+    const __m256i swapped =
+        _mm256_shuffle_epi32(stripe, _MM_SHUFFLE(1, 0, 3, 2));
+    acc = _mm256_add_epi64(acc, _mm256_add_epi64(product, swapped));
+    if ((i + 1) % kStripesPerBlock == 0) {
+      acc = _mm256_xor_si256(acc, _mm256_srli_epi64(acc, 47));
+      acc = _mm256_xor_si256(acc, scramble_keys);
+      const __m256i low = _mm256_mul_epu32(acc, prime);
+      const __m256i high = _mm256_mul_epu32(_mm256_srli_epi64(acc, 32), prime);
+      acc = _mm256_add_epi64(low, _mm256_slli_epi64(high, 32));
+    }
+  }
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc_lanes), acc);
+}
+
+// SSE2 is part of the x86-64 baseline, so this needs no CPU check.
+void AccumulateSSE2(uint64_t* acc_lanes,
+                    const uint8_t* data,
+                    size_t num_stripes,
+                    uint64_t seed) {
+  const __m128i seeds = _mm_set1_epi64x(static_cast<int64_t>(seed));
+  __m128i acc[2];
+  __m128i scramble_keys[2];
+  for (size_t j = 0; j < 2; ++j) {
+    acc[j] =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc_lanes + 2 * j));
+    scramble_keys[j] = _mm_sub_epi64(
+        _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(kScrambleSecret + 2 * j)),
+        seeds);
+  }
+  const __m128i prime = _mm_set1_epi32(static_cast<int>(kPrime32_1));
+  for (size_t i = 0; i < num_stripes; ++i) {
+    for (size_t j = 0; j < 2; ++j) {
+      const __m128i half = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(data + i * kStripeSize + 16 * j));
+      const __m128i stripe_keys =
+          _mm_add_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(
+                            kSecret.words + i % kStripesPerBlock + 2 * j)),
+                        seeds);
+      const __m128i keyed = _mm_xor_si128(half, stripe_keys);
+      const __m128i product = _mm_mul_epu32(keyed, _mm_srli_epi64(keyed, 32));
+      const __m128i swapped = _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2));
+      acc[j] = _mm_add_epi64(acc[j], _mm_add_epi64(product, swapped));
+    }
+    if ((i + 1) % kStripesPerBlock == 0) {
+      for (size_t j = 0; j < 2; ++j) {
+        acc[j] = _mm_xor_si128(acc[j], _mm_srli_epi64(acc[j], 47));
+        acc[j] = _mm_xor_si128(acc[j], scramble_keys[j]);
+        const __m128i low = _mm_mul_epu32(acc[j], prime);
+        const __m128i high = _mm_mul_epu32(_mm_srli_epi64(acc[j], 32), prime);
+        acc[j] = _mm_add_epi64(low, _mm_slli_epi64(high, 32));
+      }
+    }
+  }
+  for (size_t j = 0; j < 2; ++j)
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(acc_lanes + 2 * j), acc[j]);
+}
+
+#elif defined(ARCH_CPU_ARM64)
+
+void AccumulateNEON(uint64_t* acc_lanes,
+                    const uint8_t* data,
+                    size_t num_stripes,
+                    uint64_t seed) {
+  const uint64x2_t seeds = vdupq_n_u64(seed);
+  uint64x2_t acc[2];
+  uint64x2_t scramble_keys[2];
+  for (size_t j = 0; j < 2; ++j) {
+    acc[j] = vld1q_u64(acc_lanes + 2 * j);
+    scramble_keys[j] = vsubq_u64(vld1q_u64(kScrambleSecret + 2 * j), seeds);
+  }
+  const uint32x2_t prime = vdup_n_u32(kPrime32_1);
+  for (size_t i = 0; i < num_stripes; ++i) {
+    for (size_t j = 0; j < 2; ++j) {
+      const uint64x2_t half = vreinterpretq_u64_u8(
+          vld1q_u8(data + i * kStripeSize + 16 * j));
+      const uint64x2_t stripe_keys = vaddq_u64(
+          vld1q_u64(kSecret.words + i % kStripesPerBlock + 2 * j), seeds);
+      const uint64x2_t keyed = veorq_u64(half, stripe_keys);
+      const uint64x2_t product =
+          vmull_u32(vmovn_u64(keyed), vshrn_n_u64(keyed, 32));
+      const uint64x2_t swapped = vextq_u64(half, half, 1);
+      acc[j] = vaddq_u64(acc[j], vaddq_u64(product, swapped));
+    }
+    if ((i + 1) % kStripesPerBlock == 0) {
+      for (size_t j = 0; j < 2; ++j) {
+        acc[j] = veorq_u64(acc[j], vshrq_n_u64(acc[j], 47));
+        acc[j] = veorq_u64(acc[j], scramble_keys[j]);
+        const uint64x2_t low = vmull_u32(vmovn_u64(acc[j]), prime);
+        const uint64x2_t high = vmull_u32(vshrn_n_u64(acc[j], 32), prime);
+        acc[j] = vaddq_u64(low, vshlq_n_u64(high, 32));
+      }
+    }
+  }
+  for (size_t j = 0; j < 2; ++j)
+    vst1q_u64(acc_lanes + 2 * j, acc[j]);
+}
+
+#endif
+
+using AccumulateFunction = void (*)(uint64_t*,
+                                    const uint8_t*,
+                                    size_t,
+                                    uint64_t);
+
+// Hashes inputs of less than a stripe from their first and last words, which
+// overlap for sizes which are not a multiple of the word size.
+uint64_t HashShort(const uint8_t* data, size_t size, uint64_t seed) {
+  uint64_t hash = seed + kShortSecret + size * kPrime64_1;
+  if (size >= 16) {
+    hash = Round(hash, Load64(data));
+    hash = Round(hash, Load64(data + 8));
+    hash = Round(hash, Load64(data + size - 16));
+    hash = Round(hash, Load64(data + size - 8));
+  } else if (size >= 8) {
+    hash = Round(hash, Load64(data));
+    hash = Round(hash, Load64(data + size - 8));
+  } else if (size >= 4) {
+    hash = Round(hash, Load32(data) | Load32(data + size - 4) << 32);
+  } else if (size > 0) {
+    hash = Round(hash, uint64_t{data[0]} | uint64_t{data[size / 2]} << 8 |
+                           uint64_t{data[size - 1]} << 16);
+  }
+  return Avalanche(hash);
+}
+
+// Hashes inputs of up to |kMaxMediumSize| bytes from their first and last
+// 16-byte chunks, which overlap unless the size is a multiple of 32. The words
+// of the chunks are mixed into 4 independent lanes, to keep the multipliers
+// busy without the setup of the long inputs.
+uint64_t HashMedium(const uint8_t* data, size_t size, uint64_t seed) {
+  uint64_t lanes[kNumLanes];
+  for (size_t i = 0; i < kNumLanes; ++i)
+    lanes[i] = seed + kSecret.words[i];
+  const uint8_t* const end = data + size;
+  for (size_t offset = 0; 2 * offset < size; offset += 16) {
+    lanes[0] = Round(lanes[0], Load64(data + offset));
+    lanes[1] = Round(lanes[1], Load64(data + offset + 8));
+    lanes[2] = Round(lanes[2], Load64(end - offset - 16));
+    lanes[3] = Round(lanes[3], Load64(end - offset - 8));
+  }
+  uint64_t hash = RotateLeft(lanes[0], 1) + RotateLeft(lanes[1], 7) +
+                  RotateLeft(lanes[2], 12) + RotateLeft(lanes[3], 18);
+  return Avalanche(hash + size * kPrime64_1);
+}
+
+uint64_t HashLong(const uint8_t* data,
+                  size_t size,
+                  uint64_t seed,
+                  AccumulateFunction accumulate) {
+  uint64_t acc[kNumLanes] = {kPrime32_1, kPrime64_1, kPrime64_2, kPrime64_3};
+
+  // The last stripe is always the last 32 bytes, which overlap the previous
+  // stripe when the size is not a multiple of 32, so it is processed
+  // separately.
+  accumulate(acc, data, (size - 1) / kStripeSize, seed);
+  AccumulateStripe(acc, data + size - kStripeSize,
+                   kSecret.words + kStripesPerBlock, seed);
+
+  uint64_t hash = seed + size * kPrime64_1;
+  for (size_t i = 0; i < kNumLanes; ++i)
+    hash = Round(hash, acc[i] ^ kMergeSecret[i]);
+  return Avalanche(hash);
+}
+
+}  // namespace
+
+uint64_t Hash64WithSeed(span<const uint8_t> data, uint64_t seed) {
+  if (data.size() < kStripeSize)
+    return HashShort(data.data(), data.size(), seed);
+  if (data.size() <= kMaxMediumSize)
+    return HashMedium(data.data(), data.size(), seed);
+#if defined(ARCH_CPU_X86_64)
+  return HashLong(data.data(), data.size(), seed,
+                  CanUseAVX2() ? AccumulateAVX2 : AccumulateSSE2);
+#elif defined(ARCH_CPU_ARM64)
+  return HashLong(data.data(), data.size(), seed, AccumulateNEON);
+#else
+  return HashLong(data.data(), data.size(), seed, AccumulatePortable);
+#endif
+}
+
+namespace internal {
+
+uint64_t Hash64WithSeedPortable(span<const uint8_t> data, uint64_t seed) {
+  if (data.size() < kStripeSize)
+    return HashShort(data.data(), data.size(), seed);
+  if (data.size() <= kMaxMediumSize)
+    return HashMedium(data.data(), data.size(), seed);
+  return HashLong(data.data(), data.size(), seed, AccumulatePortable);
+}
+
+#if defined(ARCH_CPU_X86_64)
+uint64_t Hash64WithSeedSSE2(span<const uint8_t> data, uint64_t seed) {
+  if (data.size() < kStripeSize)
+    return HashShort(data.data(), data.size(), seed);
+  if (data.size() <= kMaxMediumSize)
+    return HashMedium(data.data(), data.size(), seed);
+  return HashLong(data.data(), data.size(), seed, AccumulateSSE2);
+}
+#endif
+
+}  // namespace internal
+
+}  // namespace base
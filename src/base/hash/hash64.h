@@ -0,0 +1,55 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_HASH_HASH64_H_
+#define BASE_HASH_HASH64_H_
+
+#include <stdint.h>
+
+#include "base/base_export.h"
+#include "base/containers/span.h"
+#include "base/strings/string_piece.h"
+#include "build/build_config.h"
+
+namespace base {
+
+// WARNING: These hash functions should not be used for any cryptographic
+// purpose.
+
+// A fast 64-bit hash, for hash tables and content fingerprinting. Inputs of
+// more than 128 bytes are hashed with the multiply-accumulate scheme of XXH3,
+// which processes 32 bytes per iteration and is vectorized with SSE2 or AVX2
+// on x86-64 and NEON on Arm64.
+//
+// The output does not depend on the CPU, so it may be persisted or compared
+// across machines. Different seeds give independent-looking hash functions.
+//
+// Unchanging forever: yes
+BASE_EXPORT uint64_t Hash64WithSeed(span<const uint8_t> data, uint64_t seed);
+inline uint64_t Hash64(span<const uint8_t> data) {
+  return Hash64WithSeed(data, 0);
+}
+inline uint64_t Hash64(StringPiece str) {
+  return Hash64(as_bytes(make_span(str)));
+}
+
+namespace internal {
+
+// Computes the same hash as Hash64WithSeed() without vector instructions.
+// Exposed for testing.
+BASE_EXPORT uint64_t Hash64WithSeedPortable(span<const uint8_t> data,
+                                            uint64_t seed);
+
+#if defined(ARCH_CPU_X86_64)
+// Computes the same hash as Hash64WithSeed() with SSE2 only, which it would
+// otherwise not use on CPUs supporting AVX2. Exposed for testing.
+BASE_EXPORT uint64_t Hash64WithSeedSSE2(span<const uint8_t> data,
+                                        uint64_t seed);
+#endif
+
+}  // namespace internal
+
+}  // namespace base
+
+#endif  // BASE_HASH_HASH64_H_
@@ -0,0 +1,106 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/hash/hash64.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/rand_util.h"
+#include "build/build_config.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+std::vector<uint8_t> GetRandomBytes(size_t size) {
+  std::vector<uint8_t> data(size);
+  RandBytes(data.data(), data.size());
+  return data;
+}
+
+}  // namespace
+
+// The output must never change, since it may be persisted.
+TEST(Hash64Test, KnownValues) {
+  std::string input;
+  for (int i = 0; i < 1000; ++i)
+    input.push_back(static_cast<char>(i % 251));
+  const span<const uint8_t> bytes = as_bytes(make_span(input));
+
+  EXPECT_EQ(0x7d347d62da83483bu, Hash64(bytes.first(0)));
+  EXPECT_EQ(0x8f16d0dbf995ea6bu, Hash64(bytes.first(3)));
+  EXPECT_EQ(0x81c6939231b14b5eu, Hash64(bytes.first(8)));
+  EXPECT_EQ(0x1be9047acdb241f3u, Hash64(bytes.first(31)));
+  EXPECT_EQ(0xf1b4f1e0e8e200c2u, Hash64(bytes.first(32)));
+  EXPECT_EQ(0x18c9efd25f093c34u, Hash64(bytes.first(100)));
+  EXPECT_EQ(0x99300d42cdd22fffu, Hash64(bytes.first(200)));
+  EXPECT_EQ(0xd4ef8cb29e231b70u, Hash64WithSeed(bytes.first(200), 42));
+  EXPECT_EQ(0x79e385706a8f4bc2u, Hash64(bytes));
+  EXPECT_EQ(0x449b9f47fa89f8e0u, Hash64("Hello, world!"));
+}
+
+// The vectorized implementations, if any, and the portable one give the same
+// hashes, whatever the size and alignment of the data.
+TEST(Hash64Test, MatchesPortable) {
+  const std::vector<uint8_t> data = GetRandomBytes(3000);
+  for (size_t size = 0; size < 2000; size += size < 96 ? 1 : 37) {
+    for (size_t offset = 0; offset < 8; ++offset) {
+      const span<const uint8_t> input =
+          span<const uint8_t>(data).subspan(offset, size);
+      for (uint64_t seed : {uint64_t{0}, uint64_t{0x0123456789abcdef}}) {
+        const uint64_t hash = internal::Hash64WithSeedPortable(input, seed);
+        EXPECT_EQ(hash, Hash64WithSeed(input, seed)) << size << " " << offset;
+#if defined(ARCH_CPU_X86_64)
+        EXPECT_EQ(hash, internal::Hash64WithSeedSSE2(input, seed))
+            << size << " " << offset;
+#endif
+      }
+    }
+  }
+}
+
+TEST(Hash64Test, NoCollisionsForShortInputs) {
+  std::set<uint64_t> hashes;
+  size_t count = 0;
+  std::vector<uint8_t> input;
+  for (size_t size = 0; size <= 2; ++size) {
+    input.assign(size, 0);
+    for (size_t value = 0; value < (size_t{1} << (8 * size)); ++value) {
+      for (size_t i = 0; i < size; ++i)
+        input[i] = static_cast<uint8_t>(value >> (8 * i));
+      hashes.insert(Hash64(input));
+      ++count;
+    }
+  }
+  EXPECT_EQ(count, hashes.size());
+}
+
+// Every bit of the input and the seed, and the order of the stripes, affect
+// the hash.
+TEST(Hash64Test, InputChangesHash) {
+  for (size_t size : {1, 4, 9, 16, 31, 32, 33, 100, 512, 600, 1500}) {
+    std::vector<uint8_t> input = GetRandomBytes(size);
+    const uint64_t hash = Hash64(input);
+    EXPECT_NE(hash, Hash64WithSeed(input, 1)) << size;
+    for (size_t bit = 0; bit < 8 * size; ++bit) {
+      input[bit / 8] ^= 1 << (bit % 8);
+      EXPECT_NE(hash, Hash64(input)) << size << " " << bit;
+      input[bit / 8] ^= 1 << (bit % 8);
+    }
+  }
+
+  // Large enough to go through the stripe loop rather than HashMedium().
+  std::vector<uint8_t> input = GetRandomBytes(600);
+  const uint64_t hash = Hash64(input);
+  std::swap_ranges(input.begin(), input.begin() + 32, input.begin() + 32);
+  EXPECT_NE(hash, Hash64(input));
+}
+
+}  // namespace base
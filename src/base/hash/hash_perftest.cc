@@ -6,10 +6,14 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <algorithm>
 #include <string>
 #include <vector>
 
+#include "base/hash/crc32c.h"
 #include "base/hash/hash.h"
+#include "base/hash/hash64.h"
+#include "base/metrics/crc32.h"
 #include "base/rand_util.h"
 #include "base/ranges/algorithm.h"
 #include "base/strings/string_number_conversions.h"
@@ -31,6 +35,36 @@ void FastHash(void* data, size_t size) {
   base::Hash(reinterpret_cast<uint8_t*>(data), size);
 }
 
+void Crc32cHash(void* data, size_t size) {
+  Crc32c(0, make_span(reinterpret_cast<uint8_t*>(data), size));
+}
+
+void Crc32cPortableHash(void* data, size_t size) {
+  internal::Crc32cPortable(0,
+                           make_span(reinterpret_cast<uint8_t*>(data), size));
+}
+
+void Crc32Hash(void* data, size_t size) {
+  Crc32(0, data, size);
+}
+
+void Hash64Hash(void* data, size_t size) {
+  Hash64(make_span(reinterpret_cast<uint8_t*>(data), size));
+}
+
+void Hash64PortableHash(void* data, size_t size) {
+  internal::Hash64WithSeedPortable(
+      make_span(reinterpret_cast<uint8_t*>(data), size), 0);
+}
+
+// base::FastHash() is CityHash64 on 64-bit platforms.
+void CityHash(void* data, size_t size) {
+  base::FastHash(make_span(reinterpret_cast<uint8_t*>(data), size));
+}
+
+// Sizes from hash table keys to file contents.
+constexpr size_t kInputSizes[] = {16, 64, 256, 4096, 64 * 1024, 1024 * 1024};
+
 void RunTest(const char* hash_name,
              void (*hash)(void*, size_t),
              const size_t len) {
@@ -47,6 +81,10 @@ void RunTest(const char* hash_name,
   reporter.RegisterImportantMetric(kMetricMedianThroughput, "bytesPerSecond");
 
   constexpr int kNumRuns = 111;
+  // Small inputs are hashed repeatedly in each run, so that the runs last
+  // longer than the resolution of the clock.
+  constexpr size_t kMinBytesPerRun = 64 * 1024;
+  const size_t hashes_per_run = std::max<size_t>(1, kMinBytesPerRun / len);
   std::vector<TimeDelta> utime(kNumRuns);
   TimeDelta total_test_time;
   {
@@ -55,7 +93,8 @@ void RunTest(const char* hash_name,
 
     for (int i = 0; i < kNumRuns; ++i) {
       const auto start = TimeTicks::Now();
-      hash(buf.data(), len);
+      for (size_t j = 0; j < hashes_per_run; ++j)
+        hash(buf.data(), len);
       utime[i] = TimeTicks::Now() - start;
       total_test_time += utime[i];
     }
@@ -70,8 +109,8 @@ void RunTest(const char* hash_name,
   // MB/s = (len * 1,000,000)/(usecs * 1,000,000)
   // MB/s = len/utime
   constexpr int kBytesPerMegabyte = 1'000'000;
-  const auto rate = [len](TimeDelta t) {
-    return kBytesPerMegabyte * (len / t.InMicrosecondsF());
+  const auto rate = [len, hashes_per_run](TimeDelta t) {
+    return kBytesPerMegabyte * (len * hashes_per_run / t.InMicrosecondsF());
   };
 
   reporter.AddResult(kMetricMedianThroughput, rate(utime[kNumRuns / 2]));
@@ -97,4 +136,20 @@ TEST(HashPerfTest, Speed) {
   }
 }
 
+TEST(Crc32cPerfTest, Speed) {
+  for (size_t len : kInputSizes) {
+    RunTest("Crc32c.", Crc32cHash, len);
+    RunTest("Crc32cPortable.", Crc32cPortableHash, len);
+    RunTest("Crc32.", Crc32Hash, len);
+  }
+}
+
+TEST(Hash64PerfTest, Speed) {
+  for (size_t len : kInputSizes) {
+    RunTest("Hash64.", Hash64Hash, len);
+    RunTest("Hash64Portable.", Hash64PortableHash, len);
+    RunTest("CityHash64.", CityHash, len);
+  }
+}
+
 }  // namespace base
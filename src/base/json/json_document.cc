@@ -0,0 +1,387 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_document.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+
+#include "base/bits.h"
+#include "base/check_op.h"
+#include "base/json/json_stream_reader.h"
+#include "base/notreached.h"
+#include "base/numerics/safe_conversions.h"
+
+namespace base {
+
+namespace {
+
+// The arena starts small so that small documents stay cheap, and grows
+// geometrically up to a cap so that large ones need few blocks.
+constexpr size_t kMinBlockSize = 4 * 1024;
+constexpr size_t kMaxBlockSize = 1024 * 1024;
+
+// Dictionaries with at most this many members are searched for an interned
+// key by comparing addresses in order, rather than by binary search.
+constexpr size_t kMaxMembersForLinearSearch = 16;
+
+bool MemberKeyLess(const JSONDocument::Member& a,
+                   const JSONDocument::Member& b) {
+  return a.key() < b.key();
+}
+
+}  // namespace
+
+// Arena ///////////////////////////////////////////////////////////////////////
+
+JSONDocument::Arena::Arena() : next_block_size_(kMinBlockSize) {}
+
+JSONDocument::Arena::Arena(Arena&& other) = default;
+
+JSONDocument::Arena& JSONDocument::Arena::operator=(Arena&& other) = default;
+
+JSONDocument::Arena::~Arena() = default;
+
+void* JSONDocument::Arena::Allocate(size_t size, size_t alignment) {
+  DCHECK(bits::IsPowerOfTwo(alignment));
+  DCHECK_LE(alignment, alignof(std::max_align_t));
+
+  if (next_) {
+    char* aligned = bits::AlignUp(next_, alignment);
+    if (aligned <= end_ && static_cast<size_t>(end_ - aligned) >= size) {
+      next_ = aligned + size;
+      return aligned;
+    }
+  }
+
+  // Start a new block. Blocks from operator new[] are suitably aligned for
+  // any type.
+  const size_t block_size = std::max(next_block_size_, size);
+  blocks_.push_back(std::unique_ptr<char[]>(new char[block_size]));
+  reserved_bytes_ += block_size;
+  next_block_size_ = std::min(next_block_size_ * 2, kMaxBlockSize);
+
+  char* block = blocks_.back().get();
+  next_ = block + size;
+  end_ = block + block_size;
+  return block;
+}
+
+// Builder /////////////////////////////////////////////////////////////////////
+
+// Builds the tree from parse events. Children are collected on scratch stacks
+// that are reused across containers, and copied into the arena in one piece
+// once the container is complete, so every list and dictionary ends up as a
+// single contiguous array.
+class JSONDocument::Builder : public JSONStreamReader::Delegate {
+ public:
+  // Strings and keys within |referenced_input| are referenced rather than
+  // copied into |arena|.
+  Builder(Arena* arena, KeyTable* keys, StringPiece referenced_input)
+      : arena_(arena), keys_(keys), referenced_input_(referenced_input) {}
+  Builder(const Builder&) = delete;
+  Builder& operator=(const Builder&) = delete;
+  ~Builder() override = default;
+
+  // Returns the root node, allocated in the arena.
+  const Node* TakeRoot() {
+    DCHECK(containers_.empty());
+    return arena_->AllocateCopy(&root_, 1);
+  }
+
+  // JSONStreamReader::Delegate:
+  bool OnDictStart() override {
+    containers_.push_back({/*is_dict=*/true, members_.size()});
+    return true;
+  }
+
+  bool OnDictKey(StringPiece key) override {
+    Member member;
+    member.interned_key = InternKey(key);
+    members_.push_back(member);
+    return true;
+  }
+
+  bool OnDictEnd() override {
+    const size_t first = containers_.back().first_child;
+    containers_.pop_back();
+
+    // Sort by key and keep the last of equal keys, matching JSONReader.
+    const auto begin = members_.begin() + static_cast<ptrdiff_t>(first);
+    std::stable_sort(begin, members_.end(), &MemberKeyLess);
+    auto out = begin;
+    for (auto it = begin; it != members_.end(); ++it) {
+      if (std::next(it) != members_.end() &&
+          it->interned_key == std::next(it)->interned_key) {
+        continue;
+      }
+      *out++ = *it;
+    }
+
+    Node node;
+    node.type_ = Value::Type::DICT;
+    node.size_ = checked_cast<uint32_t>(out - begin);
+    node.dict_value_ =
+        arena_->AllocateCopy(members_.data() + first, node.size_);
+    members_.erase(begin, members_.end());
+    AddValue(node);
+    return true;
+  }
+
+  bool OnListStart() override {
+    containers_.push_back({/*is_dict=*/false, nodes_.size()});
+    return true;
+  }
+
+  bool OnListEnd() override {
+    const size_t first = containers_.back().first_child;
+    containers_.pop_back();
+
+    Node node;
+    node.type_ = Value::Type::LIST;
+    node.size_ = checked_cast<uint32_t>(nodes_.size() - first);
+    node.list_value_ = arena_->AllocateCopy(nodes_.data() + first, node.size_);
+    nodes_.erase(nodes_.begin() + static_cast<ptrdiff_t>(first), nodes_.end());
+    AddValue(node);
+    return true;
+  }
+
+  bool OnScalar(Value value) override {
+    Node node;
+    node.type_ = value.type();
+    switch (value.type()) {
+      case Value::Type::NONE:
+        break;
+      case Value::Type::BOOLEAN:
+        node.bool_value_ = value.GetBool();
+        break;
+      case Value::Type::INTEGER:
+        node.int_value_ = value.GetInt();
+        break;
+      case Value::Type::DOUBLE:
+        node.double_value_ = value.GetDouble();
+        break;
+      case Value::Type::STRING:
+        node.size_ = checked_cast<uint32_t>(value.GetString().size());
+        node.string_value_ = CopyString(value.GetString());
+        break;
+      case Value::Type::BINARY:
+      case Value::Type::DICT:
+      case Value::Type::LIST:
+        NOTREACHED();
+        return false;
+    }
+    AddValue(node);
+    return true;
+  }
+
+  bool OnUnescapedString(StringPiece value) override {
+    Node node;
+    node.type_ = Value::Type::STRING;
+    node.size_ = checked_cast<uint32_t>(value.size());
+    node.string_value_ = ReferenceOrCopyString(value);
+    AddValue(node);
+    return true;
+  }
+
+ private:
+  struct Container {
+    bool is_dict;
+    // Index of the first child on |members_| or |nodes_|.
+    size_t first_child;
+  };
+
+  const char* CopyString(StringPiece string) {
+    return arena_->AllocateCopy(string.data(), string.size());
+  }
+
+  const char* ReferenceOrCopyString(StringPiece string) {
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(string.data());
+    const uintptr_t input_begin =
+        reinterpret_cast<uintptr_t>(referenced_input_.data());
+    if (begin >= input_begin &&
+        begin + string.size() <= input_begin + referenced_input_.size()) {
+      return string.data();
+    }
+    return CopyString(string);
+  }
+
+  const Key* InternKey(StringPiece key) {
+    auto it = keys_->find(key);
+    if (it != keys_->end())
+      return it->second;
+
+    Key interned;
+    interned.data_ = ReferenceOrCopyString(key);
+    interned.size_ = key.size();
+    const Key* result = arena_->AllocateCopy(&interned, 1);
+    keys_->emplace(result->str(), result);
+    return result;
+  }
+
+  void AddValue(const Node& node) {
+    if (containers_.empty())
+      root_ = node;
+    else if (containers_.back().is_dict)
+      members_.back().value = node;
+    else
+      nodes_.push_back(node);
+  }
+
+  const raw_ptr<Arena> arena_;
+  const raw_ptr<KeyTable> keys_;
+  const StringPiece referenced_input_;
+  std::vector<Container> containers_;
+  std::vector<Member> members_;
+  std::vector<Node> nodes_;
+  Node root_;
+};
+
+// Node ////////////////////////////////////////////////////////////////////////
+
+bool JSONDocument::Node::GetBool() const {
+  CHECK(is_bool());
+  return bool_value_;
+}
+
+int JSONDocument::Node::GetInt() const {
+  CHECK(is_int());
+  return int_value_;
+}
+
+double JSONDocument::Node::GetDouble() const {
+  if (is_double())
+    return double_value_;
+  CHECK(is_int());
+  return int_value_;
+}
+
+StringPiece JSONDocument::Node::GetString() const {
+  CHECK(is_string());
+  return StringPiece(string_value_, size_);
+}
+
+span<const JSONDocument::Node> JSONDocument::Node::GetList() const {
+  CHECK(is_list());
+  return make_span(list_value_, size_);
+}
+
+span<const JSONDocument::Member> JSONDocument::Node::GetDict() const {
+  CHECK(is_dict());
+  return make_span(dict_value_, size_);
+}
+
+const JSONDocument::Node* JSONDocument::Node::FindKey(StringPiece key) const {
+  span<const Member> members = GetDict();
+  auto it = std::lower_bound(
+      members.begin(), members.end(), key,
+      [](const Member& member, StringPiece key) { return member.key() < key; });
+  if (it == members.end() || it->key() != key)
+    return nullptr;
+  return &it->value;
+}
+
+const JSONDocument::Node* JSONDocument::Node::FindKey(const Key* key) const {
+  span<const Member> members = GetDict();
+  if (!key)
+    return nullptr;
+  if (members.size() > kMaxMembersForLinearSearch)
+    return FindKey(key->str());
+  for (const Member& member : members) {
+    if (member.interned_key == key)
+      return &member.value;
+  }
+  return nullptr;
+}
+
+Value JSONDocument::Node::ToValue() const {
+  switch (type()) {
+    case Value::Type::NONE:
+      return Value();
+    case Value::Type::BOOLEAN:
+      return Value(GetBool());
+    case Value::Type::INTEGER:
+      return Value(GetInt());
+    case Value::Type::DOUBLE:
+      return Value(GetDouble());
+    case Value::Type::STRING:
+      return Value(GetString());
+    case Value::Type::DICT: {
+      Value::Dict dict;
+      for (const Member& member : GetDict())
+        dict.Set(member.key(), member.value.ToValue());
+      return Value(std::move(dict));
+    }
+    case Value::Type::LIST: {
+      Value::List list;
+      list.reserve(size_);
+      for (const Node& node : GetList())
+        list.Append(node.ToValue());
+      return Value(std::move(list));
+    }
+    case Value::Type::BINARY:
+      break;
+  }
+  NOTREACHED();
+  return Value();
+}
+
+// JSONDocument ////////////////////////////////////////////////////////////////
+
+// static
+absl::optional<JSONDocument> JSONDocument::Parse(StringPiece json,
+                                                 int options,
+                                                 size_t max_depth,
+                                                 JSONReader::Error* error) {
+  return ParseImpl(json, /*reference_input=*/false, options, max_depth, error);
+}
+
+// static
+absl::optional<JSONDocument> JSONDocument::ParseReferencingInput(
+    StringPiece json,
+    int options,
+    size_t max_depth,
+    JSONReader::Error* error) {
+  return ParseImpl(json, /*reference_input=*/true, options, max_depth, error);
+}
+
+// static
+absl::optional<JSONDocument> JSONDocument::ParseImpl(StringPiece json,
+                                                     bool reference_input,
+                                                     int options,
+                                                     size_t max_depth,
+                                                     JSONReader::Error* error) {
+  JSONDocument document;
+  Builder builder(&document.arena_, &document.keys_,
+                  reference_input ? json : StringPiece());
+  JSONStreamReader reader(&builder, options, max_depth);
+  if (!reader.Feed(json) || !reader.Finish()) {
+    // The builder never stops parsing, so failure always comes with an error.
+    DCHECK(reader.error());
+    if (error) {
+      error->message = reader.error()->message;
+      error->line = reader.error()->line;
+      error->column = reader.error()->column;
+    }
+    return absl::nullopt;
+  }
+  document.root_ = builder.TakeRoot();
+  return document;
+}
+
+const JSONDocument::Key* JSONDocument::FindInternedKey(StringPiece key) const {
+  auto it = keys_.find(key);
+  return it != keys_.end() ? it->second : nullptr;
+}
+
+JSONDocument::JSONDocument() = default;
+
+JSONDocument::JSONDocument(JSONDocument&& other) = default;
+
+JSONDocument& JSONDocument::operator=(JSONDocument&& other) = default;
+
+JSONDocument::~JSONDocument() = default;
+
+}  // namespace base
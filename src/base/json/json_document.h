@@ -0,0 +1,231 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_JSON_JSON_DOCUMENT_H_
+#define BASE_JSON_JSON_DOCUMENT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/check.h"
+#include "base/containers/span.h"
+#include "base/json/json_common.h"
+#include "base/json/json_reader.h"
+#include "base/memory/raw_ptr.h"
+#include "base/strings/string_piece.h"
+#include "base/values.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
+
+namespace base {
+
+// An immutable JSON value tree whose nodes, keys and strings all live in a
+// single arena owned by the document. Building the tree costs a pointer bump
+// per node instead of a heap allocation, and destroying it releases a handful
+// of large blocks instead of freeing every node, key and string.
+//
+// Use this instead of JSONReader::Read() for large documents that are only
+// read after parsing. The tree cannot be modified; call Node::ToValue() to
+// get a mutable base::Value for (part of) it.
+//
+// Example:
+//   absl::optional<JSONDocument> document = JSONDocument::Parse(json);
+//   if (!document)
+//     return;
+//   const JSONDocument::Node* name = document->root().FindKey("name");
+//   if (name && name->is_string())
+//     Use(name->GetString());
+//
+// Dictionary keys are interned: each distinct key is stored once per document
+// however many dictionaries use it. To look up the same key in many
+// dictionaries, intern it once and compare by address:
+//   const JSONDocument::Key* id_key = document->FindInternedKey("id");
+//   for (const JSONDocument::Node& record : document->root().GetList()) {
+//     if (const JSONDocument::Node* id = record.FindKey(id_key))
+//       Use(id->GetInt());
+//   }
+class BASE_EXPORT JSONDocument {
+ private:
+  class Builder;
+
+ public:
+  struct Member;
+
+  // An interned dictionary key. All dictionary members of a document with
+  // the same key refer to the same Key, so Keys from one document are equal
+  // exactly when their addresses are.
+  class BASE_EXPORT Key {
+   public:
+    StringPiece str() const { return StringPiece(data_, size_); }
+
+   private:
+    friend class Builder;
+
+    Key() = default;
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+  };
+
+  // A single value in the document. Nodes refer to memory owned by the
+  // JSONDocument they come from, and must not outlive it.
+  class BASE_EXPORT Node {
+   public:
+    Value::Type type() const { return type_; }
+
+    bool is_none() const { return type() == Value::Type::NONE; }
+    bool is_bool() const { return type() == Value::Type::BOOLEAN; }
+    bool is_int() const { return type() == Value::Type::INTEGER; }
+    bool is_double() const { return type() == Value::Type::DOUBLE; }
+    bool is_string() const { return type() == Value::Type::STRING; }
+    bool is_dict() const { return type() == Value::Type::DICT; }
+    bool is_list() const { return type() == Value::Type::LIST; }
+
+    // These will all CHECK that the type matches, like their Value
+    // counterparts.
+    bool GetBool() const;
+    int GetInt() const;
+    // Returns an int as a double, like Value::GetDouble().
+    double GetDouble() const;
+    StringPiece GetString() const;
+    span<const Node> GetList() const;
+    // Dictionary members are sorted by key, and keys are unique. As with
+    // JSONReader, the last of several members with the same key wins.
+    span<const Member> GetDict() const;
+
+    // Returns the member of a dictionary named |key|, or nullptr. CHECKs that
+    // this is a dictionary.
+    const Node* FindKey(StringPiece key) const;
+    // As above, for a |key| interned in the same document; returns nullptr if
+    // |key| is null. Cheaper than looking up the key by name, since members
+    // are compared by address.
+    const Node* FindKey(const Key* key) const;
+
+    // Returns a deep copy of this node as a base::Value.
+    Value ToValue() const;
+
+   private:
+    friend class Builder;
+    friend struct Member;
+
+    Node() = default;
+
+    Value::Type type_ = Value::Type::NONE;
+    // The length of a string or the number of elements of a list or dict.
+    uint32_t size_ = 0;
+    union {
+      bool bool_value_;
+      int int_value_;
+      double double_value_;
+      const char* string_value_;
+      const Node* list_value_;
+      const Member* dict_value_;
+    };
+  };
+
+  struct Member {
+    StringPiece key() const { return interned_key->str(); }
+
+    const Key* interned_key = nullptr;
+    Node value;
+  };
+
+  // Parses |json| like JSONReader::Read(). Returns nullopt if |json| is not
+  // valid, in which case |error|, if non-null, is filled in.
+  static absl::optional<JSONDocument> Parse(
+      StringPiece json,
+      int options = JSON_PARSE_CHROMIUM_EXTENSIONS,
+      size_t max_depth = internal::kAbsoluteMaxDepth,
+      JSONReader::Error* error = nullptr);
+
+  // Like Parse(), but strings and keys that need no decoding refer to |json|
+  // instead of being copied into the document, so |json| must stay unchanged
+  // for as long as the document is used. Suited to input that is kept alive
+  // anyway, such as a MemoryMappedFile, when only parts of it are read.
+  static absl::optional<JSONDocument> ParseReferencingInput(
+      StringPiece json,
+      int options = JSON_PARSE_CHROMIUM_EXTENSIONS,
+      size_t max_depth = internal::kAbsoluteMaxDepth,
+      JSONReader::Error* error = nullptr);
+
+  JSONDocument(JSONDocument&& other);
+  JSONDocument& operator=(JSONDocument&& other);
+
+  JSONDocument(const JSONDocument&) = delete;
+  JSONDocument& operator=(const JSONDocument&) = delete;
+
+  ~JSONDocument();
+
+  const Node& root() const { return *root_; }
+
+  // Returns the interned key equal to |key|, or nullptr if no dictionary in
+  // the document has a member named |key|.
+  const Key* FindInternedKey(StringPiece key) const;
+
+  // Returns the number of bytes reserved by the arena. Input referenced by
+  // documents from ParseReferencingInput() is not included.
+  size_t arena_size() const { return arena_.reserved_bytes(); }
+
+ private:
+  // A bump allocator. Memory is only returned when the arena is destroyed.
+  class Arena {
+   public:
+    Arena();
+    Arena(Arena&& other);
+    Arena& operator=(Arena&& other);
+    ~Arena();
+
+    // Returns |size| bytes aligned to |alignment|, which must be a power of
+    // two no larger than alignof(std::max_align_t).
+    void* Allocate(size_t size, size_t alignment);
+
+    // Allocates an array of |count| copies of trivially copyable |T|,
+    // initialized from |values|.
+    template <typename T>
+    T* AllocateCopy(const T* values, size_t count) {
+      static_assert(std::is_trivially_copyable<T>::value, "");
+      if (!count)
+        return nullptr;
+      T* copy = static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+      memcpy(copy, values, sizeof(T) * count);
+      return copy;
+    }
+
+    size_t reserved_bytes() const { return reserved_bytes_; }
+
+   private:
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    char* next_ = nullptr;
+    char* end_ = nullptr;
+    size_t next_block_size_;
+    size_t reserved_bytes_ = 0;
+  };
+
+  using KeyTable = std::unordered_map<StringPiece, const Key*, StringPieceHash>;
+
+  JSONDocument();
+
+  // Implements Parse() and ParseReferencingInput().
+  static absl::optional<JSONDocument> ParseImpl(StringPiece json,
+                                                bool reference_input,
+                                                int options,
+                                                size_t max_depth,
+                                                JSONReader::Error* error);
+
+  Arena arena_;
+  raw_ptr<const Node> root_ = nullptr;
+  // Every distinct dictionary key in the document. The keys point into
+  // |arena_|.
+  KeyTable keys_;
+};
+
+}  // namespace base
+
+#endif  // BASE_JSON_JSON_DOCUMENT_H_
@@ -0,0 +1,254 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_document.h"
+
+#include <string>
+#include <utility>
+
+#include "base/json/json_reader.h"
+#include "base/json/json_writer.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
+
+namespace base {
+
+TEST(JSONDocumentTest, MatchesJSONReader) {
+  const char* const kDocuments[] = {
+      "null",
+      "true",
+      "-12.5e3",
+      "2147483647",
+      "4294967296",
+      "\"\\u00e9t\\u00e9\"",
+      "\xEF\xBB\xBF[1, 2, 3]",
+      "[]",
+      "{}",
+      "{\"a\": {\"b\": [1, {\"c\": null}, [], \"d\"]}, \"e\": false}",
+      "{\"z\": 1, \"a\": 2, \"m\": [3, 4]}",
+      "[[[[\"deep\"]]], {\"\": \"empty key\"}]",
+  };
+  for (const char* json : kDocuments) {
+    SCOPED_TRACE(json);
+    absl::optional<Value> expected = JSONReader::Read(json);
+    ASSERT_TRUE(expected);
+    absl::optional<JSONDocument> document = JSONDocument::Parse(json);
+    ASSERT_TRUE(document);
+    EXPECT_EQ(*expected, document->root().ToValue());
+  }
+}
+
+TEST(JSONDocumentTest, Accessors) {
+  absl::optional<JSONDocument> document = JSONDocument::Parse(
+      "{\"int\": 3, \"double\": 0.5, \"bool\": true, \"null\": null,"
+      " \"string\": \"abc\", \"list\": [1, \"two\"], \"dict\": {\"x\": 1}}");
+  ASSERT_TRUE(document);
+  const JSONDocument::Node& root = document->root();
+  ASSERT_TRUE(root.is_dict());
+  EXPECT_EQ(7u, root.GetDict().size());
+
+  const JSONDocument::Node* node = root.FindKey("int");
+  ASSERT_TRUE(node);
+  EXPECT_EQ(3, node->GetInt());
+  EXPECT_EQ(3.0, node->GetDouble());
+
+  node = root.FindKey("double");
+  ASSERT_TRUE(node);
+  EXPECT_EQ(0.5, node->GetDouble());
+
+  node = root.FindKey("bool");
+  ASSERT_TRUE(node);
+  EXPECT_TRUE(node->GetBool());
+
+  node = root.FindKey("null");
+  ASSERT_TRUE(node);
+  EXPECT_TRUE(node->is_none());
+
+  node = root.FindKey("string");
+  ASSERT_TRUE(node);
+  EXPECT_EQ("abc", node->GetString());
+
+  node = root.FindKey("list");
+  ASSERT_TRUE(node);
+  ASSERT_EQ(2u, node->GetList().size());
+  EXPECT_EQ(1, node->GetList()[0].GetInt());
+  EXPECT_EQ("two", node->GetList()[1].GetString());
+
+  node = root.FindKey("dict");
+  ASSERT_TRUE(node);
+  ASSERT_TRUE(node->FindKey("x"));
+  EXPECT_EQ(1, node->FindKey("x")->GetInt());
+
+  EXPECT_FALSE(root.FindKey("missing"));
+  EXPECT_FALSE(root.FindKey(""));
+}
+
+TEST(JSONDocumentTest, DictionaryMembersAreSorted) {
+  absl::optional<JSONDocument> document =
+      JSONDocument::Parse("{\"c\": 1, \"a\": 2, \"b\": 3}");
+  ASSERT_TRUE(document);
+  auto members = document->root().GetDict();
+  ASSERT_EQ(3u, members.size());
+  EXPECT_EQ("a", members[0].key());
+  EXPECT_EQ("b", members[1].key());
+  EXPECT_EQ("c", members[2].key());
+}
+
+TEST(JSONDocumentTest, DuplicateKeys) {
+  // Like JSONReader, the last value for a key wins.
+  const char kJson[] = "{\"dup\": 1, \"other\": 2, \"dup\": {\"dup\": 3}}";
+  absl::optional<JSONDocument> document = JSONDocument::Parse(kJson);
+  ASSERT_TRUE(document);
+  EXPECT_EQ(2u, document->root().GetDict().size());
+  const JSONDocument::Node* dup = document->root().FindKey("dup");
+  ASSERT_TRUE(dup);
+  ASSERT_TRUE(dup->is_dict());
+  EXPECT_EQ(3, dup->FindKey("dup")->GetInt());
+  EXPECT_EQ(*JSONReader::Read(kJson), document->root().ToValue());
+}
+
+TEST(JSONDocumentTest, InternedKeys) {
+  absl::optional<JSONDocument> document = JSONDocument::Parse(
+      "[{\"id\": 1, \"name\": \"a\"}, {\"name\": \"b\", \"id\": 2},"
+      " {\"other\": {\"id\": 3}}]");
+  ASSERT_TRUE(document);
+  auto records = document->root().GetList();
+  ASSERT_EQ(3u, records.size());
+
+  // Every member with the same key shares one Key.
+  const JSONDocument::Key* id_key = document->FindInternedKey("id");
+  ASSERT_TRUE(id_key);
+  EXPECT_EQ("id", id_key->str());
+  for (const JSONDocument::Member& member : records[1].GetDict()) {
+    if (member.key() == "id")
+      EXPECT_EQ(id_key, member.interned_key);
+  }
+
+  EXPECT_EQ(1, records[0].FindKey(id_key)->GetInt());
+  EXPECT_EQ(2, records[1].FindKey(id_key)->GetInt());
+  EXPECT_FALSE(records[2].FindKey(id_key));
+  EXPECT_EQ(3, records[2].FindKey("other")->FindKey(id_key)->GetInt());
+
+  // Keys that appear in no dictionary are not interned.
+  EXPECT_FALSE(document->FindInternedKey("missing"));
+  EXPECT_FALSE(records[0].FindKey(document->FindInternedKey("missing")));
+  // Nor are strings that only appear as values.
+  EXPECT_FALSE(document->FindInternedKey("a"));
+}
+
+TEST(JSONDocumentTest, InternedKeysInLargeDictionary) {
+  std::string json = "{";
+  for (int i = 0; i < 100; ++i)
+    json += "\"key" + NumberToString(i) + "\": " + NumberToString(i) + ",";
+  json.back() = '}';
+  absl::optional<JSONDocument> document = JSONDocument::Parse(json);
+  ASSERT_TRUE(document);
+  for (int i = 0; i < 100; ++i) {
+    const JSONDocument::Key* key =
+        document->FindInternedKey("key" + NumberToString(i));
+    ASSERT_TRUE(key);
+    const JSONDocument::Node* node = document->root().FindKey(key);
+    ASSERT_TRUE(node);
+    EXPECT_EQ(i, node->GetInt());
+  }
+}
+
+TEST(JSONDocumentTest, ParseReferencingInput) {
+  const std::string json =
+      "{\"plain\": \"value\", \"esc\\u0061ped\": \"line\\nbreak\","
+      " \"list\": [\"a\", \"\"]}";
+  absl::optional<JSONDocument> document =
+      JSONDocument::ParseReferencingInput(json);
+  ASSERT_TRUE(document);
+  EXPECT_EQ(*JSONReader::Read(json), document->root().ToValue());
+
+  const auto in_input = [&json](StringPiece string) {
+    return string.data() >= json.data() &&
+           string.data() + string.size() <= json.data() + json.size();
+  };
+
+  // Strings that needed no decoding point into the input.
+  const JSONDocument::Node* plain = document->root().FindKey("plain");
+  ASSERT_TRUE(plain);
+  EXPECT_TRUE(in_input(plain->GetString()));
+  EXPECT_TRUE(in_input(document->FindInternedKey("plain")->str()));
+  const JSONDocument::Node* list = document->root().FindKey("list");
+  ASSERT_TRUE(list);
+  EXPECT_TRUE(in_input(list->GetList()[0].GetString()));
+
+  // Decoded strings and keys are copied.
+  const JSONDocument::Node* escaped = document->root().FindKey("escaped");
+  ASSERT_TRUE(escaped);
+  EXPECT_EQ("line\nbreak", escaped->GetString());
+  EXPECT_FALSE(in_input(escaped->GetString()));
+  EXPECT_FALSE(in_input(document->FindInternedKey("escaped")->str()));
+}
+
+TEST(JSONDocumentTest, ParseReferencingInputUsesLessArena) {
+  Value::List list;
+  for (int i = 0; i < 1000; ++i)
+    list.Append(std::string(200, 'a' + i % 26));
+  std::string json;
+  ASSERT_TRUE(JSONWriter::Write(list, &json));
+
+  absl::optional<JSONDocument> copied = JSONDocument::Parse(json);
+  absl::optional<JSONDocument> referencing =
+      JSONDocument::ParseReferencingInput(json);
+  ASSERT_TRUE(copied);
+  ASSERT_TRUE(referencing);
+  EXPECT_EQ(copied->root().ToValue(), referencing->root().ToValue());
+  EXPECT_GE(copied->arena_size(), json.size());
+  EXPECT_LT(referencing->arena_size(), json.size() / 4);
+}
+
+TEST(JSONDocumentTest, Errors) {
+  const char* const kInvalidDocuments[] = {
+      "",
+      "{\"foo\": }",
+      "[1, 2",
+      "[1] trailing",
+  };
+  for (const char* json : kInvalidDocuments) {
+    SCOPED_TRACE(json);
+    auto expected = JSONReader::ReadAndReturnValueWithError(json);
+    ASSERT_FALSE(expected.has_value());
+
+    JSONReader::Error error;
+    EXPECT_FALSE(JSONDocument::Parse(json, JSON_PARSE_CHROMIUM_EXTENSIONS,
+                                     internal::kAbsoluteMaxDepth, &error));
+    EXPECT_EQ(expected.error().message, error.message);
+    EXPECT_EQ(expected.error().line, error.line);
+    EXPECT_EQ(expected.error().column, error.column);
+  }
+}
+
+TEST(JSONDocumentTest, LargeDocument) {
+  Value::List list;
+  for (int i = 0; i < 10000; ++i) {
+    Value::Dict dict;
+    dict.Set("index", i);
+    dict.Set("name", std::string(i % 300, 'a' + i % 26));
+    list.Append(std::move(dict));
+  }
+  Value expected(std::move(list));
+  std::string json;
+  ASSERT_TRUE(JSONWriter::Write(expected, &json));
+
+  absl::optional<JSONDocument> document = JSONDocument::Parse(json);
+  ASSERT_TRUE(document);
+  EXPECT_EQ(expected, document->root().ToValue());
+  // All nodes and strings live in the arena, which is not much larger than
+  // the input.
+  EXPECT_GE(document->arena_size(), json.size() / 2);
+  EXPECT_LE(document->arena_size(), json.size() * 4);
+
+  // Moving the document keeps its nodes valid.
+  JSONDocument moved = std::move(*document);
+  document.reset();
+  EXPECT_EQ(expected, moved.root().ToValue());
+}
+
+}  // namespace base
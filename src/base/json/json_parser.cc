@@ -9,6 +9,11 @@
 #include <utility>
 #include <vector>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "base/bits.h"
 #include "base/check_op.h"
 #include "base/json/json_reader.h"
 #include "base/metrics/histogram_functions.h"
@@ -91,6 +96,80 @@ enum class ChromiumJsonExtension {
 const char kExtensionHistogramName[] =
     "Security.JSONParser.ChromiumExtensionUsage";
 
+// Returns true if |c| can be copied verbatim into a string value without
+// decoding: printable ASCII other than the quotation mark and reverse solidus.
+constexpr bool IsVerbatimStringChar(char c) {
+  return c >= 0x20 && c != '"' && c != '\\' &&
+         static_cast<unsigned char>(c) < kExtendedASCIIStart;
+}
+
+// Returns the number of leading bytes of |input| for which
+// IsVerbatimStringChar() is true. Strings are scanned 16 bytes at a time
+// where SSE2 is available; the scalar loop handles the tail.
+size_t CountVerbatimStringChars(StringPiece input) {
+  const char* const begin = input.data();
+  const char* const end = begin + input.size();
+  const char* p = begin;
+#ifdef __SSE2__
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  // Bytes >= 0x80 are negative when compared as signed, so a single signed
+  // comparison against ' ' flags both control characters and non-ASCII bytes.
+  const __m128i space = _mm_set1_epi8(' ');
+  while (end - p >= 16) {
+    const __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i special = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                     _mm_cmpeq_epi8(chunk, backslash)),
+        _mm_cmplt_epi8(chunk, space));
+    const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(special));
+    if (mask != 0)
+      return static_cast<size_t>(p - begin) + bits::CountTrailingZeroBits(mask);
+    p += 16;
+  }
+#endif
+  while (p < end && IsVerbatimStringChar(*p))
+    ++p;
+  return static_cast<size_t>(p - begin);
+}
+
+// Returns the number of leading spaces and tabs in |input|. Line breaks are
+// not included since the parser must count them.
+size_t CountSpacesAndTabs(StringPiece input) {
+  const char* const begin = input.data();
+  const char* const end = begin + input.size();
+  const char* p = begin;
+#ifdef __SSE2__
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i tab = _mm_set1_epi8('\t');
+  while (end - p >= 16) {
+    const __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i blank = _mm_or_si128(_mm_cmpeq_epi8(chunk, space),
+                                       _mm_cmpeq_epi8(chunk, tab));
+    const uint32_t mask =
+        ~static_cast<uint32_t>(_mm_movemask_epi8(blank)) & 0xffffu;
+    if (mask != 0)
+      return static_cast<size_t>(p - begin) + bits::CountTrailingZeroBits(mask);
+    p += 16;
+  }
+#endif
+  while (p < end && (*p == ' ' || *p == '\t'))
+    ++p;
+  return static_cast<size_t>(p - begin);
+}
+
+// Returns the number of leading ASCII digits in |input|.
+size_t CountDigits(StringPiece input) {
+  const char* const begin = input.data();
+  const char* const end = begin + input.size();
+  const char* p = begin;
+  while (p < end && IsAsciiDigit(*p))
+    ++p;
+  return static_cast<size_t>(p - begin);
+}
+
 }  // namespace
 
 // This is U+FFFD.
@@ -126,25 +205,7 @@ JSONParser::JSONParser(int options, size_t max_depth)
 JSONParser::~JSONParser() = default;
 
 absl::optional<Value> JSONParser::Parse(StringPiece input) {
-  input_ = input;
-  index_ = 0;
-  // Line and column counting is 1-based, but |index_| is 0-based. For example,
-  // if input is "Aaa\nB" then 'A' and 'B' are both in column 1 (at lines 1 and
-  // 2) and have indexes of 0 and 4. We track the line number explicitly (the
-  // |line_number_| field) and the column number implicitly (the difference
-  // between |index_| and |index_last_line_|). In calculating that difference,
-  // |index_last_line_| is the index of the '\r' or '\n', not the index of the
-  // first byte after the '\n'. For the 'B' in "Aaa\nB", its |index_| and
-  // |index_last_line_| would be 4 and 3: 'B' is in column (4 - 3) = 1. We
-  // initialize |index_last_line_| to -1, not 0, since -1 is the (out of range)
-  // index of the imaginary '\n' immediately before the start of the string:
-  // 'A' is in column (0 - -1) = 1.
-  line_number_ = 1;
-  index_last_line_ = static_cast<size_t>(-1);
-
-  error_code_ = JSON_NO_ERROR;
-  error_line_ = 0;
-  error_column_ = 0;
+  StartParsing(input);
 
   // When the input JSON string starts with a UTF-8 Byte-Order-Mark,
   // advance the start position to avoid the ParseNextToken function mis-
@@ -170,8 +231,7 @@ JSONParser::JsonParseError JSONParser::error_code() const {
 }
 
 std::string JSONParser::GetErrorMessage() const {
-  return FormatErrorMessage(error_line_, error_column_,
-                            ErrorCodeToString(error_code_));
+  return FormatError(error_code_, error_line_, error_column_);
 }
 
 int JSONParser::error_line() const {
@@ -210,12 +270,27 @@ void JSONParser::StringBuilder::Append(base_icu::UChar32 point) {
   }
 }
 
+void JSONParser::StringBuilder::AppendVerbatim(StringPiece chars) {
+  if (!string_) {
+    DCHECK_EQ(pos_ + length_, chars.data());
+    length_ += chars.size();
+  } else {
+    string_->append(chars.data(), chars.size());
+  }
+}
+
 void JSONParser::StringBuilder::Convert() {
   if (string_)
     return;
   string_.emplace(pos_, length_);
 }
 
+absl::optional<StringPiece> JSONParser::StringBuilder::AsStringPiece() const {
+  if (string_)
+    return absl::nullopt;
+  return StringPiece(pos_, length_);
+}
+
 std::string JSONParser::StringBuilder::DestructiveAsString() {
   if (string_)
     return std::move(*string_);
@@ -224,6 +299,39 @@ std::string JSONParser::StringBuilder::DestructiveAsString() {
 
 // JSONParser private //////////////////////////////////////////////////////////
 
+void JSONParser::StartParsing(StringPiece input) {
+  input_ = input;
+  index_ = 0;
+  // Line and column counting is 1-based, but |index_| is 0-based. For example,
+  // if input is "Aaa\nB" then 'A' and 'B' are both in column 1 (at lines 1 and
+  // 2) and have indexes of 0 and 4. We track the line number explicitly (the
+  // |line_number_| field) and the column number implicitly (the difference
+  // between |index_| and |index_last_line_|). In calculating that difference,
+  // |index_last_line_| is the index of the '\r' or '\n', not the index of the
+  // first byte after the '\n'. For the 'B' in "Aaa\nB", its |index_| and
+  // |index_last_line_| would be 4 and 3: 'B' is in column (4 - 3) = 1. We
+  // initialize |index_last_line_| to -1, not 0, since -1 is the (out of range)
+  // index of the imaginary '\n' immediately before the start of the string:
+  // 'A' is in column (0 - -1) = 1.
+  line_number_ = 1;
+  index_last_line_ = static_cast<size_t>(-1);
+
+  error_code_ = JSON_NO_ERROR;
+  error_line_ = 0;
+  error_column_ = 0;
+}
+
+bool JSONParser::ParseStringToken(StringPiece input, StringBuilder* out) {
+  StartParsing(input);
+  if (!ConsumeStringRaw(out))
+    return false;
+  if (GetNextToken() != T_END_OF_INPUT) {
+    ReportError(JSON_UNEXPECTED_DATA_AFTER_ROOT, 0);
+    return false;
+  }
+  return true;
+}
+
 absl::optional<StringPiece> JSONParser::PeekChars(size_t count) {
   if (index_ + count > input_.length())
     return absl::nullopt;
@@ -258,6 +366,11 @@ const char* JSONParser::pos() {
   return input_.data() + index_;
 }
 
+StringPiece JSONParser::remaining_input() const {
+  DCHECK_LE(index_, input_.length());
+  return StringPiece(input_.data() + index_, input_.length() - index_);
+}
+
 JSONParser::Token JSONParser::GetNextToken() {
   EatWhitespaceAndComments();
 
@@ -313,10 +426,12 @@ void JSONParser::EatWhitespaceAndComments() {
         if (!(c == '\n' && index_ > 0 && input_[index_ - 1] == '\r')) {
           ++line_number_;
         }
-        [[fallthrough]];
+        ConsumeChar();
+        break;
       case ' ':
       case '\t':
-        ConsumeChar();
+        // Indentation tends to come in long runs, so skip it in bulk.
+        index_ += CountSpacesAndTabs(remaining_input());
         break;
       case '/':
         if (!EatComment())
@@ -529,7 +644,18 @@ bool JSONParser::ConsumeStringRaw(StringBuilder* out) {
   // std::string.
   StringBuilder string(pos());
 
-  while (PeekChar()) {
+  while (true) {
+    // Most string contents need no decoding at all, so append the longest
+    // such run in one step before falling back to per-character handling.
+    const size_t verbatim_length = CountVerbatimStringChars(remaining_input());
+    if (verbatim_length) {
+      string.AppendVerbatim(StringPiece(pos(), verbatim_length));
+      index_ += verbatim_length;
+    }
+
+    if (!PeekChar())
+      break;
+
     base_icu::UChar32 next_char = 0;
     if (!ReadUnicodeCharacter(input_.data(), input_.length(), &index_,
                               &next_char) ||
@@ -807,23 +933,13 @@ absl::optional<Value> JSONParser::ConsumeNumber() {
 }
 
 bool JSONParser::ReadInt(bool allow_leading_zeros) {
-  size_t len = 0;
-  char first = 0;
-
-  while (absl::optional<char> c = PeekChar()) {
-    if (!IsAsciiDigit(c))
-      break;
-
-    if (len == 0)
-      first = *c;
-
-    ++len;
-    ConsumeChar();
-  }
-
+  const size_t len = CountDigits(remaining_input());
   if (len == 0)
     return false;
 
+  const char first = *pos();
+  index_ += len;
+
   if (!allow_leading_zeros && len > 1 && first == '0')
     return false;
 
@@ -871,5 +987,10 @@ std::string JSONParser::FormatErrorMessage(int line, int column,
   return description;
 }
 
+// static
+std::string JSONParser::FormatError(JsonParseError code, int line, int column) {
+  return FormatErrorMessage(line, column, ErrorCodeToString(code));
+}
+
 }  // namespace internal
 }  // namespace base
@@ -22,6 +22,7 @@
 
 namespace base {
 
+class JSONStreamReader;
 class Value;
 
 namespace internal {
@@ -136,11 +137,20 @@ class BASE_EXPORT JSONParser {
     // converted, or by appending the UTF8 bytes for the code point.
     void Append(base_icu::UChar32 point);
 
+    // Appends |chars|, which must consist only of ASCII characters that need
+    // no decoding. If the builder has not been converted, |chars| must
+    // immediately follow the bytes already in the builder.
+    void AppendVerbatim(StringPiece chars);
+
     // Converts the builder from its default StringPiece to a full std::string,
     // performing a copy. Once a builder is converted, it cannot be made a
     // StringPiece again.
     void Convert();
 
+    // Returns the string as a view into the input if the builder has not been
+    // converted, or nullopt otherwise.
+    absl::optional<StringPiece> AsStringPiece() const;
+
     // Returns the builder as a string, invalidating all state. This allows
     // the internal string buffer representation to be destructively moved
     // in cases where the builder will not be needed any more.
@@ -175,6 +185,9 @@ class BASE_EXPORT JSONParser {
   // Returns a pointer to the current character position.
   const char* pos();
 
+  // Returns the input from the current position to the end.
+  StringPiece remaining_input() const;
+
   // Skips over whitespace and comments to find the next token in the stream.
   // This does not advance the parser for non-whitespace or comment chars.
   Token GetNextToken();
@@ -242,6 +255,18 @@ class BASE_EXPORT JSONParser {
   static std::string FormatErrorMessage(int line, int column,
                                         const std::string& description);
 
+  // Formats the message for |code| at |line| and |column|.
+  static std::string FormatError(JsonParseError code, int line, int column);
+
+  // Resets the parser state to parse |input| from its start.
+  void StartParsing(StringPiece input);
+
+  // Parses |input|, which must consist of exactly one string token, into
+  // |out| for JSONStreamReader. Unless the string needs decoding, |out| then
+  // refers to |input|. Returns false and sets the error information if
+  // |input| is not a valid string.
+  bool ParseStringToken(StringPiece input, StringBuilder* out);
+
   // base::JSONParserOptions that control parsing.
   const int options_;
 
@@ -269,12 +294,15 @@ class BASE_EXPORT JSONParser {
   int error_column_;
 
   friend class JSONParserTest;
+  friend class base::JSONStreamReader;
   FRIEND_TEST_ALL_PREFIXES(JSONParserTest, NextChar);
   FRIEND_TEST_ALL_PREFIXES(JSONParserTest, ConsumeDictionary);
   FRIEND_TEST_ALL_PREFIXES(JSONParserTest, ConsumeList);
   FRIEND_TEST_ALL_PREFIXES(JSONParserTest, ConsumeString);
   FRIEND_TEST_ALL_PREFIXES(JSONParserTest, ConsumeLiterals);
   FRIEND_TEST_ALL_PREFIXES(JSONParserTest, ConsumeNumbers);
+  FRIEND_TEST_ALL_PREFIXES(JSONParserTest, ConsumeLongStrings);
+  FRIEND_TEST_ALL_PREFIXES(JSONParserTest, WhitespaceRuns);
   FRIEND_TEST_ALL_PREFIXES(JSONParserTest, ErrorMessages);
 };
 
@@ -205,6 +205,64 @@ TEST_F(JSONParserTest, ConsumeNumbers) {
   EXPECT_EQ(420, value->GetDouble());
 }
 
+TEST_F(JSONParserTest, ConsumeLongStrings) {
+  // Place the first character that needs decoding at every offset around the
+  // block boundaries used by the bulk scanner.
+  for (size_t prefix_length = 0; prefix_length < 40; ++prefix_length) {
+    const std::string prefix(prefix_length, 'a');
+    const std::string suffix(prefix_length + 3, 'z');
+
+    std::string input = "\"" + prefix + "\\n" + suffix + "\",|";
+    std::unique_ptr<JSONParser> parser(NewTestParser(input));
+    absl::optional<Value> value(parser->ConsumeString());
+    EXPECT_EQ(',', *parser->pos());
+    TestLastThree(parser.get());
+    ASSERT_TRUE(value);
+    EXPECT_EQ(prefix + "\n" + suffix, value->GetString());
+
+    input = "\"" + prefix + "\xC3\xA9" + suffix + "\",|";
+    parser.reset(NewTestParser(input));
+    value = parser->ConsumeString();
+    EXPECT_EQ(',', *parser->pos());
+    TestLastThree(parser.get());
+    ASSERT_TRUE(value);
+    EXPECT_EQ(prefix + "\xC3\xA9" + suffix, value->GetString());
+
+    // Control characters must still be rejected wherever they appear.
+    input = "\"" + prefix + "\x01" + suffix + "\",|";
+    parser.reset(NewTestParser(input));
+    EXPECT_FALSE(parser->ConsumeString());
+    EXPECT_EQ(JSONParser::JSON_UNSUPPORTED_ENCODING, parser->error_code());
+
+    // An unterminated string must not read past the end of the input.
+    input = "\"" + prefix + suffix;
+    parser.reset(NewTestParser(input));
+    EXPECT_FALSE(parser->ConsumeString());
+    EXPECT_EQ(JSONParser::JSON_SYNTAX_ERROR, parser->error_code());
+  }
+}
+
+TEST_F(JSONParserTest, WhitespaceRuns) {
+  for (size_t indent = 0; indent < 40; ++indent) {
+    const std::string blanks(indent, indent % 2 ? ' ' : '\t');
+    const std::string input =
+        "{" + blanks + "\"a\"" + blanks + ":" + blanks + "1" + blanks +
+        ",\n" + blanks + "\"b\":[" + blanks + "]" + blanks + "}" + blanks;
+    JSONParser parser(JSON_PARSE_RFC);
+    absl::optional<Value> value = parser.Parse(input);
+    ASSERT_TRUE(value) << parser.GetErrorMessage();
+    ASSERT_TRUE(value->is_dict());
+    EXPECT_EQ(1, value->GetDict().FindInt("a"));
+
+    // Columns must still be counted correctly after a long run of blanks.
+    JSONParser bad_parser(JSON_PARSE_RFC);
+    EXPECT_FALSE(bad_parser.Parse("[1,\n" + blanks + "x]"));
+    EXPECT_EQ(JSONParser::FormatErrorMessage(2, static_cast<int>(indent) + 1,
+                                             JSONParser::kUnexpectedToken),
+              bad_parser.GetErrorMessage());
+  }
+}
+
 TEST_F(JSONParserTest, ErrorMessages) {
   {
     JSONParser parser(JSON_PARSE_RFC);
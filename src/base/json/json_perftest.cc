@@ -2,9 +2,16 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <memory>
+
+#include "base/files/file.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/json/json_document.h"
 #include "base/json/json_reader.h"
+#include "base/json/json_value_converter.h"
 #include "base/json/json_writer.h"
 #include "base/memory/ptr_util.h"
+#include "base/process/process_metrics.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/time/time.h"
 #include "base/values.h"
@@ -19,11 +26,23 @@ namespace {
 constexpr char kMetricPrefixJSON[] = "JSON.";
 constexpr char kMetricReadTime[] = "read_time";
 constexpr char kMetricWriteTime[] = "write_time";
+constexpr char kMetricReadThroughput[] = "read_throughput";
+constexpr char kMetricWriteThroughput[] = "write_throughput";
+constexpr char kMetricParseAndDestroyTime[] = "parse_and_destroy_time";
+constexpr char kMetricResidentGrowth[] = "resident_growth";
+constexpr char kMetricArenaSize[] = "arena_size";
+constexpr char kMetricConvertTime[] = "convert_time";
 
 perf_test::PerfResultReporter SetUpReporter(const std::string& story_name) {
   perf_test::PerfResultReporter reporter(kMetricPrefixJSON, story_name);
   reporter.RegisterImportantMetric(kMetricReadTime, "ms");
   reporter.RegisterImportantMetric(kMetricWriteTime, "ms");
+  reporter.RegisterImportantMetric(kMetricReadThroughput, "MB/s");
+  reporter.RegisterImportantMetric(kMetricWriteThroughput, "MB/s");
+  reporter.RegisterImportantMetric(kMetricParseAndDestroyTime, "ms");
+  reporter.RegisterImportantMetric(kMetricResidentGrowth, "KB");
+  reporter.RegisterImportantMetric(kMetricArenaSize, "KB");
+  reporter.RegisterImportantMetric(kMetricConvertTime, "ms");
   return reporter;
 }
 
@@ -61,6 +80,57 @@ Value::Dict GenerateLayeredDict(int breadth, int depth) {
   return root;
 }
 
+// Generates a list of |count| records, each holding a string of
+// |string_length| bytes. The result is multiple megabytes of mostly string
+// payload, which is where the parser spends most of its time on real-world
+// configuration and telemetry documents.
+Value::List GenerateLargeStringList(int count, size_t string_length) {
+  Value::List list;
+  for (int i = 0; i < count; ++i) {
+    Value::Dict record;
+    record.Set("id", i);
+    record.Set("name", "record" + base::NumberToString(i));
+    record.Set("payload", std::string(string_length, 'a' + i % 26));
+    list.Append(std::move(record));
+  }
+  return list;
+}
+
+// The typed form of the records generated by GenerateLargeStringList().
+struct Record {
+  int id = 0;
+  std::string name;
+  std::string payload;
+
+  static void RegisterJSONConverter(JSONValueConverter<Record>* converter) {
+    converter->RegisterIntField("id", &Record::id);
+    converter->RegisterStringField("name", &Record::name);
+    converter->RegisterStringField("payload", &Record::payload);
+  }
+};
+
+struct RecordList {
+  std::vector<std::unique_ptr<Record>> records;
+
+  static void RegisterJSONConverter(JSONValueConverter<RecordList>* converter) {
+    converter->RegisterRepeatedMessage("records", &RecordList::records);
+  }
+};
+
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+// Returns the resident set size of the current process, in KB.
+size_t GetResidentKB() {
+  return ProcessMetrics::CreateCurrentProcessMetrics()->GetResidentSetSize() /
+         1024;
+}
+
+// Returns how much the resident set has grown since it was |resident_before|.
+size_t GetResidentGrowthKB(size_t resident_before) {
+  const size_t resident = GetResidentKB();
+  return resident > resident_before ? resident - resident_before : 0;
+}
+#endif
+
 }  // namespace
 
 class JSONPerfTest : public testing::Test {
@@ -83,6 +153,102 @@ class JSONPerfTest : public testing::Test {
     TimeTicks end_read = TimeTicks::Now();
     reporter.AddResult(kMetricReadTime, end_read - start_read);
   }
+
+  void TestReadLargeDocument(const std::string& story_name,
+                             const std::string& json) {
+    TimeTicks start_read = TimeTicks::Now();
+    absl::optional<Value> value = JSONReader::Read(json);
+    TimeTicks end_read = TimeTicks::Now();
+    ASSERT_TRUE(value);
+
+    auto reporter = SetUpReporter(story_name);
+    reporter.AddResult(kMetricReadTime, end_read - start_read);
+    reporter.AddResult(kMetricReadThroughput,
+                       json.size() / (end_read - start_read).InSecondsF() /
+                           (1024 * 1024));
+  }
+
+  // Serializes |value| repeatedly into a reused string, and once into a file.
+  void TestWriteLargeDocument(const std::string& story_name,
+                              const Value& value) {
+    constexpr int kIterations = 5;
+    std::string json;
+    size_t total_size = 0;
+    TimeTicks start_write = TimeTicks::Now();
+    for (int i = 0; i < kIterations; ++i) {
+      ASSERT_TRUE(JSONWriter::Write(value, &json));
+      total_size += json.size();
+    }
+    TimeDelta write_time = TimeTicks::Now() - start_write;
+    auto reporter = SetUpReporter(story_name);
+    reporter.AddResult(kMetricWriteTime, write_time / kIterations);
+    reporter.AddResult(kMetricWriteThroughput,
+                       total_size / write_time.InSecondsF() / (1024 * 1024));
+
+    ScopedTempDir temp_dir;
+    ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+    File file(temp_dir.GetPath().AppendASCII("out.json"),
+              File::FLAG_CREATE | File::FLAG_WRITE);
+    ASSERT_TRUE(file.IsValid());
+    start_write = TimeTicks::Now();
+    ASSERT_TRUE(JSONWriter::WriteToFile(value, 0, &file));
+    write_time = TimeTicks::Now() - start_write;
+    auto file_reporter = SetUpReporter(story_name + "_to_file");
+    file_reporter.AddResult(kMetricWriteTime, write_time);
+    file_reporter.AddResult(
+        kMetricWriteThroughput,
+        json.size() / write_time.InSecondsF() / (1024 * 1024));
+  }
+
+  // Compares parsing |json| into a base::Value with parsing it into a
+  // JSONDocument, including the time it takes to destroy the result.
+  void TestParseAndDestroy(const std::string& story_name,
+                           const std::string& json) {
+    {
+      auto reporter = SetUpReporter(story_name + "_value");
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+      const size_t resident_before = GetResidentKB();
+#endif
+      TimeTicks start = TimeTicks::Now();
+      auto value = std::make_unique<Value>(*JSONReader::Read(json));
+      TimeDelta parse_and_destroy_time = TimeTicks::Now() - start;
+      // The resident set is sampled outside of the timed regions.
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+      reporter.AddResult(kMetricResidentGrowth,
+                         GetResidentGrowthKB(resident_before));
+#endif
+      start = TimeTicks::Now();
+      value.reset();
+      parse_and_destroy_time += TimeTicks::Now() - start;
+      reporter.AddResult(kMetricParseAndDestroyTime, parse_and_destroy_time);
+    }
+
+    // The referencing document only allocates decoded strings, so the input
+    // itself counts as part of its footprint.
+    for (bool reference_input : {false, true}) {
+      auto reporter = SetUpReporter(
+          story_name +
+          (reference_input ? "_referencing_document" : "_document"));
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+      const size_t resident_before = GetResidentKB();
+#endif
+      TimeTicks start = TimeTicks::Now();
+      absl::optional<JSONDocument> document =
+          reference_input ? JSONDocument::ParseReferencingInput(json)
+                          : JSONDocument::Parse(json);
+      TimeDelta parse_and_destroy_time = TimeTicks::Now() - start;
+      ASSERT_TRUE(document);
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_ANDROID)
+      reporter.AddResult(kMetricResidentGrowth,
+                         GetResidentGrowthKB(resident_before));
+#endif
+      reporter.AddResult(kMetricArenaSize, document->arena_size() / 1024);
+      start = TimeTicks::Now();
+      document.reset();
+      parse_and_destroy_time += TimeTicks::Now() - start;
+      reporter.AddResult(kMetricParseAndDestroyTime, parse_and_destroy_time);
+    }
+  }
 };
 
 TEST_F(JSONPerfTest, StressTest) {
@@ -97,4 +263,75 @@ TEST_F(JSONPerfTest, StressTest) {
   }
 }
 
+TEST_F(JSONPerfTest, LargeDocument) {
+  // Compact documents exercise string scanning; pretty-printed ones also spend
+  // much of their time skipping indentation.
+  for (size_t string_length : {16u, 256u, 4096u}) {
+    const int count = static_cast<int>(4 * 1024 * 1024 / string_length);
+    Value::List list = GenerateLargeStringList(count, string_length);
+    const std::string suffix =
+        "_string_length_" + base::NumberToString(string_length);
+
+    std::string json;
+    JSONWriter::Write(list, &json);
+    TestReadLargeDocument("large_compact" + suffix, json);
+
+    JSONWriter::WriteWithOptions(list, JSONWriter::OPTIONS_PRETTY_PRINT,
+                                 &json);
+    TestReadLargeDocument("large_pretty" + suffix, json);
+  }
+}
+
+TEST_F(JSONPerfTest, WriteLargeDocument) {
+  for (size_t string_length : {16u, 256u, 4096u}) {
+    const int count = static_cast<int>(4 * 1024 * 1024 / string_length);
+    TestWriteLargeDocument(
+        "write_large_string_length_" + base::NumberToString(string_length),
+        Value(GenerateLargeStringList(count, string_length)));
+  }
+  TestWriteLargeDocument("write_layered", Value(GenerateLayeredDict(4, 8)));
+}
+
+TEST_F(JSONPerfTest, ConvertToStruct) {
+  for (size_t string_length : {16u, 256u}) {
+    const int count = static_cast<int>(4 * 1024 * 1024 / string_length);
+    Value::Dict root;
+    root.Set("records", GenerateLargeStringList(count, string_length));
+    std::string json;
+    JSONWriter::Write(root, &json);
+    const JSONValueConverter<RecordList> converter;
+
+    TimeTicks start = TimeTicks::Now();
+    {
+      RecordList list;
+      absl::optional<Value> value = JSONReader::Read(json);
+      ASSERT_TRUE(value);
+      ASSERT_TRUE(converter.Convert(*value, &list));
+    }
+    auto reporter = SetUpReporter("convert_from_value_string_length_" +
+                                  base::NumberToString(string_length));
+    reporter.AddResult(kMetricConvertTime, TimeTicks::Now() - start);
+
+    start = TimeTicks::Now();
+    {
+      RecordList list;
+      ASSERT_TRUE(converter.ConvertJSON(json, &list));
+    }
+    auto json_reporter = SetUpReporter("convert_from_json_string_length_" +
+                                       base::NumberToString(string_length));
+    json_reporter.AddResult(kMetricConvertTime, TimeTicks::Now() - start);
+  }
+}
+
+TEST_F(JSONPerfTest, ParseAndDestroy) {
+  // Many small records, where per-node allocations dominate.
+  std::string json;
+  JSONWriter::Write(GenerateLargeStringList(100000, 16), &json);
+  TestParseAndDestroy("many_records", json);
+
+  // A deep tree of small dictionaries.
+  JSONWriter::Write(GenerateLayeredDict(4, 8), &json);
+  TestParseAndDestroy("layered", json);
+}
+
 }  // namespace base
@@ -0,0 +1,433 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_stream_reader.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "base/check_op.h"
+#include "base/files/file.h"
+#include "base/json/json_parser.h"
+#include "base/notreached.h"
+#include "base/numerics/safe_conversions.h"
+#include "base/strings/string_util.h"
+
+namespace base {
+
+namespace {
+
+using internal::JSONParser;
+
+constexpr StringPiece kByteOrderMark = "\xEF\xBB\xBF";
+
+bool IsWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// Returns true if |c| may be part of a number token. The scalar parser
+// validates the exact syntax once the whole token is known.
+bool IsNumberChar(char c) {
+  return IsAsciiDigit(c) || c == '-' || c == '+' || c == '.' || c == 'e' ||
+         c == 'E';
+}
+
+}  // namespace
+
+JSONStreamReader::JSONStreamReader(Delegate* delegate,
+                                   int options,
+                                   size_t max_depth)
+    : delegate_(delegate), options_(options), max_depth_(max_depth) {
+  DCHECK(delegate_);
+  CHECK_LE(max_depth, internal::kAbsoluteMaxDepth);
+}
+
+JSONStreamReader::~JSONStreamReader() = default;
+
+bool JSONStreamReader::Feed(StringPiece chunk) {
+  DCHECK(!finished_);
+  if (state_ == State::kStopped)
+    return false;
+
+  if (pending_.empty()) {
+    // Parse straight out of |chunk| and keep only the incomplete tail.
+    const size_t consumed = Process(chunk, /*is_final=*/false);
+    if (state_ != State::kStopped)
+      pending_.assign(chunk.data() + consumed, chunk.size() - consumed);
+  } else {
+    pending_.append(chunk.data(), chunk.size());
+    const size_t consumed = Process(pending_, /*is_final=*/false);
+    if (state_ != State::kStopped)
+      pending_.erase(0, consumed);
+  }
+  return state_ != State::kStopped;
+}
+
+bool JSONStreamReader::Finish() {
+  DCHECK(!finished_);
+  finished_ = true;
+  if (state_ == State::kStopped)
+    return false;
+
+  Process(pending_, /*is_final=*/true);
+  pending_.clear();
+  if (state_ == State::kStopped)
+    return false;
+
+  if (state_ != State::kDone) {
+    // The input ended in the middle of the document.
+    ReportError(ExpectsValue() ? JSONParser::JSON_UNEXPECTED_TOKEN
+                               : JSONParser::JSON_SYNTAX_ERROR);
+    return false;
+  }
+  return true;
+}
+
+bool JSONStreamReader::ReadFile(File& file, size_t chunk_size) {
+  DCHECK_GT(chunk_size, 0u);
+  std::string buffer(chunk_size, '\0');
+  while (true) {
+    const int bytes_read =
+        file.ReadAtCurrentPos(buffer.data(), checked_cast<int>(chunk_size));
+    if (bytes_read < 0) {
+      state_ = State::kStopped;
+      return false;
+    }
+    if (bytes_read == 0)
+      break;
+    if (!Feed(StringPiece(buffer.data(), static_cast<size_t>(bytes_read))))
+      return false;
+  }
+  return Finish();
+}
+
+size_t JSONStreamReader::Process(StringPiece input, bool is_final) {
+  size_t index = 0;
+
+  if (!checked_bom_) {
+    // A byte-order mark is only skipped at the very start of the input.
+    if (!is_final && input.size() < kByteOrderMark.size() &&
+        StartsWith(kByteOrderMark, input)) {
+      return 0;
+    }
+    checked_bom_ = true;
+    if (StartsWith(input, kByteOrderMark)) {
+      UpdateLocation(kByteOrderMark);
+      index = kByteOrderMark.size();
+    }
+  }
+
+  while (index < input.size() && state_ != State::kStopped) {
+    const StringPiece rest = input.substr(index);
+
+    absl::optional<size_t> length = SkipWhitespaceOrComment(rest, is_final);
+    if (!length)
+      break;
+    if (*length == 0) {
+      switch (rest[0]) {
+        case '{':
+        case '}':
+        case '[':
+        case ']':
+        case ',':
+        case ':':
+          if (!HandleStructuralChar(rest[0]))
+            return index;
+          length = 1;
+          break;
+        default: {
+          const bool is_key = ExpectsKey();
+          if ((!is_key && !ExpectsValue()) || (is_key && rest[0] != '"')) {
+            ReportUnexpectedToken();
+            return index;
+          }
+          length = FindScalarEnd(rest, is_final);
+          if (!length)
+            return index;
+          if (!HandleScalar(rest.substr(0, *length), is_key))
+            return index;
+          break;
+        }
+      }
+    }
+
+    UpdateLocation(rest.substr(0, *length));
+    index += *length;
+    pending_scan_offset_ = 0;
+  }
+  return index;
+}
+
+absl::optional<size_t> JSONStreamReader::SkipWhitespaceOrComment(
+    StringPiece input,
+    bool is_final) {
+  DCHECK(!input.empty());
+  if (IsWhitespace(input[0])) {
+    size_t length = 1;
+    while (length < input.size() && IsWhitespace(input[length]))
+      ++length;
+    return length;
+  }
+
+  // Anything else that is not a comment is left for the caller to treat as a
+  // token, so that it is reported as unexpected in the context it appears.
+  if (input[0] != '/' || !(options_ & JSON_ALLOW_COMMENTS))
+    return 0;
+  if (input.size() < 2)
+    return is_final ? absl::make_optional<size_t>(0) : absl::nullopt;
+
+  size_t end = StringPiece::npos;
+  if (input[1] == '/') {
+    // The line break itself is consumed as whitespace.
+    end = input.find_first_of("\r\n", 2);
+  } else if (input[1] == '*') {
+    end = input.find("*/", 2);
+    if (end != StringPiece::npos)
+      end += 2;
+  } else {
+    return 0;
+  }
+
+  if (end != StringPiece::npos)
+    return end;
+  // Like JSONParser, an unterminated comment runs to the end of the input.
+  return is_final ? absl::make_optional(input.size()) : absl::nullopt;
+}
+
+absl::optional<size_t> JSONStreamReader::FindScalarEnd(StringPiece input,
+                                                       bool is_final) {
+  size_t index = pending_scan_offset_;
+  if (input[0] == '"') {
+    index = std::max<size_t>(index, 1);
+    // Jump between quotes and backslashes with memchr() rather than looking
+    // at every byte, since strings are usually long and rarely escaped.
+    size_t quote = StringPiece::npos;
+    while (index < input.size()) {
+      if (quote == StringPiece::npos || quote < index)
+        quote = input.find('"', index);
+      const size_t backslash =
+          input.substr(0, std::min(quote, input.size())).find('\\', index);
+      if (backslash == StringPiece::npos) {
+        if (quote != StringPiece::npos)
+          return quote + 1;
+        index = input.size();
+        break;
+      }
+      // Resume from the backslash if the escaped character is not here yet.
+      index = backslash;
+      if (index + 1 == input.size())
+        break;
+      index += 2;
+    }
+  } else if (IsAsciiAlpha(input[0])) {
+    while (index < input.size() && IsAsciiAlpha(input[index]))
+      ++index;
+    if (index < input.size())
+      return index;
+  } else {
+    while (index < input.size() && IsNumberChar(input[index]))
+      ++index;
+    if (index < input.size())
+      return index;
+  }
+
+  if (is_final) {
+    // Let the scalar parser report what is wrong with the truncated token.
+    return input.size();
+  }
+  pending_scan_offset_ = index;
+  return absl::nullopt;
+}
+
+bool JSONStreamReader::HandleScalar(StringPiece token, bool is_key) {
+  JSONParser parser(options_, max_depth_);
+  if (token[0] == '"')
+    return HandleString(parser, token, is_key);
+
+  DCHECK(!is_key);
+  absl::optional<Value> value = parser.Parse(token);
+  if (!value) {
+    ReportScalarError(parser.error_code(), parser.error_line(),
+                      parser.error_column());
+    return false;
+  }
+
+  OnValueComplete();
+  return CheckDelegateResult(delegate_->OnScalar(std::move(*value)));
+}
+
+bool JSONStreamReader::HandleString(JSONParser& parser,
+                                    StringPiece token,
+                                    bool is_key) {
+  JSONParser::StringBuilder string;
+  if (!parser.ParseStringToken(token, &string)) {
+    ReportScalarError(parser.error_code(), parser.error_line(),
+                      parser.error_column());
+    return false;
+  }
+
+  // Unless the string had to be decoded, hand out a view of the input.
+  const absl::optional<StringPiece> view = string.AsStringPiece();
+  if (is_key) {
+    state_ = State::kPairSeparator;
+    return CheckDelegateResult(view ? delegate_->OnDictKey(*view)
+                                    : delegate_->OnDictKey(
+                                          string.DestructiveAsString()));
+  }
+
+  OnValueComplete();
+  return CheckDelegateResult(
+      view ? delegate_->OnUnescapedString(*view)
+           : delegate_->OnScalar(Value(string.DestructiveAsString())));
+}
+
+bool JSONStreamReader::HandleStructuralChar(char c) {
+  switch (c) {
+    case '{':
+    case '[': {
+      if (!ExpectsValue()) {
+        ReportUnexpectedToken();
+        return false;
+      }
+      // Matches the depth accounting of JSONParser.
+      if (container_stack_.size() + 1 >= max_depth_) {
+        ReportError(JSONParser::JSON_TOO_MUCH_NESTING);
+        return false;
+      }
+      const bool is_dict = c == '{';
+      container_stack_.push_back(is_dict);
+      if (is_dict) {
+        state_ = State::kDictKeyOrEnd;
+        return CheckDelegateResult(delegate_->OnDictStart());
+      }
+      state_ = State::kListValueOrEnd;
+      return CheckDelegateResult(delegate_->OnListStart());
+    }
+
+    case '}':
+    case ']': {
+      const bool is_dict = c == '}';
+      const State after_comma =
+          is_dict ? State::kDictKeyAfterComma : State::kListValueAfterComma;
+      if (state_ == after_comma) {
+        if (!(options_ & JSON_ALLOW_TRAILING_COMMAS)) {
+          ReportError(JSONParser::JSON_TRAILING_COMMA);
+          return false;
+        }
+      } else if (state_ != (is_dict ? State::kDictKeyOrEnd
+                                    : State::kListValueOrEnd) &&
+                 !(state_ == State::kSeparatorOrEnd &&
+                   container_stack_.back() == is_dict)) {
+        ReportUnexpectedToken();
+        return false;
+      }
+      container_stack_.pop_back();
+      OnValueComplete();
+      return CheckDelegateResult(is_dict ? delegate_->OnDictEnd()
+                                         : delegate_->OnListEnd());
+    }
+
+    case ',':
+      if (state_ != State::kSeparatorOrEnd) {
+        ReportUnexpectedToken();
+        return false;
+      }
+      state_ = container_stack_.back() ? State::kDictKeyAfterComma
+                                       : State::kListValueAfterComma;
+      return true;
+
+    case ':':
+      if (state_ != State::kPairSeparator) {
+        ReportUnexpectedToken();
+        return false;
+      }
+      state_ = State::kValue;
+      return true;
+  }
+
+  NOTREACHED();
+  return false;
+}
+
+bool JSONStreamReader::ExpectsValue() const {
+  return state_ == State::kValue || state_ == State::kListValueOrEnd ||
+         state_ == State::kListValueAfterComma;
+}
+
+bool JSONStreamReader::ExpectsKey() const {
+  return state_ == State::kDictKeyOrEnd || state_ == State::kDictKeyAfterComma;
+}
+
+void JSONStreamReader::OnValueComplete() {
+  state_ = container_stack_.empty() ? State::kDone : State::kSeparatorOrEnd;
+}
+
+void JSONStreamReader::ReportUnexpectedToken() {
+  switch (state_) {
+    case State::kValue:
+    case State::kListValueOrEnd:
+    case State::kListValueAfterComma:
+      ReportError(JSONParser::JSON_UNEXPECTED_TOKEN);
+      return;
+    case State::kDictKeyOrEnd:
+    case State::kDictKeyAfterComma:
+      ReportError(JSONParser::JSON_UNQUOTED_DICTIONARY_KEY);
+      return;
+    case State::kPairSeparator:
+    case State::kSeparatorOrEnd:
+      ReportError(JSONParser::JSON_SYNTAX_ERROR);
+      return;
+    case State::kDone:
+      ReportError(JSONParser::JSON_UNEXPECTED_DATA_AFTER_ROOT);
+      return;
+    case State::kStopped:
+      break;
+  }
+  NOTREACHED();
+}
+
+void JSONStreamReader::ReportError(int error_code) {
+  ReportScalarError(error_code, 1, 1);
+}
+
+void JSONStreamReader::ReportScalarError(int error_code, int line, int column) {
+  JSONReader::Error error;
+  error.line = line_ + line - 1;
+  error.column = line == 1 ? column_ + column - 1 : column;
+  error.message = JSONParser::FormatError(
+      static_cast<JSONParser::JsonParseError>(error_code), error.line,
+      error.column);
+  error_ = std::move(error);
+  state_ = State::kStopped;
+}
+
+void JSONStreamReader::UpdateLocation(StringPiece consumed) {
+  // Most tokens, and all long strings, contain no line breaks.
+  if (consumed.find('\n') == StringPiece::npos &&
+      consumed.find('\r') == StringPiece::npos) {
+    column_ += checked_cast<int>(consumed.size());
+    last_char_was_cr_ = false;
+    return;
+  }
+
+  for (char c : consumed) {
+    if (c == '\r' || c == '\n') {
+      // Don't count "\r\n" as two line breaks.
+      if (c == '\r' || !last_char_was_cr_)
+        ++line_;
+      column_ = 1;
+    } else {
+      ++column_;
+    }
+    last_char_was_cr_ = c == '\r';
+  }
+}
+
+bool JSONStreamReader::CheckDelegateResult(bool result) {
+  if (!result)
+    state_ = State::kStopped;
+  return result;
+}
+
+}  // namespace base
@@ -0,0 +1,224 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_JSON_JSON_STREAM_READER_H_
+#define BASE_JSON_JSON_STREAM_READER_H_
+
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/json/json_common.h"
+#include "base/json/json_reader.h"
+#include "base/memory/raw_ptr.h"
+#include "base/strings/string_piece.h"
+#include "base/values.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
+
+namespace base {
+
+class File;
+
+namespace internal {
+class JSONParser;
+}  // namespace internal
+
+// An event-based JSON reader for documents that are too large to hold as a
+// single base::Value tree. Instead of building a tree, it reports the
+// structure of the document to a Delegate as it is parsed. The input may be
+// supplied in arbitrarily split chunks; only the bytes of a single incomplete
+// token are retained between chunks, so memory use does not depend on the
+// size of the document.
+//
+// Accepts the same grammar and JSONParserOptions as JSONReader. Scalars are
+// decoded by the same parser that backs JSONReader.
+//
+// Example:
+//   class CountingDelegate : public JSONStreamReader::Delegate { ... };
+//   CountingDelegate delegate;
+//   JSONStreamReader reader(&delegate);
+//   while (HasMoreData()) {
+//     if (!reader.Feed(NextChunk()))
+//       break;
+//   }
+//   if (!reader.Finish() && reader.error())
+//     LOG(ERROR) << reader.error()->message;
+class BASE_EXPORT JSONStreamReader {
+ public:
+  // Receives parse events in document order. Every method returns true to
+  // continue parsing, or false to stop; once a method returns false, no
+  // further events are delivered and Feed() and Finish() return false without
+  // reporting an error.
+  class Delegate {
+   public:
+    virtual ~Delegate() = default;
+
+    virtual bool OnDictStart() = 0;
+    // Called for each key of a dictionary, before the events for its value.
+    virtual bool OnDictKey(StringPiece key) = 0;
+    virtual bool OnDictEnd() = 0;
+
+    virtual bool OnListStart() = 0;
+    virtual bool OnListEnd() = 0;
+
+    // Called for every null, boolean, number, and string that is not a
+    // dictionary key.
+    virtual bool OnScalar(Value value) = 0;
+
+    // Called instead of OnScalar() for a string that needs no decoding, with
+    // its contents as they appear in the input, so that delegates can avoid
+    // copying it. |value| points into the chunk passed to Feed(), unless the
+    // string was split across chunks, and is only valid during the call. By
+    // default, calls OnScalar().
+    virtual bool OnUnescapedString(StringPiece value) {
+      return OnScalar(Value(value));
+    }
+  };
+
+  // The default chunk size used by ReadFile().
+  static constexpr size_t kDefaultReadChunkSize = 64 * 1024;
+
+  explicit JSONStreamReader(Delegate* delegate,
+                            int options = JSON_PARSE_CHROMIUM_EXTENSIONS,
+                            size_t max_depth = internal::kAbsoluteMaxDepth);
+
+  JSONStreamReader(const JSONStreamReader&) = delete;
+  JSONStreamReader& operator=(const JSONStreamReader&) = delete;
+
+  ~JSONStreamReader();
+
+  // Parses |chunk|, the next part of the input. Returns false if the input
+  // is malformed or the delegate stopped parsing.
+  bool Feed(StringPiece chunk);
+
+  // Signals the end of the input. Returns true if a complete document was
+  // parsed. Must be called exactly once, after the last call to Feed().
+  bool Finish();
+
+  // Feeds the contents of |file|, read from its current position in chunks of
+  // |chunk_size| bytes, and then calls Finish(). Returns false on a read error
+  // or for the same reasons as Feed() and Finish().
+  bool ReadFile(File& file, size_t chunk_size = kDefaultReadChunkSize);
+
+  // Returns the error information if the input was malformed, or nullptr if
+  // no error has been found. An error is not reported when the delegate
+  // stops parsing.
+  const JSONReader::Error* error() const {
+    return error_ ? &*error_ : nullptr;
+  }
+
+ private:
+  enum class State {
+    // Expecting the root value, or the value after a ':'.
+    kValue,
+    // Expecting a list element or ']', just after '['.
+    kListValueOrEnd,
+    // Expecting a list element after ','.
+    kListValueAfterComma,
+    // Expecting a dictionary key or '}', just after '{'.
+    kDictKeyOrEnd,
+    // Expecting a dictionary key after ','.
+    kDictKeyAfterComma,
+    // Expecting the ':' after a dictionary key.
+    kPairSeparator,
+    // Expecting ',' or the end of the innermost container.
+    kSeparatorOrEnd,
+    // The root value has been parsed; only whitespace and comments may follow.
+    kDone,
+    // Parsing has stopped because of an error or at the delegate's request.
+    kStopped,
+  };
+
+  // Consumes as many complete tokens from |input| as possible, and returns
+  // the number of bytes consumed. If |is_final|, |input| is the end of the
+  // document, so tokens cannot continue past its end.
+  size_t Process(StringPiece input, bool is_final);
+
+  // Returns the length of the whitespace or comment at the start of |input|,
+  // 0 if |input| does not start with either, or nullopt if more input is
+  // needed to decide. May stop with an error.
+  absl::optional<size_t> SkipWhitespaceOrComment(StringPiece input,
+                                                 bool is_final);
+
+  // Returns the length of the scalar token (string, number, or literal) at
+  // the start of |input|, or nullopt if the token may continue past the end
+  // of |input|.
+  absl::optional<size_t> FindScalarEnd(StringPiece input, bool is_final);
+
+  // Decodes the complete scalar |token| and delivers it to the delegate as a
+  // key or a value. Returns false if parsing stopped.
+  bool HandleScalar(StringPiece token, bool is_key);
+
+  // HandleScalar() for a string |token|, decoded with |parser|.
+  bool HandleString(internal::JSONParser& parser,
+                    StringPiece token,
+                    bool is_key);
+
+  // Handles the single-byte structural token |c|. Returns false if parsing
+  // stopped.
+  bool HandleStructuralChar(char c);
+
+  bool ExpectsValue() const;
+  bool ExpectsKey() const;
+
+  // Transitions to the state that follows a complete value.
+  void OnValueComplete();
+
+  // Stops parsing with the error appropriate for a token that is not allowed
+  // in the current state.
+  void ReportUnexpectedToken();
+
+  // Stops parsing with the internal::JSONParser::JsonParseError |error_code|
+  // at the current location.
+  void ReportError(int error_code);
+
+  // Stops parsing and records the error |error_code| reported by the scalar
+  // parser at |line| and |column| within the token that starts at the current
+  // location.
+  void ReportScalarError(int error_code, int line, int column);
+
+  // Advances the current line and column over |consumed|.
+  void UpdateLocation(StringPiece consumed);
+
+  // Stops parsing if |result| is false, i.e. the delegate asked to stop.
+  bool CheckDelegateResult(bool result);
+
+  const raw_ptr<Delegate> delegate_;
+  const int options_;
+  const size_t max_depth_;
+
+  State state_ = State::kValue;
+
+  // For every open container, true if it is a dictionary and false if it is
+  // a list.
+  std::vector<bool> container_stack_;
+
+  // Unconsumed input carried over from the previous chunk. Always starts at
+  // a token boundary.
+  std::string pending_;
+
+  // Number of bytes at the start of |pending_| already known not to contain
+  // the end of the current token, so that long tokens split over many chunks
+  // are not rescanned from the start.
+  size_t pending_scan_offset_ = 0;
+
+  // Whether a possible byte-order mark at the start of the input has been
+  // handled.
+  bool checked_bom_ = false;
+
+  // 1-based location of the next unconsumed byte.
+  int line_ = 1;
+  int column_ = 1;
+  bool last_char_was_cr_ = false;
+
+  bool finished_ = false;
+
+  absl::optional<JSONReader::Error> error_;
+};
+
+}  // namespace base
+
+#endif  // BASE_JSON_JSON_STREAM_READER_H_
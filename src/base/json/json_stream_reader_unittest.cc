@@ -0,0 +1,275 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_stream_reader.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/files/file.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/json/json_reader.h"
+#include "base/json/json_writer.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
+
+namespace base {
+
+namespace {
+
+// Rebuilds a Value from the events it receives.
+class ValueBuilder : public JSONStreamReader::Delegate {
+ public:
+  ValueBuilder() = default;
+  ValueBuilder(const ValueBuilder&) = delete;
+  ValueBuilder& operator=(const ValueBuilder&) = delete;
+  ~ValueBuilder() override = default;
+
+  // Makes the delegate stop parsing after |count| more events.
+  void StopAfter(int count) { events_until_stop_ = count; }
+
+  int event_count() const { return event_count_; }
+  absl::optional<Value>& result() { return result_; }
+
+  // JSONStreamReader::Delegate:
+  bool OnDictStart() override {
+    stack_.emplace_back(Value::Type::DICTIONARY);
+    return OnEvent();
+  }
+  bool OnDictKey(StringPiece key) override {
+    keys_.emplace_back(key);
+    return OnEvent();
+  }
+  bool OnDictEnd() override {
+    Value dict = std::move(stack_.back());
+    stack_.pop_back();
+    Add(std::move(dict));
+    return OnEvent();
+  }
+  bool OnListStart() override {
+    stack_.emplace_back(Value::Type::LIST);
+    return OnEvent();
+  }
+  bool OnListEnd() override {
+    Value list = std::move(stack_.back());
+    stack_.pop_back();
+    Add(std::move(list));
+    return OnEvent();
+  }
+  bool OnScalar(Value value) override {
+    Add(std::move(value));
+    return OnEvent();
+  }
+
+ private:
+  void Add(Value value) {
+    if (stack_.empty()) {
+      EXPECT_FALSE(result_);
+      result_ = std::move(value);
+    } else if (stack_.back().is_dict()) {
+      stack_.back().GetDict().Set(keys_.back(), std::move(value));
+      keys_.pop_back();
+    } else {
+      stack_.back().GetList().Append(std::move(value));
+    }
+  }
+
+  bool OnEvent() {
+    ++event_count_;
+    return events_until_stop_ < 0 || --events_until_stop_ > 0;
+  }
+
+  std::vector<Value> stack_;
+  std::vector<std::string> keys_;
+  absl::optional<Value> result_;
+  int event_count_ = 0;
+  int events_until_stop_ = -1;
+};
+
+const char* const kValidDocuments[] = {
+    "null",
+    "  true  ",
+    "-12.5e3",
+    "\"\\u00e9t\\u00e9 \\\\ \\\"quoted\\\"\"",
+    "\xEF\xBB\xBF[1, 2, 3]",
+    "[]",
+    "{}",
+    "{\"a\": {\"b\": [1, {\"c\": null}, [], \"d\"]}, \"e\": false}",
+    "{\"dup\": 1, \"dup\": 2}",
+    "[1, 2, 3,]",
+    "// line comment\n[1, /* block\ncomment */ 2]\r\n",
+    "{\"multi\\nline\": \"value\\twith\\rescapes\"}",
+};
+
+// Parses |json| after splitting it at |split_points|.
+absl::optional<Value> ParseInChunks(StringPiece json,
+                                    const std::vector<size_t>& split_points,
+                                    int options) {
+  ValueBuilder builder;
+  JSONStreamReader reader(&builder, options);
+  size_t start = 0;
+  for (size_t split : split_points) {
+    EXPECT_TRUE(reader.Feed(json.substr(start, split - start)));
+    start = split;
+  }
+  EXPECT_TRUE(reader.Feed(json.substr(start)));
+  if (!reader.Finish())
+    return absl::nullopt;
+  return std::move(builder.result());
+}
+
+}  // namespace
+
+TEST(JSONStreamReaderTest, MatchesJSONReader) {
+  const int options =
+      JSON_PARSE_CHROMIUM_EXTENSIONS | JSON_ALLOW_TRAILING_COMMAS;
+  for (const char* json : kValidDocuments) {
+    SCOPED_TRACE(json);
+    absl::optional<Value> expected = JSONReader::Read(json, options);
+    ASSERT_TRUE(expected);
+
+    // Whole input at once.
+    EXPECT_EQ(*expected, ParseInChunks(json, {}, options));
+
+    // Every possible single split point, and one byte at a time.
+    const StringPiece input(json);
+    std::vector<size_t> every_byte;
+    for (size_t i = 1; i < input.size(); ++i) {
+      EXPECT_EQ(*expected, ParseInChunks(input, {i}, options)) << i;
+      every_byte.push_back(i);
+    }
+    EXPECT_EQ(*expected, ParseInChunks(input, every_byte, options));
+  }
+}
+
+TEST(JSONStreamReaderTest, Events) {
+  ValueBuilder builder;
+  JSONStreamReader reader(&builder);
+  EXPECT_TRUE(reader.Feed("{\"a\": [1, \"x\"], \"b\": {}}"));
+  EXPECT_TRUE(reader.Finish());
+  EXPECT_FALSE(reader.error());
+  // {, a, [, 1, "x", ], b, {, }, }
+  EXPECT_EQ(10, builder.event_count());
+}
+
+TEST(JSONStreamReaderTest, UnescapedStrings) {
+  // Records the strings passed to OnUnescapedString(), and how many strings
+  // were decoded.
+  class StringRecorder : public ValueBuilder {
+   public:
+    bool OnUnescapedString(StringPiece value) override {
+      unescaped.emplace_back(value);
+      return ValueBuilder::OnScalar(Value(value));
+    }
+    bool OnScalar(Value value) override {
+      if (value.is_string())
+        ++decoded_count;
+      return ValueBuilder::OnScalar(std::move(value));
+    }
+
+    std::vector<std::string> unescaped;
+    int decoded_count = 0;
+  };
+
+  const char kJson[] = "{\"k\": [\"plain\", \"tab\\there\", \"\", 1]}";
+  StringRecorder recorder;
+  JSONStreamReader reader(&recorder);
+  EXPECT_TRUE(reader.Feed(kJson));
+  EXPECT_TRUE(reader.Finish());
+  EXPECT_EQ(std::vector<std::string>({"plain", ""}), recorder.unescaped);
+  EXPECT_EQ(1, recorder.decoded_count);
+  EXPECT_EQ(*JSONReader::Read(kJson), recorder.result());
+}
+
+TEST(JSONStreamReaderTest, ErrorsMatchJSONReader) {
+  const char* const kInvalidDocuments[] = {
+      "",
+      "nu",
+      "{},{}",
+      "[1,]",
+      "{\"foo\":\"bar\",}",
+      "{foo:\"bar\"}",
+      "{\"foo\" \"bar\"}",
+      "[1 2]",
+      "[\"xxx\\q\"]",
+      "[\n  \"a\",\n  \"b\\q\"\n]",
+      "[1, 2",
+      "[\"unterminated",
+      "\"\\x01\"",
+      "[1] // comment",
+  };
+  for (const char* json : kInvalidDocuments) {
+    SCOPED_TRACE(json);
+    auto expected = JSONReader::ReadAndReturnValueWithError(json, 0);
+    ASSERT_FALSE(expected.has_value());
+
+    ValueBuilder builder;
+    JSONStreamReader reader(&builder, 0);
+    reader.Feed(json);
+    EXPECT_FALSE(reader.Finish());
+    ASSERT_TRUE(reader.error());
+    EXPECT_EQ(expected.error().message, reader.error()->message);
+    EXPECT_EQ(expected.error().line, reader.error()->line);
+    EXPECT_EQ(expected.error().column, reader.error()->column);
+  }
+}
+
+TEST(JSONStreamReaderTest, TooMuchNesting) {
+  std::string nested_json;
+  for (int i = 0; i < 201; ++i) {
+    nested_json.insert(nested_json.begin(), '[');
+    nested_json.append(1, ']');
+  }
+  auto expected = JSONReader::ReadAndReturnValueWithError(nested_json);
+  ASSERT_FALSE(expected.has_value());
+
+  ValueBuilder builder;
+  JSONStreamReader reader(&builder);
+  EXPECT_FALSE(reader.Feed(nested_json));
+  ASSERT_TRUE(reader.error());
+  EXPECT_EQ(expected.error().message, reader.error()->message);
+}
+
+TEST(JSONStreamReaderTest, DelegateStops) {
+  ValueBuilder builder;
+  builder.StopAfter(3);
+  JSONStreamReader reader(&builder);
+  EXPECT_FALSE(reader.Feed("[1, 2, 3, 4]"));
+  EXPECT_EQ(3, builder.event_count());
+  EXPECT_FALSE(reader.Feed("[5]"));
+  EXPECT_FALSE(reader.Finish());
+  EXPECT_EQ(3, builder.event_count());
+  EXPECT_FALSE(reader.error());
+}
+
+TEST(JSONStreamReaderTest, ReadFile) {
+  ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  const FilePath path = temp_dir.GetPath().AppendASCII("large.json");
+
+  Value::List list;
+  for (int i = 0; i < 1000; ++i) {
+    Value::Dict dict;
+    dict.Set("index", i);
+    dict.Set("name", std::string(i % 100, 'x'));
+    list.Append(std::move(dict));
+  }
+  Value expected(std::move(list));
+  std::string json;
+  ASSERT_TRUE(JSONWriter::Write(expected, &json));
+  ASSERT_TRUE(WriteFile(path, json));
+
+  File file(path, File::FLAG_OPEN | File::FLAG_READ);
+  ASSERT_TRUE(file.IsValid());
+  ValueBuilder builder;
+  JSONStreamReader reader(&builder);
+  // A small chunk size splits most tokens.
+  EXPECT_TRUE(reader.ReadFile(file, 7));
+  EXPECT_EQ(expected, builder.result());
+}
+
+}  // namespace base
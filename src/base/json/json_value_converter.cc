@@ -4,11 +4,250 @@
 
 #include "base/json/json_value_converter.h"
 
+#include <algorithm>
+#include <utility>
+
+#include "base/json/json_reader.h"
+#include "base/json/json_stream_reader.h"
+#include "base/parsing_buildflags.h"
+#include "base/strings/string_util.h"
 #include "base/strings/utf_string_conversions.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
 
 namespace base {
 namespace internal {
 
+namespace {
+
+// Delivers parse events to the converter of the innermost open container.
+class EventDispatcher : public JSONStreamReader::Delegate {
+ public:
+  explicit EventDispatcher(std::unique_ptr<ContainerConverter> root)
+      : root_(std::move(root)) {}
+
+  EventDispatcher(const EventDispatcher&) = delete;
+  EventDispatcher& operator=(const EventDispatcher&) = delete;
+
+  ~EventDispatcher() override = default;
+
+  // JSONStreamReader::Delegate:
+  bool OnDictStart() override { return OnContainerStart(/*is_dict=*/true); }
+  bool OnDictKey(StringPiece key) override { return stack_.back()->OnKey(key); }
+  bool OnDictEnd() override { return OnContainerEnd(); }
+  bool OnListStart() override { return OnContainerStart(/*is_dict=*/false); }
+  bool OnListEnd() override { return OnContainerEnd(); }
+  bool OnScalar(Value value) override {
+    // The root must be a dictionary.
+    return !stack_.empty() && stack_.back()->OnScalar(value);
+  }
+
+ private:
+  bool OnContainerStart(bool is_dict) {
+    std::unique_ptr<ContainerConverter> converter;
+    if (stack_.empty()) {
+      // The root must be a dictionary.
+      if (!is_dict || !root_)
+        return false;
+      converter = std::move(root_);
+    } else {
+      converter = stack_.back()->OnContainer(is_dict);
+      if (!converter)
+        return false;
+    }
+    stack_.push_back(std::move(converter));
+    return true;
+  }
+
+  bool OnContainerEnd() {
+    const bool result = stack_.back()->OnEnd();
+    stack_.pop_back();
+    return result;
+  }
+
+  std::unique_ptr<ContainerConverter> root_;
+  // The converters of all open containers, innermost last.
+  std::vector<std::unique_ptr<ContainerConverter>> stack_;
+};
+
+#if BUILDFLAG(BUILD_RUST_JSON_PARSER)
+// JSONStreamReader is not built along with the Rust JSON parser, so the events
+// are replayed from a parsed Value instead. Only the Delegate interface, which
+// is header-only, is used.
+bool ReplayEvents(const Value& value, JSONStreamReader::Delegate* delegate) {
+  if (const Value::Dict* dict = value.GetIfDict()) {
+    if (!delegate->OnDictStart())
+      return false;
+    for (const auto [key, member] : *dict) {
+      if (!delegate->OnDictKey(key) || !ReplayEvents(member, delegate))
+        return false;
+    }
+    return delegate->OnDictEnd();
+  }
+  if (const Value::List* list = value.GetIfList()) {
+    if (!delegate->OnListStart())
+      return false;
+    for (const Value& element : *list) {
+      if (!ReplayEvents(element, delegate))
+        return false;
+    }
+    return delegate->OnListEnd();
+  }
+  return delegate->OnScalar(value.Clone());
+}
+#endif  // BUILDFLAG(BUILD_RUST_JSON_PARSER)
+
+}  // namespace
+
+bool ContainerConverter::OnKey(StringPiece key) {
+  return true;
+}
+
+bool ContainerConverter::OnEnd() {
+  return true;
+}
+
+bool SkippingConverter::OnScalar(const Value& value) {
+  return true;
+}
+
+std::unique_ptr<ContainerConverter> SkippingConverter::OnContainer(
+    bool is_dict) {
+  return std::make_unique<SkippingConverter>();
+}
+
+FailureRecordingConverter::FailureRecordingConverter(
+    std::unique_ptr<ContainerConverter> converter,
+    bool* failed)
+    : converter_(std::move(converter)), failed_(failed) {}
+
+FailureRecordingConverter::~FailureRecordingConverter() = default;
+
+bool FailureRecordingConverter::OnKey(StringPiece key) {
+  if (!*failed_ && !converter_->OnKey(key))
+    *failed_ = true;
+  return true;
+}
+
+bool FailureRecordingConverter::OnScalar(const Value& value) {
+  if (!*failed_ && !converter_->OnScalar(value))
+    *failed_ = true;
+  return true;
+}
+
+std::unique_ptr<ContainerConverter> FailureRecordingConverter::OnContainer(
+    bool is_dict) {
+  if (!*failed_) {
+    std::unique_ptr<ContainerConverter> converter =
+        converter_->OnContainer(is_dict);
+    if (converter) {
+      return std::make_unique<FailureRecordingConverter>(std::move(converter),
+                                                         failed_);
+    }
+    *failed_ = true;
+  }
+  return std::make_unique<SkippingConverter>();
+}
+
+bool FailureRecordingConverter::OnEnd() {
+  if (!*failed_ && !converter_->OnEnd())
+    *failed_ = true;
+  return true;
+}
+
+// Adds a nested container to the container of its parent.
+class ValueBuildingConverter::Child : public ValueBuildingConverter {
+ public:
+  Child(bool is_dict, ValueBuildingConverter* parent)
+      : ValueBuildingConverter(is_dict), parent_(parent) {}
+
+  bool OnValue(Value value) override {
+    parent_->Add(std::move(value));
+    return true;
+  }
+
+ private:
+  const raw_ptr<ValueBuildingConverter> parent_;
+};
+
+ValueBuildingConverter::ValueBuildingConverter(bool is_dict)
+    : value_(is_dict ? Value::Type::DICT : Value::Type::LIST) {}
+
+ValueBuildingConverter::~ValueBuildingConverter() = default;
+
+bool ValueBuildingConverter::OnKey(StringPiece key) {
+  key_.assign(key.data(), key.size());
+  return true;
+}
+
+bool ValueBuildingConverter::OnScalar(const Value& value) {
+  Add(value.Clone());
+  return true;
+}
+
+std::unique_ptr<ContainerConverter> ValueBuildingConverter::OnContainer(
+    bool is_dict) {
+  return std::make_unique<Child>(is_dict, this);
+}
+
+bool ValueBuildingConverter::OnEnd() {
+  return OnValue(std::move(value_));
+}
+
+void ValueBuildingConverter::Add(Value value) {
+  if (value_.is_dict())
+    value_.GetDict().Set(key_, std::move(value));
+  else
+    value_.GetList().Append(std::move(value));
+}
+
+bool ConvertJSONEvents(StringPiece json,
+                       int options,
+                       std::unique_ptr<ContainerConverter> root) {
+  EventDispatcher dispatcher(std::move(root));
+#if BUILDFLAG(BUILD_RUST_JSON_PARSER)
+  absl::optional<Value> value = JSONReader::Read(json, options);
+  return value && ReplayEvents(*value, &dispatcher);
+#else
+  JSONStreamReader reader(&dispatcher, options);
+  return reader.Feed(json) && reader.Finish();
+#endif
+}
+
+FieldIndex::FieldIndex() = default;
+
+FieldIndex::~FieldIndex() = default;
+
+void FieldIndex::Add(std::string path, size_t index) {
+  auto it = std::upper_bound(
+      entries_.begin(), entries_.end(), path,
+      [](const std::string& path, const Entry& entry) {
+        return path < entry.path;
+      });
+  entries_.insert(it, {std::move(path), index});
+}
+
+absl::optional<size_t> FieldIndex::Find(StringPiece path) const {
+  auto it = std::lower_bound(entries_.begin(), entries_.end(), path,
+                             [](const Entry& entry, StringPiece path) {
+                               return StringPiece(entry.path) < path;
+                             });
+  if (it == entries_.end() || it->path != path)
+    return absl::nullopt;
+  return it->index;
+}
+
+span<const FieldIndex::Entry> FieldIndex::FindWithPrefix(
+    StringPiece prefix) const {
+  auto begin = std::lower_bound(entries_.begin(), entries_.end(), prefix,
+                                [](const Entry& entry, StringPiece prefix) {
+                                  return StringPiece(entry.path) < prefix;
+                                });
+  auto end = begin;
+  while (end != entries_.end() && StartsWith(end->path, prefix))
+    ++end;
+  return make_span(begin, end);
+}
+
 bool BasicValueConverter<int>::Convert(
     const base::Value& value, int* field) const {
   if (!value.is_int())
@@ -9,14 +9,19 @@
 
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 #include "base/base_export.h"
+#include "base/containers/span.h"
+#include "base/json/json_reader.h"
 #include "base/logging.h"
 #include "base/memory/ptr_util.h"
+#include "base/memory/raw_ptr.h"
 #include "base/strings/string_piece.h"
 #include "base/values.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
 
 // JSONValueConverter converts a JSON value into a C++ struct in a
 // lightweight way.
@@ -53,6 +58,10 @@
 // Also note that Convert() will modify the passed |message| even when it
 // fails for performance reason.
 //
+// If the input is JSON text, ConvertJSON() parses it and fills in the struct
+// in a single pass, without building a base::Value for it first:
+//   converter.ConvertJSON(json_text, &message);
+//
 // For nested field, the internal message also has to implement the registration
 // method.  Then, just use RegisterNestedField() from the containing struct's
 // RegisterJSONConverter method.
@@ -91,6 +100,148 @@ class JSONValueConverter;
 
 namespace internal {
 
+// Converts the contents of a single JSON list or dictionary from the parse
+// events of a JSONStreamReader, without building a Value for it. Used by
+// JSONValueConverter::ConvertJSON(). Every method returns false, or nullptr,
+// if the value cannot be converted, which stops the conversion.
+class BASE_EXPORT ContainerConverter {
+ public:
+  virtual ~ContainerConverter() = default;
+
+  // Called with each key of a dictionary, before the events for its value.
+  virtual bool OnKey(StringPiece key);
+  // Called for each element or member that is not a list or dictionary.
+  virtual bool OnScalar(const Value& value) = 0;
+  // Called for each element or member that is a list or dictionary. Returns
+  // the converter for its contents.
+  virtual std::unique_ptr<ContainerConverter> OnContainer(bool is_dict) = 0;
+  // Called once the container is complete.
+  virtual bool OnEnd();
+};
+
+// Accepts and ignores a container.
+class BASE_EXPORT SkippingConverter : public ContainerConverter {
+ public:
+  SkippingConverter() = default;
+
+  SkippingConverter(const SkippingConverter&) = delete;
+  SkippingConverter& operator=(const SkippingConverter&) = delete;
+
+  bool OnScalar(const Value& value) override;
+  std::unique_ptr<ContainerConverter> OnContainer(bool is_dict) override;
+};
+
+// Forwards the events of a container to |converter| until it fails, then
+// ignores them, recording the failure in |*failed| instead of stopping the
+// conversion, since a later member with the same key may replace the field.
+class BASE_EXPORT FailureRecordingConverter : public ContainerConverter {
+ public:
+  FailureRecordingConverter(std::unique_ptr<ContainerConverter> converter,
+                            bool* failed);
+
+  FailureRecordingConverter(const FailureRecordingConverter&) = delete;
+  FailureRecordingConverter& operator=(const FailureRecordingConverter&) =
+      delete;
+
+  ~FailureRecordingConverter() override;
+
+  bool OnKey(StringPiece key) override;
+  bool OnScalar(const Value& value) override;
+  std::unique_ptr<ContainerConverter> OnContainer(bool is_dict) override;
+  bool OnEnd() override;
+
+ private:
+  std::unique_ptr<ContainerConverter> converter_;
+  const raw_ptr<bool> failed_;
+};
+
+// Builds a Value from a container, for fields whose converters need one.
+class BASE_EXPORT ValueBuildingConverter : public ContainerConverter {
+ public:
+  explicit ValueBuildingConverter(bool is_dict);
+
+  ValueBuildingConverter(const ValueBuildingConverter&) = delete;
+  ValueBuildingConverter& operator=(const ValueBuildingConverter&) = delete;
+
+  ~ValueBuildingConverter() override;
+
+  // Called with the complete container.
+  virtual bool OnValue(Value value) = 0;
+
+  bool OnKey(StringPiece key) override;
+  bool OnScalar(const Value& value) override;
+  std::unique_ptr<ContainerConverter> OnContainer(bool is_dict) override;
+  bool OnEnd() override;
+
+ private:
+  class Child;
+
+  void Add(Value value);
+
+  Value value_;
+  std::string key_;
+};
+
+template <typename OnValueFunction>
+class CallbackValueBuildingConverter : public ValueBuildingConverter {
+ public:
+  CallbackValueBuildingConverter(bool is_dict, OnValueFunction on_value)
+      : ValueBuildingConverter(is_dict), on_value_(std::move(on_value)) {}
+
+  bool OnValue(Value value) override { return on_value_(value); }
+
+ private:
+  OnValueFunction on_value_;
+};
+
+// Returns a converter that builds a Value from a container and passes it to
+// |on_value|, which returns whether it could be converted.
+template <typename OnValueFunction>
+std::unique_ptr<ContainerConverter> MakeValueBuildingConverter(
+    bool is_dict,
+    OnValueFunction on_value) {
+  return std::make_unique<CallbackValueBuildingConverter<OnValueFunction>>(
+      is_dict, std::move(on_value));
+}
+
+// Parses |json| and feeds its events to |root|, the converter for the root
+// dictionary. Returns false if |json| is malformed, its root is not a
+// dictionary, or the conversion fails.
+BASE_EXPORT bool ConvertJSONEvents(StringPiece json,
+                                   int options,
+                                   std::unique_ptr<ContainerConverter> root);
+
+// Looks up the fields of a JSONValueConverter by path, with binary searches
+// over the sorted paths.
+class BASE_EXPORT FieldIndex {
+ public:
+  struct Entry {
+    std::string path;
+    // The index of the field in the order of registration.
+    size_t index;
+  };
+
+  FieldIndex();
+
+  FieldIndex(const FieldIndex&) = delete;
+  FieldIndex& operator=(const FieldIndex&) = delete;
+
+  ~FieldIndex();
+
+  size_t size() const { return entries_.size(); }
+
+  void Add(std::string path, size_t index);
+
+  // Returns the index of the field registered for |path|, if any.
+  absl::optional<size_t> Find(StringPiece path) const;
+
+  // Returns the fields whose path starts with |prefix|.
+  span<const Entry> FindWithPrefix(StringPiece prefix) const;
+
+ private:
+  std::vector<Entry> entries_;
+};
+
 template <typename StructType>
 class FieldConverterBase {
  public:
@@ -102,6 +253,14 @@ class FieldConverterBase {
   virtual ~FieldConverterBase() = default;
   virtual bool ConvertField(const base::Value& value,
                             StructType* obj) const = 0;
+  // Returns the converter for the field when its value is a list or
+  // dictionary, or nullptr if it cannot be converted.
+  virtual std::unique_ptr<ContainerConverter> CreateContainerConverter(
+      bool is_dict,
+      StructType* obj) const = 0;
+  // Resets the field to its default value, before converting a member which
+  // replaces a previous one with the same key. Returns false if it cannot be.
+  virtual bool ResetField(StructType* obj) const = 0;
   const std::string& field_path() const { return field_path_; }
 
  private:
@@ -113,6 +272,28 @@ class ValueConverter {
  public:
   virtual ~ValueConverter() = default;
   virtual bool Convert(const base::Value& value, FieldType* field) const = 0;
+
+  // Returns the converter for a list or dictionary value, or nullptr if it
+  // cannot be converted. By default, a Value is built and passed to Convert().
+  virtual std::unique_ptr<ContainerConverter> CreateContainerConverter(
+      bool is_dict,
+      FieldType* field) const {
+    return MakeValueBuildingConverter(
+        is_dict, [this, field](const Value& value) {
+          return Convert(value, field);
+        });
+  }
+};
+
+// A ValueConverter that only accepts null, booleans, numbers and strings.
+template <typename FieldType>
+class ScalarValueConverter : public ValueConverter<FieldType> {
+ public:
+  std::unique_ptr<ContainerConverter> CreateContainerConverter(
+      bool is_dict,
+      FieldType* field) const override {
+    return nullptr;
+  }
 };
 
 template <typename StructType, typename FieldType>
@@ -132,6 +313,23 @@ class FieldConverter : public FieldConverterBase<StructType> {
     return value_converter_->Convert(value, &(dst->*field_pointer_));
   }
 
+  std::unique_ptr<ContainerConverter> CreateContainerConverter(
+      bool is_dict,
+      StructType* dst) const override {
+    return value_converter_->CreateContainerConverter(is_dict,
+                                                      &(dst->*field_pointer_));
+  }
+
+  bool ResetField(StructType* dst) const override {
+    if constexpr (std::is_default_constructible<FieldType>::value &&
+                  std::is_move_assignable<FieldType>::value) {
+      dst->*field_pointer_ = FieldType();
+      return true;
+    } else {
+      return false;
+    }
+  }
+
  private:
   FieldType StructType::*field_pointer_;
   std::unique_ptr<ValueConverter<FieldType>> value_converter_;
@@ -141,7 +339,8 @@ template <typename FieldType>
 class BasicValueConverter;
 
 template <>
-class BASE_EXPORT BasicValueConverter<int> : public ValueConverter<int> {
+class BASE_EXPORT BasicValueConverter<int>
+    : public ScalarValueConverter<int> {
  public:
   BasicValueConverter() = default;
 
@@ -153,7 +352,7 @@ class BASE_EXPORT BasicValueConverter<int> : public ValueConverter<int> {
 
 template <>
 class BASE_EXPORT BasicValueConverter<std::string>
-    : public ValueConverter<std::string> {
+    : public ScalarValueConverter<std::string> {
  public:
   BasicValueConverter() = default;
 
@@ -165,7 +364,7 @@ class BASE_EXPORT BasicValueConverter<std::string>
 
 template <>
 class BASE_EXPORT BasicValueConverter<std::u16string>
-    : public ValueConverter<std::u16string> {
+    : public ScalarValueConverter<std::u16string> {
  public:
   BasicValueConverter() = default;
 
@@ -176,7 +375,8 @@ class BASE_EXPORT BasicValueConverter<std::u16string>
 };
 
 template <>
-class BASE_EXPORT BasicValueConverter<double> : public ValueConverter<double> {
+class BASE_EXPORT BasicValueConverter<double>
+    : public ScalarValueConverter<double> {
  public:
   BasicValueConverter() = default;
 
@@ -187,7 +387,8 @@ class BASE_EXPORT BasicValueConverter<double> : public ValueConverter<double> {
 };
 
 template <>
-class BASE_EXPORT BasicValueConverter<bool> : public ValueConverter<bool> {
+class BASE_EXPORT BasicValueConverter<bool>
+    : public ScalarValueConverter<bool> {
  public:
   BasicValueConverter() = default;
 
@@ -217,7 +418,7 @@ class ValueFieldConverter : public ValueConverter<FieldType> {
 };
 
 template <typename FieldType>
-class CustomFieldConverter : public ValueConverter<FieldType> {
+class CustomFieldConverter : public ScalarValueConverter<FieldType> {
  public:
   typedef bool (*ConvertFunc)(StringPiece value, FieldType* field);
 
@@ -247,10 +448,55 @@ class NestedValueConverter : public ValueConverter<NestedType> {
     return converter_.Convert(value, field);
   }
 
+  std::unique_ptr<ContainerConverter> CreateContainerConverter(
+      bool is_dict,
+      NestedType* field) const override {
+    return is_dict ? converter_.CreateDictConverter(field) : nullptr;
+  }
+
  private:
   JSONValueConverter<NestedType> converter_;
 };
 
+// Converts the elements of a list with |element_converter|.
+template <typename Element>
+class RepeatedElementConverter : public ContainerConverter {
+ public:
+  RepeatedElementConverter(const ValueConverter<Element>* element_converter,
+                           std::vector<std::unique_ptr<Element>>* field)
+      : element_converter_(element_converter), field_(field) {}
+
+  RepeatedElementConverter(const RepeatedElementConverter&) = delete;
+  RepeatedElementConverter& operator=(const RepeatedElementConverter&) =
+      delete;
+
+  bool OnScalar(const Value& value) override {
+    auto element = std::make_unique<Element>();
+    if (!element_converter_->Convert(value, element.get())) {
+      DVLOG(1) << "failure at " << field_->size() << "-th element";
+      return false;
+    }
+    field_->push_back(std::move(element));
+    return true;
+  }
+
+  std::unique_ptr<ContainerConverter> OnContainer(bool is_dict) override {
+    auto element = std::make_unique<Element>();
+    std::unique_ptr<ContainerConverter> converter =
+        element_converter_->CreateContainerConverter(is_dict, element.get());
+    if (!converter) {
+      DVLOG(1) << "failure at " << field_->size() << "-th element";
+      return nullptr;
+    }
+    field_->push_back(std::move(element));
+    return converter;
+  }
+
+ private:
+  const raw_ptr<const ValueConverter<Element>> element_converter_;
+  const raw_ptr<std::vector<std::unique_ptr<Element>>> field_;
+};
+
 template <typename Element>
 class RepeatedValueConverter
     : public ValueConverter<std::vector<std::unique_ptr<Element>>> {
@@ -283,6 +529,15 @@ class RepeatedValueConverter
     return true;
   }
 
+  std::unique_ptr<ContainerConverter> CreateContainerConverter(
+      bool is_dict,
+      std::vector<std::unique_ptr<Element>>* field) const override {
+    if (is_dict)
+      return nullptr;
+    return std::make_unique<RepeatedElementConverter<Element>>(
+        &basic_converter_, field);
+  }
+
  private:
   BasicValueConverter<Element> basic_converter_;
 };
@@ -317,8 +572,17 @@ class RepeatedMessageConverter
     return true;
   }
 
+  std::unique_ptr<ContainerConverter> CreateContainerConverter(
+      bool is_dict,
+      std::vector<std::unique_ptr<NestedType>>* field) const override {
+    if (is_dict)
+      return nullptr;
+    return std::make_unique<RepeatedElementConverter<NestedType>>(&converter_,
+                                                                  field);
+  }
+
  private:
-  JSONValueConverter<NestedType> converter_;
+  NestedValueConverter<NestedType> converter_;
 };
 
 template <typename NestedType>
@@ -328,7 +592,7 @@ class RepeatedCustomValueConverter
   typedef bool (*ConvertFunc)(const base::Value* value, NestedType* field);
 
   explicit RepeatedCustomValueConverter(ConvertFunc convert_func)
-      : convert_func_(convert_func) {}
+      : convert_func_(convert_func), element_converter_(convert_func) {}
 
   RepeatedCustomValueConverter(const RepeatedCustomValueConverter&) = delete;
   RepeatedCustomValueConverter& operator=(const RepeatedCustomValueConverter&) =
@@ -355,8 +619,160 @@ class RepeatedCustomValueConverter
     return true;
   }
 
+  std::unique_ptr<ContainerConverter> CreateContainerConverter(
+      bool is_dict,
+      std::vector<std::unique_ptr<NestedType>>* field) const override {
+    if (is_dict)
+      return nullptr;
+    return std::make_unique<RepeatedElementConverter<NestedType>>(
+        &element_converter_, field);
+  }
+
  private:
   ConvertFunc convert_func_;
+  ValueFieldConverter<NestedType> element_converter_;
+};
+
+// Converts the members of a dictionary into the registered fields of a
+// struct. The conversion of a member which fails is only reported once the
+// struct's dictionary ends, since, as in JSONValueConverter::Convert(), which
+// reads the last of the members with the same key, a later member may replace
+// it.
+template <typename StructType>
+class StructConverter : public ContainerConverter {
+ public:
+  using Fields = std::vector<std::unique_ptr<FieldConverterBase<StructType>>>;
+
+  // The state of the conversion of a struct, shared by the converters of its
+  // dictionary and of the dictionaries nested in it through dotted paths.
+  struct State {
+    struct FieldState {
+      // Whether a member was converted into the field.
+      bool converted = false;
+      // Whether the conversion of that member failed.
+      bool failed = false;
+    };
+
+    State(const Fields* fields,
+          const FieldIndex* field_index,
+          StructType* output)
+        : fields(fields),
+          field_index(field_index),
+          output(output),
+          field_states(fields->size()) {}
+
+    const raw_ptr<const Fields> fields;
+    const raw_ptr<const FieldIndex> field_index;
+    const raw_ptr<StructType> output;
+    std::vector<FieldState> field_states;
+  };
+
+  // Converts the dictionary of the struct itself.
+  StructConverter(const Fields* fields,
+                  const FieldIndex* field_index,
+                  StructType* output)
+      : owned_state_(std::make_unique<State>(fields, field_index, output)),
+        state_(owned_state_.get()) {}
+
+  // Converts the dictionary at |path_prefix|, the dotted path of the
+  // dictionary within the struct's own followed by a '.'.
+  StructConverter(State* state, std::string path_prefix)
+      : state_(state), path_prefix_(std::move(path_prefix)) {}
+
+  StructConverter(const StructConverter&) = delete;
+  StructConverter& operator=(const StructConverter&) = delete;
+
+  bool OnKey(StringPiece key) override {
+    field_ = absl::nullopt;
+    path_.assign(path_prefix_);
+    path_.append(key.data(), key.size());
+    // Field paths are split at dots, so they never match a key with a dot.
+    key_has_dot_ = key.find('.') != StringPiece::npos;
+    if (key_has_dot_)
+      return true;
+
+    // The member replaces the fields converted from a previous one with the
+    // same key, including those in a dictionary nested in it.
+    path_.push_back('.');
+    for (const FieldIndex::Entry& entry :
+         state_->field_index->FindWithPrefix(path_)) {
+      if (!ResetField(entry.index))
+        return false;
+    }
+    path_.pop_back();
+    field_ = state_->field_index->Find(path_);
+    return !field_ || ResetField(*field_);
+  }
+
+  bool OnScalar(const Value& value) override {
+    if (!field_)
+      return true;
+    typename State::FieldState& field_state = state_->field_states[*field_];
+    field_state.converted = true;
+    field_state.failed =
+        !(*state_->fields)[*field_]->ConvertField(value, state_->output);
+    DVLOG_IF(1, field_state.failed) << "failure at field " << path_;
+    return true;
+  }
+
+  std::unique_ptr<ContainerConverter> OnContainer(bool is_dict) override {
+    if (field_) {
+      typename State::FieldState& field_state = state_->field_states[*field_];
+      field_state.converted = true;
+      std::unique_ptr<ContainerConverter> converter =
+          (*state_->fields)[*field_]->CreateContainerConverter(
+              is_dict, state_->output);
+      if (converter) {
+        return std::make_unique<FailureRecordingConverter>(
+            std::move(converter), &field_state.failed);
+      }
+      DVLOG(1) << "failure at field " << path_;
+      field_state.failed = true;
+      return std::make_unique<SkippingConverter>();
+    }
+    if (is_dict && !key_has_dot_) {
+      // Descend if fields are registered under a dotted path through here.
+      std::string prefix = path_ + ".";
+      if (!state_->field_index->FindWithPrefix(prefix).empty())
+        return std::make_unique<StructConverter>(state_, std::move(prefix));
+    }
+    return std::make_unique<SkippingConverter>();
+  }
+
+  bool OnEnd() override {
+    // The fields are checked once the struct's own dictionary ends.
+    if (!owned_state_)
+      return true;
+    for (const typename State::FieldState& field_state :
+         state_->field_states) {
+      if (field_state.failed)
+        return false;
+    }
+    return true;
+  }
+
+ private:
+  bool ResetField(size_t field) {
+    typename State::FieldState& field_state = state_->field_states[field];
+    if (!field_state.converted)
+      return true;
+    field_state = {};
+    if (!(*state_->fields)[field]->ResetField(state_->output)) {
+      DVLOG(1) << "cannot replace field "
+               << (*state_->fields)[field]->field_path();
+      return false;
+    }
+    return true;
+  }
+
+  const std::unique_ptr<State> owned_state_;
+  const raw_ptr<State> state_;
+  const std::string path_prefix_;
+
+  // The dotted path of the current member, and its field if it has one.
+  std::string path_;
+  bool key_has_dot_ = false;
+  absl::optional<size_t> field_;
 };
 
 }  // namespace internal
@@ -364,7 +780,11 @@ class RepeatedCustomValueConverter
 template <class StructType>
 class JSONValueConverter {
  public:
-  JSONValueConverter() { StructType::RegisterJSONConverter(this); }
+  JSONValueConverter() {
+    StructType::RegisterJSONConverter(this);
+    for (size_t i = 0; i < fields_.size(); ++i)
+      field_index_.Add(fields_[i]->field_path(), i);
+  }
 
   JSONValueConverter(const JSONValueConverter&) = delete;
   JSONValueConverter& operator=(const JSONValueConverter&) = delete;
@@ -501,6 +921,36 @@ class JSONValueConverter {
             new internal::RepeatedMessageConverter<NestedType>));
   }
 
+  // Parses the JSON text |json| and converts it like Convert(), in a single
+  // pass and without building a Value, except for fields registered with
+  // RegisterCustomValueField() or RegisterRepeatedCustomValue(), whose
+  // converters are given a Value for just that field. |options| are
+  // JSONParserOptions. Returns false if |json| is malformed or cannot be
+  // converted.
+  //
+  // As with Convert(), a field whose key appears more than once in a
+  // dictionary is converted from the last member with that key: it is reset to
+  // its default value before converting each later one, and fails the
+  // conversion if its type cannot be reset. Unlike Convert(), fields are
+  // converted in the order they appear in |json|, which only matters for the
+  // fields left converted when the conversion fails.
+  bool ConvertJSON(StringPiece json,
+                   StructType* output,
+                   int options = JSON_PARSE_CHROMIUM_EXTENSIONS) const {
+    return internal::ConvertJSONEvents(json, options,
+                                       CreateDictConverter(output));
+  }
+
+  // Returns a converter that fills in |output| from the parse events of a
+  // dictionary. Used by ConvertJSON().
+  std::unique_ptr<internal::ContainerConverter> CreateDictConverter(
+      StructType* output) const {
+    // Fields must only be registered by StructType::RegisterJSONConverter().
+    DCHECK_EQ(fields_.size(), field_index_.size());
+    return std::make_unique<internal::StructConverter<StructType>>(
+        &fields_, &field_index_, output);
+  }
+
   bool Convert(const base::Value& value, StructType* output) const {
     const Value::Dict* dict = value.GetIfDict();
     if (!dict)
@@ -524,6 +974,7 @@ class JSONValueConverter {
  private:
   std::vector<std::unique_ptr<internal::FieldConverterBase<StructType>>>
       fields_;
+  internal::FieldIndex field_index_;
 };
 
 }  // namespace base
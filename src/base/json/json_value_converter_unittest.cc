@@ -92,6 +92,20 @@ struct NestedMessage {
   }
 };
 
+// For fields in nested dictionaries.
+struct DottedPathMessage {
+  int outer = 0;
+  int inner = 0;
+  std::string deep;
+
+  static void RegisterJSONConverter(
+      base::JSONValueConverter<DottedPathMessage>* converter) {
+    converter->RegisterIntField("outer", &DottedPathMessage::outer);
+    converter->RegisterIntField("a.inner", &DottedPathMessage::inner);
+    converter->RegisterStringField("a.b.deep", &DottedPathMessage::deep);
+  }
+};
+
 }  // namespace
 
 TEST(JSONValueConverterTest, ParseSimpleMessage) {
@@ -259,4 +273,162 @@ TEST(JSONValueConverterTest, RepeatedValueErrorInTheMiddle) {
   // No check the values as mentioned above.
 }
 
+TEST(JSONValueConverterTest, ConvertJSONSimpleMessage) {
+  const char normal_data[] =
+      "{\n"
+      "  \"foo\": 1,\n"
+      "  \"bar\": \"bar\",\n"
+      "  \"unknown\": {\"foo\": [2, {\"bar\": 3}]},\n"
+      "  \"baz\": true,\n"
+      "  \"bstruct\": {},\n"
+      "  \"string_values\": [{\"val\": \"value_1\"}, {\"val\": \"value_2\"}],"
+      "  \"simple_enum\": \"bar\","
+      "  \"ints\": [1, 2]"
+      "}\n";
+
+  SimpleMessage message;
+  base::JSONValueConverter<SimpleMessage> converter;
+  EXPECT_TRUE(converter.ConvertJSON(normal_data, &message));
+
+  EXPECT_EQ(1, message.foo);
+  EXPECT_EQ("bar", message.bar);
+  EXPECT_TRUE(message.baz);
+  EXPECT_TRUE(message.bstruct);
+  EXPECT_EQ(SimpleMessage::BAR, message.simple_enum);
+  ASSERT_EQ(2U, message.ints.size());
+  EXPECT_EQ(1, *(message.ints[0]));
+  EXPECT_EQ(2, *(message.ints[1]));
+  ASSERT_EQ(2U, message.string_values.size());
+  EXPECT_EQ("value_1", *message.string_values[0]);
+  EXPECT_EQ("value_2", *message.string_values[1]);
+}
+
+TEST(JSONValueConverterTest, ConvertJSONNestedMessage) {
+  const char normal_data[] =
+      "{\n"
+      "  \"foo\": 1.5,\n"
+      "  \"child\": {\n"
+      "    \"foo\": 1,\n"
+      "    \"bar\": \"bar\",\n"
+      "    \"string_values\": [{\"val\": \"value_1\"}],"
+      "    \"baz\": true\n"
+      "  },\n"
+      "  \"children\": [{\n"
+      "    \"foo\": 2,\n"
+      "    \"bar\": \"foobar\",\n"
+      "    \"bstruct\": \"\"\n"
+      "  },\n"
+      "  {\n"
+      "    \"foo\": 3,\n"
+      "    \"ints\": [4]\n"
+      "  }]\n"
+      "}\n";
+
+  NestedMessage message;
+  base::JSONValueConverter<NestedMessage> converter;
+  EXPECT_TRUE(converter.ConvertJSON(normal_data, &message));
+
+  EXPECT_EQ(1.5, message.foo);
+  EXPECT_EQ(1, message.child.foo);
+  EXPECT_EQ("bar", message.child.bar);
+  EXPECT_TRUE(message.child.baz);
+  EXPECT_FALSE(message.child.bstruct);
+  ASSERT_EQ(1U, message.child.string_values.size());
+  EXPECT_EQ("value_1", *message.child.string_values[0]);
+
+  ASSERT_EQ(2U, message.children.size());
+  EXPECT_EQ(2, message.children[0]->foo);
+  EXPECT_EQ("foobar", message.children[0]->bar);
+  EXPECT_TRUE(message.children[0]->bstruct);
+  EXPECT_EQ(3, message.children[1]->foo);
+  ASSERT_EQ(1U, message.children[1]->ints.size());
+  EXPECT_EQ(4, *message.children[1]->ints[0]);
+}
+
+TEST(JSONValueConverterTest, ConvertJSONDottedPaths) {
+  DottedPathMessage message;
+  base::JSONValueConverter<DottedPathMessage> converter;
+  EXPECT_TRUE(converter.ConvertJSON(
+      "{\"outer\": 1, \"a\": {\"inner\": 2, \"b\": {\"deep\": \"x\"}},"
+      " \"a.inner\": \"not a nested path\"}",
+      &message));
+  EXPECT_EQ(1, message.outer);
+  EXPECT_EQ(2, message.inner);
+  EXPECT_EQ("x", message.deep);
+
+  // A path through something other than a dictionary is missing, not wrong.
+  DottedPathMessage other;
+  EXPECT_TRUE(converter.ConvertJSON("{\"a\": [1, 2]}", &other));
+  EXPECT_EQ(0, other.inner);
+}
+
+TEST(JSONValueConverterTest, ConvertJSONMatchesConvert) {
+  const char* const kDocuments[] = {
+      // Succeed.
+      "{}",
+      "{\"foo\": 1, \"ints\": []}",
+      "{\"child\": {\"bstruct\": [1, {\"a\": null}]}}",
+      "{\"foo\": true, \"foo\": 1}",
+      "{\"child\": {\"ints\": [false]}, \"child\": {}}",
+      "{\"children\": [1], \"children\": []}",
+      // Fail.
+      "{\"foo\": 1, \"bar\": 2}",
+      "{\"foo\": 1.5}",
+      "{\"child\": {\"simple_enum\": \"baz\"}}",
+      "{\"child\": {\"ints\": [1, false]}}",
+      "{\"child\": {\"ints\": [1, [2]]}}",
+      "{\"child\": {\"ints\": {\"0\": 1}}}",
+      "{\"child\": [1]}",
+      "{\"child\": {\"string_values\": [{\"val\": 1}]}}",
+      "{\"children\": [1]}",
+      "{\"children\": {}}",
+      "{\"foo\": 1, \"foo\": true}",
+      "{\"children\": [{}], \"children\": [1]}",
+      "[]",
+      "1",
+  };
+  base::JSONValueConverter<NestedMessage> converter;
+  for (const char* json : kDocuments) {
+    SCOPED_TRACE(json);
+    absl::optional<Value> value = base::JSONReader::Read(json);
+    ASSERT_TRUE(value);
+    NestedMessage expected;
+    NestedMessage actual;
+    EXPECT_EQ(converter.Convert(*value, &expected),
+              converter.ConvertJSON(json, &actual));
+  }
+}
+
+// As with Convert(), the last member with a given key is converted.
+TEST(JSONValueConverterTest, ConvertJSONDuplicateKeys) {
+  NestedMessage message;
+  base::JSONValueConverter<NestedMessage> converter;
+  EXPECT_TRUE(converter.ConvertJSON(
+      "{\"foo\": 1, \"foo\": 2, \"child\": {\"foo\": 3, \"ints\": [1]},"
+      " \"child\": {\"bar\": \"x\", \"ints\": [2, 3], \"ints\": [4]}}",
+      &message));
+  EXPECT_EQ(2, message.foo);
+  EXPECT_EQ(0, message.child.foo);
+  EXPECT_EQ("x", message.child.bar);
+  ASSERT_EQ(1U, message.child.ints.size());
+  EXPECT_EQ(4, *message.child.ints[0]);
+
+  DottedPathMessage dotted;
+  base::JSONValueConverter<DottedPathMessage> dotted_converter;
+  EXPECT_TRUE(dotted_converter.ConvertJSON(
+      "{\"a\": {\"inner\": 1, \"b\": {\"deep\": \"x\"}},"
+      " \"a\": {\"inner\": 2}}",
+      &dotted));
+  EXPECT_EQ(2, dotted.inner);
+  EXPECT_EQ("", dotted.deep);
+}
+
+TEST(JSONValueConverterTest, ConvertJSONMalformed) {
+  SimpleMessage message;
+  base::JSONValueConverter<SimpleMessage> converter;
+  EXPECT_FALSE(converter.ConvertJSON("{\"foo\": 1", &message));
+  EXPECT_FALSE(converter.ConvertJSON("{\"foo\": 1} {}", &message));
+  EXPECT_FALSE(converter.ConvertJSON("", &message));
+}
+
 }  // namespace base
@@ -9,6 +9,7 @@
 #include <cmath>
 #include <limits>
 
+#include "base/files/file.h"
 #include "base/json/string_escape.h"
 #include "base/logging.h"
 #include "base/notreached.h"
@@ -52,6 +53,29 @@ bool JSONWriter::WriteWithOptions(ValueView node,
   return result;
 }
 
+// static
+bool JSONWriter::WriteToFile(ValueView node,
+                             int options,
+                             File* file,
+                             size_t max_depth) {
+  DCHECK(file);
+  std::string buffer;
+  // Leave room for the value that pushes the buffer past its limit.
+  buffer.reserve(kFileBufferSize * 2);
+
+  JSONWriter writer(options, &buffer, max_depth);
+  writer.file_ = file;
+  bool result = node.Visit([&writer](const auto& member) {
+    return writer.BuildJSONString(member, 0);
+  });
+
+  if (options & OPTIONS_PRETTY_PRINT)
+    buffer.append(kPrettyPrintLineEnding);
+
+  writer.FlushToFile();
+  return result && !writer.file_write_failed_;
+}
+
 JSONWriter::JSONWriter(int options, std::string* json, size_t max_depth)
     : omit_binary_values_((options & OPTIONS_OMIT_BINARY_VALUES) != 0),
       omit_double_type_preservation_(
@@ -151,6 +175,7 @@ bool JSONWriter::BuildJSONString(const Value::Dict& node, size_t depth) {
     });
 
     first_value_has_been_output = true;
+    MaybeFlushToFile();
   }
 
   if (pretty_print_) {
@@ -190,6 +215,7 @@ bool JSONWriter::BuildJSONString(const Value::List& node, size_t depth) {
     });
 
     first_value_has_been_output = true;
+    MaybeFlushToFile();
   }
 
   if (pretty_print_)
@@ -202,4 +228,19 @@ void JSONWriter::IndentLine(size_t depth) {
   json_string_->append(depth * 3U, ' ');
 }
 
+void JSONWriter::MaybeFlushToFile() {
+  if (file_ && json_string_->size() >= kFileBufferSize)
+    FlushToFile();
+}
+
+void JSONWriter::FlushToFile() {
+  DCHECK(file_);
+  if (!file_write_failed_ && !json_string_->empty()) {
+    const int size = checked_cast<int>(json_string_->size());
+    file_write_failed_ =
+        file_->WriteAtCurrentPos(json_string_->data(), size) != size;
+  }
+  json_string_->clear();
+}
+
 }  // namespace base
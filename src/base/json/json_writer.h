@@ -17,6 +17,8 @@
 
 namespace base {
 
+class File;
+
 class BASE_EXPORT JSONWriter {
  public:
   enum Options {
@@ -41,7 +43,9 @@ class BASE_EXPORT JSONWriter {
   JSONWriter& operator=(const JSONWriter&) = delete;
 
   // Given a root node, generates a JSON string and puts it into |json|.
-  // The output string is overwritten and not appended.
+  // The output string is overwritten and not appended. Its capacity is kept,
+  // so serializing many values into the same string only allocates when the
+  // output outgrows all previous ones.
   //
   // TODO(tc): Should we generate json if it would be invalid json (e.g.,
   // |node| is not a dictionary/list Value or if there are inf/-inf float
@@ -57,6 +61,19 @@ class BASE_EXPORT JSONWriter {
                                std::string* json,
                                size_t max_depth = internal::kAbsoluteMaxDepth);
 
+  // Same as WriteWithOptions(), but writes the JSON to |file| at its current
+  // position. Output is buffered in chunks of about kFileBufferSize bytes, so
+  // memory use does not grow with the size of the output. Returns false if
+  // |node| cannot be serialized or writing to |file| fails; |file| may then
+  // contain partial output.
+  static bool WriteToFile(ValueView node,
+                          int options,
+                          File* file,
+                          size_t max_depth = internal::kAbsoluteMaxDepth);
+
+  // The amount of output WriteToFile() buffers before writing it to the file.
+  static constexpr size_t kFileBufferSize = 64 * 1024;
+
  private:
   JSONWriter(int options,
              std::string* json,
@@ -76,6 +93,13 @@ class BASE_EXPORT JSONWriter {
   // Adds space to json_string_ for the indent level.
   void IndentLine(size_t depth);
 
+  // When writing to a file, writes out |json_string_| once it has grown past
+  // kFileBufferSize.
+  void MaybeFlushToFile();
+
+  // Writes |json_string_| to |file_| and clears it.
+  void FlushToFile();
+
   bool omit_binary_values_;
   bool omit_double_type_preservation_;
   bool pretty_print_;
@@ -88,6 +112,10 @@ class BASE_EXPORT JSONWriter {
 
   // The number of times the writer has recursed (current stack depth).
   size_t stack_depth_;
+
+  // The file that output is written to by WriteToFile(), if any.
+  raw_ptr<File> file_ = nullptr;
+  bool file_write_failed_ = false;
 };
 
 }  // namespace base
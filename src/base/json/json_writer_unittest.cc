@@ -6,7 +6,11 @@
 #include "base/json/json_reader.h"
 
 #include "base/containers/span.h"
+#include "base/files/file.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
 #include "base/memory/ptr_util.h"
+#include "base/strings/string_number_conversions.h"
 #include "base/strings/stringprintf.h"
 #include "base/values.h"
 #include "build/build_config.h"
@@ -208,4 +212,64 @@ TEST(JSONWriterTest, TestMaxDepthWithValidNodes) {
   EXPECT_TRUE(JSONWriter::Write(value, &serialized));
 }
 
+TEST(JSONWriterTest, ReuseOutputString) {
+  std::string output_js;
+  EXPECT_TRUE(JSONWriter::Write(Value(std::string(4096, 'x')), &output_js));
+  const size_t capacity = output_js.capacity();
+  EXPECT_TRUE(JSONWriter::Write(Value(true), &output_js));
+  EXPECT_EQ("true", output_js);
+  EXPECT_EQ(capacity, output_js.capacity());
+}
+
+TEST(JSONWriterTest, WriteToFile) {
+  ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+
+  // Large enough to be written in several chunks.
+  Value::List list;
+  for (int i = 0; i < 10000; ++i) {
+    Value::Dict dict;
+    dict.Set("index", i);
+    dict.Set("name", "record <" + NumberToString(i) + ">\n");
+    list.Append(std::move(dict));
+  }
+  const Value value(std::move(list));
+
+  for (int options : {0, int{JSONWriter::OPTIONS_PRETTY_PRINT}}) {
+    std::string expected;
+    EXPECT_TRUE(JSONWriter::WriteWithOptions(value, options, &expected));
+    ASSERT_GT(expected.size(), JSONWriter::kFileBufferSize * 2);
+
+    const FilePath path =
+        temp_dir.GetPath().AppendASCII(NumberToString(options) + ".json");
+    File file(path, File::FLAG_CREATE | File::FLAG_WRITE);
+    ASSERT_TRUE(file.IsValid());
+    EXPECT_TRUE(JSONWriter::WriteToFile(value, options, &file));
+    file.Close();
+
+    std::string actual;
+    ASSERT_TRUE(ReadFileToString(path, &actual));
+    EXPECT_EQ(expected, actual);
+  }
+}
+
+TEST(JSONWriterTest, WriteToFileFailure) {
+  ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  const FilePath path = temp_dir.GetPath().AppendASCII("read_only.json");
+  ASSERT_TRUE(WriteFile(path, ""));
+
+  // The file is not open for writing.
+  File file(path, File::FLAG_OPEN | File::FLAG_READ);
+  ASSERT_TRUE(file.IsValid());
+  EXPECT_FALSE(JSONWriter::WriteToFile(Value(1), 0, &file));
+
+  // Serialization failures are reported as well.
+  File writable(temp_dir.GetPath().AppendASCII("binary.json"),
+                File::FLAG_CREATE | File::FLAG_WRITE);
+  ASSERT_TRUE(writable.IsValid());
+  EXPECT_FALSE(JSONWriter::WriteToFile(Value(Value::BlobStorage()), 0,
+                                       &writable));
+}
+
 }  // namespace base
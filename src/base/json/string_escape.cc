@@ -10,6 +10,11 @@
 #include <limits>
 #include <string>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "base/bits.h"
 #include "base/check_op.h"
 #include "base/strings/string_util.h"
 #include "base/strings/stringprintf.h"
@@ -78,6 +83,53 @@ bool EscapeSpecialCodePoint(base_icu::UChar32 code_point, std::string* dest) {
   return true;
 }
 
+// Returns true if |c| is a printable ASCII character that is copied to the
+// output unchanged.
+template <typename Char>
+bool IsVerbatimChar(Char c) {
+  return c >= 0x20 && c < 0x80 && c != '"' && c != '\\' && c != '<';
+}
+
+// Returns the number of leading characters of |str| that are copied to the
+// output unchanged. Most strings consist mainly of such characters, so they
+// are copied in runs rather than one code point at a time.
+size_t CountVerbatimChars(StringPiece str) {
+  const char* const begin = str.data();
+  const char* const end = begin + str.size();
+  const char* p = begin;
+#ifdef __SSE2__
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i less_than = _mm_set1_epi8('<');
+  // Bytes >= 0x80 are negative when compared as signed, so a single signed
+  // comparison against ' ' flags both control characters and non-ASCII bytes.
+  const __m128i space = _mm_set1_epi8(' ');
+  while (end - p >= 16) {
+    const __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i special = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                     _mm_cmpeq_epi8(chunk, backslash)),
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, less_than),
+                     _mm_cmplt_epi8(chunk, space)));
+    const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(special));
+    if (mask != 0)
+      return static_cast<size_t>(p - begin) + bits::CountTrailingZeroBits(mask);
+    p += 16;
+  }
+#endif
+  while (p < end && IsVerbatimChar(static_cast<unsigned char>(*p)))
+    ++p;
+  return static_cast<size_t>(p - begin);
+}
+
+size_t CountVerbatimChars(StringPiece16 str) {
+  size_t count = 0;
+  while (count < str.size() && IsVerbatimChar(str[count]))
+    ++count;
+  return count;
+}
+
 template <typename S>
 bool EscapeJSONStringImpl(const S& str, bool put_in_quotes, std::string* dest) {
   bool did_replacement = false;
@@ -87,6 +139,14 @@ bool EscapeJSONStringImpl(const S& str, bool put_in_quotes, std::string* dest) {
 
   const size_t length = str.length();
   for (size_t i = 0; i < length; ++i) {
+    const size_t verbatim_count = CountVerbatimChars(str.substr(i));
+    if (verbatim_count) {
+      dest->append(str.begin() + i, str.begin() + i + verbatim_count);
+      i += verbatim_count;
+      if (i == length)
+        break;
+    }
+
     base_icu::UChar32 code_point;
     if (!ReadUnicodeCharacter(str.data(), length, &i, &code_point) ||
         code_point == CBU_SENTINEL) {
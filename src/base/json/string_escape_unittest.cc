@@ -231,6 +231,36 @@ TEST(JSONStringEscapeTest, EscapeUTF16OutsideBMP) {
   }
 }
 
+TEST(JSONStringEscapeTest, EscapeLongStrings) {
+  // Long strings are scanned in blocks; place each character that needs
+  // escaping or validation at every offset within and across blocks.
+  const char* const kSpecials[] = {
+      "\"",   "\\",   "<",        "\n",           "\x01",
+      "\x7F", "\xFF", "\xC3\xA9", "\xE2\x80\xA8",
+  };
+  for (const char* special : kSpecials) {
+    std::string escaped_special;
+    const bool special_is_valid =
+        EscapeJSONString(special, false, &escaped_special);
+    for (size_t offset = 0; offset < 40; ++offset) {
+      SCOPED_TRACE(testing::Message() << special << " at " << offset);
+      const std::string prefix(offset, 'a');
+      const std::string suffix(40 - offset, 'z');
+      std::string escaped;
+      EXPECT_EQ(special_is_valid,
+                EscapeJSONString(prefix + special + suffix, true, &escaped));
+      EXPECT_EQ("\"" + prefix + escaped_special + suffix + "\"", escaped);
+
+      if (special_is_valid) {
+        std::string escaped16;
+        EXPECT_TRUE(EscapeJSONString(UTF8ToUTF16(prefix + special + suffix),
+                                     true, &escaped16));
+        EXPECT_EQ(escaped, escaped16);
+      }
+    }
+  }
+}
+
 TEST(JSONStringEscapeTest, EscapeBytes) {
   const struct {
     const char* to_escape;
@@ -154,6 +154,7 @@ void MessagePumpEpoll::AddEpollEvent(EpollEventEntry& entry) {
   DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
   const uint32_t events = entry.ComputeActiveEvents();
   epoll_event event{.events = events, .data = {.ptr = &entry}};
+  ++syscall_count_;
   int rv = epoll_ctl(epoll_.get(), EPOLL_CTL_ADD, entry.fd, &event);
   DPCHECK(rv == 0);
   entry.registered_events = events;
@@ -167,6 +168,7 @@ void MessagePumpEpoll::UpdateEpollEvent(EpollEventEntry& entry) {
     return;
   }
   epoll_event event{.events = events, .data = {.ptr = &entry}};
+  ++syscall_count_;
   int rv = epoll_ctl(epoll_.get(), EPOLL_CTL_MOD, entry.fd, &event);
   DPCHECK(rv == 0);
   entry.registered_events = events;
@@ -188,6 +190,7 @@ void MessagePumpEpoll::UnregisterInterest(
 
   if (interests.empty()) {
     entries_.erase(entry_it);
+    ++syscall_count_;
     int rv = epoll_ctl(epoll_.get(), EPOLL_CTL_DEL, fd, nullptr);
     DPCHECK(rv == 0);
   } else {
@@ -200,6 +203,7 @@ bool MessagePumpEpoll::WaitForEpollEvent(TimeDelta timeout) {
   const int epoll_timeout =
       timeout.is_max() ? -1 : saturated_cast<int>(timeout.InMilliseconds());
   epoll_event event;
+  ++syscall_count_;
   const int epoll_result =
       epoll_wait(epoll_.get(), &event, /*maxevents=*/1, epoll_timeout);
   if (epoll_result < 0) {
@@ -304,6 +308,7 @@ void MessagePumpEpoll::HandleEvent(int fd,
 void MessagePumpEpoll::HandleWakeUp() {
   DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
   uint64_t value;
+  ++syscall_count_;
   ssize_t n = HANDLE_EINTR(read(wake_event_.get(), &value, sizeof(value)));
   DPCHECK(n == sizeof(value));
 }
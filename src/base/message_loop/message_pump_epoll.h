@@ -52,6 +52,11 @@ class BASE_EXPORT MessagePumpEpoll : public MessagePump,
   void ScheduleDelayedWork(
       const Delegate::NextWorkInfo& next_work_info) override;
 
+  // Returns the number of system calls made so far on this pump's thread to
+  // update the interest list, wait for events and consume wakeups.
+  // ScheduleWork() is not counted.
+  size_t syscall_count_for_testing() const { return syscall_count_; }
+
  private:
   friend class MessagePumpLibevent;
   friend class MessagePumpLibeventTest;
@@ -132,6 +137,8 @@ class BASE_EXPORT MessagePumpEpoll : public MessagePump,
   // An eventfd object used to wake the pump's thread when scheduling new work.
   ScopedFD wake_event_;
 
+  size_t syscall_count_ = 0;
+
   // WatchFileDescriptor() must be called from this thread, and so must
   // FdWatchController::StopWatchingFileDescriptor().
   THREAD_CHECKER(thread_checker_);
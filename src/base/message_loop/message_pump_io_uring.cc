@@ -0,0 +1,666 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/message_loop/message_pump_io_uring.h"
+
+#include <poll.h>
+#include <signal.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "base/auto_reset.h"
+#include "base/check_op.h"
+#include "base/memory/ref_counted.h"
+#include "base/numerics/safe_conversions.h"
+#include "base/posix/eintr_wrapper.h"
+#include "base/trace_event/base_tracing.h"
+
+namespace base {
+
+namespace {
+
+// The number of submission queue entries. The completion ring is twice as
+// large. Submissions are only queued between two waits of the pump, so this
+// rarely needs to accommodate more than a handful of requests; GetSqe()
+// submits early if it's ever exhausted.
+constexpr uint32_t kSubmissionQueueEntries = 256;
+
+// The kernel features which this pump relies on. They were all introduced by
+// Linux 5.11, along with IORING_FEAT_EXT_ARG which is used for timed waits.
+constexpr uint32_t kRequiredFeatures =
+    IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_RW_CUR_POS |
+    IORING_FEAT_EXT_ARG;
+
+// The low bits of the user_data of each request tell what kind of request
+// completed. The remaining bits identify the request within its kind.
+enum RequestTag : uint64_t {
+  kWakeUpTag = 0,
+  kPollTag = 1,
+  kIOTag = 2,
+  // Requests whose completion is ignored, such as poll removals.
+  kIgnoredTag = 3,
+};
+constexpr int kTagBits = 2;
+constexpr uint64_t kTagMask = (1 << kTagBits) - 1;
+
+// Poll requests identify their file descriptor in the 32 bits above the tag,
+// and their generation in the remaining 30 bits.
+constexpr int kPollGenerationShift = 32 + kTagBits;
+constexpr uint32_t kPollGenerationMask =
+    (1u << (64 - kPollGenerationShift)) - 1;
+
+uint64_t MakePollUserData(int fd, uint32_t generation) {
+  DCHECK_EQ(generation & kPollGenerationMask, generation);
+  return (uint64_t{generation} << kPollGenerationShift) |
+         (uint64_t{static_cast<uint32_t>(fd)} << kTagBits) | kPollTag;
+}
+
+int io_uring_setup(uint32_t entries, io_uring_params* params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int io_uring_enter(int ring_fd,
+                   uint32_t to_submit,
+                   uint32_t min_complete,
+                   uint32_t flags,
+                   const void* arg,
+                   size_t arg_size) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit,
+                                  min_complete, flags, arg, arg_size));
+}
+
+template <typename T>
+T* RingPointer(void* ring, uint32_t offset) {
+  return reinterpret_cast<T*>(static_cast<char*>(ring) + offset);
+}
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) &&
+                  std::atomic<uint32_t>::is_always_lock_free,
+              "Ring indices shared with the kernel are accessed atomically");
+
+}  // namespace
+
+MessagePumpIOUring::MessagePumpIOUring() {
+  DCHECK(IsSupported());
+
+  io_uring_params params = {};
+  ring_.reset(io_uring_setup(kSubmissionQueueEntries, &params));
+  PCHECK(ring_.is_valid());
+  CHECK_EQ(params.features & kRequiredFeatures, kRequiredFeatures);
+
+  // With IORING_FEAT_SINGLE_MMAP, both rings live in a single mapping.
+  rings_size_ = std::max(
+      params.sq_off.array + params.sq_entries * sizeof(uint32_t),
+      params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+  rings_ = mmap(nullptr, rings_size_, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, ring_.get(), IORING_OFF_SQ_RING);
+  PCHECK(rings_ != MAP_FAILED);
+
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring_.get(), IORING_OFF_SQES);
+  PCHECK(sqes != MAP_FAILED);
+  sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+  sq_head_ = RingPointer<std::atomic<uint32_t>>(rings_, params.sq_off.head);
+  sq_tail_ = RingPointer<std::atomic<uint32_t>>(rings_, params.sq_off.tail);
+  sq_mask_ = *RingPointer<uint32_t>(rings_, params.sq_off.ring_mask);
+  sq_entries_ = params.sq_entries;
+  cq_head_ = RingPointer<std::atomic<uint32_t>>(rings_, params.cq_off.head);
+  cq_tail_ = RingPointer<std::atomic<uint32_t>>(rings_, params.cq_off.tail);
+  cq_mask_ = *RingPointer<uint32_t>(rings_, params.cq_off.ring_mask);
+  cqes_ = RingPointer<io_uring_cqe>(rings_, params.cq_off.cqes);
+  sq_local_tail_ = sq_tail_->load(std::memory_order_relaxed);
+
+  // Submission queue entries are always used in ring order, so the indirection
+  // array can be set up once and for all.
+  uint32_t* sq_array = RingPointer<uint32_t>(rings_, params.sq_off.array);
+  for (uint32_t i = 0; i < sq_entries_; ++i)
+    sq_array[i] = i;
+
+  // The eventfd is blocking so that the kernel waits for it to be readable
+  // instead of failing the read with EAGAIN. ScheduleWork() never blocks in
+  // practice, since that would require 2^64 - 1 writes without a read.
+  wake_event_.reset(eventfd(0, EFD_CLOEXEC));
+  PCHECK(wake_event_.is_valid());
+  ArmWakeUpRead();
+}
+
+MessagePumpIOUring::~MessagePumpIOUring() {
+  // Closing the ring doesn't wait for the requests still in flight, which could
+  // then write into freed buffers, including `wake_value_`.
+  CancelAllRequests();
+  ring_.reset();
+  munmap(sqes_.get(), sqes_size_);
+  munmap(rings_.get(), rings_size_);
+}
+
+// static
+bool MessagePumpIOUring::IsSupported() {
+  static const bool is_supported = [] {
+    io_uring_params params = {};
+    ScopedFD ring(io_uring_setup(/*entries=*/1, &params));
+    // Setup fails with ENOSYS on kernels without io_uring or with seccomp
+    // filters denying it, and with EPERM if disabled by the
+    // kernel.io_uring_disabled sysctl.
+    return ring.is_valid() &&
+           (params.features & kRequiredFeatures) == kRequiredFeatures;
+  }();
+  return is_supported;
+}
+
+bool MessagePumpIOUring::WatchFileDescriptor(int fd,
+                                             bool persistent,
+                                             int mode,
+                                             FdWatchController* controller,
+                                             FdWatcher* watcher) {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  TRACE_EVENT("base", "MessagePumpIOUring::WatchFileDescriptor", "fd", fd,
+              "persistent", persistent, "watch_read", mode & WATCH_READ,
+              "watch_write", mode & WATCH_WRITE);
+
+  const InterestParams params{
+      .fd = fd,
+      .read = (mode == WATCH_READ || mode == WATCH_READ_WRITE),
+      .write = (mode == WATCH_WRITE || mode == WATCH_READ_WRITE),
+      .one_shot = !persistent,
+  };
+
+  PollEntry& entry = entries_.emplace(fd, fd).first->second;
+  scoped_refptr<Interest> existing_interest = controller->epoll_interest();
+  if (existing_interest && existing_interest->params().IsEqual(params)) {
+    // Reactivate the existing (presumably deactivated, one-shot) Interest, as
+    // MessagePumpEpoll does.
+    existing_interest->set_active(true);
+  } else {
+    entry.interests->push_back(controller->AssignEpollInterest(params));
+    if (existing_interest) {
+      UnregisterInterest(existing_interest);
+    }
+  }
+  UpdatePoll(entry);
+
+  controller->set_io_uring_pump(weak_ptr_factory_.GetWeakPtr());
+  controller->set_watcher(watcher);
+  return true;
+}
+
+void MessagePumpIOUring::SubmitRead(int fd,
+                                    span<uint8_t> buffer,
+                                    int64_t offset,
+                                    IOCompletionCallback callback) {
+  SubmitReadOrWrite(IORING_OP_READ, fd, buffer.data(), buffer.size(), offset,
+                    std::move(callback));
+}
+
+void MessagePumpIOUring::SubmitWrite(int fd,
+                                     span<const uint8_t> buffer,
+                                     int64_t offset,
+                                     IOCompletionCallback callback) {
+  SubmitReadOrWrite(IORING_OP_WRITE, fd, buffer.data(), buffer.size(), offset,
+                    std::move(callback));
+}
+
+void MessagePumpIOUring::Run(Delegate* delegate) {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  RunState run_state(delegate);
+  AutoReset<RunState*> auto_reset_run_state(&run_state_, &run_state);
+  for (;;) {
+    // Do some work and see if the next task is ready right away.
+    Delegate::NextWorkInfo next_work_info = delegate->DoWork();
+    const bool immediate_work_available = next_work_info.is_immediate();
+    if (run_state.should_quit) {
+      break;
+    }
+
+    // Submit the requests queued by the work above, and process any completion
+    // which is already available, but don't wait for more yet.
+    const bool processed_events = WaitForCompletions(TimeDelta());
+    if (run_state.should_quit) {
+      break;
+    }
+
+    if (immediate_work_available || processed_events) {
+      continue;
+    }
+
+    const bool did_idle_work = delegate->DoIdleWork();
+    if (run_state.should_quit) {
+      break;
+    }
+    if (did_idle_work) {
+      continue;
+    }
+
+    TimeDelta timeout = TimeDelta::Max();
+    DCHECK(!next_work_info.delayed_run_time.is_null());
+    if (!next_work_info.delayed_run_time.is_max()) {
+      timeout = next_work_info.remaining_delay();
+    }
+    delegate->BeforeWait();
+    WaitForCompletions(timeout);
+    if (run_state.should_quit) {
+      break;
+    }
+  }
+}
+
+void MessagePumpIOUring::Quit() {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  DCHECK(run_state_) << "Quit() called outside of Run()";
+  run_state_->should_quit = true;
+}
+
+void MessagePumpIOUring::ScheduleWork() {
+  const uint64_t value = 1;
+  ssize_t n = HANDLE_EINTR(write(wake_event_.get(), &value, sizeof(value)));
+  DPCHECK(n == sizeof(value));
+}
+
+void MessagePumpIOUring::ScheduleDelayedWork(
+    const Delegate::NextWorkInfo& next_work_info) {
+  // Nothing to do. This can only be called from the same thread as Run(), so
+  // the pump must be in between waits. The scheduled work therefore will be
+  // seen in time for the next wait.
+}
+
+io_uring_sqe* MessagePumpIOUring::GetSqe() {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  while (sq_local_tail_ - sq_head_->load(std::memory_order_acquire) ==
+         sq_entries_) {
+    SubmitAndWait(TimeDelta());
+    // Without SQPOLL, the kernel consumes submitted entries synchronously,
+    // unless it refuses them for now: with EBUSY until completions are reaped
+    // from a full completion ring, or with EAGAIN or EINTR. Reap them, without
+    // running callbacks from within this call, and try again.
+    if (sq_local_tail_ - sq_head_->load(std::memory_order_acquire) ==
+        sq_entries_) {
+      ReapCompletions();
+    }
+  }
+  io_uring_sqe* sqe = &sqes_[sq_local_tail_ & sq_mask_];
+  memset(sqe, 0, sizeof(*sqe));
+  ++sq_local_tail_;
+  ++sq_pending_;
+  return sqe;
+}
+
+void MessagePumpIOUring::SubmitAndWait(TimeDelta timeout) {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  const bool wait = !timeout.is_zero();
+  if (!sq_pending_ && !wait) {
+    return;
+  }
+
+  // Publish the queued entries. The release store pairs with the kernel's
+  // acquire load of the tail, making the entries' contents visible to it.
+  sq_tail_->store(sq_local_tail_, std::memory_order_release);
+
+  uint32_t flags = 0;
+  uint32_t min_complete = 0;
+  io_uring_getevents_arg arg = {};
+  __kernel_timespec ts = {};
+  if (wait) {
+    flags |= IORING_ENTER_GETEVENTS;
+    min_complete = 1;
+    if (!timeout.is_max()) {
+      ts.tv_sec = timeout.InSeconds();
+      ts.tv_nsec = (timeout - Seconds(ts.tv_sec)).InNanoseconds();
+      flags |= IORING_ENTER_EXT_ARG;
+      arg.sigmask_sz = _NSIG / 8;
+      arg.ts = reinterpret_cast<uint64_t>(&ts);
+    }
+  }
+
+  ++syscall_count_;
+  const int result =
+      io_uring_enter(ring_.get(), sq_pending_, min_complete, flags,
+                     (flags & IORING_ENTER_EXT_ARG) ? &arg : nullptr,
+                     (flags & IORING_ENTER_EXT_ARG) ? sizeof(arg) : 0);
+  if (result >= 0) {
+    DCHECK_LE(static_cast<uint32_t>(result), sq_pending_);
+    sq_pending_ -= static_cast<uint32_t>(result);
+    in_flight_ += static_cast<uint32_t>(result);
+    return;
+  }
+
+  // Errors are only reported if no entry was submitted. ETIME means that the
+  // wait timed out. With EINTR, EAGAIN or EBUSY (completion ring overflow), the
+  // entries remain queued and are submitted again by the next call, once
+  // completions have been reaped.
+  DPCHECK(errno == ETIME || errno == EINTR || errno == EAGAIN ||
+          errno == EBUSY);
+}
+
+void MessagePumpIOUring::ReapCompletions() {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  uint32_t head = cq_head_->load(std::memory_order_relaxed);
+  const uint32_t tail = cq_tail_->load(std::memory_order_acquire);
+  for (; head != tail; ++head) {
+    reaped_completions_.push_back(cqes_[head & cq_mask_]);
+    --in_flight_;
+  }
+  cq_head_->store(head, std::memory_order_release);
+}
+
+void MessagePumpIOUring::CancelAllRequests() {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  // The entries which the kernel hasn't consumed yet can simply be dropped.
+  sq_local_tail_ -= sq_pending_;
+  sq_pending_ = 0;
+
+  // IORING_ASYNC_CANCEL_ANY requires Linux 5.19, so cancel each request which
+  // may be in flight. Cancelling one which already completed does no harm.
+  auto cancel = [this](uint64_t user_data) {
+    io_uring_sqe* sqe = GetSqe();
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = user_data;
+    sqe->user_data = kIgnoredTag;
+  };
+  cancel(kWakeUpTag);
+  for (const auto& [id, callback] : pending_io_) {
+    cancel((id << kTagBits) | kIOTag);
+  }
+  for (const auto& [fd, entry] : entries_) {
+    if (entry.armed_events) {
+      cancel(MakePollUserData(fd, entry.armed_generation));
+    }
+  }
+
+  // Requests which can't be cancelled, such as a read of a regular file which
+  // already started, complete normally.
+  while (sq_pending_ || in_flight_) {
+    SubmitAndWait(in_flight_ ? TimeDelta::Max() : TimeDelta());
+    ReapCompletions();
+  }
+  reaped_completions_.clear();
+}
+
+void MessagePumpIOUring::UpdatePoll(PollEntry& entry) {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  const uint32_t events = entry.ComputeActiveEvents();
+  if (events == entry.armed_events) {
+    return;
+  }
+
+  if (entry.armed_events) {
+    io_uring_sqe* sqe = GetSqe();
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = MakePollUserData(entry.fd, entry.armed_generation);
+    sqe->user_data = kIgnoredTag;
+    entry.armed_events = 0;
+    entry.armed_generation = 0;
+  }
+
+  if (events) {
+    last_poll_generation_ = (last_poll_generation_ + 1) & kPollGenerationMask;
+    if (last_poll_generation_ == 0) {
+      last_poll_generation_ = 1;
+    }
+    io_uring_sqe* sqe = GetSqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = entry.fd;
+    sqe->poll32_events = events;
+    sqe->user_data = MakePollUserData(entry.fd, last_poll_generation_);
+    entry.armed_events = events;
+    entry.armed_generation = last_poll_generation_;
+  }
+}
+
+void MessagePumpIOUring::UnregisterInterest(
+    const scoped_refptr<Interest>& interest) {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+
+  const int fd = interest->params().fd;
+  auto entry_it = entries_.find(fd);
+  DCHECK(entry_it != entries_.end());
+
+  PollEntry& entry = entry_it->second;
+  auto& interests = entry.interests.container();
+  auto it = std::find(interests.begin(), interests.end(), interest);
+  DCHECK(it != interests.end());
+  interests.erase(it);
+
+  UpdatePoll(entry);
+  if (interests.empty()) {
+    entries_.erase(entry_it);
+    // The caller may close `fd` as soon as this returns. Submit the removal
+    // right away so that the ring doesn't keep the file open, as epoll_ctl()
+    // would.
+    SubmitAndWait(TimeDelta());
+  }
+}
+
+void MessagePumpIOUring::SubmitReadOrWrite(uint8_t opcode,
+                                           int fd,
+                                           const uint8_t* buffer,
+                                           size_t size,
+                                           int64_t offset,
+                                           IOCompletionCallback callback) {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  DCHECK_GE(fd, 0);
+  DCHECK_GE(offset, kCurrentFilePosition);
+  DCHECK(callback);
+
+  const uint64_t id = next_io_id_++;
+  pending_io_.emplace(id, std::move(callback));
+
+  io_uring_sqe* sqe = GetSqe();
+  sqe->opcode = opcode;
+  sqe->fd = fd;
+  sqe->addr = reinterpret_cast<uint64_t>(buffer);
+  sqe->len = checked_cast<uint32_t>(size);
+  sqe->off = static_cast<uint64_t>(offset);
+  sqe->user_data = (id << kTagBits) | kIOTag;
+}
+
+void MessagePumpIOUring::ArmWakeUpRead() {
+  io_uring_sqe* sqe = GetSqe();
+  sqe->opcode = IORING_OP_READ;
+  sqe->fd = wake_event_.get();
+  sqe->addr = reinterpret_cast<uint64_t>(&wake_value_);
+  sqe->len = sizeof(wake_value_);
+  sqe->off = static_cast<uint64_t>(kCurrentFilePosition);
+  sqe->user_data = kWakeUpTag;
+}
+
+bool MessagePumpIOUring::WaitForCompletions(TimeDelta timeout) {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  // Only wait if no completion is available yet.
+  if (!reaped_completions_.empty() ||
+      cq_head_->load(std::memory_order_relaxed) !=
+          cq_tail_->load(std::memory_order_acquire)) {
+    timeout = TimeDelta();
+  }
+  SubmitAndWait(timeout);
+
+  bool processed_events = false;
+  for (;;) {
+    // Completions are consumed one at a time, since dispatching one may run a
+    // nested loop which consumes the others. Those reaped by GetSqe() come
+    // first.
+    io_uring_cqe cqe;
+    if (!reaped_completions_.empty()) {
+      cqe = reaped_completions_.front();
+      reaped_completions_.pop_front();
+    } else {
+      const uint32_t head = cq_head_->load(std::memory_order_relaxed);
+      if (head == cq_tail_->load(std::memory_order_acquire)) {
+        break;
+      }
+      cqe = cqes_[head & cq_mask_];
+      cq_head_->store(head + 1, std::memory_order_release);
+      --in_flight_;
+    }
+
+    processed_events |= OnCompletion(cqe.user_data, cqe.res);
+    if (run_state_ && run_state_->should_quit) {
+      break;
+    }
+  }
+  return processed_events;
+}
+
+bool MessagePumpIOUring::OnCompletion(uint64_t user_data, int32_t result) {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  switch (user_data & kTagMask) {
+    case kWakeUpTag:
+      DCHECK_EQ(result, static_cast<int32_t>(sizeof(wake_value_)));
+      ArmWakeUpRead();
+      return true;
+
+    case kPollTag:
+      return OnPollCompletion(
+          static_cast<int>(static_cast<uint32_t>(user_data >> kTagBits)),
+          static_cast<uint32_t>(user_data >> kPollGenerationShift), result);
+
+    case kIOTag: {
+      auto it = pending_io_.find(user_data >> kTagBits);
+      DCHECK(it != pending_io_.end());
+      IOCompletionCallback callback = std::move(it->second);
+      pending_io_.erase(it);
+      HandleIOCompletion(std::move(callback), result);
+      return true;
+    }
+
+    case kIgnoredTag:
+      return false;
+  }
+  NOTREACHED();
+  return false;
+}
+
+bool MessagePumpIOUring::OnPollCompletion(int fd,
+                                          uint32_t generation,
+                                          int32_t result) {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  auto entry_it = entries_.find(fd);
+  if (entry_it == entries_.end() ||
+      entry_it->second.armed_generation != generation) {
+    // This is the completion of a poll request which was cancelled.
+    return false;
+  }
+
+  PollEntry& entry = entry_it->second;
+  entry.armed_events = 0;
+  entry.armed_generation = 0;
+
+  // Report any failure of the poll request itself as an error on `fd`, so that
+  // the watcher's next read finds out what's wrong.
+  const uint32_t events = result >= 0 ? static_cast<uint32_t>(result) : POLLERR;
+  const bool readable = (events & POLLIN) != 0;
+  const bool writable = (events & POLLOUT) != 0;
+
+  // Under different circumstances, peer closure may raise both/either POLLHUP
+  // and/or POLLERR. Treat them as equivalent.
+  const bool disconnected = (events & (POLLHUP | POLLERR)) != 0;
+
+  // Copy the set of Interests, since interests may be added to or removed from
+  // `entry` during the loop below.
+  auto interests = entry.interests;
+  for (const auto& interest : interests.container()) {
+    if (!interest->active()) {
+      continue;
+    }
+
+    const bool can_read = (readable || disconnected) && interest->params().read;
+    const bool can_write = writable && interest->params().write;
+    if (!can_read && !can_write) {
+      continue;
+    }
+
+    if (interest->params().one_shot) {
+      // Deactivate the one-shot interest before it triggers. The event handler
+      // may reactivate it.
+      interest->set_active(false);
+    }
+
+    HandleEvent(fd, can_read, can_write, interest->controller());
+  }
+
+  // Poll requests are one-shot, so re-arm for the interests which remain
+  // active, unless the handlers above stopped watching `fd` altogether. The
+  // new request is submitted with the next wait.
+  entry_it = entries_.find(fd);
+  if (entry_it != entries_.end()) {
+    UpdatePoll(entry_it->second);
+  }
+  return true;
+}
+
+void MessagePumpIOUring::HandleEvent(int fd,
+                                     bool can_read,
+                                     bool can_write,
+                                     FdWatchController* controller) {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  // Make the MessagePumpDelegate aware of this other form of "DoWork". Skip if
+  // HandleEvent() is called outside of Run() (e.g. in unit tests).
+  Delegate::ScopedDoWorkItem scoped_do_work_item;
+  if (run_state_) {
+    scoped_do_work_item = run_state_->delegate->BeginWorkItem();
+  }
+
+  // Trace events must begin after the above BeginWorkItem() so that the
+  // ensuing "ThreadController active" outscopes all the events under it.
+  TRACE_EVENT("toplevel", "IOUringPollEvent", "controller_created_from",
+              controller->created_from_location(), "fd", fd, "can_read",
+              can_read, "can_write", can_write, "context",
+              static_cast<void*>(controller));
+  TRACE_HEAP_PROFILER_API_SCOPED_TASK_EXECUTION heap_profiler_scope(
+      controller->created_from_location().file_name());
+  if (can_read && can_write) {
+    bool controller_was_destroyed = false;
+    controller->was_destroyed_ = &controller_was_destroyed;
+    controller->OnFdWritable();
+    if (!controller_was_destroyed) {
+      controller->OnFdReadable();
+    }
+    if (!controller_was_destroyed) {
+      controller->was_destroyed_ = nullptr;
+    }
+  } else if (can_write) {
+    controller->OnFdWritable();
+  } else if (can_read) {
+    controller->OnFdReadable();
+  }
+}
+
+void MessagePumpIOUring::HandleIOCompletion(IOCompletionCallback callback,
+                                            int32_t result) {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  Delegate::ScopedDoWorkItem scoped_do_work_item;
+  if (run_state_) {
+    scoped_do_work_item = run_state_->delegate->BeginWorkItem();
+  }
+
+  TRACE_EVENT("toplevel", "IOUringCompletion", "result", result);
+  std::move(callback).Run(result);
+}
+
+MessagePumpIOUring::PollEntry::PollEntry(int fd) : fd(fd) {}
+
+MessagePumpIOUring::PollEntry::~PollEntry() = default;
+
+uint32_t MessagePumpIOUring::PollEntry::ComputeActiveEvents() {
+  uint32_t events = 0;
+  for (const auto& interest : interests.container()) {
+    if (!interest->active()) {
+      continue;
+    }
+    const InterestParams& params = interest->params();
+    events |= (params.read ? POLLIN : 0) | (params.write ? POLLOUT : 0);
+  }
+  return events;
+}
+
+}  // namespace base
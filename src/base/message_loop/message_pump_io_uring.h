@@ -0,0 +1,258 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_MESSAGE_LOOP_MESSAGE_PUMP_IO_URING_H_
+#define BASE_MESSAGE_LOOP_MESSAGE_PUMP_IO_URING_H_
+
+#include <linux/io_uring.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+
+#include "base/base_export.h"
+#include "base/callback.h"
+#include "base/containers/circular_deque.h"
+#include "base/containers/span.h"
+#include "base/containers/stack_container.h"
+#include "base/files/scoped_file.h"
+#include "base/memory/raw_ptr.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/weak_ptr.h"
+#include "base/message_loop/message_pump.h"
+#include "base/message_loop/message_pump_libevent.h"
+#include "base/message_loop/watchable_io_message_pump_posix.h"
+#include "base/threading/thread_checker.h"
+#include "base/time/time.h"
+
+namespace base {
+
+// A MessagePump implementation for I/O message loops on Linux-based systems
+// with io_uring support. In addition to readiness-based watching through
+// WatchFileDescriptor(), which is implemented with one-shot IORING_OP_POLL_ADD
+// requests, this pump supports completion-based reads and writes: the kernel
+// performs the I/O itself and the pump runs a callback with the result. Both
+// kinds of requests are queued in the submission ring and submitted together
+// by the single io_uring_enter() call which also waits for completions, so a
+// wakeup followed by a read costs one system call instead of two.
+class BASE_EXPORT MessagePumpIOUring : public MessagePump,
+                                       public WatchableIOMessagePumpPosix {
+  using InterestParams = MessagePumpLibevent::EpollInterestParams;
+  using Interest = MessagePumpLibevent::EpollInterest;
+
+ public:
+  using FdWatchController = MessagePumpLibevent::FdWatchController;
+
+  // Receives the result of a submitted read or write: the number of bytes
+  // transferred, or a negated errno value on failure.
+  using IOCompletionCallback = OnceCallback<void(int result)>;
+
+  // Passed as the offset of SubmitRead() or SubmitWrite() to use (and update)
+  // the current file position, as read() and write() do. This is the only
+  // valid offset for pipes and sockets.
+  static constexpr int64_t kCurrentFilePosition = -1;
+
+  // Must only be called if IsSupported() returns true.
+  MessagePumpIOUring();
+  MessagePumpIOUring(const MessagePumpIOUring&) = delete;
+  MessagePumpIOUring& operator=(const MessagePumpIOUring&) = delete;
+  ~MessagePumpIOUring() override;
+
+  // Returns true if the running kernel supports every io_uring feature this
+  // pump relies on, and io_uring isn't disabled by policy. The result is
+  // computed once per process.
+  static bool IsSupported();
+
+  bool WatchFileDescriptor(int fd,
+                           bool persistent,
+                           int mode,
+                           FdWatchController* controller,
+                           FdWatcher* watcher);
+
+  // Queues a read of up to `buffer.size()` bytes from `fd` at `offset` into
+  // `buffer`. `callback` is run on this pump's thread once the read completes.
+  // The read is submitted to the kernel the next time the pump looks for
+  // events, together with any other request queued in the meantime. If `fd`
+  // isn't ready, the kernel waits for it to be, except that depending on the
+  // kernel version, a request on a non-blocking `fd` may instead complete with
+  // -EAGAIN, as read() would. `buffer` must remain valid until `callback` runs
+  // or the pump is destroyed; requests which are still in flight when the pump
+  // is destroyed are cancelled, and their callbacks are destroyed without
+  // being run.
+  void SubmitRead(int fd,
+                  span<uint8_t> buffer,
+                  int64_t offset,
+                  IOCompletionCallback callback);
+
+  // Same as SubmitRead(), but writes `buffer` to `fd`.
+  void SubmitWrite(int fd,
+                   span<const uint8_t> buffer,
+                   int64_t offset,
+                   IOCompletionCallback callback);
+
+  // MessagePump methods:
+  void Run(Delegate* delegate) override;
+  void Quit() override;
+  void ScheduleWork() override;
+  void ScheduleDelayedWork(
+      const Delegate::NextWorkInfo& next_work_info) override;
+
+  // Returns the number of system calls made so far on this pump's thread to
+  // submit requests and wait for completions. ScheduleWork() is not counted.
+  size_t syscall_count_for_testing() const { return syscall_count_; }
+
+ private:
+  friend class MessagePumpLibevent;
+  friend class MessagePumpLibeventTest;
+
+  // Tracks the state of a single file descriptor watched by one or more
+  // FdWatchControllers. At most one poll request is in flight for `fd` at any
+  // time, monitoring the union of the events of all active interests.
+  struct PollEntry {
+    explicit PollEntry(int fd);
+    PollEntry(const PollEntry&) = delete;
+    PollEntry& operator=(const PollEntry&) = delete;
+    ~PollEntry();
+
+    // Returns the poll(2) event mask derived from all the active interests in
+    // `interests`: POLLIN if any wants to `read` and POLLOUT if any wants to
+    // `write`.
+    uint32_t ComputeActiveEvents();
+
+    // The file descriptor to which this entry pertains.
+    const int fd;
+
+    // The events monitored by the in-flight poll request, and the generation
+    // which identifies its completion. Zero if no poll request is in flight.
+    uint32_t armed_events = 0;
+    uint32_t armed_generation = 0;
+
+    // All the interests regarding `fd` on this message pump. See
+    // MessagePumpEpoll::EpollEventEntry.
+    StackVector<scoped_refptr<Interest>, 2> interests;
+  };
+
+  // State which lives on the stack within Run(), to support nested run loops.
+  struct RunState {
+    explicit RunState(Delegate* delegate) : delegate(delegate) {}
+
+    // `delegate` is not a raw_ptr<...> for performance reasons (based on
+    // analysis of sampling profiler data and tab_search:top100:2020).
+    RAW_PTR_EXCLUSION Delegate* const delegate;
+
+    // Used to flag that the current Run() invocation should return ASAP.
+    bool should_quit = false;
+  };
+
+  // Returns a zeroed submission queue entry to fill in, submitting queued
+  // entries first if the submission ring is full.
+  io_uring_sqe* GetSqe();
+
+  // Moves all the available completions out of the completion ring, so that
+  // the kernel can post more, into `reaped_completions_`.
+  void ReapCompletions();
+
+  // Cancels all the requests in flight, and waits for their completions, so
+  // that the kernel no longer accesses their buffers. Their callbacks are not
+  // run.
+  void CancelAllRequests();
+
+  // Hands all queued submission queue entries to the kernel, and waits until
+  // at least one completion is available or `timeout` expires, unless
+  // `timeout` is zero. Doesn't make a system call if there is nothing to
+  // submit and nothing to wait for.
+  void SubmitAndWait(TimeDelta timeout);
+
+  // Arms, re-arms or cancels the poll request of `entry` so that it monitors
+  // the events of all its active interests.
+  void UpdatePoll(PollEntry& entry);
+  void UnregisterInterest(const scoped_refptr<Interest>& interest);
+
+  void SubmitReadOrWrite(uint8_t opcode,
+                         int fd,
+                         const uint8_t* buffer,
+                         size_t size,
+                         int64_t offset,
+                         IOCompletionCallback callback);
+  void ArmWakeUpRead();
+
+  // Waits for completions as described by SubmitAndWait(), and processes all
+  // the available ones. Returns true if any I/O event or completion was
+  // dispatched, or the pump was woken up.
+  bool WaitForCompletions(TimeDelta timeout);
+  bool OnCompletion(uint64_t user_data, int32_t result);
+  bool OnPollCompletion(int fd, uint32_t generation, int32_t result);
+  void HandleEvent(int fd,
+                   bool can_read,
+                   bool can_write,
+                   FdWatchController* controller);
+  void HandleIOCompletion(IOCompletionCallback callback, int32_t result);
+
+  // Null if Run() is not currently executing. Otherwise it's a pointer into the
+  // stack of the innermost nested Run() invocation.
+  RunState* run_state_ = nullptr;
+
+  // All file descriptors currently watched by this message pump. Values need
+  // stable addresses; see MessagePumpEpoll::entries_.
+  std::map<int, PollEntry> entries_;
+
+  // Callbacks of the reads and writes in flight, keyed by request id.
+  std::map<uint64_t, IOCompletionCallback> pending_io_;
+  uint64_t next_io_id_ = 0;
+
+  // Generation of the last poll request submitted. This is never zero for an
+  // armed request, and lets stale completions of cancelled poll requests be
+  // told apart from completions of the current request on the same fd.
+  uint32_t last_poll_generation_ = 0;
+
+  // The io_uring instance, the memory mapping which holds both its submission
+  // and completion rings, and the mapping of its submission queue entries.
+  ScopedFD ring_;
+  raw_ptr<void> rings_ = nullptr;
+  size_t rings_size_ = 0;
+  raw_ptr<io_uring_sqe> sqes_ = nullptr;
+  size_t sqes_size_ = 0;
+
+  // Pointers into the rings. The kernel updates the head of the submission
+  // ring and the tail of the completion ring concurrently.
+  raw_ptr<std::atomic<uint32_t>> sq_head_ = nullptr;
+  raw_ptr<std::atomic<uint32_t>> sq_tail_ = nullptr;
+  uint32_t sq_mask_ = 0;
+  uint32_t sq_entries_ = 0;
+  raw_ptr<std::atomic<uint32_t>> cq_head_ = nullptr;
+  raw_ptr<std::atomic<uint32_t>> cq_tail_ = nullptr;
+  uint32_t cq_mask_ = 0;
+  raw_ptr<io_uring_cqe> cqes_ = nullptr;
+
+  // Tail of the submission ring including the entries which were queued but
+  // not yet handed to the kernel, and the number of such entries.
+  uint32_t sq_local_tail_ = 0;
+  uint32_t sq_pending_ = 0;
+
+  // The number of requests handed to the kernel whose completion hasn't been
+  // reaped yet.
+  size_t in_flight_ = 0;
+
+  // Completions which were reaped to make room in the completion ring, but not
+  // processed yet. They precede those still in the ring.
+  circular_deque<io_uring_cqe> reaped_completions_;
+
+  // An eventfd object used to wake the pump's thread when scheduling new work.
+  // A read of it is always in flight; its completion is the wakeup.
+  ScopedFD wake_event_;
+  uint64_t wake_value_ = 0;
+
+  size_t syscall_count_ = 0;
+
+  // WatchFileDescriptor(), SubmitRead() and SubmitWrite() must be called from
+  // this thread, and so must FdWatchController::StopWatchingFileDescriptor().
+  THREAD_CHECKER(thread_checker_);
+
+  WeakPtrFactory<MessagePumpIOUring> weak_ptr_factory_{this};
+};
+
+}  // namespace base
+
+#endif  // BASE_MESSAGE_LOOP_MESSAGE_PUMP_IO_URING_H_
@@ -0,0 +1,283 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/message_loop/message_pump_io_uring.h"
+
+#include <errno.h>
+#include <unistd.h>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/callback_helpers.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_file.h"
+#include "base/memory/raw_ptr.h"
+#include "base/message_loop/message_pump_libevent.h"
+#include "base/posix/eintr_wrapper.h"
+#include "base/run_loop.h"
+#include "base/task/single_thread_task_executor.h"
+#include "base/test/bind.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+class MessagePumpIOUringTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    if (!MessagePumpIOUring::IsSupported()) {
+      GTEST_SKIP() << "io_uring is not supported";
+    }
+
+    auto pump = std::make_unique<MessagePumpLibevent>(
+        MessagePumpLibevent::kUseIOUring);
+    pump_ = pump->io_uring_pump();
+    ASSERT_TRUE(pump_);
+    executor_ = std::make_unique<SingleThreadTaskExecutor>(std::move(pump));
+
+    int fds[2];
+    ASSERT_TRUE(CreateLocalNonBlockingPipe(fds));
+    read_fd_.reset(fds[0]);
+    write_fd_.reset(fds[1]);
+  }
+
+  void TearDown() override {
+    pump_ = nullptr;
+    executor_.reset();
+  }
+
+  raw_ptr<MessagePumpIOUring> pump_ = nullptr;
+  std::unique_ptr<SingleThreadTaskExecutor> executor_;
+  ScopedFD read_fd_;
+  ScopedFD write_fd_;
+};
+
+namespace {
+
+// Runs `on_readable` whenever the watched file descriptor is readable.
+class ReadableWatcher : public MessagePumpLibevent::FdWatcher {
+ public:
+  explicit ReadableWatcher(RepeatingClosure on_readable)
+      : on_readable_(std::move(on_readable)) {}
+  ~ReadableWatcher() override = default;
+
+  void OnFileCanReadWithoutBlocking(int fd) override { on_readable_.Run(); }
+  void OnFileCanWriteWithoutBlocking(int fd) override { ADD_FAILURE(); }
+
+ private:
+  RepeatingClosure on_readable_;
+};
+
+}  // namespace
+
+TEST_F(MessagePumpIOUringTest, SubmitWriteThenRead) {
+  const uint8_t data[] = {1, 2, 3, 4};
+  uint8_t buffer[8] = {};
+  int write_result = 0;
+  int read_result = 0;
+
+  RunLoop run_loop;
+  pump_->SubmitWrite(write_fd_.get(), data,
+                     MessagePumpIOUring::kCurrentFilePosition,
+                     BindLambdaForTesting([&](int result) {
+                       write_result = result;
+                       pump_->SubmitRead(
+                           read_fd_.get(), buffer,
+                           MessagePumpIOUring::kCurrentFilePosition,
+                           BindLambdaForTesting([&](int result) {
+                             read_result = result;
+                             run_loop.Quit();
+                           }));
+                     }));
+  run_loop.Run();
+
+  EXPECT_EQ(write_result, static_cast<int>(sizeof(data)));
+  EXPECT_EQ(read_result, static_cast<int>(sizeof(data)));
+  EXPECT_EQ(std::vector<uint8_t>(buffer, buffer + sizeof(data)),
+            std::vector<uint8_t>(std::begin(data), std::end(data)));
+}
+
+// A submitted read of a blocking file descriptor completes once data becomes
+// available, without blocking the pump.
+TEST_F(MessagePumpIOUringTest, SubmitReadWaitsForData) {
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+  ScopedFD read_fd(fds[0]);
+  ScopedFD write_fd(fds[1]);
+  uint8_t buffer = 0;
+  int read_result = 0;
+
+  RunLoop run_loop;
+  pump_->SubmitRead(read_fd.get(), span<uint8_t>(&buffer, 1u),
+                    MessagePumpIOUring::kCurrentFilePosition,
+                    BindLambdaForTesting([&](int result) {
+                      read_result = result;
+                      run_loop.Quit();
+                    }));
+  executor_->task_runner()->PostTask(FROM_HERE, BindLambdaForTesting([&]() {
+                                       ASSERT_TRUE(WriteFileDescriptor(
+                                           write_fd.get(), "x"));
+                                     }));
+  run_loop.Run();
+
+  EXPECT_EQ(read_result, 1);
+  EXPECT_EQ(buffer, 'x');
+}
+
+TEST_F(MessagePumpIOUringTest, SubmitReportsErrors) {
+  uint8_t buffer = 0;
+  int read_result = 0;
+
+  RunLoop run_loop;
+  // The write end of a pipe can't be read.
+  pump_->SubmitRead(write_fd_.get(), span<uint8_t>(&buffer, 1u),
+                    MessagePumpIOUring::kCurrentFilePosition,
+                    BindLambdaForTesting([&](int result) {
+                      read_result = result;
+                      run_loop.Quit();
+                    }));
+  run_loop.Run();
+
+  EXPECT_EQ(read_result, -EBADF);
+}
+
+// Requests queued between two waits of the pump are submitted together.
+TEST_F(MessagePumpIOUringTest, BatchedSubmission) {
+  constexpr size_t kNumWrites = 16;
+  const uint8_t data = 0;
+  size_t num_completed = 0;
+
+  RunLoop run_loop;
+  executor_->task_runner()->PostTask(
+      FROM_HERE, BindLambdaForTesting([&]() {
+        for (size_t i = 0; i < kNumWrites; ++i) {
+          pump_->SubmitWrite(write_fd_.get(), span<const uint8_t>(&data, 1u),
+                             MessagePumpIOUring::kCurrentFilePosition,
+                             BindLambdaForTesting([&](int result) {
+                               EXPECT_EQ(result, 1);
+                               if (++num_completed == kNumWrites)
+                                 run_loop.Quit();
+                             }));
+        }
+      }));
+  const size_t syscall_count_before = pump_->syscall_count_for_testing();
+  run_loop.Run();
+
+  EXPECT_EQ(num_completed, kNumWrites);
+  EXPECT_LE(pump_->syscall_count_for_testing() - syscall_count_before, 2u);
+}
+
+// More requests than the completion ring can hold can be queued between two
+// waits of the pump. Their callbacks only run once the pump waits.
+TEST_F(MessagePumpIOUringTest, SubmitMoreThanCompletionRingHolds) {
+  constexpr size_t kNumWrites = 2000;
+  const uint8_t data = 0;
+  size_t num_completed = 0;
+
+  RunLoop run_loop;
+  executor_->task_runner()->PostTask(
+      FROM_HERE, BindLambdaForTesting([&]() {
+        for (size_t i = 0; i < kNumWrites; ++i) {
+          pump_->SubmitWrite(write_fd_.get(), span<const uint8_t>(&data, 1u),
+                             MessagePumpIOUring::kCurrentFilePosition,
+                             BindLambdaForTesting([&](int result) {
+                               EXPECT_EQ(result, 1);
+                               if (++num_completed == kNumWrites)
+                                 run_loop.Quit();
+                             }));
+        }
+        EXPECT_EQ(num_completed, 0u);
+      }));
+  run_loop.Run();
+
+  EXPECT_EQ(num_completed, kNumWrites);
+  std::vector<uint8_t> buffer(kNumWrites + 1);
+  EXPECT_EQ(HANDLE_EINTR(read(read_fd_.get(), buffer.data(), buffer.size())),
+            static_cast<ssize_t>(kNumWrites));
+}
+
+// Destroying the pump cancels the reads in flight before returning, so they
+// don't consume data or write into their buffer afterwards.
+TEST_F(MessagePumpIOUringTest, DestroyCancelsReadsInFlight) {
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+  ScopedFD read_fd(fds[0]);
+  ScopedFD write_fd(fds[1]);
+  auto buffer = std::make_unique<uint8_t>(0);
+  pump_->SubmitRead(read_fd.get(), span<uint8_t>(buffer.get(), 1u),
+                    MessagePumpIOUring::kCurrentFilePosition,
+                    BindOnce([](int result) { ADD_FAILURE(); }));
+  // Have the pump submit the read.
+  RunLoop().RunUntilIdle();
+
+  pump_ = nullptr;
+  executor_.reset();
+  ASSERT_TRUE(WriteFileDescriptor(write_fd.get(), "x"));
+  char c = 0;
+  EXPECT_EQ(HANDLE_EINTR(read(read_fd.get(), &c, 1)), 1);
+  EXPECT_EQ(c, 'x');
+  EXPECT_EQ(*buffer, 0);
+}
+
+TEST_F(MessagePumpIOUringTest, WatchPersistentRead) {
+  MessagePumpLibevent::FdWatchController controller(FROM_HERE);
+  RunLoop run_loop;
+  int num_reads = 0;
+  ReadableWatcher watcher(BindLambdaForTesting([&]() {
+    char c;
+    ASSERT_EQ(HANDLE_EINTR(read(read_fd_.get(), &c, 1)), 1);
+    if (++num_reads < 3) {
+      ASSERT_TRUE(WriteFileDescriptor(write_fd_.get(), "x"));
+    } else {
+      run_loop.Quit();
+    }
+  }));
+  ASSERT_TRUE(pump_->WatchFileDescriptor(read_fd_.get(), /*persistent=*/true,
+                                         MessagePumpLibevent::WATCH_READ,
+                                         &controller, &watcher));
+  ASSERT_TRUE(WriteFileDescriptor(write_fd_.get(), "x"));
+  run_loop.Run();
+
+  EXPECT_EQ(num_reads, 3);
+}
+
+TEST_F(MessagePumpIOUringTest, WatchOneShotRead) {
+  MessagePumpLibevent::FdWatchController controller(FROM_HERE);
+  int num_notifications = 0;
+  ReadableWatcher watcher(
+      BindLambdaForTesting([&]() { ++num_notifications; }));
+  ASSERT_TRUE(pump_->WatchFileDescriptor(read_fd_.get(), /*persistent=*/false,
+                                         MessagePumpLibevent::WATCH_READ,
+                                         &controller, &watcher));
+  ASSERT_TRUE(WriteFileDescriptor(write_fd_.get(), "x"));
+
+  // The data is never read, but the one-shot watch only triggers once.
+  for (int i = 0; i < 3; ++i)
+    RunLoop().RunUntilIdle();
+  EXPECT_EQ(num_notifications, 1);
+
+  // Watching again triggers again.
+  ASSERT_TRUE(pump_->WatchFileDescriptor(read_fd_.get(), /*persistent=*/false,
+                                         MessagePumpLibevent::WATCH_READ,
+                                         &controller, &watcher));
+  RunLoop().RunUntilIdle();
+  EXPECT_EQ(num_notifications, 2);
+}
+
+TEST_F(MessagePumpIOUringTest, StopWatching) {
+  MessagePumpLibevent::FdWatchController controller(FROM_HERE);
+  ReadableWatcher watcher(BindRepeating([]() { ADD_FAILURE(); }));
+  ASSERT_TRUE(pump_->WatchFileDescriptor(read_fd_.get(), /*persistent=*/true,
+                                         MessagePumpLibevent::WATCH_READ,
+                                         &controller, &watcher));
+  RunLoop().RunUntilIdle();
+  EXPECT_TRUE(controller.StopWatchingFileDescriptor());
+
+  ASSERT_TRUE(WriteFileDescriptor(write_fd_.get(), "x"));
+  RunLoop().RunUntilIdle();
+}
+
+}  // namespace base
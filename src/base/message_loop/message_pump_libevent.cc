@@ -26,6 +26,10 @@
 #include "base/message_loop/message_pump_epoll.h"
 #endif
 
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_IO_URING)
+#include "base/message_loop/message_pump_io_uring.h"
+#endif
+
 // Lifecycle of struct event
 // Libevent uses two main data structures:
 // struct event_base (of which there is one per message pump), and
@@ -48,6 +52,16 @@ const Feature kMessagePumpEpoll{"MessagePumpEpoll",
                                 FEATURE_DISABLED_BY_DEFAULT};
 #endif
 
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_IO_URING)
+bool g_use_io_uring = false;
+
+// Takes precedence over kMessagePumpEpoll. Has no effect if the kernel doesn't
+// support io_uring, in which case epoll or libevent is used as if this feature
+// were disabled.
+const Feature kMessagePumpIOUring{"MessagePumpIOUring",
+                                  FEATURE_DISABLED_BY_DEFAULT};
+#endif
+
 }  // namespace
 
 MessagePumpLibevent::FdWatchController::FdWatchController(
@@ -81,6 +95,14 @@ bool MessagePumpLibevent::FdWatchController::StopWatchingFileDescriptor() {
   }
 #endif
 
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_IO_URING)
+  if (epoll_interest_ && io_uring_pump_) {
+    io_uring_pump_->UnregisterInterest(epoll_interest_);
+    epoll_interest_.reset();
+    io_uring_pump_.reset();
+  }
+#endif
+
   return true;
 }
 
@@ -138,6 +160,13 @@ void MessagePumpLibevent::FdWatchController::OnFdWritable() {
 }
 
 MessagePumpLibevent::MessagePumpLibevent() : event_base_(event_base_new()) {
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_IO_URING)
+  if (g_use_io_uring && MessagePumpIOUring::IsSupported()) {
+    io_uring_pump_ = std::make_unique<MessagePumpIOUring>();
+    return;
+  }
+#endif
+
 #if BUILDFLAG(ENABLE_MESSAGE_PUMP_EPOLL)
   if (g_use_epoll) {
     epoll_pump_ = std::make_unique<MessagePumpEpoll>();
@@ -160,11 +189,19 @@ MessagePumpLibevent::MessagePumpLibevent(decltype(kUseEpoll))
 }
 #endif
 
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_IO_URING)
+MessagePumpLibevent::MessagePumpLibevent(decltype(kUseIOUring))
+    : io_uring_pump_(std::make_unique<MessagePumpIOUring>()),
+      event_base_(event_base_new()) {}
+#endif
+
 MessagePumpLibevent::~MessagePumpLibevent() {
+  bool using_libevent = true;
 #if BUILDFLAG(ENABLE_MESSAGE_PUMP_EPOLL)
-  const bool using_libevent = !epoll_pump_;
-#else
-  const bool using_libevent = true;
+  using_libevent &= !epoll_pump_;
+#endif
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_IO_URING)
+  using_libevent &= !io_uring_pump_;
 #endif
 
   DCHECK(event_base_);
@@ -192,6 +229,9 @@ void MessagePumpLibevent::InitializeFeatures() {
 #if BUILDFLAG(ENABLE_MESSAGE_PUMP_EPOLL)
   g_use_epoll = FeatureList::IsEnabled(kMessagePumpEpoll);
 #endif
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_IO_URING)
+  g_use_io_uring = FeatureList::IsEnabled(kMessagePumpIOUring);
+#endif
 }
 
 bool MessagePumpLibevent::WatchFileDescriptor(int fd,
@@ -205,6 +245,12 @@ bool MessagePumpLibevent::WatchFileDescriptor(int fd,
                                             delegate);
   }
 #endif
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_IO_URING)
+  if (io_uring_pump_) {
+    return io_uring_pump_->WatchFileDescriptor(fd, persistent, mode,
+                                               controller, delegate);
+  }
+#endif
 
   TRACE_EVENT("base", "MessagePumpLibevent::WatchFileDescriptor", "fd", fd,
               "persistent", persistent, "watch_read", mode & WATCH_READ,
@@ -281,6 +327,12 @@ void MessagePumpLibevent::Run(Delegate* delegate) {
     return;
   }
 #endif
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_IO_URING)
+  if (io_uring_pump_) {
+    io_uring_pump_->Run(delegate);
+    return;
+  }
+#endif
 
   RunState run_state(delegate);
   AutoReset<RunState*> auto_reset_run_state(&run_state_, &run_state);
@@ -374,6 +426,12 @@ void MessagePumpLibevent::Quit() {
     return;
   }
 #endif
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_IO_URING)
+  if (io_uring_pump_) {
+    io_uring_pump_->Quit();
+    return;
+  }
+#endif
 
   DCHECK(run_state_) << "Quit was called outside of Run!";
   // Tell both libevent and Run that they should break out of their loops.
@@ -388,6 +446,12 @@ void MessagePumpLibevent::ScheduleWork() {
     return;
   }
 #endif
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_IO_URING)
+  if (io_uring_pump_) {
+    io_uring_pump_->ScheduleWork();
+    return;
+  }
+#endif
 
   // Tell libevent (in a threadsafe way) that it should break out of its loop.
   char buf = 0;
@@ -402,6 +466,21 @@ void MessagePumpLibevent::ScheduleDelayedWork(
   // thread as Run(). When using epoll, the pump clearly must be in between
   // waits if we're here. In either case, any scheduled work will be seen prior
   // to the next libevent loop or epoll wait, so there's nothing to do here.
+  // The same goes for io_uring.
+}
+
+size_t MessagePumpLibevent::GetSyscallCountForTesting() const {
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_EPOLL)
+  if (epoll_pump_) {
+    return epoll_pump_->syscall_count_for_testing();
+  }
+#endif
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_IO_URING)
+  if (io_uring_pump_) {
+    return io_uring_pump_->syscall_count_for_testing();
+  }
+#endif
+  return 0;
 }
 
 bool MessagePumpLibevent::Init() {
@@ -24,6 +24,7 @@ struct event;
 namespace base {
 
 class MessagePumpEpoll;
+class MessagePumpIOUring;
 
 // Class to monitor sockets and issue callbacks when sockets are ready for I/O
 // TODO(dkegel): add support for background file IO somehow
@@ -81,12 +82,12 @@ class BASE_EXPORT MessagePumpLibevent : public MessagePump,
     bool active_ = true;
   };
 
-  // Note that this class is used as the FdWatchController for both
-  // MessagePumpLibevent *and* MessagePumpEpoll in order to avoid unnecessary
-  // code churn during experimentation and eventual transition. Consumers
-  // construct their own FdWatchController instances, so switching this type
-  // at runtime would require potentially complex logic changes to all
-  // consumers.
+  // Note that this class is used as the FdWatchController for
+  // MessagePumpLibevent, MessagePumpEpoll *and* MessagePumpIOUring in order to
+  // avoid unnecessary code churn during experimentation and eventual
+  // transition. Consumers construct their own FdWatchController instances, so
+  // switching this type at runtime would require potentially complex logic
+  // changes to all consumers.
   class FdWatchController : public FdWatchControllerInterface {
    public:
     explicit FdWatchController(const Location& from_here);
@@ -102,10 +103,11 @@ class BASE_EXPORT MessagePumpLibevent : public MessagePump,
 
    private:
     friend class MessagePumpEpoll;
+    friend class MessagePumpIOUring;
     friend class MessagePumpLibevent;
     friend class MessagePumpLibeventTest;
 
-    // Common methods called by both pump implementations.
+    // Common methods called by all pump implementations.
     void set_watcher(FdWatcher* watcher) { watcher_ = watcher; }
 
     // Methods called only by MessagePumpLibevent
@@ -118,17 +120,23 @@ class BASE_EXPORT MessagePumpLibevent : public MessagePump,
     void OnFileCanReadWithoutBlocking(int fd, MessagePumpLibevent* pump);
     void OnFileCanWriteWithoutBlocking(int fd, MessagePumpLibevent* pump);
 
-    // Methods called only by MessagePumpEpoll
+    // Methods called by MessagePumpEpoll and MessagePumpIOUring
     void set_epoll_pump(WeakPtr<MessagePumpEpoll> pump) {
       epoll_pump_ = std::move(pump);
     }
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_IO_URING)
+    void set_io_uring_pump(WeakPtr<MessagePumpIOUring> pump) {
+      io_uring_pump_ = std::move(pump);
+    }
+#endif
     const scoped_refptr<EpollInterest>& epoll_interest() const {
       return epoll_interest_;
     }
 
     // Creates a new Interest described by `params` and adopts it as this
     // controller's exclusive interest. Any prior interest is dropped by the
-    // controller and should be unregistered on the MessagePumpEpoll.
+    // controller and should be unregistered on the MessagePumpEpoll or
+    // MessagePumpIOUring.
     const scoped_refptr<EpollInterest>& AssignEpollInterest(
         const EpollInterestParams& params);
 
@@ -146,8 +154,11 @@ class BASE_EXPORT MessagePumpLibevent : public MessagePump,
     std::unique_ptr<event> event_;
     raw_ptr<MessagePumpLibevent> libevent_pump_ = nullptr;
 
-    // State used only with epoll
+    // State used with epoll and io_uring. Only one of the pumps is set.
     WeakPtr<MessagePumpEpoll> epoll_pump_;
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_IO_URING)
+    WeakPtr<MessagePumpIOUring> io_uring_pump_;
+#endif
     scoped_refptr<EpollInterest> epoll_interest_;
   };
 
@@ -160,6 +171,17 @@ class BASE_EXPORT MessagePumpLibevent : public MessagePump,
   explicit MessagePumpLibevent(decltype(kUseEpoll));
 #endif
 
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_IO_URING)
+  // Constructs a MessagePumpLibevent which is forced to use io_uring directly
+  // instead of libevent. MessagePumpIOUring::IsSupported() must return true.
+  enum { kUseIOUring };
+  explicit MessagePumpLibevent(decltype(kUseIOUring));
+
+  // Returns the io_uring pump used by this pump, through which reads and
+  // writes can be submitted, or null if io_uring isn't used.
+  MessagePumpIOUring* io_uring_pump() { return io_uring_pump_.get(); }
+#endif
+
   MessagePumpLibevent(const MessagePumpLibevent&) = delete;
   MessagePumpLibevent& operator=(const MessagePumpLibevent&) = delete;
 
@@ -183,6 +205,11 @@ class BASE_EXPORT MessagePumpLibevent : public MessagePump,
   void ScheduleDelayedWork(
       const Delegate::NextWorkInfo& next_work_info) override;
 
+  // Returns the number of system calls made so far by the epoll or io_uring
+  // pump used by this pump on its thread to wait for events, not counting
+  // those made by FdWatchers. Always 0 with libevent, which isn't instrumented.
+  size_t GetSyscallCountForTesting() const;
+
  private:
   friend class MessagePumpLibeventTest;
 
@@ -214,6 +241,12 @@ class BASE_EXPORT MessagePumpLibevent : public MessagePump,
   std::unique_ptr<MessagePumpEpoll> epoll_pump_;
 #endif
 
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_IO_URING)
+  // Same as `epoll_pump_`, if direct use of io_uring is enabled and supported
+  // instead. At most one of `epoll_pump_` and `io_uring_pump_` is set.
+  std::unique_ptr<MessagePumpIOUring> io_uring_pump_;
+#endif
+
   // State for the current invocation of Run(). null if not running.
   RunState* run_state_ = nullptr;
 
@@ -37,11 +37,16 @@
 #include "base/message_loop/message_pump_epoll.h"
 #endif
 
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_IO_URING)
+#include "base/message_loop/message_pump_io_uring.h"
+#endif
+
 namespace base {
 
 enum PumpType {
   kLibevent,
   kEpoll,
+  kIOUring,
 };
 
 class MessagePumpLibeventTest : public testing::Test,
@@ -54,6 +59,11 @@ class MessagePumpLibeventTest : public testing::Test,
   ~MessagePumpLibeventTest() override = default;
 
   void SetUp() override {
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_IO_URING)
+    if (GetParam() == kIOUring && !MessagePumpIOUring::IsSupported()) {
+      GTEST_SKIP() << "io_uring is not supported";
+    }
+#endif
     Thread::Options options(MessagePumpType::IO, 0);
     ASSERT_TRUE(io_thread_.StartWithOptions(std::move(options)));
     int ret = pipe(pipefds_);
@@ -61,6 +71,10 @@ class MessagePumpLibeventTest : public testing::Test,
   }
 
   void TearDown() override {
+    if (IsSkipped()) {
+      return;
+    }
+
     // Some tests watch |pipefds_| from the |io_thread_|. The |io_thread_| must
     // thus be joined to ensure those watches are complete before closing the
     // pipe.
@@ -78,6 +92,12 @@ class MessagePumpLibeventTest : public testing::Test,
       return std::make_unique<MessagePumpLibevent>(
           MessagePumpLibevent::kUseEpoll);
     }
+#endif
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_IO_URING)
+    if (GetParam() == kIOUring) {
+      return std::make_unique<MessagePumpLibevent>(
+          MessagePumpLibevent::kUseIOUring);
+    }
 #endif
     return std::make_unique<MessagePumpLibevent>();
   }
@@ -94,6 +114,13 @@ class MessagePumpLibeventTest : public testing::Test,
                                      controller);
       return;
     }
+#endif
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_IO_URING)
+    if (GetParam() == kIOUring) {
+      pump->io_uring_pump_->HandleEvent(0, /*can_read=*/true,
+                                        /*can_write=*/true, controller);
+      return;
+    }
 #endif
     pump->OnLibeventNotification(0, EV_WRITE | EV_READ, controller);
   }
@@ -289,7 +316,10 @@ TEST_P(MessagePumpLibeventTest, QuitWatcher) {
                                             Owned(watcher.release())));
 }
 
-#if BUILDFLAG(ENABLE_MESSAGE_PUMP_EPOLL)
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_EPOLL) && \
+    BUILDFLAG(ENABLE_MESSAGE_PUMP_IO_URING)
+#define TEST_PARAM_VALUES kLibevent, kEpoll, kIOUring
+#elif BUILDFLAG(ENABLE_MESSAGE_PUMP_EPOLL)
 #define TEST_PARAM_VALUES kLibevent, kEpoll
 #else
 #define TEST_PARAM_VALUES kLibevent
@@ -6,11 +6,13 @@
 #include <stdint.h>
 
 #include <memory>
+#include <utility>
 
 #include "base/bind.h"
 #include "base/callback_helpers.h"
 #include "base/format_macros.h"
 #include "base/memory/ptr_util.h"
+#include "base/message_loop/message_pump_buildflags.h"
 #include "base/message_loop/message_pump_type.h"
 #include "base/strings/stringprintf.h"
 #include "base/synchronization/condition_variable.h"
@@ -29,6 +31,21 @@
 #include "base/android/java_handler_thread.h"
 #endif
 
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_EPOLL) || \
+    BUILDFLAG(ENABLE_MESSAGE_PUMP_IO_URING)
+#include <unistd.h>
+
+#include "base/files/scoped_file.h"
+#include "base/memory/raw_ptr.h"
+#include "base/message_loop/message_pump_libevent.h"
+#include "base/posix/eintr_wrapper.h"
+#include "base/test/bind.h"
+#endif
+
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_IO_URING)
+#include "base/message_loop/message_pump_io_uring.h"
+#endif
+
 namespace base {
 namespace {
 
@@ -265,4 +282,212 @@ TEST_F(ScheduleWorkTest, ThreadTimeToJavaFromFourThreads) {
 }
 #endif
 
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_EPOLL) || \
+    BUILDFLAG(ENABLE_MESSAGE_PUMP_IO_URING)
+namespace {
+
+constexpr char kMetricPrefixIOWakeUp[] = "IOWakeUp.";
+constexpr char kMetricRoundTripTime[] = "round_trip_time";
+constexpr char kMetricSyscallsPerRoundTrip[] = "syscalls_per_round_trip";
+
+// How the I/O thread echoes the bytes it receives.
+enum class EchoMode {
+  // Watch the input with WatchFileDescriptor(), then read() and write().
+  kReadiness,
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_IO_URING)
+  // Submit reads and writes to MessagePumpIOUring.
+  kCompletion,
+#endif
+};
+
+// Echoes every byte read from `in` to `out`, on the thread of `pump`, and
+// counts the system calls it makes itself.
+class Echo : public MessagePumpLibevent::FdWatcher {
+ public:
+  Echo(MessagePumpLibevent* pump, int in, int out)
+      : pump_(pump), in_(in), out_(out), controller_(FROM_HERE) {}
+  ~Echo() override = default;
+
+  void Start(EchoMode mode) {
+    switch (mode) {
+      case EchoMode::kReadiness:
+        pump_->WatchFileDescriptor(in_, /*persistent=*/true,
+                                   MessagePumpLibevent::WATCH_READ,
+                                   &controller_, this);
+        break;
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_IO_URING)
+      case EchoMode::kCompletion:
+        SubmitRead();
+        break;
+#endif
+    }
+  }
+
+  size_t syscall_count() const { return syscall_count_; }
+
+  // MessagePumpLibevent::FdWatcher:
+  void OnFileCanReadWithoutBlocking(int fd) override {
+    syscall_count_ += 2;
+    ASSERT_EQ(HANDLE_EINTR(read(in_, &byte_, 1)), 1);
+    ASSERT_EQ(HANDLE_EINTR(write(out_, &byte_, 1)), 1);
+  }
+  void OnFileCanWriteWithoutBlocking(int fd) override {}
+
+ private:
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_IO_URING)
+  void SubmitRead() {
+    pump_->io_uring_pump()->SubmitRead(
+        in_, span<uint8_t>(&byte_, 1u),
+        MessagePumpIOUring::kCurrentFilePosition,
+        BindOnce(&Echo::OnReadComplete, Unretained(this)));
+  }
+
+  void OnReadComplete(int result) {
+    if (result != 1) {
+      // The input was closed.
+      return;
+    }
+    // The write is submitted along with the next read, by the same system call
+    // as the pump's next wait.
+    pump_->io_uring_pump()->SubmitWrite(
+        out_, span<const uint8_t>(&byte_, 1u),
+        MessagePumpIOUring::kCurrentFilePosition,
+        BindOnce([](int result) { ASSERT_EQ(result, 1); }));
+    SubmitRead();
+  }
+#endif
+
+  const raw_ptr<MessagePumpLibevent> pump_;
+  const int in_;
+  const int out_;
+  MessagePumpLibevent::FdWatchController controller_;
+  uint8_t byte_ = 0;
+  size_t syscall_count_ = 0;
+};
+
+}  // namespace
+
+// Measures the latency of waking up an I/O thread blocked in its message pump
+// by making a file descriptor readable, and the number of system calls the I/O
+// thread makes to handle each wakeup. The main thread writes a byte to a pipe,
+// which the I/O thread echoes to another pipe, from which the main thread
+// reads it back.
+class IOWakeUpTest : public testing::Test {
+ public:
+  using PumpFactory = RepeatingCallback<std::unique_ptr<MessagePumpLibevent>()>;
+
+  void RoundTrip(PumpFactory pump_factory,
+                 EchoMode mode,
+                 const std::string& story_name) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    ScopedFD ping_read(fds[0]);
+    ScopedFD ping_write(fds[1]);
+    ASSERT_EQ(pipe(fds), 0);
+    ScopedFD pong_read(fds[0]);
+    ScopedFD pong_write(fds[1]);
+
+    MessagePumpLibevent* pump = nullptr;
+    Thread io_thread("IOWakeUpTest");
+    Thread::Options options;
+    options.message_pump_factory = BindLambdaForTesting(
+        [&]() -> std::unique_ptr<MessagePump> {
+          std::unique_ptr<MessagePumpLibevent> new_pump = pump_factory.Run();
+          pump = new_pump.get();
+          return new_pump;
+        });
+    ASSERT_TRUE(io_thread.StartWithOptions(std::move(options)));
+    io_thread.WaitUntilThreadStarted();
+
+    auto echo = std::make_unique<Echo>(pump, ping_read.get(), pong_write.get());
+    RunOnIOThread(io_thread,
+                  BindLambdaForTesting([&]() { echo->Start(mode); }));
+
+    size_t syscalls_before = 0;
+    RunOnIOThread(io_thread, BindLambdaForTesting([&]() {
+                    syscalls_before = pump->GetSyscallCountForTesting() +
+                                      echo->syscall_count();
+                  }));
+
+    const TimeTicks start = TimeTicks::Now();
+    for (size_t i = 0; i < kNumRoundTrips; ++i) {
+      const uint8_t sent = static_cast<uint8_t>(i);
+      uint8_t received = 0;
+      ASSERT_EQ(HANDLE_EINTR(write(ping_write.get(), &sent, 1)), 1);
+      ASSERT_EQ(HANDLE_EINTR(read(pong_read.get(), &received, 1)), 1);
+      ASSERT_EQ(received, sent);
+    }
+    const TimeDelta elapsed = TimeTicks::Now() - start;
+
+    size_t syscalls_after = 0;
+    RunOnIOThread(io_thread, BindLambdaForTesting([&]() {
+                    syscalls_after = pump->GetSyscallCountForTesting() +
+                                     echo->syscall_count();
+                    // A read submitted by `echo` may still be in flight. It is
+                    // cancelled without running its callback when the pump is
+                    // destroyed.
+                    echo.reset();
+                  }));
+    io_thread.Stop();
+
+    perf_test::PerfResultReporter reporter(kMetricPrefixIOWakeUp, story_name);
+    reporter.RegisterImportantMetric(kMetricRoundTripTime, "us");
+    reporter.RegisterImportantMetric(kMetricSyscallsPerRoundTrip, "count");
+    reporter.AddResult(kMetricRoundTripTime,
+                       elapsed.InMicrosecondsF() / kNumRoundTrips);
+    // Includes the system calls made to run the tasks posted by
+    // RunOnIOThread() after the last round trip.
+    reporter.AddResult(
+        kMetricSyscallsPerRoundTrip,
+        static_cast<double>(syscalls_after - syscalls_before) / kNumRoundTrips);
+  }
+
+ private:
+  static void RunOnIOThread(Thread& io_thread, OnceClosure task) {
+    WaitableEvent done;
+    io_thread.task_runner()->PostTask(
+        FROM_HERE, std::move(task).Then(BindOnce(&WaitableEvent::Signal,
+                                                 Unretained(&done))));
+    done.Wait();
+  }
+
+  static constexpr size_t kNumRoundTrips = 20000;
+};
+
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_EPOLL)
+TEST_F(IOWakeUpTest, EpollReadiness) {
+  RoundTrip(BindRepeating([]() {
+              return std::make_unique<MessagePumpLibevent>(
+                  MessagePumpLibevent::kUseEpoll);
+            }),
+            EchoMode::kReadiness, "epoll_readiness");
+}
+#endif
+
+#if BUILDFLAG(ENABLE_MESSAGE_PUMP_IO_URING)
+TEST_F(IOWakeUpTest, IOUringReadiness) {
+  if (!MessagePumpIOUring::IsSupported()) {
+    GTEST_SKIP() << "io_uring is not supported";
+  }
+  RoundTrip(BindRepeating([]() {
+              return std::make_unique<MessagePumpLibevent>(
+                  MessagePumpLibevent::kUseIOUring);
+            }),
+            EchoMode::kReadiness, "io_uring_readiness");
+}
+
+TEST_F(IOWakeUpTest, IOUringCompletion) {
+  if (!MessagePumpIOUring::IsSupported()) {
+    GTEST_SKIP() << "io_uring is not supported";
+  }
+  RoundTrip(BindRepeating([]() {
+              return std::make_unique<MessagePumpLibevent>(
+                  MessagePumpLibevent::kUseIOUring);
+            }),
+            EchoMode::kCompletion, "io_uring_completion");
+}
+#endif
+#endif  // BUILDFLAG(ENABLE_MESSAGE_PUMP_EPOLL) ||
+        // BUILDFLAG(ENABLE_MESSAGE_PUMP_IO_URING)
+
 }  // namespace base
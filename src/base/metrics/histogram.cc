@@ -29,6 +29,7 @@
 #include "base/metrics/persistent_histogram_allocator.h"
 #include "base/metrics/persistent_memory_allocator.h"
 #include "base/metrics/sample_vector.h"
+#include "base/metrics/sharded_samples.h"
 #include "base/metrics/statistics_recorder.h"
 #include "base/notreached.h"
 #include "base/pickle.h"
@@ -523,7 +524,10 @@ void Histogram::AddCount(int value, int count) {
     NOTREACHED();
     return;
   }
-  unlogged_samples_->Accumulate(value, count);
+  if (flags() & kShardedRecordingFlag)
+    GetOrCreateShardedSamples()->Accumulate(value, count);
+  else
+    unlogged_samples_->Accumulate(value, count);
 
   if (UNLIKELY(StatisticsRecorder::have_active_callbacks()))
     FindAndRunCallbacks(value);
@@ -613,7 +617,9 @@ Histogram::Histogram(const char* name,
       unlogged_samples_->id(), ranges, logged_meta, logged_counts);
 }
 
-Histogram::~Histogram() = default;
+Histogram::~Histogram() {
+  delete sharded_samples_.load(std::memory_order_relaxed);
+}
 
 const std::string Histogram::GetAsciiBucketRange(size_t i) const {
   return GetSimpleAsciiBucketRange(ranges(i));
@@ -656,12 +662,37 @@ std::unique_ptr<SampleVector> Histogram::SnapshotAllSamples() const {
 }
 
 std::unique_ptr<SampleVector> Histogram::SnapshotUnloggedSamples() const {
+  MergeShardedSamples();
   std::unique_ptr<SampleVector> samples(
       new SampleVector(unlogged_samples_->id(), bucket_ranges()));
   samples->Add(*unlogged_samples_);
   return samples;
 }
 
+ShardedSampleVector* Histogram::GetOrCreateShardedSamples() {
+  ShardedSampleVector* sharded_samples =
+      sharded_samples_.load(std::memory_order_acquire);
+  if (LIKELY(sharded_samples))
+    return sharded_samples;
+  auto new_sharded_samples = std::make_unique<ShardedSampleVector>(
+      unlogged_samples_->id(), bucket_ranges());
+  // If another thread created the shards first, |sharded_samples| is updated
+  // to point to them.
+  if (sharded_samples_.compare_exchange_strong(
+          sharded_samples, new_sharded_samples.get(), std::memory_order_acq_rel,
+          std::memory_order_acquire)) {
+    sharded_samples = new_sharded_samples.release();
+  }
+  return sharded_samples;
+}
+
+void Histogram::MergeShardedSamples() const {
+  ShardedSampleVector* sharded_samples =
+      sharded_samples_.load(std::memory_order_acquire);
+  if (sharded_samples)
+    sharded_samples->MoveTo(unlogged_samples_.get());
+}
+
 Value::Dict Histogram::GetParameters() const {
   Value::Dict params;
   params.Set("type", HistogramTypeToString(GetHistogramType()));
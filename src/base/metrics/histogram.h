@@ -67,6 +67,7 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <atomic>
 #include <map>
 #include <memory>
 #include <string>
@@ -97,6 +98,7 @@ class Pickle;
 class PickleIterator;
 class SampleVector;
 class SampleVectorBase;
+class ShardedSampleVector;
 
 class BASE_EXPORT Histogram : public HistogramBase {
  public:
@@ -274,9 +276,17 @@ class BASE_EXPORT Histogram : public HistogramBase {
   // internal use.
   std::unique_ptr<SampleVector> SnapshotAllSamples() const;
 
-  // Create a copy of unlogged samples.
+  // Create a copy of unlogged samples, after merging the sharded samples into
+  // them.
   std::unique_ptr<SampleVector> SnapshotUnloggedSamples() const;
 
+  // Returns the shards which samples are recorded into when the histogram has
+  // kShardedRecordingFlag, creating them on first use.
+  ShardedSampleVector* GetOrCreateShardedSamples();
+
+  // Moves the samples recorded into shards, if any, to |unlogged_samples_|.
+  void MergeShardedSamples() const;
+
   // Writes the type, min, max, and bucket count information of the histogram in
   // |params|.
   Value::Dict GetParameters() const override;
@@ -287,6 +297,10 @@ class BASE_EXPORT Histogram : public HistogramBase {
   // Accumulation of all samples that have been logged with SnapshotDelta().
   std::unique_ptr<SampleVectorBase> logged_samples_;
 
+  // Samples recorded with kShardedRecordingFlag which haven't been merged into
+  // |unlogged_samples_| yet. Created on first use, and owned by this object.
+  std::atomic<ShardedSampleVector*> sharded_samples_{nullptr};
+
 #if DCHECK_IS_ON()  // Don't waste memory if it won't be used.
   // Flag to indicate if PrepareFinalDelta has been previously called. It is
   // used to DCHECK that a final delta is not created multiple times.
@@ -130,6 +130,13 @@ class BASE_EXPORT HistogramBase {
     // MemoryAllocator, and that loaded into the Histogram module before this
     // histogram is created.
     kIsPersistent = 0x40,
+
+    // Indicates that samples are recorded into per-thread shards, which are
+    // merged into the histogram's samples when it's snapshotted. This avoids
+    // contention between threads which record into the same histogram at a
+    // high rate, at the cost of some memory per histogram. For persistent
+    // histograms, samples only reach persistent memory once merged.
+    kShardedRecordingFlag = 0x80,
   };
 
   // Histogram data inconsistency types.
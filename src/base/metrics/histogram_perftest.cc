@@ -0,0 +1,176 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/check.h"
+#include "base/memory/raw_ptr.h"
+#include "base/metrics/histogram.h"
+#include "base/metrics/histogram_base.h"
+#include "base/metrics/histogram_samples.h"
+#include "base/metrics/sparse_histogram.h"
+#include "base/metrics/statistics_recorder.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/simple_thread.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+
+namespace base {
+
+namespace {
+
+constexpr char kMetricPrefixHistogram[] = "Histogram.";
+constexpr char kMetricAddThroughput[] = "add_throughput";
+constexpr char kMetricFindThroughput[] = "find_throughput";
+
+constexpr int kNumAddsPerThread = 1000000;
+constexpr int kNumFindsPerThread = 200000;
+constexpr int kNumFoundHistograms = 64;
+
+perf_test::PerfResultReporter SetUpReporter(const std::string& story_name) {
+  perf_test::PerfResultReporter reporter(kMetricPrefixHistogram, story_name);
+  reporter.RegisterImportantMetric(kMetricAddThroughput, "adds/ms");
+  reporter.RegisterImportantMetric(kMetricFindThroughput, "finds/ms");
+  return reporter;
+}
+
+class AddThread : public SimpleThread {
+ public:
+  AddThread(HistogramBase* histogram, WaitableEvent* start)
+      : SimpleThread("AddThread"), histogram_(histogram), start_(start) {}
+
+  void Run() override {
+    start_->Wait();
+    for (int i = 0; i < kNumAddsPerThread; ++i)
+      histogram_->Add(i & 15);
+  }
+
+ private:
+  const raw_ptr<HistogramBase> histogram_;
+  const raw_ptr<WaitableEvent> start_;
+};
+
+// Looks up registered histograms by name, as the histogram macros do the first
+// time they run at each call site, and as FactoryGet() does every time.
+class FindThread : public SimpleThread {
+ public:
+  FindThread(const std::vector<std::string>* names, WaitableEvent* start)
+      : SimpleThread("FindThread"), names_(names), start_(start) {}
+
+  void Run() override {
+    start_->Wait();
+    for (int i = 0; i < kNumFindsPerThread; ++i) {
+      const std::string& name = (*names_)[i % names_->size()];
+      CHECK(StatisticsRecorder::FindHistogram(name));
+    }
+  }
+
+ private:
+  const raw_ptr<const std::vector<std::string>> names_;
+  const raw_ptr<WaitableEvent> start_;
+};
+
+}  // namespace
+
+// Measures the throughput of HistogramBase::Add() on 1 to 8 threads recording
+// into the same histogram, with and without kShardedRecordingFlag.
+class HistogramPerfTest : public testing::Test {
+ public:
+  HistogramPerfTest()
+      : statistics_recorder_(StatisticsRecorder::CreateTemporaryForTesting()) {}
+  HistogramPerfTest(const HistogramPerfTest&) = delete;
+  HistogramPerfTest& operator=(const HistogramPerfTest&) = delete;
+
+ protected:
+  void RunTest(const std::string& story_prefix,
+               HistogramBase* histogram,
+               int num_threads) {
+    WaitableEvent start;
+    std::vector<std::unique_ptr<AddThread>> threads;
+    for (int i = 0; i < num_threads; ++i) {
+      threads.push_back(std::make_unique<AddThread>(histogram, &start));
+      threads.back()->Start();
+    }
+
+    const TimeTicks start_time = TimeTicks::Now();
+    start.Signal();
+    for (auto& thread : threads)
+      thread->Join();
+    const TimeDelta elapsed = TimeTicks::Now() - start_time;
+
+    EXPECT_EQ(num_threads * kNumAddsPerThread,
+              histogram->SnapshotDelta()->TotalCount());
+    auto reporter =
+        SetUpReporter(story_prefix + "_" + NumberToString(num_threads));
+    reporter.AddResult(kMetricAddThroughput, num_threads * kNumAddsPerThread /
+                                                 elapsed.InMillisecondsF());
+  }
+
+  void RunTests(const std::string& story_prefix, HistogramBase* histogram) {
+    for (int num_threads : {1, 2, 4, 8})
+      RunTest(story_prefix, histogram, num_threads);
+  }
+
+ private:
+  std::unique_ptr<StatisticsRecorder> statistics_recorder_;
+};
+
+TEST_F(HistogramPerfTest, Add) {
+  RunTests("histogram",
+           Histogram::FactoryGet("Histogram", 1, 100, 16,
+                                 HistogramBase::kNoFlags));
+}
+
+TEST_F(HistogramPerfTest, AddSharded) {
+  RunTests("histogram_sharded",
+           Histogram::FactoryGet("ShardedHistogram", 1, 100, 16,
+                                 HistogramBase::kShardedRecordingFlag));
+}
+
+// Measures the throughput of StatisticsRecorder::FindHistogram() on 1 to 8
+// threads looking up registered histograms, which doesn't take the
+// StatisticsRecorder lock.
+TEST_F(HistogramPerfTest, FindHistogram) {
+  std::vector<std::string> names;
+  for (int i = 0; i < kNumFoundHistograms; ++i) {
+    names.push_back("FoundHistogram" + NumberToString(i));
+    Histogram::FactoryGet(names.back(), 1, 100, 16, HistogramBase::kNoFlags);
+  }
+
+  for (int num_threads : {1, 2, 4, 8}) {
+    WaitableEvent start;
+    std::vector<std::unique_ptr<FindThread>> threads;
+    for (int i = 0; i < num_threads; ++i) {
+      threads.push_back(std::make_unique<FindThread>(&names, &start));
+      threads.back()->Start();
+    }
+
+    const TimeTicks start_time = TimeTicks::Now();
+    start.Signal();
+    for (auto& thread : threads)
+      thread->Join();
+    const TimeDelta elapsed = TimeTicks::Now() - start_time;
+
+    auto reporter = SetUpReporter("find_" + NumberToString(num_threads));
+    reporter.AddResult(kMetricFindThroughput, num_threads * kNumFindsPerThread /
+                                                  elapsed.InMillisecondsF());
+  }
+}
+
+TEST_F(HistogramPerfTest, AddSparse) {
+  RunTests("sparse", SparseHistogram::FactoryGet("SparseHistogram",
+                                                 HistogramBase::kNoFlags));
+}
+
+TEST_F(HistogramPerfTest, AddSparseSharded) {
+  RunTests("sparse_sharded",
+           SparseHistogram::FactoryGet("ShardedSparseHistogram",
+                                       HistogramBase::kShardedRecordingFlag));
+}
+
+}  // namespace base
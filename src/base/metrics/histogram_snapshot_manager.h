@@ -51,7 +51,9 @@ class BASE_EXPORT HistogramSnapshotManager final {
   // iterator, the steps can be performed separately. Call PerpareDelta()
   // as many times as necessary. PrepareFinalDelta() works like PrepareDelta()
   // except that it does not update the previous logged values and can thus
-  // be used with read-only files.
+  // be used with read-only files. Samples which histograms with
+  // kShardedRecordingFlag hold in per-thread shards are merged by the
+  // snapshots these take.
   void PrepareDelta(HistogramBase* histogram);
   void PrepareFinalDelta(const HistogramBase* histogram);
 
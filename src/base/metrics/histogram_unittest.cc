@@ -8,11 +8,13 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <atomic>
 #include <climits>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include "base/bind.h"
 #include "base/lazy_instance.h"
 #include "base/logging.h"
 #include "base/memory/raw_ptr.h"
@@ -28,6 +30,7 @@
 #include "base/pickle.h"
 #include "base/strings/stringprintf.h"
 #include "base/test/gtest_util.h"
+#include "base/threading/thread.h"
 #include "base/time/time.h"
 #include "base/values.h"
 #include "testing/gmock/include/gmock/gmock.h"
@@ -204,6 +207,89 @@ TEST_P(HistogramTest, DeltaTest) {
   EXPECT_EQ(0, samples->TotalCount());
 }
 
+// Check that samples recorded into shards, from several threads, are merged
+// by snapshots.
+TEST_P(HistogramTest, ShardedRecordingTest) {
+  HistogramBase* histogram =
+      Histogram::FactoryGet("ShardedHistogram", 1, 64, 8,
+                            HistogramBase::kShardedRecordingFlag);
+  histogram->Add(1);
+  histogram->AddCount(10, 3);
+
+  std::unique_ptr<HistogramSamples> samples = histogram->SnapshotSamples();
+  EXPECT_EQ(4, samples->TotalCount());
+  EXPECT_EQ(1, samples->GetCount(1));
+  EXPECT_EQ(3, samples->GetCount(10));
+  EXPECT_EQ(31, samples->sum());
+
+  constexpr int kNumThreads = 4;
+  constexpr int kNumSamplesPerThread = 1000;
+  std::vector<std::unique_ptr<Thread>> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.push_back(std::make_unique<Thread>("ShardedRecording"));
+    threads.back()->Start();
+    threads.back()->task_runner()->PostTask(
+        FROM_HERE, BindOnce(
+                       [](HistogramBase* histogram) {
+                         for (int i = 0; i < kNumSamplesPerThread; ++i)
+                           histogram->Add(50);
+                       },
+                       Unretained(histogram)));
+  }
+  for (auto& thread : threads)
+    thread->Stop();
+
+  samples = histogram->SnapshotDelta();
+  EXPECT_EQ(4 + kNumThreads * kNumSamplesPerThread, samples->TotalCount());
+  EXPECT_EQ(kNumThreads * kNumSamplesPerThread, samples->GetCount(50));
+  EXPECT_EQ(samples->TotalCount(), samples->redundant_count());
+  EXPECT_EQ(31 + 50 * kNumThreads * kNumSamplesPerThread, samples->sum());
+
+  samples = histogram->SnapshotDelta();
+  EXPECT_EQ(0, samples->TotalCount());
+  histogram->Add(2);
+  samples = histogram->SnapshotFinalDelta();
+  EXPECT_EQ(1, samples->TotalCount());
+  EXPECT_EQ(1, samples->GetCount(2));
+}
+
+// Check that snapshots taken on two threads at once, which both merge the
+// shards, don't move the same samples twice: every delta holds exactly the
+// samples recorded since the previous one.
+TEST_P(HistogramTest, ShardedConcurrentSnapshotsTest) {
+  HistogramBase* histogram =
+      Histogram::FactoryGet("ShardedSnapshotsHistogram", 1, 64, 8,
+                            HistogramBase::kShardedRecordingFlag);
+
+  std::atomic<bool> stop{false};
+  Thread thread("ShardedSnapshots");
+  thread.Start();
+  thread.task_runner()->PostTask(
+      FROM_HERE, BindOnce(
+                     [](HistogramBase* histogram, std::atomic<bool>* stop) {
+                       while (!stop->load(std::memory_order_relaxed))
+                         histogram->SnapshotSamples();
+                     },
+                     Unretained(histogram), Unretained(&stop)));
+
+  constexpr int kNumRounds = 1000;
+  constexpr int kNumSamplesPerRound = 10;
+  int total_count = 0;
+  for (int i = 0; i < kNumRounds; ++i) {
+    histogram->AddCount(50, kNumSamplesPerRound);
+    std::unique_ptr<HistogramSamples> samples = histogram->SnapshotDelta();
+    ASSERT_EQ(kNumSamplesPerRound, samples->GetCount(50)) << i;
+    total_count += samples->TotalCount();
+  }
+  stop.store(true, std::memory_order_relaxed);
+  thread.Stop();
+
+  EXPECT_EQ(kNumRounds * kNumSamplesPerRound, total_count);
+  std::unique_ptr<HistogramSamples> samples = histogram->SnapshotSamples();
+  EXPECT_EQ(kNumRounds * kNumSamplesPerRound, samples->TotalCount());
+  EXPECT_EQ(samples->TotalCount(), samples->redundant_count());
+}
+
 // Check that final-delta calculations work correctly.
 TEST_P(HistogramTest, FinalDeltaTest) {
   HistogramBase* histogram = Histogram::FactoryGet("FinalDeltaHistogram", 1, 64,
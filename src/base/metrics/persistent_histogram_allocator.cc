@@ -8,6 +8,7 @@
 #include <limits>
 #include <utility>
 
+#include "base/files/file.h"
 #include "base/files/file_path.h"
 #include "base/files/file_util.h"
 #include "base/files/important_file_writer.h"
@@ -21,6 +22,7 @@
 #include "base/metrics/histogram_base.h"
 #include "base/metrics/histogram_samples.h"
 #include "base/metrics/metrics_hashes.h"
+#include "base/metrics/persistent_histogram_snapshot.h"
 #include "base/metrics/persistent_sample_map.h"
 #include "base/metrics/sparse_histogram.h"
 #include "base/metrics/statistics_recorder.h"
@@ -947,6 +949,42 @@ bool GlobalHistogramAllocator::WriteToPersistentLocation() {
 #endif
 }
 
+bool GlobalHistogramAllocator::AppendSnapshotToFile(const FilePath& path) {
+#if BUILDFLAG(IS_NACL)
+  // NACL doesn't support file operations.
+  NOTREACHED();
+  return false;
+#else
+  if (!snapshot_writer_) {
+    snapshot_writer_ =
+        std::make_unique<PersistentHistogramSnapshotWriter>(this);
+  }
+
+  std::string snapshot;
+  if (!snapshot_writer_->PrepareSnapshot(&snapshot)) {
+    snapshot_writer_->CommitSnapshot();
+    return true;
+  }
+
+  // The samples of the snapshot are only committed once it is appended, so
+  // that they are written by the next call otherwise. A partially appended
+  // snapshot is removed, since it would make the whole file unreadable.
+  File file(path, File::FLAG_OPEN_ALWAYS | File::FLAG_APPEND);
+  const int64_t length = file.IsValid() ? file.GetLength() : -1;
+  const int size = checked_cast<int>(snapshot.size());
+  if (length < 0 || file.WriteAtCurrentPos(snapshot.data(), size) != size) {
+    LOG(ERROR) << "Could not append \"" << Name() << "\" histogram snapshot"
+               << " to file: " << path.value();
+    if (length >= 0)
+      file.SetLength(length);
+    return false;
+  }
+
+  snapshot_writer_->CommitSnapshot();
+  return true;
+#endif
+}
+
 void GlobalHistogramAllocator::DeletePersistentLocation() {
   memory_allocator()->SetMemoryState(PersistentMemoryAllocator::MEMORY_DELETED);
 
@@ -26,6 +26,7 @@ namespace base {
 
 class BucketRanges;
 class FilePath;
+class PersistentHistogramSnapshotWriter;
 class PersistentSampleMapRecords;
 class PersistentSparseHistogramDataManager;
 class WritableSharedMemoryRegion;
@@ -478,6 +479,15 @@ class BASE_EXPORT GlobalHistogramAllocator
   // indicates success.
   bool WriteToPersistentLocation();
 
+  // Appends to the file at |path| a compact snapshot of the samples recorded
+  // since the previous call, which can be merged back with
+  // MergePersistentHistogramSnapshots(). Unlike WriteToPersistentLocation(),
+  // this writes only the buckets which changed, so it's much cheaper to call
+  // repeatedly. Must always be called on the same thread. The return value
+  // indicates success. On failure, the file is left as it was and the samples
+  // are appended by the next call instead.
+  bool AppendSnapshotToFile(const FilePath& path);
+
   // If there is a global metrics file being updated on disk, mark it to be
   // deleted when the process exits.
   void DeletePersistentLocation();
@@ -506,6 +516,9 @@ class BASE_EXPORT GlobalHistogramAllocator
 
   // The location to which the data should be persisted.
   FilePath persistent_location_;
+
+  // Writes the snapshots of AppendSnapshotToFile(), created on first use.
+  std::unique_ptr<PersistentHistogramSnapshotWriter> snapshot_writer_;
 };
 
 }  // namespace base
@@ -0,0 +1,288 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/metrics/persistent_histogram_snapshot.h"
+
+#include <stdint.h>
+
+#include <utility>
+
+#include "base/check.h"
+#include "base/metrics/histogram_base.h"
+#include "base/metrics/histogram_samples.h"
+#include "base/metrics/statistics_recorder.h"
+#include "base/numerics/safe_conversions.h"
+#include "base/pickle.h"
+
+namespace base {
+
+namespace {
+
+// "HSNP", followed by a version number.
+constexpr uint32_t kSnapshotMagic = 0x504E5348;
+constexpr uint8_t kSnapshotVersion = 1;
+
+void WriteVarint(uint64_t value, std::string* output) {
+  while (value >= 0x80) {
+    output->push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  output->push_back(static_cast<char>(value));
+}
+
+void WriteSignedVarint(int64_t value, std::string* output) {
+  // Zigzag encoding keeps small negative values small.
+  WriteVarint((static_cast<uint64_t>(value) << 1) ^
+                  static_cast<uint64_t>(value >> 63),
+              output);
+}
+
+// Reads the fields of a snapshot, failing on the first read past its end.
+class SnapshotReader {
+ public:
+  explicit SnapshotReader(StringPiece data) : data_(data) {}
+
+  bool done() const { return data_.empty(); }
+
+  bool ReadVarint(uint64_t* value) {
+    *value = 0;
+    for (int shift = 0; shift < 64 && !data_.empty(); shift += 7) {
+      const uint8_t byte = static_cast<uint8_t>(data_[0]);
+      data_.remove_prefix(1);
+      *value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+      if (!(byte & 0x80))
+        return true;
+    }
+    return false;
+  }
+
+  bool ReadSignedVarint(int64_t* value) {
+    uint64_t encoded;
+    if (!ReadVarint(&encoded))
+      return false;
+    *value = static_cast<int64_t>(encoded >> 1) ^
+             -static_cast<int64_t>(encoded & 1);
+    return true;
+  }
+
+  bool ReadBytes(size_t size, StringPiece* bytes) {
+    if (size > data_.size())
+      return false;
+    *bytes = data_.substr(0, size);
+    data_.remove_prefix(size);
+    return true;
+  }
+
+ private:
+  StringPiece data_;
+};
+
+// Returns whether |samples| holds any sample.
+bool HasSamples(const HistogramSamples& samples) {
+  return samples.redundant_count() != 0 || samples.sum() != 0 ||
+         !samples.Iterator()->Done();
+}
+
+void WriteRecord(const HistogramBase& histogram,
+                 const HistogramSamples& samples,
+                 std::string* output) {
+  Pickle info;
+  histogram.SerializeInfo(&info);
+  WriteVarint(info.size(), output);
+  output->append(static_cast<const char*>(info.data()), info.size());
+
+  WriteSignedVarint(samples.sum(), output);
+  WriteSignedVarint(samples.redundant_count(), output);
+
+  std::string buckets;
+  size_t num_buckets = 0;
+  int64_t previous_min = 0;
+  HistogramBase::Sample min;
+  int64_t max;
+  HistogramBase::Count count;
+  for (std::unique_ptr<SampleCountIterator> it = samples.Iterator();
+       !it->Done(); it->Next()) {
+    it->Get(&min, &max, &count);
+    WriteSignedVarint(min - previous_min, &buckets);
+    WriteVarint(static_cast<uint64_t>(max - min), &buckets);
+    WriteSignedVarint(count, &buckets);
+    previous_min = min;
+    ++num_buckets;
+  }
+  WriteVarint(num_buckets, output);
+  output->append(buckets);
+}
+
+// Merges the next record of |reader| into the StatisticsRecorder. Returns
+// false if the record is malformed.
+bool MergeRecord(SnapshotReader* reader) {
+  uint64_t info_size;
+  StringPiece info;
+  if (!reader->ReadVarint(&info_size) || !reader->ReadBytes(info_size, &info))
+    return false;
+  const Pickle info_pickle(info.data(), info.size());
+  PickleIterator info_iter(info_pickle);
+  HistogramBase* const histogram = DeserializeHistogramInfo(&info_iter);
+  if (!histogram)
+    return false;
+
+  // The samples are converted to the format of HistogramSamples::Serialize(),
+  // which histograms know how to validate and add.
+  int64_t sum;
+  int64_t redundant_count;
+  uint64_t num_buckets;
+  if (!reader->ReadSignedVarint(&sum) ||
+      !reader->ReadSignedVarint(&redundant_count) ||
+      !IsValueInRangeForNumericType<HistogramBase::Count>(redundant_count) ||
+      !reader->ReadVarint(&num_buckets)) {
+    return false;
+  }
+  Pickle samples_pickle;
+  samples_pickle.WriteInt64(sum);
+  samples_pickle.WriteInt(static_cast<HistogramBase::Count>(redundant_count));
+  int64_t min = 0;
+  for (uint64_t i = 0; i < num_buckets; ++i) {
+    int64_t min_delta;
+    uint64_t width;
+    int64_t count;
+    if (!reader->ReadSignedVarint(&min_delta) || !reader->ReadVarint(&width) ||
+        !reader->ReadSignedVarint(&count)) {
+      return false;
+    }
+    min += min_delta;
+    if (!IsValueInRangeForNumericType<HistogramBase::Sample>(min) ||
+        !IsValueInRangeForNumericType<uint32_t>(width) ||
+        !IsValueInRangeForNumericType<HistogramBase::Count>(count)) {
+      return false;
+    }
+    samples_pickle.WriteInt(static_cast<HistogramBase::Sample>(min));
+    samples_pickle.WriteInt64(min + static_cast<int64_t>(width));
+    samples_pickle.WriteInt(static_cast<HistogramBase::Count>(count));
+  }
+  PickleIterator samples_iter(samples_pickle);
+  return histogram->AddSamplesFromPickle(&samples_iter);
+}
+
+}  // namespace
+
+struct PersistentHistogramSnapshotWriter::Entry {
+  // The histogram read from the allocator.
+  std::unique_ptr<HistogramBase> histogram;
+
+  // The histogram whose samples are snapshotted: the one registered with the
+  // StatisticsRecorder for histograms of the global allocator, so that the
+  // records of a sparse histogram are never read by two objects at once, or
+  // |histogram| otherwise.
+  raw_ptr<HistogramBase> snapshotted_histogram;
+
+  // The samples written so far.
+  std::unique_ptr<HistogramSamples> written_samples;
+
+  // The samples of the prepared snapshot, added to |written_samples| when it is
+  // committed.
+  std::unique_ptr<HistogramSamples> prepared_samples;
+};
+
+PersistentHistogramSnapshotWriter::PersistentHistogramSnapshotWriter(
+    PersistentHistogramAllocator* allocator)
+    : allocator_(allocator), iterator_(allocator) {}
+
+PersistentHistogramSnapshotWriter::~PersistentHistogramSnapshotWriter() =
+    default;
+
+size_t PersistentHistogramSnapshotWriter::WriteSnapshot(std::string* output) {
+  const size_t num_records = PrepareSnapshot(output);
+  CommitSnapshot();
+  return num_records;
+}
+
+size_t PersistentHistogramSnapshotWriter::PrepareSnapshot(
+    std::string* output) {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+
+  const bool is_global_allocator =
+      allocator_ == GlobalHistogramAllocator::Get();
+  while (std::unique_ptr<HistogramBase> histogram = iterator_.GetNext()) {
+    HistogramBase* snapshotted_histogram = histogram.get();
+    if (is_global_allocator) {
+      HistogramBase* const registered_histogram =
+          StatisticsRecorder::FindHistogram(histogram->histogram_name());
+      if (registered_histogram &&
+          (registered_histogram->flags() & HistogramBase::kIsPersistent)) {
+        snapshotted_histogram = registered_histogram;
+      }
+    }
+    entries_.push_back(
+        {std::move(histogram), snapshotted_histogram, nullptr, nullptr});
+  }
+
+  std::string records;
+  size_t num_records = 0;
+  for (Entry& entry : entries_) {
+    std::unique_ptr<HistogramSamples> samples =
+        entry.snapshotted_histogram->SnapshotSamples();
+    if (entry.written_samples)
+      samples->Subtract(*entry.written_samples);
+    if (HasSamples(*samples)) {
+      WriteRecord(*entry.histogram, *samples, &records);
+      ++num_records;
+    }
+    entry.prepared_samples = std::move(samples);
+  }
+  has_prepared_snapshot_ = true;
+  if (!num_records)
+    return 0;
+
+  for (size_t i = 0; i < sizeof(kSnapshotMagic); ++i)
+    output->push_back(static_cast<char>(kSnapshotMagic >> (8 * i)));
+  output->push_back(static_cast<char>(kSnapshotVersion));
+  WriteVarint(num_records, output);
+  output->append(records);
+  return num_records;
+}
+
+void PersistentHistogramSnapshotWriter::CommitSnapshot() {
+  DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+  DCHECK(has_prepared_snapshot_);
+  has_prepared_snapshot_ = false;
+
+  for (Entry& entry : entries_) {
+    if (!entry.prepared_samples)
+      continue;
+    if (entry.written_samples)
+      entry.written_samples->Add(*entry.prepared_samples);
+    else
+      entry.written_samples = std::move(entry.prepared_samples);
+    entry.prepared_samples.reset();
+  }
+}
+
+bool MergePersistentHistogramSnapshots(StringPiece snapshots) {
+  SnapshotReader reader(snapshots);
+  while (!reader.done()) {
+    StringPiece header;
+    if (!reader.ReadBytes(sizeof(kSnapshotMagic) + 1, &header))
+      return false;
+    uint32_t magic = 0;
+    for (size_t i = 0; i < sizeof(kSnapshotMagic); ++i) {
+      magic |= static_cast<uint32_t>(static_cast<uint8_t>(header[i]))
+               << (8 * i);
+    }
+    if (magic != kSnapshotMagic ||
+        static_cast<uint8_t>(header[sizeof(kSnapshotMagic)]) !=
+            kSnapshotVersion) {
+      return false;
+    }
+    uint64_t num_records;
+    if (!reader.ReadVarint(&num_records))
+      return false;
+    for (uint64_t i = 0; i < num_records; ++i) {
+      if (!MergeRecord(&reader))
+        return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace base
@@ -0,0 +1,94 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Persisting histograms by writing their whole PersistentMemoryAllocator
+// segment to disk writes every bucket of every histogram, most of which are
+// zero, on every flush. A PersistentHistogramSnapshotWriter instead writes
+// compact snapshots holding only the samples recorded since the previous
+// snapshot, and only for the histograms which recorded any. Snapshots can be
+// appended to the same file, and merged back into the StatisticsRecorder with
+// MergePersistentHistogramSnapshots().
+//
+// A snapshot is made of a header and of one record per histogram. Integers
+// are encoded as LEB128 varints, signed ones being zigzag-encoded first:
+//
+//   snapshot := magic:uint32 (little endian), version:uint8,
+//               num_records:varint, record*
+//   record   := info_size:varint, info:byte[info_size] (see SerializeInfo()),
+//               sum:signed, redundant_count:signed, num_buckets:varint,
+//               bucket*
+//   bucket   := min:signed (delta from the previous bucket's min),
+//               width:varint (max - min), count:signed
+
+#ifndef BASE_METRICS_PERSISTENT_HISTOGRAM_SNAPSHOT_H_
+#define BASE_METRICS_PERSISTENT_HISTOGRAM_SNAPSHOT_H_
+
+#include <stddef.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/memory/raw_ptr.h"
+#include "base/metrics/persistent_histogram_allocator.h"
+#include "base/strings/string_piece.h"
+#include "base/threading/thread_checker.h"
+
+namespace base {
+
+class HistogramBase;
+class HistogramSamples;
+
+class BASE_EXPORT PersistentHistogramSnapshotWriter {
+ public:
+  // The |allocator| must outlive this object.
+  explicit PersistentHistogramSnapshotWriter(
+      PersistentHistogramAllocator* allocator);
+
+  PersistentHistogramSnapshotWriter(const PersistentHistogramSnapshotWriter&) =
+      delete;
+  PersistentHistogramSnapshotWriter& operator=(
+      const PersistentHistogramSnapshotWriter&) = delete;
+
+  ~PersistentHistogramSnapshotWriter();
+
+  // Appends to |output| a snapshot of the samples recorded in the histograms
+  // of the allocator since the previous snapshot, or since they were created
+  // for the first one. Nothing is appended if no samples were recorded. Returns
+  // the number of histograms in the snapshot.
+  size_t WriteSnapshot(std::string* output);
+
+  // Same as WriteSnapshot(), but the samples of the snapshot are only
+  // considered written once CommitSnapshot() is called, e.g. after |output|
+  // was successfully stored. Until then, the next snapshot includes them again.
+  size_t PrepareSnapshot(std::string* output);
+  void CommitSnapshot();
+
+ private:
+  struct Entry;
+
+  const raw_ptr<PersistentHistogramAllocator> allocator_;
+
+  // Finds the histograms created in the allocator since the previous call to
+  // WriteSnapshot().
+  PersistentHistogramAllocator::Iterator iterator_;
+
+  std::vector<Entry> entries_;
+
+  // Whether the samples of the last prepared snapshot can be committed.
+  bool has_prepared_snapshot_ = false;
+
+  THREAD_CHECKER(thread_checker_);
+};
+
+// Merges the snapshots written by PersistentHistogramSnapshotWriter and
+// concatenated in |snapshots| into the histograms of the StatisticsRecorder,
+// creating them if needed. Returns false if |snapshots| is malformed, in which
+// case the records preceding the malformed one are still merged.
+BASE_EXPORT bool MergePersistentHistogramSnapshots(StringPiece snapshots);
+
+}  // namespace base
+
+#endif  // BASE_METRICS_PERSISTENT_HISTOGRAM_SNAPSHOT_H_
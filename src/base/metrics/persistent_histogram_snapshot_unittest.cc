@@ -0,0 +1,207 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/metrics/persistent_histogram_snapshot.h"
+
+#include <memory>
+#include <string>
+
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/memory/raw_ptr.h"
+#include "base/metrics/histogram.h"
+#include "base/metrics/histogram_samples.h"
+#include "base/metrics/persistent_histogram_allocator.h"
+#include "base/metrics/sparse_histogram.h"
+#include "base/metrics/statistics_recorder.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+class PersistentHistogramSnapshotTest : public testing::Test {
+ public:
+  PersistentHistogramSnapshotTest(const PersistentHistogramSnapshotTest&) =
+      delete;
+  PersistentHistogramSnapshotTest& operator=(
+      const PersistentHistogramSnapshotTest&) = delete;
+
+ protected:
+  const int32_t kAllocatorMemorySize = 64 << 10;  // 64 KiB
+
+  PersistentHistogramSnapshotTest()
+      : statistics_recorder_(StatisticsRecorder::CreateTemporaryForTesting()) {
+    GlobalHistogramAllocator::ReleaseForTesting();
+    GlobalHistogramAllocator::CreateWithLocalMemory(
+        kAllocatorMemorySize, 0, "PersistentHistogramSnapshotTest");
+    allocator_ = GlobalHistogramAllocator::Get();
+  }
+
+  ~PersistentHistogramSnapshotTest() override {
+    GlobalHistogramAllocator::ReleaseForTesting();
+  }
+
+  // Releases the allocator and replaces the StatisticsRecorder, so that
+  // snapshots are merged into new histograms.
+  void ResetHistograms() {
+    allocator_ = nullptr;
+    GlobalHistogramAllocator::ReleaseForTesting();
+    statistics_recorder_.reset();
+    statistics_recorder_ = StatisticsRecorder::CreateTemporaryForTesting();
+  }
+
+  std::unique_ptr<StatisticsRecorder> statistics_recorder_;
+  raw_ptr<GlobalHistogramAllocator> allocator_;
+};
+
+TEST_F(PersistentHistogramSnapshotTest, WritesChangedHistograms) {
+  HistogramBase* const histogram = Histogram::FactoryGet(
+      "TestHistogram", 1, 1000, 50, HistogramBase::kNoFlags);
+  HistogramBase* const sparse_histogram = SparseHistogram::FactoryGet(
+      "TestSparseHistogram", HistogramBase::kNoFlags);
+  Histogram::FactoryGet("UnusedHistogram", 1, 1000, 50,
+                        HistogramBase::kNoFlags);
+  PersistentHistogramSnapshotWriter writer(allocator_);
+
+  histogram->Add(5);
+  histogram->Add(500);
+  sparse_histogram->Add(-7);
+  std::string snapshot;
+  EXPECT_EQ(2u, writer.WriteSnapshot(&snapshot));
+  // Only the 3 used buckets of the histograms are written.
+  EXPECT_LT(snapshot.size(), 200u);
+
+  // Histograms without new samples are skipped.
+  std::string second_snapshot;
+  histogram->Add(5);
+  EXPECT_EQ(1u, writer.WriteSnapshot(&second_snapshot));
+  EXPECT_LT(second_snapshot.size(), snapshot.size());
+
+  std::string third_snapshot;
+  EXPECT_EQ(0u, writer.WriteSnapshot(&third_snapshot));
+  EXPECT_TRUE(third_snapshot.empty());
+
+  // Histograms created after the first snapshot are written too.
+  HistogramBase* const new_histogram = Histogram::FactoryGet(
+      "NewHistogram", 1, 1000, 50, HistogramBase::kNoFlags);
+  new_histogram->Add(1);
+  EXPECT_EQ(1u, writer.WriteSnapshot(&third_snapshot));
+}
+
+TEST_F(PersistentHistogramSnapshotTest, MergeSnapshots) {
+  HistogramBase* const histogram = Histogram::FactoryGet(
+      "TestHistogram", 1, 1000, 50, HistogramBase::kNoFlags);
+  HistogramBase* const sparse_histogram = SparseHistogram::FactoryGet(
+      "TestSparseHistogram", HistogramBase::kNoFlags);
+  std::string snapshots;
+  {
+    PersistentHistogramSnapshotWriter writer(allocator_);
+    histogram->Add(5);
+    sparse_histogram->Add(-7);
+    sparse_histogram->Add(1 << 20);
+    writer.WriteSnapshot(&snapshots);
+    histogram->Add(5);
+    histogram->Add(999);
+    sparse_histogram->Add(-7);
+    writer.WriteSnapshot(&snapshots);
+  }
+
+  ResetHistograms();
+  EXPECT_FALSE(StatisticsRecorder::FindHistogram("TestHistogram"));
+  EXPECT_TRUE(MergePersistentHistogramSnapshots(snapshots));
+
+  HistogramBase* const merged_histogram =
+      StatisticsRecorder::FindHistogram("TestHistogram");
+  ASSERT_TRUE(merged_histogram);
+  std::unique_ptr<HistogramSamples> samples =
+      merged_histogram->SnapshotSamples();
+  EXPECT_EQ(3, samples->TotalCount());
+  EXPECT_EQ(2, samples->GetCount(5));
+  EXPECT_EQ(1, samples->GetCount(999));
+  EXPECT_EQ(1009, samples->sum());
+
+  HistogramBase* const merged_sparse_histogram =
+      StatisticsRecorder::FindHistogram("TestSparseHistogram");
+  ASSERT_TRUE(merged_sparse_histogram);
+  samples = merged_sparse_histogram->SnapshotSamples();
+  EXPECT_EQ(3, samples->TotalCount());
+  EXPECT_EQ(2, samples->GetCount(-7));
+  EXPECT_EQ(1, samples->GetCount(1 << 20));
+  EXPECT_EQ((1 << 20) - 14, samples->sum());
+}
+
+TEST_F(PersistentHistogramSnapshotTest, MergeMalformedSnapshots) {
+  HistogramBase* const histogram = Histogram::FactoryGet(
+      "TestHistogram", 1, 1000, 50, HistogramBase::kNoFlags);
+  histogram->Add(5);
+  std::string snapshot;
+  PersistentHistogramSnapshotWriter(allocator_).WriteSnapshot(&snapshot);
+  ResetHistograms();
+
+  EXPECT_TRUE(MergePersistentHistogramSnapshots(""));
+  EXPECT_FALSE(MergePersistentHistogramSnapshots("garbage"));
+  EXPECT_FALSE(MergePersistentHistogramSnapshots(
+      StringPiece(snapshot).substr(0, snapshot.size() - 1)));
+  std::string bad_magic = snapshot;
+  bad_magic[0] ^= 1;
+  EXPECT_FALSE(MergePersistentHistogramSnapshots(bad_magic));
+}
+
+TEST_F(PersistentHistogramSnapshotTest, AppendSnapshotToFile) {
+  ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  const FilePath path = temp_dir.GetPath().AppendASCII("histograms.snapshot");
+
+  HistogramBase* const histogram = Histogram::FactoryGet(
+      "TestHistogram", 1, 1000, 50, HistogramBase::kNoFlags);
+  histogram->Add(5);
+  EXPECT_TRUE(allocator_->AppendSnapshotToFile(path));
+  EXPECT_TRUE(allocator_->AppendSnapshotToFile(path));
+  histogram->Add(5);
+  EXPECT_TRUE(allocator_->AppendSnapshotToFile(path));
+
+  std::string snapshots;
+  ASSERT_TRUE(ReadFileToString(path, &snapshots));
+  ResetHistograms();
+  EXPECT_TRUE(MergePersistentHistogramSnapshots(snapshots));
+  HistogramBase* const merged_histogram =
+      StatisticsRecorder::FindHistogram("TestHistogram");
+  ASSERT_TRUE(merged_histogram);
+  EXPECT_EQ(2, merged_histogram->SnapshotSamples()->GetCount(5));
+}
+
+// The samples of a snapshot which could not be appended are appended by the
+// next call.
+TEST_F(PersistentHistogramSnapshotTest, AppendSnapshotToFileFailure) {
+  ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  const FilePath path = temp_dir.GetPath().AppendASCII("histograms.snapshot");
+  const FilePath bad_path =
+      temp_dir.GetPath().AppendASCII("missing").AppendASCII("bad.snapshot");
+
+  HistogramBase* const histogram = Histogram::FactoryGet(
+      "TestHistogram", 1, 1000, 50, HistogramBase::kNoFlags);
+  histogram->Add(5);
+  EXPECT_TRUE(allocator_->AppendSnapshotToFile(path));
+  histogram->Add(5);
+  histogram->Add(7);
+  EXPECT_FALSE(allocator_->AppendSnapshotToFile(bad_path));
+  histogram->Add(7);
+  EXPECT_TRUE(allocator_->AppendSnapshotToFile(path));
+
+  std::string snapshots;
+  ASSERT_TRUE(ReadFileToString(path, &snapshots));
+  ResetHistograms();
+  EXPECT_TRUE(MergePersistentHistogramSnapshots(snapshots));
+  HistogramBase* const merged_histogram =
+      StatisticsRecorder::FindHistogram("TestHistogram");
+  ASSERT_TRUE(merged_histogram);
+  std::unique_ptr<HistogramSamples> samples =
+      merged_histogram->SnapshotSamples();
+  EXPECT_EQ(2, samples->GetCount(5));
+  EXPECT_EQ(2, samples->GetCount(7));
+  EXPECT_EQ(4, samples->TotalCount());
+}
+
+}  // namespace base
@@ -0,0 +1,119 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/metrics/sharded_samples.h"
+
+#include <memory>
+
+#include "base/compiler_specific.h"
+#include "base/metrics/histogram_samples.h"
+#include "base/metrics/sample_vector.h"
+
+namespace base {
+
+namespace internal {
+
+size_t GetSampleShardIndex() {
+  static std::atomic<size_t> next_shard_index{0};
+  thread_local const size_t shard_index =
+      next_shard_index.fetch_add(1, std::memory_order_relaxed) %
+      kNumSampleShards;
+  return shard_index;
+}
+
+}  // namespace internal
+
+ShardedSampleVector::ShardedSampleVector(uint64_t id,
+                                         const BucketRanges* bucket_ranges)
+    : id_(id), bucket_ranges_(bucket_ranges) {}
+
+ShardedSampleVector::~ShardedSampleVector() {
+  for (Shard& shard : shards_)
+    delete shard.samples.load(std::memory_order_relaxed);
+}
+
+void ShardedSampleVector::Accumulate(HistogramBase::Sample value,
+                                     HistogramBase::Count count) {
+  Shard& shard = shards_[internal::GetSampleShardIndex()];
+  SampleVector* samples = shard.samples.load(std::memory_order_acquire);
+  if (UNLIKELY(!samples)) {
+    auto new_samples = std::make_unique<SampleVector>(id_, bucket_ranges_);
+    // If another thread sharing the shard installed its SampleVector first,
+    // |samples| is updated to point to it.
+    if (shard.samples.compare_exchange_strong(samples, new_samples.get(),
+                                              std::memory_order_acq_rel,
+                                              std::memory_order_acquire)) {
+      samples = new_samples.release();
+    }
+  }
+  samples->Accumulate(value, count);
+}
+
+void ShardedSampleVector::MoveTo(HistogramSamples* samples) {
+  AutoLock auto_lock(move_lock_);
+  for (Shard& shard : shards_) {
+    SampleVector* const shard_samples =
+        shard.samples.load(std::memory_order_acquire);
+    if (!shard_samples || !shard_samples->redundant_count())
+      continue;
+    // Like Histogram::SnapshotDelta(), subtract exactly what was copied, so
+    // that samples accumulated concurrently stay in the shard.
+    SampleVector snapshot(id_, bucket_ranges_);
+    snapshot.Add(*shard_samples);
+    shard_samples->Subtract(snapshot);
+    samples->Add(snapshot);
+  }
+}
+
+ShardedSampleMap::ShardedSampleMap() = default;
+
+ShardedSampleMap::~ShardedSampleMap() = default;
+
+bool ShardedSampleMap::Accumulate(HistogramBase::Sample value,
+                                  HistogramBase::Count count) {
+  const uint32_t bits = static_cast<uint32_t>(value);
+  const uint64_t key = bits | kKeyUsedBit;
+  Shard& shard = shards_[internal::GetSampleShardIndex()];
+  // Open addressing with linear probing, starting from a multiplicative hash
+  // of the value.
+  size_t index = ((bits * 0x9E3779B9u) >> 16) % kEntriesPerShard;
+  for (size_t probe = 0; probe < kEntriesPerShard; ++probe) {
+    Entry& entry = shard.entries[index];
+    uint64_t entry_key = entry.key.load(std::memory_order_relaxed);
+    // On failure, |entry_key| is updated to the key set concurrently, which
+    // may be |key|.
+    if (!entry_key &&
+        entry.key.compare_exchange_strong(entry_key, key,
+                                          std::memory_order_relaxed)) {
+      entry_key = key;
+    }
+    if (entry_key == key) {
+      entry.count.fetch_add(count, std::memory_order_relaxed);
+      return true;
+    }
+    index = (index + 1) % kEntriesPerShard;
+  }
+  return false;
+}
+
+void ShardedSampleMap::MoveTo(HistogramSamples* samples) {
+  // An entry seen free is skipped, and a count added to it concurrently is left
+  // for the next call. Exchanging counts can't lose concurrent additions.
+  for (Shard& shard : shards_) {
+    for (Entry& entry : shard.entries) {
+      const uint64_t key = entry.key.load(std::memory_order_relaxed);
+      if (!key)
+        continue;
+      const HistogramBase::Count count =
+          entry.count.exchange(0, std::memory_order_relaxed);
+      if (count) {
+        samples->Accumulate(
+            static_cast<HistogramBase::Sample>(static_cast<uint32_t>(key)),
+            count);
+      }
+    }
+  }
+}
+
+}  // namespace base
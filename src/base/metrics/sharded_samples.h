@@ -0,0 +1,121 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// ShardedSampleVector and ShardedSampleMap buffer the samples of histograms
+// recorded with HistogramBase::kShardedRecordingFlag. Each thread records into
+// one of a fixed number of shards, so that threads recording concurrently into
+// the same histogram don't contend on the cache lines holding its counts (or,
+// for sparse histograms, on its lock). The shards are merged into the
+// histogram's samples whenever it's snapshotted, e.g. by
+// HistogramSnapshotManager.
+
+#ifndef BASE_METRICS_SHARDED_SAMPLES_H_
+#define BASE_METRICS_SHARDED_SAMPLES_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <atomic>
+
+#include "base/base_export.h"
+#include "base/memory/raw_ptr.h"
+#include "base/metrics/histogram_base.h"
+#include "base/synchronization/lock.h"
+
+namespace base {
+
+class BucketRanges;
+class HistogramSamples;
+class SampleVector;
+
+// The number of shards of a sharded histogram. Threads are spread over the
+// shards round-robin, in the order in which they first record a sharded
+// sample.
+constexpr size_t kNumSampleShards = 16;
+
+namespace internal {
+
+// Returns the index of the shard which the calling thread records into.
+BASE_EXPORT size_t GetSampleShardIndex();
+
+}  // namespace internal
+
+// Shards of the samples of a Histogram. Each shard is a SampleVector with the
+// histogram's bucket ranges, allocated the first time a thread records into it.
+class BASE_EXPORT ShardedSampleVector {
+ public:
+  ShardedSampleVector(uint64_t id, const BucketRanges* bucket_ranges);
+  ShardedSampleVector(const ShardedSampleVector&) = delete;
+  ShardedSampleVector& operator=(const ShardedSampleVector&) = delete;
+  ~ShardedSampleVector();
+
+  // Accumulates |count| samples of |value| into the calling thread's shard.
+  // Can be called from any thread.
+  void Accumulate(HistogramBase::Sample value, HistogramBase::Count count);
+
+  // Moves the samples accumulated so far to |samples|, which must have the same
+  // bucket ranges. Samples accumulated concurrently are either moved, or left
+  // for the next call. Can be called from any thread; concurrent calls are
+  // serialized.
+  void MoveTo(HistogramSamples* samples);
+
+ private:
+  struct alignas(64) Shard {
+    std::atomic<SampleVector*> samples{nullptr};
+  };
+
+  const uint64_t id_;
+  const raw_ptr<const BucketRanges> bucket_ranges_;
+  std::array<Shard, kNumSampleShards> shards_;
+
+  // Held by MoveTo(), which copies each shard then subtracts the copy from it:
+  // two concurrent calls could otherwise both move the same samples.
+  Lock move_lock_;
+};
+
+// Shards of the samples of a SparseHistogram. Each shard is a small lock-free
+// hash table of sample values and counts. Since values are never removed from a
+// shard, a shard which has no room for a new value rejects it, and the caller
+// must record it by other means.
+class BASE_EXPORT ShardedSampleMap {
+ public:
+  // The number of distinct values which a shard can hold.
+  static constexpr size_t kEntriesPerShard = 32;
+
+  ShardedSampleMap();
+  ShardedSampleMap(const ShardedSampleMap&) = delete;
+  ShardedSampleMap& operator=(const ShardedSampleMap&) = delete;
+  ~ShardedSampleMap();
+
+  // Accumulates |count| samples of |value| into the calling thread's shard.
+  // Returns false if the shard is full and doesn't hold |value|. Can be called
+  // from any thread.
+  bool Accumulate(HistogramBase::Sample value, HistogramBase::Count count);
+
+  // Moves the samples accumulated so far to |samples|. Samples accumulated
+  // concurrently are either moved, or left for the next call. Can be called
+  // from any thread, even concurrently, since each count is exchanged with 0.
+  void MoveTo(HistogramSamples* samples);
+
+ private:
+  struct Entry {
+    // The sample value with kKeyUsedBit set, or 0 if the entry is free. An
+    // entry's key never changes once set.
+    std::atomic<uint64_t> key{0};
+    std::atomic<HistogramBase::Count> count{0};
+  };
+
+  struct alignas(64) Shard {
+    std::array<Entry, kEntriesPerShard> entries;
+  };
+
+  static constexpr uint64_t kKeyUsedBit = uint64_t{1} << 32;
+
+  std::array<Shard, kNumSampleShards> shards_;
+};
+
+}  // namespace base
+
+#endif  // BASE_METRICS_SHARDED_SAMPLES_H_
@@ -0,0 +1,150 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/metrics/sharded_samples.h"
+
+#include <memory>
+#include <vector>
+
+#include "base/metrics/bucket_ranges.h"
+#include "base/metrics/histogram.h"
+#include "base/metrics/sample_map.h"
+#include "base/metrics/sample_vector.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+constexpr int kNumThreads = 8;
+constexpr int kNumSamplesPerThread = 10000;
+
+// Calls |accumulate| kNumSamplesPerThread times on each of kNumThreads
+// threads, while the main thread moves the accumulated samples to |samples|.
+template <typename Accumulate, typename Sharded>
+void AccumulateConcurrently(const Accumulate& accumulate,
+                            Sharded* sharded,
+                            HistogramSamples* samples) {
+  DelegateSimpleThreadPool pool("ShardedSamplesTest", kNumThreads);
+  pool.Start();
+  class AccumulateDelegate : public DelegateSimpleThread::Delegate {
+   public:
+    explicit AccumulateDelegate(const Accumulate& accumulate)
+        : accumulate_(accumulate) {}
+    void Run() override {
+      for (int i = 0; i < kNumSamplesPerThread; ++i)
+        accumulate_(i);
+    }
+
+   private:
+    const Accumulate& accumulate_;
+  };
+  AccumulateDelegate delegate(accumulate);
+  pool.AddWork(&delegate, kNumThreads);
+  for (int i = 0; i < 100; ++i)
+    sharded->MoveTo(samples);
+  pool.JoinAll();
+  sharded->MoveTo(samples);
+}
+
+}  // namespace
+
+TEST(ShardedSamplesTest, ShardIndexIsStablePerThread) {
+  const size_t shard_index = internal::GetSampleShardIndex();
+  EXPECT_LT(shard_index, kNumSampleShards);
+  EXPECT_EQ(shard_index, internal::GetSampleShardIndex());
+}
+
+TEST(ShardedSamplesTest, SampleVectorMoveTo) {
+  BucketRanges ranges(9);
+  Histogram::InitializeBucketRanges(1, 64, &ranges);
+  ShardedSampleVector sharded(1, &ranges);
+  SampleVector samples(1, &ranges);
+
+  sharded.MoveTo(&samples);
+  EXPECT_EQ(0, samples.TotalCount());
+
+  sharded.Accumulate(1, 2);
+  sharded.Accumulate(40, 1);
+  sharded.MoveTo(&samples);
+  EXPECT_EQ(3, samples.TotalCount());
+  EXPECT_EQ(2, samples.GetCount(1));
+  EXPECT_EQ(1, samples.GetCount(40));
+  EXPECT_EQ(42, samples.sum());
+
+  // Samples are moved only once.
+  sharded.MoveTo(&samples);
+  EXPECT_EQ(3, samples.TotalCount());
+  EXPECT_EQ(samples.TotalCount(), samples.redundant_count());
+}
+
+TEST(ShardedSamplesTest, SampleVectorConcurrentAccumulate) {
+  BucketRanges ranges(9);
+  Histogram::InitializeBucketRanges(1, 64, &ranges);
+  ShardedSampleVector sharded(1, &ranges);
+  SampleVector samples(1, &ranges);
+
+  AccumulateConcurrently(
+      [&sharded](int i) { sharded.Accumulate(i % 64, 1); }, &sharded,
+      &samples);
+
+  EXPECT_EQ(kNumThreads * kNumSamplesPerThread, samples.TotalCount());
+  EXPECT_EQ(samples.TotalCount(), samples.redundant_count());
+  int64_t expected_sum = 0;
+  for (int i = 0; i < kNumSamplesPerThread; ++i)
+    expected_sum += i % 64;
+  EXPECT_EQ(kNumThreads * expected_sum, samples.sum());
+}
+
+TEST(ShardedSamplesTest, SampleMapMoveTo) {
+  ShardedSampleMap sharded;
+  SampleMap samples(1);
+
+  sharded.MoveTo(&samples);
+  EXPECT_EQ(0, samples.TotalCount());
+
+  EXPECT_TRUE(sharded.Accumulate(-5, 2));
+  EXPECT_TRUE(sharded.Accumulate(1 << 30, 1));
+  EXPECT_TRUE(sharded.Accumulate(-5, 1));
+  sharded.MoveTo(&samples);
+  EXPECT_EQ(4, samples.TotalCount());
+  EXPECT_EQ(3, samples.GetCount(-5));
+  EXPECT_EQ(1, samples.GetCount(1 << 30));
+  EXPECT_EQ((1 << 30) - 15, samples.sum());
+
+  sharded.MoveTo(&samples);
+  EXPECT_EQ(4, samples.TotalCount());
+}
+
+TEST(ShardedSamplesTest, SampleMapFullShard) {
+  ShardedSampleMap sharded;
+  for (size_t i = 0; i < ShardedSampleMap::kEntriesPerShard; ++i)
+    EXPECT_TRUE(sharded.Accumulate(static_cast<HistogramBase::Sample>(i), 1));
+  // The shard is full: only the values it holds can still be accumulated,
+  // even after they were moved.
+  EXPECT_FALSE(sharded.Accumulate(-1, 1));
+  SampleMap samples(1);
+  sharded.MoveTo(&samples);
+  EXPECT_FALSE(sharded.Accumulate(-1, 1));
+  EXPECT_TRUE(sharded.Accumulate(3, 1));
+  sharded.MoveTo(&samples);
+  EXPECT_EQ(2, samples.GetCount(3));
+  EXPECT_EQ(0, samples.GetCount(-1));
+}
+
+TEST(ShardedSamplesTest, SampleMapConcurrentAccumulate) {
+  ShardedSampleMap sharded;
+  SampleMap samples(1);
+
+  AccumulateConcurrently(
+      [&sharded](int i) { EXPECT_TRUE(sharded.Accumulate(i % 16, 1)); },
+      &sharded, &samples);
+
+  EXPECT_EQ(kNumThreads * kNumSamplesPerThread, samples.TotalCount());
+  for (int value = 0; value < 16; ++value)
+    EXPECT_EQ(kNumThreads * kNumSamplesPerThread / 16, samples.GetCount(value));
+}
+
+}  // namespace base
@@ -4,8 +4,10 @@
 
 #include "base/metrics/sparse_histogram.h"
 
+#include <memory>
 #include <utility>
 
+#include "base/compiler_specific.h"
 #include "base/logging.h"
 #include "base/memory/ptr_util.h"
 #include "base/metrics/dummy_histogram.h"
@@ -13,6 +15,7 @@
 #include "base/metrics/persistent_histogram_allocator.h"
 #include "base/metrics/persistent_sample_map.h"
 #include "base/metrics/sample_map.h"
+#include "base/metrics/sharded_samples.h"
 #include "base/metrics/statistics_recorder.h"
 #include "base/notreached.h"
 #include "base/pickle.h"
@@ -87,7 +90,9 @@ std::unique_ptr<HistogramBase> SparseHistogram::PersistentCreate(
   return WrapUnique(new SparseHistogram(allocator, name, meta, logged_meta));
 }
 
-SparseHistogram::~SparseHistogram() = default;
+SparseHistogram::~SparseHistogram() {
+  delete sharded_samples_.load(std::memory_order_relaxed);
+}
 
 uint64_t SparseHistogram::name_hash() const {
   return unlogged_samples_->id();
@@ -114,7 +119,8 @@ void SparseHistogram::AddCount(Sample value, int count) {
     NOTREACHED();
     return;
   }
-  {
+  if (!(flags() & kShardedRecordingFlag) ||
+      !GetOrCreateShardedSamples()->Accumulate(value, count)) {
     base::AutoLock auto_lock(lock_);
     unlogged_samples_->Accumulate(value, count);
   }
@@ -127,6 +133,7 @@ std::unique_ptr<HistogramSamples> SparseHistogram::SnapshotSamples() const {
   std::unique_ptr<SampleMap> snapshot(new SampleMap(name_hash()));
 
   base::AutoLock auto_lock(lock_);
+  MergeShardedSamples();
   snapshot->Add(*unlogged_samples_);
   snapshot->Add(*logged_samples_);
   return std::move(snapshot);
@@ -137,6 +144,7 @@ std::unique_ptr<HistogramSamples> SparseHistogram::SnapshotDelta() {
 
   std::unique_ptr<SampleMap> snapshot(new SampleMap(name_hash()));
   base::AutoLock auto_lock(lock_);
+  MergeShardedSamples();
   snapshot->Add(*unlogged_samples_);
 
   unlogged_samples_->Subtract(*snapshot);
@@ -150,6 +158,7 @@ std::unique_ptr<HistogramSamples> SparseHistogram::SnapshotFinalDelta() const {
 
   std::unique_ptr<SampleMap> snapshot(new SampleMap(name_hash()));
   base::AutoLock auto_lock(lock_);
+  MergeShardedSamples();
   snapshot->Add(*unlogged_samples_);
 
   return std::move(snapshot);
@@ -222,4 +231,28 @@ Value::Dict SparseHistogram::GetParameters() const {
   return params;
 }
 
+ShardedSampleMap* SparseHistogram::GetOrCreateShardedSamples() {
+  ShardedSampleMap* sharded_samples =
+      sharded_samples_.load(std::memory_order_acquire);
+  if (LIKELY(sharded_samples))
+    return sharded_samples;
+  auto new_sharded_samples = std::make_unique<ShardedSampleMap>();
+  // If another thread created the shards first, |sharded_samples| is updated
+  // to point to them.
+  if (sharded_samples_.compare_exchange_strong(
+          sharded_samples, new_sharded_samples.get(), std::memory_order_acq_rel,
+          std::memory_order_acquire)) {
+    sharded_samples = new_sharded_samples.release();
+  }
+  return sharded_samples;
+}
+
+void SparseHistogram::MergeShardedSamples() const {
+  lock_.AssertAcquired();
+  ShardedSampleMap* sharded_samples =
+      sharded_samples_.load(std::memory_order_acquire);
+  if (sharded_samples)
+    sharded_samples->MoveTo(unlogged_samples_.get());
+}
+
 }  // namespace base
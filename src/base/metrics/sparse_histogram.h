@@ -8,6 +8,7 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <atomic>
 #include <map>
 #include <memory>
 #include <string>
@@ -24,6 +25,7 @@ class HistogramSamples;
 class PersistentHistogramAllocator;
 class Pickle;
 class PickleIterator;
+class ShardedSampleMap;
 
 class BASE_EXPORT SparseHistogram : public HistogramBase {
  public:
@@ -79,6 +81,14 @@ class BASE_EXPORT SparseHistogram : public HistogramBase {
   // Writes the type of the sparse histogram in the |params|.
   Value::Dict GetParameters() const override;
 
+  // Returns the shards which samples are recorded into when the histogram has
+  // kShardedRecordingFlag, creating them on first use.
+  ShardedSampleMap* GetOrCreateShardedSamples();
+
+  // Moves the samples recorded into shards, if any, to |unlogged_samples_|.
+  // |lock_| must be held.
+  void MergeShardedSamples() const;
+
   // For constructor calling.
   friend class SparseHistogramTest;
 
@@ -90,6 +100,12 @@ class BASE_EXPORT SparseHistogram : public HistogramBase {
 
   std::unique_ptr<HistogramSamples> unlogged_samples_;
   std::unique_ptr<HistogramSamples> logged_samples_;
+
+  // Samples recorded with kShardedRecordingFlag which haven't been merged into
+  // |unlogged_samples_| yet. Created on first use, and owned by this object.
+  // Samples for which the calling thread's shard has no room are recorded
+  // into |unlogged_samples_| directly.
+  std::atomic<ShardedSampleMap*> sharded_samples_{nullptr};
 };
 
 }  // namespace base
@@ -17,6 +17,7 @@
 #include "base/metrics/persistent_histogram_allocator.h"
 #include "base/metrics/persistent_memory_allocator.h"
 #include "base/metrics/sample_map.h"
+#include "base/metrics/sharded_samples.h"
 #include "base/metrics/statistics_recorder.h"
 #include "base/pickle.h"
 #include "base/strings/stringprintf.h"
@@ -137,6 +138,35 @@ TEST_P(SparseHistogramTest, BasicTestAddCount) {
   EXPECT_EQ(25, snapshot2->GetCount(101));
 }
 
+// Values which don't fit in the calling thread's shard are recorded directly,
+// and snapshots merge both.
+TEST_P(SparseHistogramTest, ShardedRecordingTest) {
+  std::unique_ptr<SparseHistogram> histogram(NewSparseHistogram("Sparse"));
+  histogram->SetFlags(HistogramBase::kShardedRecordingFlag);
+
+  const int kNumValues = 3 * ShardedSampleMap::kEntriesPerShard;
+  for (int value = 0; value < kNumValues; ++value)
+    histogram->AddCount(value - 10, value + 1);
+  histogram->Add(-10);
+
+  std::unique_ptr<HistogramSamples> snapshot = histogram->SnapshotDelta();
+  int64_t expected_sum = -10;
+  for (int value = 0; value < kNumValues; ++value) {
+    EXPECT_EQ(value + 1 + (value == 0 ? 1 : 0),
+              snapshot->GetCount(value - 10));
+    expected_sum += static_cast<int64_t>(value - 10) * (value + 1);
+  }
+  EXPECT_EQ(kNumValues * (kNumValues + 1) / 2 + 1, snapshot->TotalCount());
+  EXPECT_EQ(expected_sum, snapshot->sum());
+
+  EXPECT_EQ(0, histogram->SnapshotDelta()->TotalCount());
+  histogram->Add(7);
+  snapshot = histogram->SnapshotSamples();
+  EXPECT_EQ(1 + kNumValues * (kNumValues + 1) / 2 + 1,
+            snapshot->TotalCount());
+  EXPECT_EQ(1, histogram->SnapshotFinalDelta()->GetCount(7));
+}
+
 TEST_P(SparseHistogramTest, AddCount_LargeValuesDontOverflow) {
   std::unique_ptr<SparseHistogram> histogram(NewSparseHistogram("Sparse"));
   std::unique_ptr<HistogramSamples> snapshot(histogram->SnapshotSamples());
@@ -5,10 +5,13 @@
 #include "base/metrics/statistics_recorder.h"
 
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include "base/at_exit.h"
 #include "base/containers/contains.h"
 #include "base/debug/leak_annotations.h"
+#include "base/hash/hash.h"
 #include "base/json/string_escape.h"
 #include "base/logging.h"
 #include "base/memory/ptr_util.h"
@@ -31,12 +34,162 @@ bool HistogramNameLesser(const base::HistogramBase* a,
 
 }  // namespace
 
+// An open-addressing hash table of the registered histograms, keyed by a hash
+// of their name. It's modified while the global lock is held, and searched
+// without it: a slot's histogram is published before its key, with release
+// semantics, and keys never change once set. When the table grows, the new
+// table is published atomically, and the old ones are kept until the index is
+// deleted, since readers may still be searching them. Since the capacity
+// doubles, this at most doubles the memory used. Names are compared on
+// lookup, so hash collisions only cost additional probes.
+class StatisticsRecorder::HistogramIndex {
+ public:
+  HistogramIndex() { Grow(kInitialCapacity); }
+  HistogramIndex(const HistogramIndex&) = delete;
+  HistogramIndex& operator=(const HistogramIndex&) = delete;
+  ~HistogramIndex() = default;
+
+  // Returns the indexed histogram named |name|, or null if there's none. Can
+  // be called on any thread without holding the global lock.
+  HistogramBase* Find(StringPiece name) const {
+    const Table* const table = table_.load(std::memory_order_acquire);
+    const size_t key = GetKey(name);
+    const size_t mask = table->capacity - 1;
+    for (size_t i = key & mask;; i = (i + 1) & mask) {
+      const Slot& slot = table->slots[i];
+      const size_t slot_key = slot.key.load(std::memory_order_acquire);
+      // The table is never full, so the search always ends on a free slot.
+      if (!slot_key)
+        return nullptr;
+      if (slot_key != key)
+        continue;
+      HistogramBase* const histogram =
+          slot.histogram.load(std::memory_order_acquire);
+      if (histogram && name == histogram->histogram_name())
+        return histogram;
+    }
+  }
+
+  // Indexes |histogram|, whose name mustn't be indexed yet. The global lock
+  // must be held.
+  void Insert(HistogramBase* histogram) {
+    lock_.Get().AssertAcquired();
+    if (InsertIntoTable(tables_.back().get(), histogram))
+      return;
+    // The table is too full to take a new key.
+    Grow(tables_.back()->capacity * 2);
+    const bool inserted = InsertIntoTable(tables_.back().get(), histogram);
+    DCHECK(inserted);
+  }
+
+  // Removes the histogram named |name| from the index, if present. The global
+  // lock must be held.
+  void Remove(StringPiece name) {
+    lock_.Get().AssertAcquired();
+    Table* const table = tables_.back().get();
+    const size_t key = GetKey(name);
+    const size_t mask = table->capacity - 1;
+    for (size_t i = key & mask;; i = (i + 1) & mask) {
+      Slot& slot = table->slots[i];
+      const size_t slot_key = slot.key.load(std::memory_order_relaxed);
+      if (!slot_key)
+        return;
+      HistogramBase* const histogram =
+          slot.histogram.load(std::memory_order_relaxed);
+      if (slot_key == key && histogram && name == histogram->histogram_name()) {
+        // The key stays, so that searches still probe past this slot.
+        slot.histogram.store(nullptr, std::memory_order_relaxed);
+        return;
+      }
+    }
+  }
+
+ private:
+  static constexpr size_t kInitialCapacity = 512;
+
+  struct Slot {
+    // A hash of the histogram's name, or 0 if the slot was never used.
+    std::atomic<size_t> key{0};
+    // Null if the histogram was removed.
+    std::atomic<HistogramBase*> histogram{nullptr};
+  };
+
+  struct Table {
+    explicit Table(size_t capacity)
+        : capacity(capacity), slots(new Slot[capacity]) {}
+
+    // A power of 2.
+    const size_t capacity;
+    // Number of slots with a key, at most half of |capacity|.
+    size_t num_used_slots = 0;
+    const std::unique_ptr<Slot[]> slots;
+  };
+
+  static size_t GetKey(StringPiece name) {
+    const size_t hash = FastHash(name);
+    return hash ? hash : 1;
+  }
+
+  // Inserts |histogram| into |table|, reusing the slot of a removed histogram
+  // with the same key if possible. Returns false if that requires a new slot
+  // and |table| is too full.
+  static bool InsertIntoTable(Table* table, HistogramBase* histogram) {
+    const size_t key = GetKey(histogram->histogram_name());
+    const size_t mask = table->capacity - 1;
+    for (size_t i = key & mask;; i = (i + 1) & mask) {
+      Slot& slot = table->slots[i];
+      const size_t slot_key = slot.key.load(std::memory_order_relaxed);
+      if (slot_key == key &&
+          !slot.histogram.load(std::memory_order_relaxed)) {
+        slot.histogram.store(histogram, std::memory_order_release);
+        return true;
+      }
+      if (!slot_key) {
+        if (2 * (table->num_used_slots + 1) > table->capacity)
+          return false;
+        ++table->num_used_slots;
+        slot.histogram.store(histogram, std::memory_order_relaxed);
+        slot.key.store(key, std::memory_order_release);
+        return true;
+      }
+    }
+  }
+
+  // Publishes a table of |capacity| slots holding the indexed histograms.
+  void Grow(size_t capacity) {
+    auto table = std::make_unique<Table>(capacity);
+    if (!tables_.empty()) {
+      const Table& old_table = *tables_.back();
+      for (size_t i = 0; i < old_table.capacity; ++i) {
+        HistogramBase* const histogram =
+            old_table.slots[i].histogram.load(std::memory_order_relaxed);
+        if (histogram) {
+          const bool inserted = InsertIntoTable(table.get(), histogram);
+          DCHECK(inserted);
+        }
+      }
+    }
+    table_.store(table.get(), std::memory_order_release);
+    tables_.push_back(std::move(table));
+  }
+
+  // The table searched by Find().
+  std::atomic<const Table*> table_{nullptr};
+
+  // All the tables published so far, the last one being |table_|.
+  std::vector<std::unique_ptr<Table>> tables_;
+};
+
 // static
 LazyInstance<Lock>::Leaky StatisticsRecorder::lock_ = LAZY_INSTANCE_INITIALIZER;
 
 // static
 StatisticsRecorder* StatisticsRecorder::top_ = nullptr;
 
+// static
+std::atomic<const StatisticsRecorder::HistogramIndex*>
+    StatisticsRecorder::top_histogram_index_{nullptr};
+
 // static
 bool StatisticsRecorder::is_vlog_initialized_ = false;
 
@@ -70,6 +223,9 @@ StatisticsRecorder::~StatisticsRecorder() {
   const AutoLock auto_lock(lock_.Get());
   DCHECK_EQ(this, top_);
   top_ = previous_;
+  top_histogram_index_.store(
+      top_ ? top_->histogram_index_.get() : nullptr,
+      std::memory_order_release);
 }
 
 // static
@@ -95,6 +251,15 @@ void StatisticsRecorder::RegisterHistogramProvider(
 // static
 HistogramBase* StatisticsRecorder::RegisterOrDeleteDuplicate(
     HistogramBase* histogram) {
+  // Registering a histogram which is already registered, typically after a
+  // race between threads creating it, doesn't take the lock.
+  if (HistogramBase* const registered =
+          FindRegisteredHistogram(histogram->histogram_name())) {
+    if (registered != histogram)
+      delete histogram;
+    return registered;
+  }
+
   // Declared before |auto_lock| to ensure correct destruction order.
   std::unique_ptr<HistogramBase> histogram_deleter;
   const AutoLock auto_lock(lock_.Get());
@@ -107,6 +272,7 @@ HistogramBase* StatisticsRecorder::RegisterOrDeleteDuplicate(
     // |name| is guaranteed to never change or be deallocated so long
     // as the histogram is alive (which is forever).
     registered = histogram;
+    top_->histogram_index_->Insert(histogram);
     ANNOTATE_LEAKING_OBJECT_PTR(histogram);  // see crbug.com/79322
     // If there are callbacks for this histogram, we set the kCallbackExists
     // flag.
@@ -181,6 +347,11 @@ std::vector<const BucketRanges*> StatisticsRecorder::GetBucketRanges() {
 
 // static
 HistogramBase* StatisticsRecorder::FindHistogram(base::StringPiece name) {
+  // Importing histograms from persistent memory can't change which histogram
+  // is registered with a name, so it's not needed if one already is.
+  if (HistogramBase* const histogram = FindRegisteredHistogram(name))
+    return histogram;
+
   // This must be called *before* the lock is acquired below because it will
   // call back into this object to register histograms. Those called methods
   // will acquire the lock at that time.
@@ -193,6 +364,13 @@ HistogramBase* StatisticsRecorder::FindHistogram(base::StringPiece name) {
   return it != top_->histograms_.end() ? it->second : nullptr;
 }
 
+// static
+HistogramBase* StatisticsRecorder::FindRegisteredHistogram(StringPiece name) {
+  const HistogramIndex* const index =
+      top_histogram_index_.load(std::memory_order_acquire);
+  return index ? index->Find(name) : nullptr;
+}
+
 // static
 StatisticsRecorder::HistogramProviders
 StatisticsRecorder::GetHistogramProviders() {
@@ -341,6 +519,7 @@ void StatisticsRecorder::ForgetHistogramForTesting(base::StringPiece name) {
     static_cast<Histogram*>(base)->bucket_ranges()->set_persistent_reference(0);
   }
 
+  top_->histogram_index_->Remove(name);
   top_->histograms_.erase(found);
 }
 
@@ -434,10 +613,13 @@ void StatisticsRecorder::ImportGlobalPersistentHistograms() {
     allocator->ImportHistogramsToStatisticsRecorder();
 }
 
-StatisticsRecorder::StatisticsRecorder() {
+StatisticsRecorder::StatisticsRecorder()
+    : histogram_index_(std::make_unique<HistogramIndex>()) {
   lock_.Get().AssertAcquired();
   previous_ = top_;
   top_ = this;
+  top_histogram_index_.store(histogram_index_.get(),
+                             std::memory_order_release);
   InitLogOnShutdownWhileLocked();
 }
 
@@ -169,7 +169,8 @@ class BASE_EXPORT StatisticsRecorder {
   // Finds a histogram by name. Matches the exact name. Returns a null pointer
   // if a matching histogram is not found.
   //
-  // This method is thread safe.
+  // This method is thread safe. Finding a registered histogram doesn't take
+  // the global lock.
   static HistogramBase* FindHistogram(base::StringPiece name);
 
   // Imports histograms from providers.
@@ -307,6 +308,9 @@ class BASE_EXPORT StatisticsRecorder {
                              scoped_refptr<HistogramSampleObserverList>>
       ObserverMap;
 
+  // A lock-free index of the registered histograms, by name. See the .cc file.
+  class HistogramIndex;
+
   friend class StatisticsRecorderTest;
   FRIEND_TEST_ALL_PREFIXES(StatisticsRecorderTest, IterationTest);
 
@@ -316,6 +320,13 @@ class BASE_EXPORT StatisticsRecorder {
   // Precondition: The global lock is already acquired.
   static void EnsureGlobalRecorderWhileLocked();
 
+  // Finds a registered histogram by name, without taking the global lock.
+  // Returns a null pointer if a matching histogram is not found, which may
+  // also happen while it's being registered.
+  //
+  // This method is thread safe.
+  static HistogramBase* FindRegisteredHistogram(StringPiece name);
+
   // Gets histogram providers.
   //
   // This method is thread safe.
@@ -343,6 +354,11 @@ class BASE_EXPORT StatisticsRecorder {
   static void InitLogOnShutdownWhileLocked();
 
   HistogramMap histograms_;
+
+  // Indexes the histograms of |histograms_|, for lookups which don't take the
+  // global lock. Only modified while the global lock is held.
+  const std::unique_ptr<HistogramIndex> histogram_index_;
+
   ObserverMap observers_;
   HistogramProviders providers_;
   RangesManager ranges_manager_;
@@ -359,6 +375,10 @@ class BASE_EXPORT StatisticsRecorder {
   // previous global recorder is referenced by top_->previous_.
   static StatisticsRecorder* top_;
 
+  // The |histogram_index_| of |top_|, for lookups which don't take the global
+  // lock. A recorder must not be deleted while other threads find histograms.
+  static std::atomic<const HistogramIndex*> top_histogram_index_;
+
   // Tracks whether InitLogOnShutdownWhileLocked() has registered a logging
   // function that will be called when the program finishes.
   static bool is_vlog_initialized_;
@@ -7,6 +7,7 @@
 #include <stddef.h>
 
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -20,7 +21,9 @@
 #include "base/metrics/persistent_histogram_allocator.h"
 #include "base/metrics/record_histogram_checker.h"
 #include "base/metrics/sparse_histogram.h"
+#include "base/strings/stringprintf.h"
 #include "base/test/task_environment.h"
+#include "base/threading/simple_thread.h"
 #include "base/values.h"
 #include "testing/gmock/include/gmock/gmock.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -225,6 +228,66 @@ TEST_P(StatisticsRecorderTest, FindHistogram) {
   EXPECT_FALSE(StatisticsRecorder::FindHistogram("TestHistogram"));
 }
 
+// Histograms stay findable as the lock-free index grows, and histograms which
+// are forgotten stop being found, until a histogram with the same name is
+// registered again.
+TEST_P(StatisticsRecorderTest, FindHistogramInGrowingIndex) {
+  constexpr int kNumHistograms = 3000;
+  // The histograms refer to their names, which mustn't move.
+  std::vector<std::string> names;
+  names.reserve(kNumHistograms);
+  std::vector<HistogramBase*> histograms;
+  for (int i = 0; i < kNumHistograms; ++i) {
+    names.push_back(StringPrintf("TestHistogram%d", i));
+    histograms.push_back(StatisticsRecorder::RegisterOrDeleteDuplicate(
+        CreateHistogram(names.back().c_str(), 1, 1000, 10)));
+    // A histogram registered earlier is still found.
+    EXPECT_EQ(histograms[i / 2],
+              StatisticsRecorder::FindHistogram(names[i / 2]));
+  }
+  for (int i = 0; i < kNumHistograms; ++i)
+    EXPECT_EQ(histograms[i], StatisticsRecorder::FindHistogram(names[i]));
+
+  StatisticsRecorder::ForgetHistogramForTesting("TestHistogram7");
+  EXPECT_FALSE(StatisticsRecorder::FindHistogram("TestHistogram7"));
+  EXPECT_EQ(histograms[8], StatisticsRecorder::FindHistogram("TestHistogram8"));
+
+  HistogramBase* const histogram =
+      CreateHistogram("TestHistogram7", 1, 1000, 10);
+  EXPECT_EQ(histogram,
+            StatisticsRecorder::RegisterOrDeleteDuplicate(histogram));
+  EXPECT_EQ(histogram, StatisticsRecorder::FindHistogram("TestHistogram7"));
+}
+
+// Threads registering histograms concurrently with lookups always find the
+// histogram registered first with a name.
+TEST_P(StatisticsRecorderTest, ConcurrentRegisterAndFind) {
+  constexpr int kNumThreads = 4;
+  // Few enough to fit in the persistent allocator, even with duplicates.
+  constexpr int kNumHistograms = 50;
+
+  class RegisterAndFindDelegate : public DelegateSimpleThread::Delegate {
+   public:
+    void Run() override {
+      for (int i = 0; i < kNumHistograms; ++i) {
+        const std::string name = StringPrintf("ConcurrentHistogram%d", i);
+        HistogramBase* const histogram = Histogram::FactoryGet(
+            name, 1, 1000, 10, HistogramBase::kNoFlags);
+        EXPECT_EQ(histogram, StatisticsRecorder::FindHistogram(name));
+        EXPECT_EQ(name, histogram->histogram_name());
+      }
+    }
+  };
+
+  RegisterAndFindDelegate delegate;
+  DelegateSimpleThreadPool pool("RegisterAndFind", kNumThreads);
+  pool.AddWork(&delegate, kNumThreads);
+  pool.Start();
+  pool.JoinAll();
+  EXPECT_EQ(static_cast<size_t>(kNumHistograms),
+            StatisticsRecorder::GetHistogramCount());
+}
+
 TEST_P(StatisticsRecorderTest, WithName) {
   Histogram::FactoryGet("TestHistogram1", 1, 1000, 10, Histogram::kNoFlags);
   Histogram::FactoryGet("TestHistogram2", 1, 1000, 10, Histogram::kNoFlags);
@@ -0,0 +1,288 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/profiler/call_tree_profile_builder.h"
+
+#include "base/check.h"
+#include "base/files/file_path.h"
+#include "base/strings/string_piece.h"
+
+namespace base {
+
+namespace {
+
+// Field numbers of the pprof messages, from
+// https://github.com/google/pprof/blob/main/proto/profile.proto.
+enum ProfileField {
+  kProfileSampleType = 1,
+  kProfileSample = 2,
+  kProfileMapping = 3,
+  kProfileLocation = 4,
+  kProfileStringTable = 6,
+  kProfileTimeNanos = 9,
+  kProfileDurationNanos = 10,
+  kProfilePeriodType = 11,
+  kProfilePeriod = 12,
+};
+
+enum ValueTypeField {
+  kValueTypeType = 1,
+  kValueTypeUnit = 2,
+};
+
+enum SampleField {
+  kSampleLocationId = 1,
+  kSampleValue = 2,
+};
+
+enum MappingField {
+  kMappingId = 1,
+  kMappingMemoryStart = 2,
+  kMappingMemoryLimit = 3,
+  kMappingFilename = 5,
+  kMappingBuildId = 6,
+};
+
+enum LocationField {
+  kLocationId = 1,
+  kLocationMappingId = 2,
+  kLocationAddress = 3,
+};
+
+enum WireType {
+  kVarint = 0,
+  kLengthDelimited = 2,
+};
+
+void AppendVarint(uint64_t value, std::string* output) {
+  while (value >= 0x80) {
+    output->push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  output->push_back(static_cast<char>(value));
+}
+
+void AppendTag(int field, WireType wire_type, std::string* output) {
+  AppendVarint(static_cast<uint64_t>(field) << 3 | wire_type, output);
+}
+
+// Zero is the default value of proto3 scalar fields, so it is not written.
+void AppendVarintField(int field, uint64_t value, std::string* output) {
+  if (value == 0)
+    return;
+  AppendTag(field, kVarint, output);
+  AppendVarint(value, output);
+}
+
+void AppendBytesField(int field, StringPiece bytes, std::string* output) {
+  AppendTag(field, kLengthDelimited, output);
+  AppendVarint(bytes.size(), output);
+  output->append(bytes.data(), bytes.size());
+}
+
+void AppendPackedVarintField(int field,
+                             const std::vector<uint64_t>& values,
+                             std::string* output) {
+  std::string packed;
+  for (uint64_t value : values)
+    AppendVarint(value, &packed);
+  AppendBytesField(field, packed, output);
+}
+
+// Interns the strings of the profile. pprof requires the first string to be
+// empty.
+class StringTable {
+ public:
+  StringTable() { Intern(std::string()); }
+
+  uint64_t Intern(const std::string& string) {
+    auto it = indices_.emplace(string, strings_.size()).first;
+    if (it->second == strings_.size())
+      strings_.push_back(&it->first);
+    return it->second;
+  }
+
+  void AppendTo(std::string* output) const {
+    for (const std::string* string : strings_)
+      AppendBytesField(kProfileStringTable, *string, output);
+  }
+
+ private:
+  std::map<std::string, uint64_t> indices_;
+  std::vector<const std::string*> strings_;
+};
+
+void AppendValueTypeField(int field,
+                          const std::string& type,
+                          const std::string& unit,
+                          StringTable* strings,
+                          std::string* output) {
+  std::string value_type;
+  AppendVarintField(kValueTypeType, strings->Intern(type), &value_type);
+  AppendVarintField(kValueTypeUnit, strings->Intern(unit), &value_type);
+  AppendBytesField(field, value_type, output);
+}
+
+}  // namespace
+
+CallTreeProfileBuilder::CallTreeProfileBuilder(
+    ModuleCache* module_cache,
+    CompletedCallback completed_callback,
+    size_t max_nodes)
+    : module_cache_(module_cache),
+      completed_callback_(std::move(completed_callback)),
+      max_nodes_(max_nodes) {
+  nodes_.push_back({0, 0, 0});
+}
+
+CallTreeProfileBuilder::~CallTreeProfileBuilder() = default;
+
+ModuleCache* CallTreeProfileBuilder::GetModuleCache() {
+  return module_cache_;
+}
+
+void CallTreeProfileBuilder::OnSampleCompleted(std::vector<Frame> frames,
+                                               TimeTicks sample_timestamp) {
+  if (profile_start_time_.is_null())
+    profile_start_time_ = Time::Now();
+
+  // The frames are ordered from the innermost to the outermost one, so the
+  // tree is walked down from the last frame. A frame is only interned once a
+  // node is created for it, so that the locations stay bounded by the nodes
+  // once the tree is full.
+  uint32_t node = 0;
+  for (auto it = frames.rbegin(); it != frames.rend(); ++it) {
+    const absl::optional<uint32_t> existing_location = FindLocation(*it);
+    if (existing_location) {
+      auto child = children_.find({node, *existing_location});
+      if (child != children_.end()) {
+        node = child->second;
+        continue;
+      }
+    }
+    if (node_count() >= max_nodes_) {
+      ++truncated_sample_count_;
+      break;
+    }
+    const uint32_t location =
+        existing_location ? *existing_location : InternLocation(*it);
+    const uint32_t new_node = static_cast<uint32_t>(nodes_.size());
+    nodes_.push_back({node, location, 0});
+    children_.emplace(std::make_pair(node, location), new_node);
+    node = new_node;
+  }
+  ++nodes_[node].sample_count;
+}
+
+void CallTreeProfileBuilder::OnProfileCompleted(TimeDelta profile_duration,
+                                                TimeDelta sampling_period) {
+  if (completed_callback_) {
+    std::move(completed_callback_)
+        .Run(Serialize(profile_duration, sampling_period));
+  }
+}
+
+absl::optional<uint32_t> CallTreeProfileBuilder::FindLocation(
+    const Frame& frame) const {
+  auto it = location_indices_.find({frame.instruction_pointer, frame.module});
+  if (it == location_indices_.end())
+    return absl::nullopt;
+  return it->second;
+}
+
+uint32_t CallTreeProfileBuilder::InternLocation(const Frame& frame) {
+  DCHECK(!FindLocation(frame));
+  const uint32_t index = static_cast<uint32_t>(locations_.size());
+  const uint32_t mapping_id = frame.module ? InternModule(frame.module) : 0;
+  locations_.push_back({frame.instruction_pointer, mapping_id});
+  location_indices_.emplace(
+      std::make_pair(frame.instruction_pointer, frame.module), index);
+  return index;
+}
+
+uint32_t CallTreeProfileBuilder::InternModule(
+    const ModuleCache::Module* module) {
+  auto it = mapping_ids_.emplace(module, modules_.size() + 1).first;
+  if (it->second > modules_.size())
+    modules_.push_back(module);
+  return it->second;
+}
+
+std::string CallTreeProfileBuilder::Serialize(TimeDelta profile_duration,
+                                              TimeDelta sampling_period) const {
+  std::string output;
+  StringTable strings;
+
+  AppendValueTypeField(kProfileSampleType, "samples", "count", &strings,
+                       &output);
+  AppendValueTypeField(kProfileSampleType, "wall", "nanoseconds", &strings,
+                       &output);
+
+  // A sample is written for each node which is the innermost frame of any
+  // sample, with its location and those of its ancestors. pprof IDs are
+  // one-based, so location i has ID i + 1.
+  std::vector<uint64_t> location_ids;
+  for (const Node& leaf : nodes_) {
+    if (leaf.sample_count == 0)
+      continue;
+    location_ids.clear();
+    for (const Node* node = &leaf; node != &nodes_[0];
+         node = &nodes_[node->parent]) {
+      location_ids.push_back(node->location + 1);
+    }
+    const std::vector<uint64_t> values = {
+        leaf.sample_count, static_cast<uint64_t>(
+                               leaf.sample_count *
+                               sampling_period.InNanoseconds())};
+    std::string sample;
+    if (!location_ids.empty())
+      AppendPackedVarintField(kSampleLocationId, location_ids, &sample);
+    AppendPackedVarintField(kSampleValue, values, &sample);
+    AppendBytesField(kProfileSample, sample, &output);
+  }
+
+  for (size_t i = 0; i < modules_.size(); ++i) {
+    const ModuleCache::Module* module = modules_[i];
+    std::string mapping;
+    AppendVarintField(kMappingId, i + 1, &mapping);
+    AppendVarintField(kMappingMemoryStart, module->GetBaseAddress(), &mapping);
+    AppendVarintField(kMappingMemoryLimit,
+                      module->GetBaseAddress() + module->GetSize(), &mapping);
+    AppendVarintField(kMappingFilename,
+                      strings.Intern(module->GetDebugBasename().AsUTF8Unsafe()),
+                      &mapping);
+    AppendVarintField(kMappingBuildId, strings.Intern(module->GetId()),
+                      &mapping);
+    AppendBytesField(kProfileMapping, mapping, &output);
+  }
+
+  for (size_t i = 0; i < locations_.size(); ++i) {
+    std::string location;
+    AppendVarintField(kLocationId, i + 1, &location);
+    AppendVarintField(kLocationMappingId, locations_[i].mapping_id, &location);
+    AppendVarintField(kLocationAddress, locations_[i].address, &location);
+    AppendBytesField(kProfileLocation, location, &output);
+  }
+
+  if (!profile_start_time_.is_null()) {
+    AppendVarintField(kProfileTimeNanos,
+                      static_cast<uint64_t>(
+                          (profile_start_time_ - Time::UnixEpoch())
+                              .InNanoseconds()),
+                      &output);
+  }
+  AppendVarintField(kProfileDurationNanos,
+                    static_cast<uint64_t>(profile_duration.InNanoseconds()),
+                    &output);
+  AppendValueTypeField(kProfilePeriodType, "wall", "nanoseconds", &strings,
+                       &output);
+  AppendVarintField(kProfilePeriod,
+                    static_cast<uint64_t>(sampling_period.InNanoseconds()),
+                    &output);
+
+  strings.AppendTo(&output);
+  return output;
+}
+
+}  // namespace base
@@ -0,0 +1,125 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_PROFILER_CALL_TREE_PROFILE_BUILDER_H_
+#define BASE_PROFILER_CALL_TREE_PROFILE_BUILDER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/callback.h"
+#include "base/memory/raw_ptr.h"
+#include "base/profiler/frame.h"
+#include "base/profiler/module_cache.h"
+#include "base/profiler/profile_builder.h"
+#include "base/time/time.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
+
+namespace base {
+
+// A ProfileBuilder which aggregates the samples of a profile into a call tree
+// and serializes it in the pprof format
+// (https://github.com/google/pprof/blob/main/proto/profile.proto) when the
+// profile completes, so that embedders don't need their own serialization.
+//
+// Frames are interned by instruction pointer and module, modules by identity,
+// and each distinct stack is stored once as a path from the root of the tree.
+// The memory used therefore grows with the number of distinct stacks rather
+// than with the number of samples, and is capped by |max_nodes|: once the tree
+// is full, the stacks of new samples are truncated to their outermost frames
+// already in the tree, and their frames which are not in the tree are dropped.
+//
+// The profile holds no symbols. Each location is the sampled address within a
+// mapping identified by the ID and debug basename of its module, to be
+// symbolized offline (e.g. by pprof). Sample metadata is not recorded.
+class BASE_EXPORT CallTreeProfileBuilder : public ProfileBuilder {
+ public:
+  // Receives the profile serialized as an uncompressed pprof Profile message.
+  using CompletedCallback = OnceCallback<void(std::string profile)>;
+
+  static constexpr size_t kDefaultMaxNodes = 1 << 16;
+
+  // |module_cache| must outlive this object. |completed_callback| is run on
+  // the profiler thread when the profile completes.
+  CallTreeProfileBuilder(ModuleCache* module_cache,
+                         CompletedCallback completed_callback,
+                         size_t max_nodes = kDefaultMaxNodes);
+
+  CallTreeProfileBuilder(const CallTreeProfileBuilder&) = delete;
+  CallTreeProfileBuilder& operator=(const CallTreeProfileBuilder&) = delete;
+
+  ~CallTreeProfileBuilder() override;
+
+  // ProfileBuilder:
+  ModuleCache* GetModuleCache() override;
+  void OnSampleCompleted(std::vector<Frame> frames,
+                         TimeTicks sample_timestamp) override;
+  void OnProfileCompleted(TimeDelta profile_duration,
+                          TimeDelta sampling_period) override;
+
+  // Returns the number of nodes in the call tree, excluding its root.
+  size_t node_count() const { return nodes_.size() - 1; }
+
+  // Returns the number of distinct frames in the call tree.
+  size_t location_count() const { return locations_.size(); }
+
+  // Returns the number of samples whose stack was truncated because the call
+  // tree was full.
+  size_t truncated_sample_count() const { return truncated_sample_count_; }
+
+ private:
+  struct Node {
+    uint32_t parent;
+    // Index of the location in |locations_|.
+    uint32_t location;
+    // Number of samples whose innermost frame is this node.
+    uint32_t sample_count;
+  };
+
+  struct Location {
+    uintptr_t address;
+    // Index of the module in |modules_| plus one, or zero for frames without
+    // a module.
+    uint32_t mapping_id;
+  };
+
+  // Returns the index of the location of |frame| in |locations_|, if any.
+  absl::optional<uint32_t> FindLocation(const Frame& frame) const;
+  uint32_t InternLocation(const Frame& frame);
+  uint32_t InternModule(const ModuleCache::Module* module);
+
+  std::string Serialize(TimeDelta profile_duration,
+                        TimeDelta sampling_period) const;
+
+  const raw_ptr<ModuleCache> module_cache_;
+  CompletedCallback completed_callback_;
+  const size_t max_nodes_;
+
+  // The call tree. |nodes_[0]| is a root without location, and the children
+  // of a node are indexed by their (parent, location) in |children_|.
+  std::vector<Node> nodes_;
+  std::map<std::pair<uint32_t, uint32_t>, uint32_t> children_;
+
+  std::vector<Location> locations_;
+  std::map<std::pair<uintptr_t, const ModuleCache::Module*>, uint32_t>
+      location_indices_;
+
+  // The modules are owned by |module_cache_|, which keeps them alive even
+  // once they are no longer loaded.
+  std::vector<const ModuleCache::Module*> modules_;
+  std::map<const ModuleCache::Module*, uint32_t> mapping_ids_;
+
+  size_t truncated_sample_count_ = 0;
+  Time profile_start_time_;
+};
+
+}  // namespace base
+
+#endif  // BASE_PROFILER_CALL_TREE_PROFILE_BUILDER_H_
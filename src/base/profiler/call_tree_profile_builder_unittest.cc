@@ -0,0 +1,360 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/profiler/call_tree_profile_builder.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/profiler/stack_sampling_profiler_test_util.h"
+#include "base/strings/string_piece.h"
+#include "base/test/bind.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// The subset of a pprof Profile message checked by the tests.
+struct DecodedProfile {
+  struct Sample {
+    std::vector<uint64_t> location_ids;
+    std::vector<uint64_t> values;
+  };
+  struct Mapping {
+    uint64_t memory_start = 0;
+    uint64_t memory_limit = 0;
+    uint64_t filename = 0;
+    uint64_t build_id = 0;
+  };
+  struct Location {
+    uint64_t mapping_id = 0;
+    uint64_t address = 0;
+  };
+  // Indices into |strings|.
+  struct ValueType {
+    uint64_t type = 0;
+    uint64_t unit = 0;
+  };
+
+  std::vector<ValueType> sample_types;
+
+  std::vector<Sample> samples;
+  std::map<uint64_t, Mapping> mappings;
+  std::map<uint64_t, Location> locations;
+  std::vector<std::string> strings;
+  ValueType period_type;
+  uint64_t period = 0;
+  uint64_t duration_nanos = 0;
+};
+
+// Reads the fields of a protobuf message, which may only be varints or
+// length-delimited.
+class FieldReader {
+ public:
+  explicit FieldReader(StringPiece input) : input_(input) {}
+
+  // Reads the next field, setting either |varint| or |bytes| depending on its
+  // wire type. Returns false at the end of the input.
+  bool Next(int* field, uint64_t* varint, StringPiece* bytes) {
+    if (input_.empty())
+      return false;
+    uint64_t tag = ReadVarint();
+    *field = static_cast<int>(tag >> 3);
+    *varint = 0;
+    *bytes = StringPiece();
+    if ((tag & 7) == 0) {
+      *varint = ReadVarint();
+    } else {
+      EXPECT_EQ(2u, tag & 7);
+      const size_t size = static_cast<size_t>(ReadVarint());
+      *bytes = input_.substr(0, size);
+      input_.remove_prefix(bytes->size());
+    }
+    return true;
+  }
+
+  uint64_t ReadVarint() {
+    uint64_t value = 0;
+    for (int shift = 0; !input_.empty(); shift += 7) {
+      const uint8_t byte = static_cast<uint8_t>(input_[0]);
+      input_.remove_prefix(1);
+      value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+        break;
+    }
+    return value;
+  }
+
+  bool empty() const { return input_.empty(); }
+
+ private:
+  StringPiece input_;
+};
+
+DecodedProfile::ValueType DecodeValueType(StringPiece bytes) {
+  DecodedProfile::ValueType value_type;
+  FieldReader reader(bytes);
+  int field;
+  uint64_t varint;
+  StringPiece unused_bytes;
+  while (reader.Next(&field, &varint, &unused_bytes)) {
+    if (field == 1)
+      value_type.type = varint;
+    else if (field == 2)
+      value_type.unit = varint;
+  }
+  return value_type;
+}
+
+std::vector<uint64_t> DecodePackedVarints(StringPiece bytes) {
+  std::vector<uint64_t> values;
+  FieldReader reader(bytes);
+  while (!reader.empty())
+    values.push_back(reader.ReadVarint());
+  return values;
+}
+
+DecodedProfile DecodeProfile(StringPiece serialized_profile) {
+  DecodedProfile profile;
+  FieldReader reader(serialized_profile);
+  int field;
+  uint64_t varint;
+  StringPiece bytes;
+  while (reader.Next(&field, &varint, &bytes)) {
+    FieldReader message(bytes);
+    int message_field;
+    uint64_t message_varint;
+    StringPiece message_bytes;
+    switch (field) {
+      case 1:
+        profile.sample_types.push_back(DecodeValueType(bytes));
+        break;
+      case 2: {
+        DecodedProfile::Sample sample;
+        while (message.Next(&message_field, &message_varint, &message_bytes)) {
+          if (message_field == 1)
+            sample.location_ids = DecodePackedVarints(message_bytes);
+          else if (message_field == 2)
+            sample.values = DecodePackedVarints(message_bytes);
+        }
+        profile.samples.push_back(sample);
+        break;
+      }
+      case 3: {
+        uint64_t id = 0;
+        DecodedProfile::Mapping mapping;
+        while (message.Next(&message_field, &message_varint, &message_bytes)) {
+          if (message_field == 1)
+            id = message_varint;
+          else if (message_field == 2)
+            mapping.memory_start = message_varint;
+          else if (message_field == 3)
+            mapping.memory_limit = message_varint;
+          else if (message_field == 5)
+            mapping.filename = message_varint;
+          else if (message_field == 6)
+            mapping.build_id = message_varint;
+        }
+        profile.mappings[id] = mapping;
+        break;
+      }
+      case 4: {
+        uint64_t id = 0;
+        DecodedProfile::Location location;
+        while (message.Next(&message_field, &message_varint, &message_bytes)) {
+          if (message_field == 1)
+            id = message_varint;
+          else if (message_field == 2)
+            location.mapping_id = message_varint;
+          else if (message_field == 3)
+            location.address = message_varint;
+        }
+        profile.locations[id] = location;
+        break;
+      }
+      case 6:
+        profile.strings.push_back(std::string(bytes));
+        break;
+      case 10:
+        profile.duration_nanos = varint;
+        break;
+      case 11:
+        profile.period_type = DecodeValueType(bytes);
+        break;
+      case 12:
+        profile.period = varint;
+        break;
+    }
+  }
+  return profile;
+}
+
+class CallTreeProfileBuilderTest : public testing::Test {
+ protected:
+  CallTreeProfileBuilderTest() {
+    module1_.set_id("ID1");
+    module1_.set_debug_basename(FilePath(FILE_PATH_LITERAL("libfoo.so")));
+    module2_.set_id("ID2");
+    module2_.set_debug_basename(FilePath(FILE_PATH_LITERAL("libbar.so")));
+  }
+
+  std::unique_ptr<CallTreeProfileBuilder> CreateBuilder(
+      size_t max_nodes = CallTreeProfileBuilder::kDefaultMaxNodes) {
+    return std::make_unique<CallTreeProfileBuilder>(
+        &module_cache_,
+        BindLambdaForTesting([this](std::string profile) {
+          serialized_profile_ = std::move(profile);
+        }),
+        max_nodes);
+  }
+
+  // Returns the addresses of the frames of |sample|, innermost first.
+  std::vector<uint64_t> GetAddresses(const DecodedProfile& profile,
+                                     const DecodedProfile::Sample& sample) {
+    std::vector<uint64_t> addresses;
+    for (uint64_t id : sample.location_ids)
+      addresses.push_back(profile.locations.at(id).address);
+    return addresses;
+  }
+
+  ModuleCache module_cache_;
+  TestModule module1_{0x1000, 0x1000};
+  TestModule module2_{0x4000, 0x2000};
+  std::string serialized_profile_;
+};
+
+}  // namespace
+
+TEST_F(CallTreeProfileBuilderTest, AggregatesIdenticalStacks) {
+  std::unique_ptr<CallTreeProfileBuilder> builder = CreateBuilder();
+  for (int i = 0; i < 3; ++i) {
+    builder->OnSampleCompleted(
+        {Frame(0x1010, &module1_), Frame(0x4020, &module2_)}, TimeTicks());
+  }
+  builder->OnSampleCompleted(
+      {Frame(0x1030, &module1_), Frame(0x4020, &module2_)}, TimeTicks());
+  EXPECT_EQ(3u, builder->node_count());
+  builder->OnProfileCompleted(Milliseconds(40), Milliseconds(10));
+
+  const DecodedProfile profile = DecodeProfile(serialized_profile_);
+  ASSERT_EQ(2u, profile.samples.size());
+  EXPECT_EQ((std::vector<uint64_t>{0x1010, 0x4020}),
+            GetAddresses(profile, profile.samples[0]));
+  EXPECT_EQ((std::vector<uint64_t>{3, 30000000}), profile.samples[0].values);
+  EXPECT_EQ((std::vector<uint64_t>{0x1030, 0x4020}),
+            GetAddresses(profile, profile.samples[1]));
+  EXPECT_EQ((std::vector<uint64_t>{1, 10000000}), profile.samples[1].values);
+
+  // The shared outermost frame is interned as a single location.
+  EXPECT_EQ(3u, profile.locations.size());
+  EXPECT_EQ(profile.samples[0].location_ids[1],
+            profile.samples[1].location_ids[1]);
+
+  EXPECT_EQ(10000000u, profile.period);
+  EXPECT_EQ(40000000u, profile.duration_nanos);
+  ASSERT_FALSE(profile.strings.empty());
+  EXPECT_EQ("", profile.strings[0]);
+
+  // The samples are of wall time, as they are taken whether or not the
+  // sampled thread is running.
+  ASSERT_EQ(2u, profile.sample_types.size());
+  EXPECT_EQ("samples", profile.strings.at(profile.sample_types[0].type));
+  EXPECT_EQ("count", profile.strings.at(profile.sample_types[0].unit));
+  EXPECT_EQ("wall", profile.strings.at(profile.sample_types[1].type));
+  EXPECT_EQ("nanoseconds", profile.strings.at(profile.sample_types[1].unit));
+  EXPECT_EQ("wall", profile.strings.at(profile.period_type.type));
+  EXPECT_EQ("nanoseconds", profile.strings.at(profile.period_type.unit));
+}
+
+TEST_F(CallTreeProfileBuilderTest, Mappings) {
+  std::unique_ptr<CallTreeProfileBuilder> builder = CreateBuilder();
+  builder->OnSampleCompleted(
+      {Frame(0x1010, &module1_), Frame(0x4020, &module2_),
+       Frame(0x1020, &module1_), Frame(0x9000, nullptr)},
+      TimeTicks());
+  builder->OnProfileCompleted(Milliseconds(10), Milliseconds(10));
+
+  const DecodedProfile profile = DecodeProfile(serialized_profile_);
+  ASSERT_EQ(2u, profile.mappings.size());
+  ASSERT_EQ(4u, profile.locations.size());
+  ASSERT_EQ(1u, profile.samples.size());
+  const std::vector<uint64_t>& ids = profile.samples[0].location_ids;
+  ASSERT_EQ(4u, ids.size());
+
+  // Frames of the same module share a mapping, and frames without a module
+  // have none.
+  const uint64_t mapping1_id = profile.locations.at(ids[0]).mapping_id;
+  EXPECT_EQ(mapping1_id, profile.locations.at(ids[2]).mapping_id);
+  EXPECT_EQ(0u, profile.locations.at(ids[3]).mapping_id);
+
+  const DecodedProfile::Mapping& mapping1 = profile.mappings.at(mapping1_id);
+  EXPECT_EQ(0x1000u, mapping1.memory_start);
+  EXPECT_EQ(0x2000u, mapping1.memory_limit);
+  EXPECT_EQ("libfoo.so", profile.strings.at(mapping1.filename));
+  EXPECT_EQ("ID1", profile.strings.at(mapping1.build_id));
+
+  const DecodedProfile::Mapping& mapping2 =
+      profile.mappings.at(profile.locations.at(ids[1]).mapping_id);
+  EXPECT_EQ(0x4000u, mapping2.memory_start);
+  EXPECT_EQ(0x6000u, mapping2.memory_limit);
+  EXPECT_EQ("libbar.so", profile.strings.at(mapping2.filename));
+  EXPECT_EQ("ID2", profile.strings.at(mapping2.build_id));
+}
+
+TEST_F(CallTreeProfileBuilderTest, TruncatesStacksWhenFull) {
+  std::unique_ptr<CallTreeProfileBuilder> builder = CreateBuilder(2);
+  builder->OnSampleCompleted(
+      {Frame(0x1010, &module1_), Frame(0x4020, &module2_)}, TimeTicks());
+  // The tree is full, so this sample is attributed to its outermost frame.
+  builder->OnSampleCompleted(
+      {Frame(0x1030, &module1_), Frame(0x4020, &module2_)}, TimeTicks());
+  EXPECT_EQ(2u, builder->node_count());
+  EXPECT_EQ(1u, builder->truncated_sample_count());
+  builder->OnProfileCompleted(Milliseconds(20), Milliseconds(10));
+
+  const DecodedProfile profile = DecodeProfile(serialized_profile_);
+  ASSERT_EQ(2u, profile.samples.size());
+  EXPECT_EQ((std::vector<uint64_t>{0x4020}),
+            GetAddresses(profile, profile.samples[0]));
+  EXPECT_EQ((std::vector<uint64_t>{0x1010, 0x4020}),
+            GetAddresses(profile, profile.samples[1]));
+}
+
+// The frames of truncated stacks are not interned.
+TEST_F(CallTreeProfileBuilderTest, TruncatedFramesAreNotInterned) {
+  std::unique_ptr<CallTreeProfileBuilder> builder = CreateBuilder(2);
+  builder->OnSampleCompleted(
+      {Frame(0x1010, &module1_), Frame(0x4020, &module2_)}, TimeTicks());
+  EXPECT_EQ(2u, builder->location_count());
+  for (uintptr_t address = 0x1100; address < 0x1200; ++address) {
+    builder->OnSampleCompleted(
+        {Frame(address, &module1_), Frame(0x9000 + address, nullptr)},
+        TimeTicks());
+    builder->OnSampleCompleted(
+        {Frame(address, &module1_), Frame(0x4020, &module2_)}, TimeTicks());
+  }
+  EXPECT_EQ(2u, builder->node_count());
+  EXPECT_EQ(2u, builder->location_count());
+  EXPECT_EQ(0x200u, builder->truncated_sample_count());
+  builder->OnProfileCompleted(Milliseconds(20), Milliseconds(10));
+
+  const DecodedProfile profile = DecodeProfile(serialized_profile_);
+  EXPECT_EQ(2u, profile.locations.size());
+}
+
+TEST_F(CallTreeProfileBuilderTest, EmptyProfile) {
+  std::unique_ptr<CallTreeProfileBuilder> builder = CreateBuilder();
+  builder->OnProfileCompleted(TimeDelta(), Milliseconds(10));
+
+  const DecodedProfile profile = DecodeProfile(serialized_profile_);
+  EXPECT_TRUE(profile.samples.empty());
+  EXPECT_TRUE(profile.locations.empty());
+  EXPECT_EQ(10000000u, profile.period);
+}
+
+}  // namespace base
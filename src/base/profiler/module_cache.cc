@@ -64,7 +64,12 @@ const ModuleCache::Module* ModuleCache::GetModuleForAddress(uintptr_t address) {
   if (const ModuleCache::Module* module = GetExistingModuleForAddress(address))
     return module;
 
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS)
+  std::unique_ptr<const Module> new_module =
+      CreateModuleForAddressCachingMisses(address);
+#else
   std::unique_ptr<const Module> new_module = CreateModuleForAddress(address);
+#endif
   if (!new_module && auxiliary_module_provider_)
     new_module = auxiliary_module_provider_->TryCreateModuleForAddress(address);
   if (!new_module)
@@ -5,6 +5,9 @@
 #ifndef BASE_PROFILER_MODULE_CACHE_H_
 #define BASE_PROFILER_MODULE_CACHE_H_
 
+#include <stdint.h>
+
+#include <map>
 #include <memory>
 #include <set>
 #include <string>
@@ -166,6 +169,14 @@ class BASE_EXPORT ModuleCache {
   static std::unique_ptr<const Module> CreateModuleForAddress(
       uintptr_t address);
 
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS)
+  // Same as CreateModuleForAddress(), but returns null without reading
+  // /proc/self/maps again if |address| is in |non_module_ranges_|, and adds the
+  // range around |address| to them if it holds no module.
+  std::unique_ptr<const Module> CreateModuleForAddressCachingMisses(
+      uintptr_t address);
+#endif
+
   // Set of native modules sorted by base address. We use set rather than
   // flat_set because the latter type has O(n^2) runtime for adding modules
   // one-at-a-time, which is how modules are added on Windows and Mac.
@@ -193,6 +204,16 @@ class BASE_EXPORT ModuleCache {
 
   // Auxiliary module provider, for lazily creating native modules.
   raw_ptr<AuxiliaryModuleProvider> auxiliary_module_provider_ = nullptr;
+
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS)
+  // Ranges of addresses which /proc/self/maps listed as holding no module,
+  // mapped from their end to their start, so that the frames in anonymous or
+  // JIT-compiled code don't read it again on every lookup. They are forgotten
+  // when the dynamic linker loads or unloads a library, which may map a module
+  // over them.
+  std::map<uintptr_t, uintptr_t> non_module_ranges_;
+  uint64_t loaded_libraries_generation_ = 0;
+#endif
 };
 
 }  // namespace base
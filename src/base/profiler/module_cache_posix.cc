@@ -6,11 +6,26 @@
 
 #include <dlfcn.h>
 #include <elf.h>
+#include <stddef.h>
+
+#include <algorithm>
+#include <string>
 
 #include "base/debug/elf_reader.h"
 #include "build/build_config.h"
 #include "third_party/abseil-cpp/absl/types/optional.h"
 
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS)
+#include <link.h>
+
+#include <limits>
+
+#include "base/debug/proc_maps_linux.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_piece.h"
+#include "base/strings/string_util.h"
+#endif
+
 // arm64 has execute-only memory (XOM) protecting code pages from being read.
 // PosixModule reads executable pages in order to extract module info. This may
 // result in a crash if the module is mapped as XOM so the code is disabled on
@@ -28,7 +43,7 @@ namespace base {
 
 namespace {
 
-#if !defined(ARCH_CPU_ARM64)
+#if !defined(ARCH_CPU_ARM64) || BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS)
 // Returns the unique build ID for a module loaded at |module_addr|. Returns the
 // empty string if the function fails to get the build ID.
 //
@@ -83,7 +98,134 @@ FilePath GetDebugBasenameForModule(const void* base_address, const char* file) {
 
   return FilePath(file).BaseName();
 }
-#endif  // !defined(ARCH_CPU_ARM64)
+#endif  // !defined(ARCH_CPU_ARM64) || BUILDFLAG(IS_LINUX) ||
+        // BUILDFLAG(IS_CHROMEOS)
+
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS)
+// A mapping listed in /proc/self/maps. |path| references the contents read
+// from the file.
+struct ProcMapsEntry {
+  uintptr_t start = 0;
+  uintptr_t end = 0;
+  uint64_t offset = 0;
+  bool readable = false;
+  bool executable = false;
+  StringPiece path;
+};
+
+// Parses a line of /proc/self/maps, whose format is
+//   start-end perms offset dev inode [path]
+// without allocating memory, unlike debug::ParseProcMaps().
+bool ParseProcMapsLine(StringPiece line, ProcMapsEntry* entry) {
+  StringPiece fields[5];
+  for (StringPiece& field : fields) {
+    const size_t field_end = std::min(line.find(' '), line.size());
+    field = line.substr(0, field_end);
+    line.remove_prefix(std::min(field_end + 1, line.size()));
+  }
+
+  const size_t dash = fields[0].find('-');
+  uint64_t start;
+  uint64_t end;
+  if (dash == StringPiece::npos ||
+      !HexStringToUInt64(fields[0].substr(0, dash), &start) ||
+      !HexStringToUInt64(fields[0].substr(dash + 1), &end) ||
+      fields[1].size() != 4 || !HexStringToUInt64(fields[2], &entry->offset)) {
+    return false;
+  }
+  entry->start = static_cast<uintptr_t>(start);
+  entry->end = static_cast<uintptr_t>(end);
+  entry->readable = fields[1][0] == 'r';
+  entry->executable = fields[1][2] == 'x';
+  entry->path = TrimWhitespaceASCII(line, TRIM_LEADING);
+  return true;
+}
+
+// The extents of a module, as listed in /proc/self/maps.
+struct ProcMapsModule {
+  uintptr_t base_address = 0;
+  // The end of the last executable mapping of the module.
+  uintptr_t executable_end = 0;
+  // Whether the ELF headers at |base_address| can be read. Code mapped as
+  // execute-only memory (XOM) can't be, which is why arm64 modules aren't
+  // read from unless /proc/self/maps says they are readable.
+  bool headers_readable = false;
+  std::string path;
+};
+
+// A range of addresses [start, end) which holds no module.
+struct NonModuleRange {
+  uintptr_t start = 0;
+  uintptr_t end = 0;
+};
+
+// Finds the module containing |address| in /proc/self/maps, which lists the
+// mappings of a module consecutively and sorted by address. The scan stops as
+// soon as the module is found, and allocates nothing but the buffer holding
+// the file. If there is no module at |address|, |non_module_range| is set to
+// the mapping or the unmapped range containing it.
+absl::optional<ProcMapsModule> FindModuleInProcMaps(
+    uintptr_t address,
+    NonModuleRange* non_module_range) {
+  std::string proc_maps;
+  if (!debug::ReadProcMaps(&proc_maps))
+    return absl::nullopt;
+
+  ProcMapsModule module;
+  StringPiece module_path;
+  uint64_t module_offset = 0;
+  bool found = false;
+  NonModuleRange containing_range = {0, std::numeric_limits<uintptr_t>::max()};
+  for (StringPiece remaining(proc_maps); !remaining.empty();) {
+    const size_t line_end = std::min(remaining.find('\n'), remaining.size());
+    const StringPiece line = remaining.substr(0, line_end);
+    remaining.remove_prefix(std::min(line_end + 1, remaining.size()));
+
+    ProcMapsEntry entry;
+    if (!ParseProcMapsLine(line, &entry))
+      continue;
+
+    // Anonymous mappings, such as the .bss section following a module, are
+    // not part of it.
+    if (entry.path.empty() || entry.path != module_path) {
+      if (found)
+        break;
+      if (entry.start > address) {
+        containing_range.end = entry.start;
+        *non_module_range = containing_range;
+        return absl::nullopt;
+      }
+      module_path = entry.path;
+      module_offset = entry.offset;
+      module.base_address = entry.start;
+      module.executable_end = 0;
+      module.headers_readable = entry.readable;
+    }
+    if (entry.executable)
+      module.executable_end = entry.end;
+    if (address >= entry.start && address < entry.end) {
+      found = true;
+      containing_range = {entry.start, entry.end};
+    } else if (!found) {
+      containing_range.start = entry.end;
+    }
+  }
+
+  // Only files mapped from their start with executable code are modules.
+  if (!found || module_offset != 0 || !StartsWith(module_path, "/") ||
+      !module.executable_end) {
+    *non_module_range = containing_range;
+    return absl::nullopt;
+  }
+
+  // The file of a module may have been replaced since it was loaded.
+  constexpr StringPiece kDeletedSuffix = " (deleted)";
+  if (EndsWith(module_path, kDeletedSuffix))
+    module_path.remove_suffix(kDeletedSuffix.size());
+  module.path = std::string(module_path);
+  return module;
+}
+#endif  // BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS)
 
 class PosixModule : public ModuleCache::Module {
  public:
@@ -118,12 +260,61 @@ PosixModule::PosixModule(uintptr_t base_address,
       debug_basename_(debug_basename),
       size_(size) {}
 
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS)
+std::unique_ptr<const ModuleCache::Module> CreateModuleFromProcMaps(
+    uintptr_t address,
+    NonModuleRange* non_module_range) {
+  // /proc/self/maps is used rather than dladdr(), since it tells whether the
+  // ELF headers of the module are readable on arm64, and it also finds
+  // modules which weren't loaded by the dynamic linker.
+  const absl::optional<ProcMapsModule> module =
+      FindModuleInProcMaps(address, non_module_range);
+  if (!module)
+    return nullptr;
+
+  const void* const base_address =
+      reinterpret_cast<const void*>(module->base_address);
+  std::string build_id;
+  size_t size = module->executable_end - module->base_address;
+  if (module->headers_readable) {
+    build_id = GetUniqueBuildId(base_address);
+    // The end of the last executable segment from the ELF headers excludes the
+    // padding up to the end of the page.
+    const size_t last_executable_offset = GetLastExecutableOffset(base_address);
+    if (last_executable_offset)
+      size = std::min(size, last_executable_offset);
+  }
+  return std::make_unique<PosixModule>(
+      module->base_address, build_id,
+      GetDebugBasenameForModule(base_address, module->path.c_str()), size);
+}
+
+// Returns a number which changes whenever the dynamic linker loads or unloads
+// a library.
+uint64_t GetLoadedLibrariesGeneration() {
+  uint64_t generation = 0;
+  dl_iterate_phdr(
+      [](dl_phdr_info* info, size_t size, void* data) {
+        // The counters are reported with every library, so the first one is
+        // enough.
+        if (size >= offsetof(dl_phdr_info, dlpi_subs) + sizeof(info->dlpi_subs))
+          *static_cast<uint64_t*>(data) = info->dlpi_adds + info->dlpi_subs;
+        return 1;
+      },
+      &generation);
+  return generation;
+}
+#endif  // BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS)
+
 }  // namespace
 
 // static
 std::unique_ptr<const ModuleCache::Module> ModuleCache::CreateModuleForAddress(
     uintptr_t address) {
-#if defined(ARCH_CPU_ARM64)
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS)
+  NonModuleRange non_module_range;
+  return CreateModuleFromProcMaps(address, &non_module_range);
+#elif defined(ARCH_CPU_ARM64)
   // arm64 has execute-only memory (XOM) protecting code pages from being read.
   // PosixModule reads executable pages in order to extract module info. This
   // may result in a crash if the module is mapped as XOM
@@ -162,4 +353,26 @@ std::unique_ptr<const ModuleCache::Module> ModuleCache::CreateModuleForAddress(
 #endif
 }
 
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS)
+std::unique_ptr<const ModuleCache::Module>
+ModuleCache::CreateModuleForAddressCachingMisses(uintptr_t address) {
+  const uint64_t generation = GetLoadedLibrariesGeneration();
+  if (generation != loaded_libraries_generation_) {
+    non_module_ranges_.clear();
+    loaded_libraries_generation_ = generation;
+  }
+
+  const auto range = non_module_ranges_.upper_bound(address);
+  if (range != non_module_ranges_.end() && range->second <= address)
+    return nullptr;
+
+  NonModuleRange non_module_range;
+  std::unique_ptr<const Module> module =
+      CreateModuleFromProcMaps(address, &non_module_range);
+  if (!module && non_module_range.start < non_module_range.end)
+    non_module_ranges_.emplace(non_module_range.end, non_module_range.start);
+  return module;
+}
+#endif  // BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS)
+
 }  // namespace base
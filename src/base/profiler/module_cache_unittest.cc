@@ -20,6 +20,13 @@
 #include "base/debug/proc_maps_linux.h"
 #endif
 
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS)
+#include <dlfcn.h>
+#include <sys/mman.h>
+
+#include "base/memory/page_size.h"
+#endif
+
 namespace base {
 namespace {
 
@@ -94,7 +101,8 @@ const ModuleCache::Module* AddNonNativeModule(
 }
 
 #if (BUILDFLAG(IS_POSIX) && !BUILDFLAG(IS_IOS) && !defined(ARCH_CPU_ARM64)) || \
-    (BUILDFLAG(IS_FUCHSIA) && !defined(ARCH_CPU_ARM64)) || BUILDFLAG(IS_WIN)
+    (BUILDFLAG(IS_FUCHSIA) && !defined(ARCH_CPU_ARM64)) ||                    \
+    BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || BUILDFLAG(IS_WIN)
 #define MAYBE_TEST(TestSuite, TestName) TEST(TestSuite, TestName)
 #else
 #define MAYBE_TEST(TestSuite, TestName) TEST(TestSuite, DISABLED_##TestName)
@@ -331,7 +339,7 @@ MAYBE_TEST(ModuleCacheTest, InvalidModule) {
   EXPECT_EQ(nullptr, cache.GetModuleForAddress(1));
 }
 
-// arm64 module support is not implemented.
+// arm64 module support is only implemented on Linux and ChromeOS.
 #if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS) || \
     (BUILDFLAG(IS_ANDROID) && !defined(ARCH_CPU_ARM64))
 // Validates that, for the memory regions listed in /proc/self/maps, the modules
@@ -411,6 +419,58 @@ TEST(ModuleCacheTest, CheckAgainstProcMaps) {
 }
 #endif
 
+#if BUILDFLAG(IS_LINUX) || BUILDFLAG(IS_CHROMEOS)
+// Checks that the module found in /proc/self/maps is the one dladdr() finds,
+// and that its headers are read.
+TEST(ModuleCacheTest, MatchesDladdr) {
+  const uintptr_t address = reinterpret_cast<uintptr_t>(&AFunctionForTest);
+  Dl_info info;
+  ASSERT_TRUE(dladdr(reinterpret_cast<const void*>(address), &info));
+
+  ModuleCache cache;
+  const ModuleCache::Module* module = cache.GetModuleForAddress(address);
+  ASSERT_NE(nullptr, module);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(info.dli_fbase),
+            module->GetBaseAddress());
+  EXPECT_GT(module->GetBaseAddress() + module->GetSize(), address);
+  EXPECT_FALSE(module->GetId().empty());
+  EXPECT_TRUE(module->IsNative());
+}
+
+// Anonymous executable memory, such as JIT-compiled code, isn't part of a
+// module.
+TEST(ModuleCacheTest, AnonymousExecutableMemory) {
+  void* const mapping = mmap(nullptr, GetPageSize(), PROT_READ | PROT_EXEC,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  ASSERT_NE(MAP_FAILED, mapping);
+  ModuleCache cache;
+  EXPECT_EQ(nullptr,
+            cache.GetModuleForAddress(reinterpret_cast<uintptr_t>(mapping)));
+  munmap(mapping, GetPageSize());
+}
+
+// The ranges found to hold no module don't hide the modules next to them.
+TEST(ModuleCacheTest, MissesDontHideModules) {
+  const uintptr_t address = reinterpret_cast<uintptr_t>(&AFunctionForTest);
+  void* const mapping = mmap(nullptr, 2 * GetPageSize(), PROT_READ | PROT_EXEC,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  ASSERT_NE(MAP_FAILED, mapping);
+  const uintptr_t mapping_address = reinterpret_cast<uintptr_t>(mapping);
+
+  ModuleCache cache;
+  EXPECT_EQ(nullptr, cache.GetModuleForAddress(1));
+  EXPECT_EQ(nullptr, cache.GetModuleForAddress(mapping_address));
+  EXPECT_EQ(nullptr,
+            cache.GetModuleForAddress(mapping_address + GetPageSize()));
+  EXPECT_EQ(nullptr, cache.GetModuleForAddress(mapping_address + 1));
+  const ModuleCache::Module* module = cache.GetModuleForAddress(address);
+  ASSERT_NE(nullptr, module);
+  EXPECT_TRUE(module->IsNative());
+  EXPECT_EQ(nullptr, cache.GetModuleForAddress(1));
+  munmap(mapping, 2 * GetPageSize());
+}
+#endif
+
 // Module provider that always return a fake module of size 1 for a given
 // |address|.
 class MockModuleProvider : public ModuleCache::AuxiliaryModuleProvider {
@@ -47,14 +47,17 @@
 
 // STACK_SAMPLING_PROFILER_SUPPORTED is used to conditionally enable the tests
 // below for supported platforms (currently Win x64, Mac x64, iOS 64, some
-// Android, and ChromeOS x64).
-// ChromeOS: These don't run under MSan because parts of the stack aren't
-// initialized.
+// Android, ChromeOS x64, and Linux x64 and arm64).
+// ChromeOS and Linux: These don't run under MSan because parts of the stack
+// aren't initialized.
 #if (BUILDFLAG(IS_WIN) && defined(ARCH_CPU_X86_64)) ||            \
     (BUILDFLAG(IS_MAC) && defined(ARCH_CPU_X86_64)) ||            \
     (BUILDFLAG(IS_IOS) && defined(ARCH_CPU_64_BITS)) ||           \
     (BUILDFLAG(IS_ANDROID) && BUILDFLAG(ENABLE_ARM_CFI_TABLE)) || \
     (BUILDFLAG(IS_CHROMEOS) && defined(ARCH_CPU_X86_64) &&        \
+     !defined(MEMORY_SANITIZER)) ||                               \
+    (BUILDFLAG(IS_LINUX) &&                                       \
+     (defined(ARCH_CPU_X86_64) || defined(ARCH_CPU_ARM64)) &&     \
      !defined(MEMORY_SANITIZER))
 #define STACK_SAMPLING_PROFILER_SUPPORTED 1
 #endif
@@ -195,8 +198,9 @@ void SynchronousUnloadNativeLibrary(NativeLibrary library) {
          ::GetLastError() != ERROR_MOD_NOT_FOUND) {
     PlatformThread::Sleep(Milliseconds(1));
   }
-#elif BUILDFLAG(IS_APPLE) || BUILDFLAG(IS_ANDROID) || BUILDFLAG(IS_CHROMEOS)
-// Unloading a library on Mac and Android is synchronous.
+#elif BUILDFLAG(IS_APPLE) || BUILDFLAG(IS_ANDROID) || BUILDFLAG(IS_LINUX) || \
+    BUILDFLAG(IS_CHROMEOS)
+// Unloading a library on Mac, Android and Linux is synchronous.
 #else
   NOTIMPLEMENTED();
 #endif
@@ -441,10 +445,11 @@ class StackSamplingProfilerTest : public testing::Test {
 //
 // If we're running the ChromeOS unit tests on Linux, this test will never pass
 // because Ubuntu's libc isn't compiled with frame pointers. Skip if not a real
-// ChromeOS device.
-#if (defined(ADDRESS_SANITIZER) && BUILDFLAG(IS_APPLE)) ||   \
-    (defined(ADDRESS_SANITIZER) && BUILDFLAG(IS_ANDROID)) || \
-    (BUILDFLAG(IS_CHROMEOS) && !BUILDFLAG(IS_CHROMEOS_DEVICE))
+// ChromeOS device, and on Linux for the same reason.
+#if (defined(ADDRESS_SANITIZER) && BUILDFLAG(IS_APPLE)) ||        \
+    (defined(ADDRESS_SANITIZER) && BUILDFLAG(IS_ANDROID)) ||      \
+    (BUILDFLAG(IS_CHROMEOS) && !BUILDFLAG(IS_CHROMEOS_DEVICE)) || \
+    BUILDFLAG(IS_LINUX)
 #define MAYBE_Basic DISABLED_Basic
 #else
 #define MAYBE_Basic Basic
@@ -500,10 +505,11 @@ class TestAuxUnwinder : public Unwinder {
 // frames.
 // If we're running the ChromeOS unit tests on Linux, this test will never pass
 // because Ubuntu's libc isn't compiled with frame pointers. Skip if not a real
-// ChromeOS device.
-#if (defined(ADDRESS_SANITIZER) && BUILDFLAG(IS_APPLE)) || \
-    BUILDFLAG(IS_ANDROID) ||                               \
-    (BUILDFLAG(IS_CHROMEOS) && !BUILDFLAG(IS_CHROMEOS_DEVICE))
+// ChromeOS device, and on Linux for the same reason.
+#if (defined(ADDRESS_SANITIZER) && BUILDFLAG(IS_APPLE)) ||        \
+    BUILDFLAG(IS_ANDROID) ||                                      \
+    (BUILDFLAG(IS_CHROMEOS) && !BUILDFLAG(IS_CHROMEOS_DEVICE)) || \
+    BUILDFLAG(IS_LINUX)
 #define MAYBE_Alloca DISABLED_Alloca
 #else
 #define MAYBE_Alloca Alloca
@@ -528,12 +534,13 @@ PROFILER_TEST_F(StackSamplingProfilerTest, MAYBE_Alloca) {
 // ASAN. This is now disabled because the android-asan bot fails.
 // If we're running the ChromeOS unit tests on Linux, this test will never pass
 // because Ubuntu's libc isn't compiled with frame pointers. Skip if not a real
-// ChromeOS device.
+// ChromeOS device, and on Linux for the same reason.
 #if (defined(ADDRESS_SANITIZER) && BUILDFLAG(IS_APPLE)) ||         \
     BUILDFLAG(IS_IOS) ||                                           \
     (BUILDFLAG(IS_ANDROID) && BUILDFLAG(EXCLUDE_UNWIND_TABLES)) || \
     (BUILDFLAG(IS_ANDROID) && defined(ADDRESS_SANITIZER)) ||       \
-    (BUILDFLAG(IS_CHROMEOS) && !BUILDFLAG(IS_CHROMEOS_DEVICE))
+    (BUILDFLAG(IS_CHROMEOS) && !BUILDFLAG(IS_CHROMEOS_DEVICE)) ||  \
+    BUILDFLAG(IS_LINUX)
 #define MAYBE_OtherLibrary DISABLED_OtherLibrary
 #else
 #define MAYBE_OtherLibrary OtherLibrary
@@ -559,11 +566,12 @@ PROFILER_TEST_F(StackSamplingProfilerTest, MAYBE_OtherLibrary) {
 // ASAN. This is now disabled because the android-asan bot fails.
 // If we're running the ChromeOS unit tests on Linux, this test will never pass
 // because Ubuntu's libc isn't compiled with frame pointers. Skip if not a real
-// ChromeOS device.
+// ChromeOS device, and on Linux for the same reason.
 #if BUILDFLAG(IS_APPLE) ||                                         \
     (BUILDFLAG(IS_ANDROID) && BUILDFLAG(EXCLUDE_UNWIND_TABLES)) || \
     (BUILDFLAG(IS_ANDROID) && defined(ADDRESS_SANITIZER)) ||       \
-    (BUILDFLAG(IS_CHROMEOS) && !BUILDFLAG(IS_CHROMEOS_DEVICE))
+    (BUILDFLAG(IS_CHROMEOS) && !BUILDFLAG(IS_CHROMEOS_DEVICE)) ||  \
+    BUILDFLAG(IS_LINUX)
 #define MAYBE_UnloadingLibrary DISABLED_UnloadingLibrary
 #else
 #define MAYBE_UnloadingLibrary UnloadingLibrary
@@ -578,10 +586,11 @@ PROFILER_TEST_F(StackSamplingProfilerTest, MAYBE_UnloadingLibrary) {
 // Android is not supported since modules are found before unwinding.
 // If we're running the ChromeOS unit tests on Linux, this test will never pass
 // because Ubuntu's libc isn't compiled with frame pointers. Skip if not a real
-// ChromeOS device.
-#if (defined(ADDRESS_SANITIZER) && BUILDFLAG(IS_APPLE)) || \
-    BUILDFLAG(IS_ANDROID) || BUILDFLAG(IS_IOS) ||          \
-    (BUILDFLAG(IS_CHROMEOS) && !BUILDFLAG(IS_CHROMEOS_DEVICE))
+// ChromeOS device, and on Linux for the same reason.
+#if (defined(ADDRESS_SANITIZER) && BUILDFLAG(IS_APPLE)) ||        \
+    BUILDFLAG(IS_ANDROID) || BUILDFLAG(IS_IOS) ||                 \
+    (BUILDFLAG(IS_CHROMEOS) && !BUILDFLAG(IS_CHROMEOS_DEVICE)) || \
+    BUILDFLAG(IS_LINUX)
 #define MAYBE_UnloadedLibrary DISABLED_UnloadedLibrary
 #else
 #define MAYBE_UnloadedLibrary UnloadedLibrary
@@ -24,6 +24,7 @@
 #include "base/check_op.h"
 #include "base/no_destructor.h"
 #include "base/strings/string_util_internal.h"
+#include "base/strings/string_util_simd.h"
 #include "base/strings/utf_string_conversion_utils.h"
 #include "base/strings/utf_string_conversions.h"
 #include "base/third_party/icu/icu_utf.h"
@@ -234,11 +235,11 @@ bool ContainsOnlyChars(StringPiece16 input, StringPiece16 characters) {
 
 
 bool IsStringASCII(StringPiece str) {
-  return internal::DoIsStringASCII(str.data(), str.length());
+  return internal::FindFirstNonASCII(str) == str.length();
 }
 
 bool IsStringASCII(StringPiece16 str) {
-  return internal::DoIsStringASCII(str.data(), str.length());
+  return internal::FindFirstNonASCII(str) == str.length();
 }
 
 #if defined(WCHAR_T_IS_UTF32)
@@ -5,6 +5,9 @@
 #ifndef BASE_STRINGS_STRING_UTIL_INTERNAL_H_
 #define BASE_STRINGS_STRING_UTIL_INTERNAL_H_
 
+#include <stdint.h>
+#include <string.h>
+
 #include <algorithm>
 
 #include "base/check.h"
@@ -13,6 +16,7 @@
 #include "base/notreached.h"
 #include "base/ranges/algorithm.h"
 #include "base/strings/string_piece.h"
+#include "base/strings/string_util_simd.h"
 #include "base/third_party/icu/icu_utf.h"
 
 namespace base {
@@ -234,6 +238,20 @@ inline bool DoIsStringUTF8(StringPiece str) {
   size_t char_index = 0;
 
   while (char_index < src_len) {
+    // ASCII is always valid. Runs of at least a word of it are skipped with
+    // the vector kernel, and shorter ones a byte at a time.
+    if (src[char_index] < 0x80) {
+      uint64_t word;
+      if (src_len - char_index >= sizeof(word)) {
+        memcpy(&word, src + char_index, sizeof(word));
+        if (!(word & 0x8080808080808080ULL)) {
+          char_index += FindFirstNonASCII(str.substr(char_index));
+          continue;
+        }
+      }
+      ++char_index;
+      continue;
+    }
     base_icu::UChar32 code_point;
     CBU8_NEXT(src, char_index, src_len, code_point);
     if (!Validator(code_point))
@@ -5,7 +5,9 @@
 #include "base/strings/string_util.h"
 
 #include <cinttypes>
+#include <string>
 
+#include "base/strings/utf_string_conversions.h"
 #include "base/time/time.h"
 #include "build/build_config.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -43,4 +45,67 @@ TEST(StringUtilTest, DISABLED_IsStringASCIIPerf) {
   }
 }
 
+// Builds a string of |str_length| ASCII characters, or of mostly ASCII text
+// with a two-byte character every |non_ascii_interval| bytes.
+std::string MakeUTF8String(size_t str_length, size_t non_ascii_interval) {
+  std::string str;
+  while (str.length() + 2 <= str_length) {
+    if (non_ascii_interval && str.length() % non_ascii_interval == 0)
+      str += "\xC3\xA9";
+    else
+      str += 'A';
+  }
+  str.resize(str_length, 'A');
+  return str;
+}
+
+void MeasureIsStringUTF8(size_t str_length, size_t non_ascii_interval) {
+  const std::string str = MakeUTF8String(str_length, non_ascii_interval);
+  TimeTicks t0 = TimeTicks::Now();
+  for (size_t i = 0; i < 1000000; ++i)
+    IsStringUTF8(str);
+  TimeDelta time = TimeTicks::Now() - t0;
+  printf("length:\t%zu\tnon-ascii-interval:\t%zu\ttime-ms:\t%" PRIu64 "\n",
+         str_length, non_ascii_interval, time.InMilliseconds());
+}
+
+void MeasureUTFConversions(size_t str_length, size_t non_ascii_interval) {
+  const std::string utf8 = MakeUTF8String(str_length, non_ascii_interval);
+  const std::u16string utf16 = UTF8ToUTF16(utf8);
+  std::u16string converted16;
+  std::string converted8;
+
+  TimeTicks t0 = TimeTicks::Now();
+  for (size_t i = 0; i < 1000000; ++i)
+    UTF8ToUTF16(utf8.data(), utf8.length(), &converted16);
+  TimeDelta utf8_to_utf16_time = TimeTicks::Now() - t0;
+
+  t0 = TimeTicks::Now();
+  for (size_t i = 0; i < 1000000; ++i)
+    UTF16ToUTF8(utf16.data(), utf16.length(), &converted8);
+  TimeDelta utf16_to_utf8_time = TimeTicks::Now() - t0;
+
+  printf("length:\t%zu\tnon-ascii-interval:\t%zu\tutf8-to-utf16-ms:\t%" PRIu64
+         "\tutf16-to-utf8-ms:\t%" PRIu64 "\n",
+         str_length, non_ascii_interval, utf8_to_utf16_time.InMilliseconds(),
+         utf16_to_utf8_time.InMilliseconds());
+}
+
+// An interval of 0 means the text is all ASCII.
+constexpr size_t kNonASCIIIntervals[] = {0, 64, 8};
+
+TEST(StringUtilTest, DISABLED_IsStringUTF8Perf) {
+  for (size_t str_length = 16; str_length <= 4096; str_length *= 4) {
+    for (size_t non_ascii_interval : kNonASCIIIntervals)
+      MeasureIsStringUTF8(str_length, non_ascii_interval);
+  }
+}
+
+TEST(StringUtilTest, DISABLED_UTFConversionsPerf) {
+  for (size_t str_length = 16; str_length <= 4096; str_length *= 4) {
+    for (size_t non_ascii_interval : kNonASCIIIntervals)
+      MeasureUTFConversions(str_length, non_ascii_interval);
+  }
+}
+
 }  // namespace base
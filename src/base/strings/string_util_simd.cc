@@ -0,0 +1,303 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/strings/string_util_simd.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <type_traits>
+
+#include "base/bits.h"
+#include "build/build_config.h"
+
+#if defined(ARCH_CPU_X86_64)
+#include <immintrin.h>
+
+#include "base/cpu.h"
+#endif
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#if defined(ARCH_CPU_ARM64)
+#include <arm_neon.h>
+#endif
+
+namespace base {
+namespace internal {
+
+namespace {
+
+template <typename Char>
+constexpr bool IsASCIIChar(Char c) {
+  return static_cast<std::make_unsigned_t<Char>>(c) < 0x80;
+}
+
+// Scalar kernels. These finish the tail of the vector loops, and are all
+// there is on other architectures. Both start at index |i|.
+
+template <typename Char>
+size_t FindFirstNonASCIIScalar(const Char* chars, size_t length, size_t i) {
+  // The bits that are set in a word of |Char|s when any of them is not ASCII.
+  constexpr uint64_t kNonASCIIMask =
+      sizeof(Char) == 1 ? 0x8080808080808080ULL : 0xFF80FF80FF80FF80ULL;
+  constexpr size_t kCharsPerWord = sizeof(uint64_t) / sizeof(Char);
+  for (; length - i >= kCharsPerWord; i += kCharsPerWord) {
+    uint64_t word;
+    memcpy(&word, chars + i, sizeof(word));
+    if (word & kNonASCIIMask)
+      break;
+  }
+  while (i < length && IsASCIIChar(chars[i]))
+    ++i;
+  return i;
+}
+
+template <typename SrcChar, typename DestChar>
+size_t CopyASCIIPrefixScalar(const SrcChar* src,
+                             size_t length,
+                             size_t i,
+                             DestChar* dest) {
+  for (; i < length && IsASCIIChar(src[i]); ++i)
+    dest[i] = static_cast<DestChar>(src[i]);
+  return i;
+}
+
+#ifdef __SSE2__
+
+size_t FindFirstNonASCIISSE2(const char* chars, size_t length) {
+  size_t i = 0;
+  for (; length - i >= 16; i += 16) {
+    const __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(chars + i));
+    // The mask holds the top bit of each byte, which is set for non-ASCII.
+    const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(chunk));
+    if (mask)
+      return i + bits::CountTrailingZeroBits(mask);
+  }
+  return FindFirstNonASCIIScalar(chars, length, i);
+}
+
+size_t FindFirstNonASCIISSE2(const char16_t* chars, size_t length) {
+  const __m128i non_ascii_bits = _mm_set1_epi16(static_cast<short>(0xFF80));
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+  for (; length - i >= 8; i += 8) {
+    const __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(chars + i));
+    const __m128i ascii =
+        _mm_cmpeq_epi16(_mm_and_si128(chunk, non_ascii_bits), zero);
+    // Two mask bits per character.
+    const uint32_t mask =
+        ~static_cast<uint32_t>(_mm_movemask_epi8(ascii)) & 0xffffu;
+    if (mask)
+      return i + bits::CountTrailingZeroBits(mask) / 2;
+  }
+  return FindFirstNonASCIIScalar(chars, length, i);
+}
+
+size_t CopyASCIIPrefixSSE2(const char* src, size_t length, char16_t* dest) {
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+  for (; length - i >= 16; i += 16) {
+    const __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    if (_mm_movemask_epi8(chunk))
+      break;
+    // Interleaving with zero bytes widens each byte to 16 bits.
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i),
+                     _mm_unpacklo_epi8(chunk, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i + 8),
+                     _mm_unpackhi_epi8(chunk, zero));
+  }
+  return CopyASCIIPrefixScalar(src, length, i, dest);
+}
+
+size_t CopyASCIIPrefixSSE2(const char16_t* src, size_t length, char* dest) {
+  const __m128i non_ascii_bits = _mm_set1_epi16(static_cast<short>(0xFF80));
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+  for (; length - i >= 16; i += 16) {
+    const __m128i low =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    const __m128i high =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8));
+    const __m128i ascii = _mm_cmpeq_epi16(
+        _mm_and_si128(_mm_or_si128(low, high), non_ascii_bits), zero);
+    if (_mm_movemask_epi8(ascii) != 0xffff)
+      break;
+    // Every character fits in a byte, so saturation never kicks in.
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i),
+                     _mm_packus_epi16(low, high));
+  }
+  return CopyASCIIPrefixScalar(src, length, i, dest);
+}
+
+#endif  // __SSE2__
+
+#if defined(ARCH_CPU_X86_64)
+
+// Strings shorter than this are scanned with SSE2, since the wider AVX2 loop
+// would barely run.
+constexpr size_t kMinAVX2Length = 64;
+
+bool CanUseAVX2() {
+  static const bool can_use_avx2 = CPU::GetInstanceNoAllocation().has_avx2();
+  return can_use_avx2;
+}
+
+__attribute__((target("avx2"))) size_t FindFirstNonASCIIAVX2(
+    const char* chars,
+    size_t length) {
+  size_t i = 0;
+  // Check two vectors per iteration, and only find the exact position once a
+  // non-ASCII byte shows up.
+  for (; length - i >= 64; i += 64) {
+    const __m256i low =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(chars + i));
+    const __m256i high =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(chars + i + 32));
+    if (_mm256_movemask_epi8(_mm256_or_si256(low, high)))
+      break;
+  }
+  for (; length - i >= 32; i += 32) {
+    const __m256i chunk =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(chars + i));
+    const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(chunk));
+    if (mask)
+      return i + bits::CountTrailingZeroBits(mask);
+  }
+  return i + FindFirstNonASCIISSE2(chars + i, length - i);
+}
+
+__attribute__((target("avx2"))) size_t FindFirstNonASCIIAVX2(
+    const char16_t* chars,
+    size_t length) {
+  const __m256i non_ascii_bits = _mm256_set1_epi16(static_cast<short>(0xFF80));
+  const __m256i zero = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; length - i >= 16; i += 16) {
+    const __m256i chunk =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(chars + i));
+    const __m256i ascii =
+        _mm256_cmpeq_epi16(_mm256_and_si256(chunk, non_ascii_bits), zero);
+    // Two mask bits per character.
+    const uint32_t mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(ascii));
+    if (mask)
+      return i + bits::CountTrailingZeroBits(mask) / 2;
+  }
+  return i + FindFirstNonASCIISSE2(chars + i, length - i);
+}
+
+#endif  // defined(ARCH_CPU_X86_64)
+
+#if defined(ARCH_CPU_ARM64)
+
+size_t FindFirstNonASCIINEON(const char* chars, size_t length) {
+  size_t i = 0;
+  for (; length - i >= 16; i += 16) {
+    const uint8x16_t chunk =
+        vld1q_u8(reinterpret_cast<const uint8_t*>(chars + i));
+    if (vmaxvq_u8(chunk) >= 0x80)
+      break;
+  }
+  return FindFirstNonASCIIScalar(chars, length, i);
+}
+
+size_t FindFirstNonASCIINEON(const char16_t* chars, size_t length) {
+  size_t i = 0;
+  for (; length - i >= 8; i += 8) {
+    const uint16x8_t chunk =
+        vld1q_u16(reinterpret_cast<const uint16_t*>(chars + i));
+    if (vmaxvq_u16(chunk) >= 0x80)
+      break;
+  }
+  return FindFirstNonASCIIScalar(chars, length, i);
+}
+
+size_t CopyASCIIPrefixNEON(const char* src, size_t length, char16_t* dest) {
+  size_t i = 0;
+  for (; length - i >= 16; i += 16) {
+    const uint8x16_t chunk =
+        vld1q_u8(reinterpret_cast<const uint8_t*>(src + i));
+    if (vmaxvq_u8(chunk) >= 0x80)
+      break;
+    uint16_t* out = reinterpret_cast<uint16_t*>(dest + i);
+    vst1q_u16(out, vmovl_u8(vget_low_u8(chunk)));
+    vst1q_u16(out + 8, vmovl_high_u8(chunk));
+  }
+  return CopyASCIIPrefixScalar(src, length, i, dest);
+}
+
+size_t CopyASCIIPrefixNEON(const char16_t* src, size_t length, char* dest) {
+  size_t i = 0;
+  for (; length - i >= 16; i += 16) {
+    const uint16x8_t low =
+        vld1q_u16(reinterpret_cast<const uint16_t*>(src + i));
+    const uint16x8_t high =
+        vld1q_u16(reinterpret_cast<const uint16_t*>(src + i + 8));
+    if (vmaxvq_u16(vorrq_u16(low, high)) >= 0x80)
+      break;
+    vst1q_u8(reinterpret_cast<uint8_t*>(dest + i),
+             vcombine_u8(vmovn_u16(low), vmovn_u16(high)));
+  }
+  return CopyASCIIPrefixScalar(src, length, i, dest);
+}
+
+#endif  // defined(ARCH_CPU_ARM64)
+
+}  // namespace
+
+size_t FindFirstNonASCII(StringPiece str) {
+#if defined(ARCH_CPU_X86_64)
+  if (str.size() >= kMinAVX2Length && CanUseAVX2())
+    return FindFirstNonASCIIAVX2(str.data(), str.size());
+#endif
+#if defined(__SSE2__)
+  return FindFirstNonASCIISSE2(str.data(), str.size());
+#elif defined(ARCH_CPU_ARM64)
+  return FindFirstNonASCIINEON(str.data(), str.size());
+#else
+  return FindFirstNonASCIIScalar(str.data(), str.size(), 0);
+#endif
+}
+
+size_t FindFirstNonASCII(StringPiece16 str) {
+#if defined(ARCH_CPU_X86_64)
+  if (str.size() >= kMinAVX2Length / 2 && CanUseAVX2())
+    return FindFirstNonASCIIAVX2(str.data(), str.size());
+#endif
+#if defined(__SSE2__)
+  return FindFirstNonASCIISSE2(str.data(), str.size());
+#elif defined(ARCH_CPU_ARM64)
+  return FindFirstNonASCIINEON(str.data(), str.size());
+#else
+  return FindFirstNonASCIIScalar(str.data(), str.size(), 0);
+#endif
+}
+
+size_t CopyASCIIPrefix(StringPiece src, char16_t* dest) {
+#if defined(__SSE2__)
+  return CopyASCIIPrefixSSE2(src.data(), src.size(), dest);
+#elif defined(ARCH_CPU_ARM64)
+  return CopyASCIIPrefixNEON(src.data(), src.size(), dest);
+#else
+  return CopyASCIIPrefixScalar(src.data(), src.size(), 0, dest);
+#endif
+}
+
+size_t CopyASCIIPrefix(StringPiece16 src, char* dest) {
+#if defined(__SSE2__)
+  return CopyASCIIPrefixSSE2(src.data(), src.size(), dest);
+#elif defined(ARCH_CPU_ARM64)
+  return CopyASCIIPrefixNEON(src.data(), src.size(), dest);
+#else
+  return CopyASCIIPrefixScalar(src.data(), src.size(), 0, dest);
+#endif
+}
+
+}  // namespace internal
+}  // namespace base
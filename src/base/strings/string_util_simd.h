@@ -0,0 +1,39 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Vectorized kernels for finding and copying runs of ASCII characters. These
+// are the building blocks of IsStringASCII(), IsStringUTF8() and the UTF-8 <->
+// UTF-16 conversions, which spend most of their time on ASCII text.
+//
+// The kernels use SSE2 on x86 (and AVX2 on x86-64 CPUs that support it,
+// detected at runtime with base::CPU) and NEON on ARM64, with a word-at-a-time
+// fallback elsewhere. Callers should use the functions in string_util.h and
+// utf_string_conversions.h rather than these.
+
+#ifndef BASE_STRINGS_STRING_UTIL_SIMD_H_
+#define BASE_STRINGS_STRING_UTIL_SIMD_H_
+
+#include <stddef.h>
+
+#include "base/base_export.h"
+#include "base/strings/string_piece.h"
+
+namespace base {
+namespace internal {
+
+// Returns the index of the first non-ASCII character of |str|, or its length
+// if it is all ASCII.
+BASE_EXPORT size_t FindFirstNonASCII(StringPiece str);
+BASE_EXPORT size_t FindFirstNonASCII(StringPiece16 str);
+
+// Copies the leading ASCII characters of |src| to |dest|, converting them to
+// the other character width, and returns how many were copied. |dest| must
+// have room for |src.size()| characters.
+BASE_EXPORT size_t CopyASCIIPrefix(StringPiece src, char16_t* dest);
+BASE_EXPORT size_t CopyASCIIPrefix(StringPiece16 src, char* dest);
+
+}  // namespace internal
+}  // namespace base
+
+#endif  // BASE_STRINGS_STRING_UTIL_SIMD_H_
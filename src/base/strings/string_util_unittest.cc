@@ -591,6 +591,46 @@ TEST(StringUtilTest, IsStringASCII) {
 #endif  // WCHAR_T_IS_UTF32
 }
 
+TEST(StringUtilTest, IsStringASCIILongStrings) {
+  // Long enough for every vector width, with a tail that is not a multiple of
+  // any of them.
+  constexpr size_t kLength = 203;
+  std::string str(kLength, 'a');
+  std::u16string str16(kLength, 'a');
+  EXPECT_TRUE(IsStringASCII(str));
+  EXPECT_TRUE(IsStringASCII(str16));
+  for (size_t pos = 0; pos < kLength; ++pos) {
+    str[pos] = '\x80';
+    EXPECT_FALSE(IsStringASCII(str)) << pos;
+    EXPECT_TRUE(IsStringASCII(StringPiece(str).substr(0, pos))) << pos;
+    str[pos] = 'a';
+
+    str16[pos] = 0x100;
+    EXPECT_FALSE(IsStringASCII(str16)) << pos;
+    EXPECT_TRUE(IsStringASCII(StringPiece16(str16).substr(0, pos))) << pos;
+    str16[pos] = 'a';
+  }
+}
+
+TEST(StringUtilTest, IsStringUTF8LongStrings) {
+  constexpr size_t kLength = 203;
+  for (size_t pos = 0; pos + 2 < kLength; ++pos) {
+    // A valid multi-byte character surrounded by ASCII runs.
+    std::string str(kLength, 'a');
+    str.replace(pos, 3, "\xE4\xBD\xA0");
+    EXPECT_TRUE(IsStringUTF8(str)) << pos;
+
+    // A truncated one.
+    str[pos + 2] = 'a';
+    EXPECT_FALSE(IsStringUTF8(str)) << pos;
+
+    // A noncharacter.
+    str.replace(pos, 3, "\xEF\xBF\xBF");
+    EXPECT_FALSE(IsStringUTF8(str)) << pos;
+    EXPECT_TRUE(IsStringUTF8AllowingNoncharacters(str)) << pos;
+  }
+}
+
 TEST(StringUtilTest, ConvertASCII) {
   static const char* const char_cases[] = {
     "Google Video",
@@ -12,6 +12,7 @@
 
 #include "base/strings/string_piece.h"
 #include "base/strings/string_util.h"
+#include "base/strings/string_util_simd.h"
 #include "base/strings/utf_string_conversion_utils.h"
 #include "base/third_party/icu/icu_utf.h"
 #include "build/build_config.h"
@@ -91,6 +92,29 @@ void UnicodeAppendUnsafe(Char* out,
   out[(*size)++] = static_cast<Char>(code_point);
 }
 
+// CopyASCIIRun ---------------------------------------------------------------
+// Function overloads that copy the leading ASCII codeunits of src to dest and
+// return how many were copied. The UTF-8 <-> UTF-16 cases are vectorized.
+
+template <typename SrcChar, typename DestChar>
+size_t CopyASCIIRun(const SrcChar* src, size_t src_len, DestChar* dest) {
+  size_t i = 0;
+  while (i < src_len &&
+         static_cast<std::make_unsigned_t<SrcChar>>(src[i]) < 0x80) {
+    dest[i] = static_cast<DestChar>(src[i]);
+    ++i;
+  }
+  return i;
+}
+
+size_t CopyASCIIRun(const char* src, size_t src_len, char16_t* dest) {
+  return internal::CopyASCIIPrefix(StringPiece(src, src_len), dest);
+}
+
+size_t CopyASCIIRun(const char16_t* src, size_t src_len, char* dest) {
+  return internal::CopyASCIIPrefix(StringPiece16(src, src_len), dest);
+}
+
 // DoUTFConversion ------------------------------------------------------------
 // Main driver of UTFConversion specialized for different Src encodings.
 // dest has to have enough room for the converted text.
@@ -103,6 +127,15 @@ bool DoUTFConversion(const char* src,
   bool success = true;
 
   for (size_t i = 0; i < src_len;) {
+    // Text is mostly ASCII, which converts one to one.
+    if (static_cast<uint8_t>(src[i]) < 0x80) {
+      const size_t ascii_len =
+          CopyASCIIRun(src + i, src_len - i, dest + *dest_len);
+      i += ascii_len;
+      *dest_len += ascii_len;
+      continue;
+    }
+
     base_icu::UChar32 code_point;
     CBU8_NEXT(reinterpret_cast<const uint8_t*>(src), i, src_len, code_point);
 
@@ -137,6 +170,15 @@ bool DoUTFConversion(const char16_t* src,
   // Always have another symbol in order to avoid checking boundaries in the
   // middle of the surrogate pair.
   while (i + 1 < src_len) {
+    // Text is mostly ASCII, which converts one to one.
+    if (src[i] < 0x80) {
+      const size_t ascii_len =
+          CopyASCIIRun(src + i, src_len - i, dest + *dest_len);
+      i += ascii_len;
+      *dest_len += ascii_len;
+      continue;
+    }
+
     base_icu::UChar32 code_point;
 
     if (CBU16_IS_LEAD(src[i]) && CBU16_IS_TRAIL(src[i + 1])) {
@@ -191,23 +233,25 @@ bool DoUTFConversion(const wchar_t* src,
 
 template <typename InputString, typename DestString>
 bool UTFConversion(const InputString& src_str, DestString* dest_str) {
-  if (IsStringASCII(src_str)) {
-    dest_str->assign(src_str.begin(), src_str.end());
+  const size_t src_len = src_str.length();
+
+  // Most text is ASCII, which converts one to one, so start by copying the
+  // ASCII prefix into a string of the same length. operator[] is fine to call
+  // on an empty string.
+  dest_str->resize(src_len);
+  size_t dest_len = CopyASCIIRun(src_str.data(), src_len, &(*dest_str)[0]);
+  if (dest_len == src_len)
     return true;
-  }
 
-  dest_str->resize(src_str.length() *
+  dest_str->resize(src_len *
                    size_coefficient_v<typename InputString::value_type,
                                       typename DestString::value_type>);
-
-  // Empty string is ASCII => it OK to call operator[].
   auto* dest = &(*dest_str)[0];
 
-  // ICU requires 32 bit numbers.
-  size_t src_len = src_str.length();
-  size_t dest_len = 0;
-
-  bool res = DoUTFConversion(src_str.data(), src_len, dest, &dest_len);
+  // Each ASCII codeunit became one destination codeunit, so |dest_len| is
+  // also the number of source codeunits consumed.
+  bool res = DoUTFConversion(src_str.data() + dest_len, src_len - dest_len,
+                             dest, &dest_len);
 
   dest_str->resize(dest_len);
   dest_str->shrink_to_fit();
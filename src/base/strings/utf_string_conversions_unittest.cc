@@ -179,6 +179,46 @@ TEST(UTFStringConversionsTest, ConvertUTF32ToUTF8) {
 }
 #endif  // defined(WCHAR_T_IS_UTF32)
 
+TEST(UTFStringConversionsTest, ConvertMixedASCIIRuns) {
+  // ASCII runs of every length up to a few vector widths, separated by
+  // multi-byte characters.
+  std::string utf8;
+  std::u16string utf16;
+  for (size_t run = 0; run < 70; ++run) {
+    utf8.append(run, 'x');
+    utf16.append(run, 'x');
+    if (run % 2) {
+      utf8 += "\xE4\xBD\xA0";
+      utf16 += u'\x4f60';
+    } else {
+      utf8 += "\xF0\x90\x8C\x80";
+      utf16 += u"\xd800\xdf00";
+    }
+  }
+  EXPECT_EQ(utf16, UTF8ToUTF16(utf8));
+  EXPECT_EQ(utf8, UTF16ToUTF8(utf16));
+
+  // Invalid input in the middle of a long ASCII run is still replaced.
+  std::string invalid_utf8(100, 'x');
+  invalid_utf8[50] = '\xFF';
+  std::u16string expected_utf16(100, 'x');
+  expected_utf16[50] = 0xFFFD;
+  std::u16string converted_utf16;
+  EXPECT_FALSE(
+      UTF8ToUTF16(invalid_utf8.data(), invalid_utf8.size(), &converted_utf16));
+  EXPECT_EQ(expected_utf16, converted_utf16);
+
+  std::u16string invalid_utf16(100, 'x');
+  invalid_utf16[50] = 0xd800;
+  std::string expected_utf8(50, 'x');
+  expected_utf8 += "\xEF\xBF\xBD";
+  expected_utf8.append(49, 'x');
+  std::string converted_utf8;
+  EXPECT_FALSE(UTF16ToUTF8(invalid_utf16.data(), invalid_utf16.size(),
+                           &converted_utf8));
+  EXPECT_EQ(expected_utf8, converted_utf8);
+}
+
 TEST(UTFStringConversionsTest, ConvertMultiString) {
   static char16_t multi16[] = {'f',  'o', 'o', '\0', 'b',  'a', 'r',
                                '\0', 'b', 'a', 'z',  '\0', '\0'};
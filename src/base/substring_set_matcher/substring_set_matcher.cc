@@ -5,9 +5,11 @@
 #include "base/substring_set_matcher/substring_set_matcher.h"
 
 #include <stddef.h>
+#include <string.h>
 
 #include <algorithm>
 #include <queue>
+#include <utility>
 
 #ifdef __SSE2__
 #include <immintrin.h>
@@ -17,6 +19,7 @@
 #include "base/check_op.h"
 #include "base/containers/contains.h"
 #include "base/containers/queue.h"
+#include "base/files/memory_mapped_file.h"
 #include "base/numerics/checked_math.h"
 #include "base/trace_event/memory_usage_estimator.h"  // no-presubmit-check
 
@@ -41,6 +44,51 @@ std::vector<const MatcherStringPattern*> GetVectorOfPointers(
   return pattern_pointers;
 }
 
+// The header of a serialized tree. It is followed by the serialized
+// TeddyPrefilter, then by the arrays of the flat tree: the root edges, the
+// nodes, the edges and the outputs. All of them have a size which is a
+// multiple of 4, and hold 4-byte aligned elements, so that they are aligned
+// in a mapped file.
+struct SerializedHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t is_empty;
+  uint32_t num_nodes;
+  uint32_t num_edges;
+  uint32_t num_outputs;
+};
+
+constexpr uint32_t kSerializedMagic = 0x41535353;  // "SSSA"
+constexpr uint32_t kSerializedVersion = 1;
+
+static_assert(TeddyPrefilter::kSerializedSize % sizeof(uint32_t) == 0,
+              "Serialized arrays must stay aligned");
+
+template <typename T>
+void AppendArray(span<const T> array, std::string* output) {
+  output->append(reinterpret_cast<const char*>(array.data()),
+                 array.size_bytes());
+}
+
+// Points |array| to the |size| elements at |*offset| in |data|, and advances
+// |*offset| past them. Returns false if |data| is too short.
+template <typename T>
+bool ReadArray(span<const uint8_t> data,
+               size_t* offset,
+               size_t size,
+               span<const T>* array) {
+  static_assert(alignof(T) <= sizeof(uint32_t), "Elements must stay aligned");
+  size_t end;
+  if (!CheckAdd(*offset, CheckMul(size, sizeof(T))).AssignIfValid(&end) ||
+      end > data.size()) {
+    return false;
+  }
+  *array = span<const T>(reinterpret_cast<const T*>(data.data() + *offset),
+                         size);
+  *offset = end;
+  return true;
+}
+
 }  // namespace
 
 bool SubstringSetMatcher::Build(
@@ -85,6 +133,8 @@ bool SubstringSetMatcher::Build(
   DCHECK_EQ(tree_.size(), static_cast<size_t>(GetTreeSize(patterns)));
 
   is_empty_ = patterns.empty() && tree_.size() == 1u;
+  BuildFlatTree();
+  prefilter_.Build(patterns);
   return true;
 }
 
@@ -96,31 +146,20 @@ bool SubstringSetMatcher::Match(
   const size_t old_number_of_matches = matches->size();
 
   // Handle patterns matching the empty string.
-  const AhoCorasickNode* const root = &tree_[kRootID];
-  AccumulateMatchesForNode(root, matches);
-
-  const AhoCorasickNode* current_node = root;
-  for (const char c : text) {
-    NodeID child = current_node->GetEdge(static_cast<unsigned char>(c));
-
-    // If the child not can't be found, progressively iterate over the longest
-    // proper suffix of the string represented by the current node. In a sense
-    // we are pruning prefixes from the text.
-    while (child == kInvalidNodeID && current_node != root) {
-      current_node = &tree_[current_node->failure()];
-      child = current_node->GetEdge(static_cast<unsigned char>(c));
-    }
-
-    if (child != kInvalidNodeID) {
-      // The string represented by |child| is the longest possible suffix of the
-      // current position of |text| in the trie.
-      current_node = &tree_[child];
-      AccumulateMatchesForNode(current_node, matches);
-    } else {
-      // The empty string is the longest possible suffix of the current position
-      // of |text| in the trie.
-      DCHECK_EQ(root, current_node);
+  AccumulateMatchesForNode(kRootID, matches);
+
+  NodeID current_node = kRootID;
+  for (size_t i = 0; i < text.size(); ++i) {
+    // At the root, no match is in progress, so the text can be skipped up to
+    // the next position where a match may start.
+    if (current_node == kRootID) {
+      i = SkipFromRoot(text, i);
+      if (i == text.size())
+        break;
     }
+    current_node =
+        Transition(current_node, static_cast<unsigned char>(text[i]));
+    AccumulateMatchesForNode(current_node, matches);
   }
 
   return old_number_of_matches != matches->size();
@@ -128,34 +167,21 @@ bool SubstringSetMatcher::Match(
 
 bool SubstringSetMatcher::AnyMatch(const std::string& text) const {
   // Handle patterns matching the empty string.
-  const AhoCorasickNode* const root = &tree_[kRootID];
-  if (root->has_outputs()) {
+  if (flat_nodes_[kRootID].has_outputs()) {
     return true;
   }
 
-  const AhoCorasickNode* current_node = root;
-  for (const char c : text) {
-    NodeID child = current_node->GetEdge(static_cast<unsigned char>(c));
-
-    // If the child not can't be found, progressively iterate over the longest
-    // proper suffix of the string represented by the current node. In a sense
-    // we are pruning prefixes from the text.
-    while (child == kInvalidNodeID && current_node != root) {
-      current_node = &tree_[current_node->failure()];
-      child = current_node->GetEdge(static_cast<unsigned char>(c));
+  NodeID current_node = kRootID;
+  for (size_t i = 0; i < text.size(); ++i) {
+    if (current_node == kRootID) {
+      i = SkipFromRoot(text, i);
+      if (i == text.size())
+        break;
     }
-
-    if (child != kInvalidNodeID) {
-      // The string represented by |child| is the longest possible suffix of the
-      // current position of |text| in the trie.
-      current_node = &tree_[child];
-      if (current_node->has_outputs()) {
-        return true;
-      }
-    } else {
-      // The empty string is the longest possible suffix of the current position
-      // of |text| in the trie.
-      DCHECK_EQ(root, current_node);
+    current_node =
+        Transition(current_node, static_cast<unsigned char>(text[i]));
+    if (flat_nodes_[current_node].has_outputs()) {
+      return true;
     }
   }
 
@@ -163,7 +189,117 @@ bool SubstringSetMatcher::AnyMatch(const std::string& text) const {
 }
 
 size_t SubstringSetMatcher::EstimateMemoryUsage() const {
-  return base::trace_event::EstimateMemoryUsage(tree_);
+  return base::trace_event::EstimateMemoryUsage(tree_) +
+         base::trace_event::EstimateMemoryUsage(flat_nodes_storage_) +
+         base::trace_event::EstimateMemoryUsage(flat_edges_storage_) +
+         base::trace_event::EstimateMemoryUsage(root_edges_storage_) +
+         base::trace_event::EstimateMemoryUsage(flat_outputs_storage_);
+}
+
+void SubstringSetMatcher::Serialize(std::string* output) const {
+  DCHECK(!flat_nodes_.empty());
+  static_assert(sizeof(FlatNode) == 12 && sizeof(AhoCorasickEdge) == 4 &&
+                    sizeof(FlatOutputs) == 8,
+                "Serialized types must be packed");
+
+  const SerializedHeader header = {
+      kSerializedMagic,
+      kSerializedVersion,
+      is_empty_,
+      static_cast<uint32_t>(flat_nodes_.size()),
+      static_cast<uint32_t>(flat_edges_.size()),
+      static_cast<uint32_t>(flat_outputs_.size())};
+  output->append(reinterpret_cast<const char*>(&header), sizeof(header));
+  prefilter_.Serialize(output);
+  AppendArray(root_edges_, output);
+  AppendArray(flat_nodes_, output);
+  AppendArray(flat_edges_, output);
+  AppendArray(flat_outputs_, output);
+}
+
+bool SubstringSetMatcher::InitFromMemoryMappedFile(
+    std::unique_ptr<MemoryMappedFile> file) {
+  DCHECK(flat_nodes_.empty());
+  if (!InitFromSerializedData(make_span(file->data(), file->length()))) {
+    // Replace what was read from |file| with the tree of no patterns, which
+    // matches nothing.
+    const bool built = Build(std::vector<const MatcherStringPattern*>());
+    DCHECK(built);
+    return false;
+  }
+  mapped_file_ = std::move(file);
+  return true;
+}
+
+bool SubstringSetMatcher::InitFromSerializedData(span<const uint8_t> data) {
+  SerializedHeader header;
+  if (data.size() < sizeof(header) ||
+      reinterpret_cast<uintptr_t>(data.data()) % alignof(uint32_t) != 0) {
+    return false;
+  }
+  memcpy(&header, data.data(), sizeof(header));
+  if (header.magic != kSerializedMagic ||
+      header.version != kSerializedVersion) {
+    return false;
+  }
+
+  size_t offset = sizeof(header);
+  span<const uint8_t> prefilter;
+  if (!ReadArray(data, &offset, TeddyPrefilter::kSerializedSize, &prefilter) ||
+      !prefilter_.Deserialize(prefilter) ||
+      !ReadArray(data, &offset, 256, &root_edges_) ||
+      !ReadArray(data, &offset, header.num_nodes, &flat_nodes_) ||
+      !ReadArray(data, &offset, header.num_edges, &flat_edges_) ||
+      !ReadArray(data, &offset, header.num_outputs, &flat_outputs_) ||
+      offset != data.size()) {
+    return false;
+  }
+  is_empty_ = header.is_empty != 0;
+  return IsValidFlatTree();
+}
+
+bool SubstringSetMatcher::IsValidFlatTree() const {
+  // There must be a root, and the edges must be padded.
+  if (flat_nodes_.size() < 2 || flat_edges_.size() < 3 ||
+      flat_nodes_.back().edges_begin != flat_edges_.size() - 3) {
+    return false;
+  }
+  // Node IDs must fit in their 23 bits, and kInvalidNodeID is not a node:
+  // Transition() would loop forever at the root if it was one of its edges.
+  const size_t num_nodes = flat_nodes_.size() - 1;
+  if (num_nodes > kInvalidNodeID)
+    return false;
+  for (NodeID child : root_edges_) {
+    if (child == kInvalidNodeID || child >= num_nodes)
+      return false;
+  }
+
+  // Nodes are numbered in breadth first order, so children have larger IDs
+  // than their parent, while failure edges and output links lead to smaller
+  // IDs, which bounds the walks over them.
+  if (flat_nodes_[kRootID].failure != kRootID)
+    return false;
+  for (size_t node = 0; node < num_nodes; ++node) {
+    const FlatNode& flat_node = flat_nodes_[node];
+    if (flat_node.edges_begin > flat_nodes_[node + 1].edges_begin ||
+        (node != kRootID && flat_node.failure >= node) ||
+        (flat_node.has_outputs() &&
+         flat_node.outputs >= flat_outputs_.size())) {
+      return false;
+    }
+    for (uint32_t edge_idx = flat_node.edges_begin;
+         edge_idx < flat_nodes_[node + 1].edges_begin; ++edge_idx) {
+      const NodeID child = flat_edges_[edge_idx].node_id;
+      if (child == kInvalidNodeID || child <= node || child >= num_nodes)
+        return false;
+    }
+  }
+  for (size_t outputs = 0; outputs < flat_outputs_.size(); ++outputs) {
+    const uint32_t next = flat_outputs_[outputs].next;
+    if (next != kInvalidNodeID && next >= outputs)
+      return false;
+  }
+  return true;
 }
 
 // static
@@ -321,23 +457,136 @@ void SubstringSetMatcher::CreateFailureAndOutputEdges() {
   }
 }
 
+void SubstringSetMatcher::BuildFlatTree() {
+  // Number the nodes in breadth first order, and their outputs in the same
+  // order.
+  std::vector<NodeID> flat_ids(tree_.size(), kInvalidNodeID);
+  std::vector<uint32_t> outputs(tree_.size(), kInvalidNodeID);
+  std::vector<NodeID> tree_ids;
+  tree_ids.reserve(tree_.size());
+  flat_ids[kRootID] = kRootID;
+  tree_ids.push_back(kRootID);
+  uint32_t num_outputs = 0;
+  for (size_t flat_id = 0; flat_id < tree_ids.size(); ++flat_id) {
+    const AhoCorasickNode& node = tree_[tree_ids[flat_id]];
+    if (node.has_outputs())
+      outputs[tree_ids[flat_id]] = num_outputs++;
+    for (unsigned edge_idx = 0; edge_idx < node.num_edges(); ++edge_idx) {
+      const AhoCorasickEdge& edge = node.edges()[edge_idx];
+      if (edge.label >= kFirstSpecialLabel)
+        continue;
+      flat_ids[edge.node_id] = static_cast<NodeID>(tree_ids.size());
+      tree_ids.push_back(edge.node_id);
+    }
+  }
+  DCHECK_EQ(tree_.size(), tree_ids.size());
+
+  std::vector<FlatNode>& flat_nodes = flat_nodes_storage_;
+  std::vector<AhoCorasickEdge>& flat_edges = flat_edges_storage_;
+  std::vector<NodeID>& root_edges = root_edges_storage_;
+  std::vector<FlatOutputs>& flat_outputs = flat_outputs_storage_;
+  flat_nodes.clear();
+  flat_nodes.reserve(tree_ids.size() + 1);
+  flat_edges.clear();
+  flat_edges.reserve(tree_ids.size() + 3);
+  root_edges.assign(256, kRootID);
+  flat_outputs.clear();
+  flat_outputs.reserve(num_outputs);
+  for (NodeID tree_id : tree_ids) {
+    const AhoCorasickNode& node = tree_[tree_id];
+    flat_nodes.push_back({static_cast<uint32_t>(flat_edges.size()),
+                          flat_ids[node.failure()], outputs[tree_id]});
+    if (node.has_outputs()) {
+      const NodeID output_link = node.output_link();
+      flat_outputs.push_back(
+          {node.IsEndOfPattern() ? static_cast<uint32_t>(node.GetMatchID())
+                                 : kInvalidNodeID,
+           output_link == kInvalidNodeID ? kInvalidNodeID
+                                         : outputs[output_link]});
+    }
+    for (unsigned edge_idx = 0; edge_idx < node.num_edges(); ++edge_idx) {
+      const AhoCorasickEdge& edge = node.edges()[edge_idx];
+      if (edge.label >= kFirstSpecialLabel)
+        continue;
+      if (tree_id == kRootID)
+        root_edges[edge.label] = flat_ids[edge.node_id];
+      else
+        flat_edges.push_back({edge.label, flat_ids[edge.node_id]});
+    }
+  }
+  flat_nodes.push_back({static_cast<uint32_t>(flat_edges.size()),
+                        kInvalidNodeID, kInvalidNodeID});
+  flat_edges.resize(flat_edges.size() + 3, {kEmptyLabel, kInvalidNodeID});
+
+  flat_nodes_ = flat_nodes;
+  flat_edges_ = flat_edges;
+  root_edges_ = root_edges;
+  flat_outputs_ = flat_outputs;
+
+  // Release the storage, which shrink_to_fit() doesn't do since the move
+  // constructor of AhoCorasickNode isn't noexcept.
+  tree_ = std::vector<AhoCorasickNode>();
+}
+
+SubstringSetMatcher::NodeID SubstringSetMatcher::GetFlatEdgeNoInline(
+    NodeID node,
+    uint32_t label) const {
+  const uint32_t edges_begin = flat_nodes_[node].edges_begin;
+  const uint32_t edges_end = flat_nodes_[node + 1].edges_begin;
+  const AhoCorasickEdge* const edges = flat_edges_.data();
+#ifdef __SSE2__
+  const __m128i lbl = _mm_set1_epi32(static_cast<int>(label));
+  const __m128i mask = _mm_set1_epi32(0x1ff);
+  for (uint32_t edge_idx = edges_begin; edge_idx < edges_end; edge_idx += 4) {
+    const __m128i four =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(&edges[edge_idx]));
+    const __m128i match = _mm_cmpeq_epi32(_mm_and_si128(four, mask), lbl);
+    const uint32_t match_mask = static_cast<uint32_t>(_mm_movemask_epi8(match));
+    if (match_mask != 0) {
+      // The match may be an edge of one of the next nodes.
+      const uint32_t match_idx =
+          edge_idx + bits::CountTrailingZeroBits(match_mask) / 4;
+      return match_idx < edges_end ? edges[match_idx].node_id : kInvalidNodeID;
+    }
+  }
+#else
+  for (uint32_t edge_idx = edges_begin; edge_idx < edges_end; ++edge_idx) {
+    if (edges[edge_idx].label == label)
+      return edges[edge_idx].node_id;
+  }
+#endif
+  return kInvalidNodeID;
+}
+
+SubstringSetMatcher::NodeID SubstringSetMatcher::Transition(
+    NodeID node,
+    unsigned char c) const {
+  NodeID child = GetFlatEdge(node, c);
+
+  // If the child can't be found, progressively iterate over the longest proper
+  // suffix of the string represented by the current node. In a sense we are
+  // pruning prefixes from the text. This ends at the root, where the lookup
+  // can't fail since the missing edges of the root lead back to it.
+  while (child == kInvalidNodeID) {
+    DCHECK_NE(kRootID, node);
+    node = flat_nodes_[node].failure;
+    child = GetFlatEdge(node, c);
+  }
+  return child;
+}
+
 void SubstringSetMatcher::AccumulateMatchesForNode(
-    const AhoCorasickNode* node,
+    NodeID node,
     std::set<MatcherStringPattern::ID>* matches) const {
   DCHECK(matches);
 
-  if (!node->has_outputs()) {
-    // Fast reject.
-    return;
-  }
-  if (node->IsEndOfPattern())
-    matches->insert(node->GetMatchID());
-
-  NodeID node_id = node->output_link();
-  while (node_id != kInvalidNodeID) {
-    node = &tree_[node_id];
-    matches->insert(node->GetMatchID());
-    node_id = node->output_link();
+  // The outputs of a node are followed by those of the nodes its output link
+  // chain leads to, all of which end a pattern.
+  for (uint32_t outputs = flat_nodes_[node].outputs; outputs != kInvalidNodeID;
+       outputs = flat_outputs_[outputs].next) {
+    const uint32_t match_id = flat_outputs_[outputs].match_id;
+    if (match_id != kInvalidNodeID)
+      matches->insert(match_id);
   }
 }
 
@@ -8,16 +8,21 @@
 #include <stdint.h>
 
 #include <limits>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
 
 #include "base/base_export.h"
 #include "base/check_op.h"
+#include "base/containers/span.h"
 #include "base/substring_set_matcher/matcher_string_pattern.h"
+#include "base/substring_set_matcher/teddy_prefilter.h"
 
 namespace base {
 
+class MemoryMappedFile;
+
 // Class that store a set of string patterns and can find for a string S,
 // which string patterns occur in S.
 class BASE_EXPORT SubstringSetMatcher {
@@ -44,6 +49,19 @@ class BASE_EXPORT SubstringSetMatcher {
   bool Build(const std::vector<MatcherStringPattern>& patterns);
   bool Build(std::vector<const MatcherStringPattern*> patterns);
 
+  // Appends the tree built by Build() to |output|, in a position-independent
+  // format which InitFromMemoryMappedFile() matches against in place. The
+  // format depends on the byte order of the machine.
+  void Serialize(std::string* output) const;
+
+  // Initializes the matcher, instead of Build(), from |file| holding a tree
+  // written by Serialize(). The tree is matched against directly in the
+  // mapped pages, which are shared by all the processes mapping the file, so
+  // this takes no allocation besides |file|. The file is checked in a single
+  // pass, and rejected if it is malformed, in which case false is returned
+  // and the matcher is left empty, matching nothing.
+  bool InitFromMemoryMappedFile(std::unique_ptr<MemoryMappedFile> file);
+
   // Matches |text| against all registered MatcherStringPatterns. Stores the IDs
   // of matching patterns in |matches|. |matches| is not cleared before adding
   // to it.
@@ -52,6 +70,9 @@ class BASE_EXPORT SubstringSetMatcher {
   //    Let k = range of char. Generally 256.
   //    Let z = number of matches returned.
   // Complexity = O(t * logk + zlogz)
+  // If the patterns have few distinct prefixes, the automaton is only walked
+  // from the positions of |text| where one of them may start, which are found
+  // 16 bytes at a time by a TeddyPrefilter.
   bool Match(const std::string& text,
              std::set<MatcherStringPattern::ID>* matches) const;
 
@@ -319,15 +340,87 @@ class BASE_EXPORT SubstringSetMatcher {
 
   void CreateFailureAndOutputEdges();
 
+  // Copies |tree_| into the storage of the flat tree, then frees it.
+  void BuildFlatTree();
+
+  // Points the flat tree to |data|, if it holds a valid serialized tree.
+  bool InitFromSerializedData(span<const uint8_t> data);
+
+  // Returns whether the flat tree is consistent, so that matching against it
+  // stays in bounds and terminates.
+  bool IsValidFlatTree() const;
+
+  // Returns the child of the node |node| of the flat tree for |label|, or
+  // kInvalidNodeID if there is none. The root has no missing children, as
+  // those lead back to it.
+  NodeID GetFlatEdge(NodeID node, uint32_t label) const {
+    if (node == kRootID)
+      return root_edges_[label];
+    return GetFlatEdgeNoInline(node, label);
+  }
+  NodeID GetFlatEdgeNoInline(NodeID node, uint32_t label) const;
+
+  // Returns the node of the flat tree reached from |node| by |c|, following
+  // failure edges as needed.
+  NodeID Transition(NodeID node, unsigned char c) const;
+
+  // Returns the position of |text| at or after |begin| from which to walk the
+  // flat tree when at its root.
+  size_t SkipFromRoot(const std::string& text, size_t begin) const {
+    return prefilter_.is_enabled() ? prefilter_.FindCandidate(text, begin)
+                                   : begin;
+  }
+
   // Adds all pattern IDs to |matches| which are a suffix of the string
-  // represented by |node|.
+  // represented by the node |node| of the flat tree.
   void AccumulateMatchesForNode(
-      const AhoCorasickNode* node,
+      NodeID node,
       std::set<MatcherStringPattern::ID>* matches) const;
 
-  // The nodes of a Aho-Corasick tree.
+  // The nodes of a Aho-Corasick tree, while it is being built.
   std::vector<AhoCorasickNode> tree_;
 
+  // The tree which is matched against, in a flat layout: the nodes are
+  // numbered in breadth first order, so that those near the root, where most
+  // of the text is matched, are packed together. The edges of each node are
+  // contiguous in |flat_edges_|, except for those of the root, which are
+  // indexed by label in |root_edges_|, kRootID standing for missing edges.
+  // The few nodes producing matches have an entry in |flat_outputs_|.
+  struct FlatNode {
+    // Index of the first edge of the node in |flat_edges_|. The edges of a
+    // node end where those of the next node begin.
+    uint32_t edges_begin;
+    NodeID failure;
+    // Index of the outputs of the node in |flat_outputs_|, or kInvalidNodeID
+    // if it produces no matches.
+    uint32_t outputs;
+
+    bool has_outputs() const { return outputs != kInvalidNodeID; }
+  };
+  struct FlatOutputs {
+    // The ID of the pattern ending at the node, or kInvalidNodeID.
+    uint32_t match_id;
+    // Index of the outputs of the node the output link of the node leads to,
+    // or kInvalidNodeID.
+    uint32_t next;
+  };
+  // Has one more node than the tree, to mark the end of the last node's edges.
+  span<const FlatNode> flat_nodes_;
+  // Padded so that the edges of any node can be read 4 at a time.
+  span<const AhoCorasickEdge> flat_edges_;
+  span<const NodeID> root_edges_;
+  span<const FlatOutputs> flat_outputs_;
+
+  // The storage of the flat tree, either built by Build() or mapped by
+  // InitFromMemoryMappedFile().
+  std::vector<FlatNode> flat_nodes_storage_;
+  std::vector<AhoCorasickEdge> flat_edges_storage_;
+  std::vector<NodeID> root_edges_storage_;
+  std::vector<FlatOutputs> flat_outputs_storage_;
+  std::unique_ptr<MemoryMappedFile> mapped_file_;
+
+  TeddyPrefilter prefilter_;
+
   bool is_empty_ = true;
 };
 
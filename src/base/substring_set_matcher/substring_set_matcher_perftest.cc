@@ -5,10 +5,14 @@
 #include "base/substring_set_matcher/substring_set_matcher.h"
 
 #include <limits>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "base/containers/contains.h"
+#include "base/files/file_util.h"
+#include "base/files/memory_mapped_file.h"
+#include "base/files/scoped_temp_dir.h"
 #include "base/rand_util.h"
 #include "base/time/time.h"
 #include "base/timer/elapsed_timer.h"
@@ -81,6 +85,161 @@ TEST(SubstringSetMatcherPerfTest, RandomKeys) {
       (base::trace_event::EstimateMemoryUsage(matcher) * 1.0 / (1 << 20)));
 }
 
+// Returns a random URL-like string of the given length, made of components of
+// lowercase letters separated by punctuation.
+std::string GetRandomUrl(size_t len) {
+  static constexpr char kSeparators[] = "/.-?=&";
+  std::string url = "https://";
+  while (url.size() < len) {
+    url += GetRandomString(base::RandInt(2, 10));
+    url.push_back(kSeparators[base::RandInt(0, sizeof(kSeparators) - 2)]);
+  }
+  url.resize(len);
+  return url;
+}
+
+// Reports the time to build a SubstringSetMatcher for |patterns| and the
+// average time to match it against each of |texts|.
+void RunMatchPerfTest(const std::string& story_name,
+                      const std::vector<MatcherStringPattern>& patterns,
+                      const std::vector<std::string>& texts) {
+  base::ElapsedTimer init_timer;
+  auto matcher = std::make_unique<SubstringSetMatcher>();
+  ASSERT_TRUE(matcher->Build(patterns));
+  base::TimeDelta init_time = init_timer.Elapsed();
+
+  const int kNumIterations = 10;
+  size_t num_matches = 0;
+  base::ElapsedTimer match_timer;
+  for (int i = 0; i < kNumIterations; ++i) {
+    for (const std::string& text : texts) {
+      std::set<MatcherStringPattern::ID> matches;
+      matcher->Match(text, &matches);
+      num_matches += matches.size();
+    }
+  }
+  base::TimeDelta match_time =
+      match_timer.Elapsed() / (kNumIterations * texts.size());
+  EXPECT_GT(num_matches, 0u);
+
+  const char* kInitializationTime = ".init_time";
+  const char* kMatchTime = ".match_time";
+  const char* kMemoryUsage = ".memory_usage";
+  auto reporter = perf_test::PerfResultReporter("SubstringSetMatcher",
+                                                story_name);
+  reporter.RegisterImportantMetric(kInitializationTime, "us");
+  reporter.RegisterImportantMetric(kMatchTime, "us");
+  reporter.RegisterImportantMetric(kMemoryUsage, "Mb");
+
+  reporter.AddResult(kInitializationTime, init_time);
+  reporter.AddResult(kMatchTime, match_time);
+  reporter.AddResult(
+      kMemoryUsage,
+      (base::trace_event::EstimateMemoryUsage(matcher) * 1.0 / (1 << 20)));
+}
+
+// Returns 100000 random URL components.
+std::vector<MatcherStringPattern> GetUrlPatterns() {
+  std::vector<MatcherStringPattern> patterns;
+  std::set<std::string> pattern_strings;
+  const size_t kNumPatterns = 100000;
+  while (patterns.size() < kNumPatterns) {
+    std::string str = GetRandomUrl(base::RandInt(16, 40)).substr(8);
+    if (pattern_strings.insert(str).second)
+      patterns.emplace_back(str, patterns.size());
+  }
+  return patterns;
+}
+
+// Returns random URLs, a tenth of which have one of |patterns| embedded so
+// that they have matches.
+std::vector<std::string> GetUrlTexts(
+    const std::vector<MatcherStringPattern>& patterns) {
+  std::vector<std::string> texts;
+  for (size_t i = 0; i < 1000; i++) {
+    std::string text = GetRandomUrl(base::RandInt(50, 300));
+    if (i % 10 == 0)
+      text += patterns[base::RandInt(0, patterns.size() - 1)].pattern();
+    texts.push_back(text);
+  }
+  return texts;
+}
+
+// Tests performance of SubstringSetMatcher for 100000 URL components against
+// URLs, the way it is used by URL blocklists.
+TEST(SubstringSetMatcherPerfTest, ManyUrlKeys) {
+  std::vector<MatcherStringPattern> patterns = GetUrlPatterns();
+  RunMatchPerfTest("ManyUrlKeys", patterns, GetUrlTexts(patterns));
+}
+
+// Tests performance of loading the SubstringSetMatcher of ManyUrlKeys from a
+// file written by Serialize(), and of matching against the mapped file.
+TEST(SubstringSetMatcherPerfTest, MappedManyUrlKeys) {
+  std::vector<MatcherStringPattern> patterns = GetUrlPatterns();
+  const std::vector<std::string> texts = GetUrlTexts(patterns);
+  std::string serialized;
+  {
+    SubstringSetMatcher matcher;
+    ASSERT_TRUE(matcher.Build(patterns));
+    matcher.Serialize(&serialized);
+  }
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  const base::FilePath path = temp_dir.GetPath().AppendASCII("matcher");
+  ASSERT_TRUE(base::WriteFile(path, serialized));
+
+  base::ElapsedTimer load_timer;
+  auto file = std::make_unique<base::MemoryMappedFile>();
+  ASSERT_TRUE(file->Initialize(path));
+  SubstringSetMatcher matcher;
+  ASSERT_TRUE(matcher.InitFromMemoryMappedFile(std::move(file)));
+  base::TimeDelta load_time = load_timer.Elapsed();
+
+  base::ElapsedTimer match_timer;
+  size_t num_matches = 0;
+  for (const std::string& text : texts) {
+    std::set<MatcherStringPattern::ID> matches;
+    matcher.Match(text, &matches);
+    num_matches += matches.size();
+  }
+  base::TimeDelta match_time = match_timer.Elapsed() / texts.size();
+  EXPECT_GT(num_matches, 0u);
+
+  const char* kLoadTime = ".load_time";
+  const char* kMatchTime = ".match_time";
+  const char* kFileSize = ".file_size";
+  auto reporter = perf_test::PerfResultReporter("SubstringSetMatcher",
+                                                "MappedManyUrlKeys");
+  reporter.RegisterImportantMetric(kLoadTime, "us");
+  reporter.RegisterImportantMetric(kMatchTime, "us");
+  reporter.RegisterImportantMetric(kFileSize, "Mb");
+  reporter.AddResult(kLoadTime, load_time);
+  reporter.AddResult(kMatchTime, match_time);
+  reporter.AddResult(kFileSize, serialized.size() * 1.0 / (1 << 20));
+}
+
+// Tests performance of SubstringSetMatcher for a few patterns against long
+// texts, where matches are rare and most of the text is skipped by the
+// prefilter.
+TEST(SubstringSetMatcherPerfTest, FewKeys) {
+  std::vector<MatcherStringPattern> patterns;
+  patterns.emplace_back("/pagead/", 0);
+  patterns.emplace_back("doubleclick.", 1);
+  patterns.emplace_back("&utm_source=", 2);
+  patterns.emplace_back("?tracking_id=", 3);
+  patterns.emplace_back("analytics.js", 4);
+  patterns.emplace_back("/beacon?", 5);
+
+  std::vector<std::string> texts;
+  for (size_t i = 0; i < 100; i++) {
+    std::string text = GetRandomUrl(10000);
+    text += patterns[i % patterns.size()].pattern();
+    texts.push_back(text);
+  }
+
+  RunMatchPerfTest("FewKeys", patterns, texts);
+}
+
 }  // namespace
 
 }  // namespace base
@@ -6,10 +6,16 @@
 
 #include <stddef.h>
 
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
 
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/files/memory_mapped_file.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/rand_util.h"
 #include "testing/gmock/include/gmock/gmock.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
@@ -68,6 +74,24 @@ void TestTwoPatterns(const std::string& test_string,
   }
 }
 
+std::string GetRandomString(int min_length, int max_length, char max_char) {
+  std::string string;
+  const int length = RandInt(min_length, max_length);
+  for (int i = 0; i < length; ++i)
+    string.push_back(static_cast<char>(RandInt('a', max_char)));
+  return string;
+}
+
+std::unique_ptr<MemoryMappedFile> MapData(const FilePath& path,
+                                          const std::string& data) {
+  if (!WriteFile(path, data))
+    return nullptr;
+  auto file = std::make_unique<MemoryMappedFile>();
+  if (!file->Initialize(path))
+    return nullptr;
+  return file;
+}
+
 }  // namespace
 
 TEST(SubstringSetMatcherTest, TestMatcher) {
@@ -188,6 +212,137 @@ TEST(SubstringSetMatcherTest, TestMatcher3) {
   }
 }
 
+// Compares Match() and AnyMatch() to a naive search on random texts, both with
+// few patterns, which are prefiltered, and with many.
+TEST(SubstringSetMatcherTest, TestRandomTexts) {
+  for (size_t num_patterns : {3, 500}) {
+    std::vector<MatcherStringPattern> patterns;
+    std::set<std::string> pattern_strings;
+    while (patterns.size() < num_patterns) {
+      const std::string pattern = GetRandomString(1, 6, 'h');
+      if (pattern_strings.insert(pattern).second)
+        patterns.emplace_back(pattern, patterns.size());
+    }
+    SubstringSetMatcher matcher;
+    ASSERT_TRUE(matcher.Build(patterns));
+
+    for (int iteration = 0; iteration < 100; ++iteration) {
+      const std::string text = GetRandomString(0, 100, 'z');
+
+      std::set<MatcherStringPattern::ID> expected_matches;
+      for (const MatcherStringPattern& pattern : patterns) {
+        if (text.find(pattern.pattern()) != std::string::npos)
+          expected_matches.insert(pattern.id());
+      }
+      std::set<MatcherStringPattern::ID> matches;
+      EXPECT_EQ(!expected_matches.empty(), matcher.Match(text, &matches))
+          << text;
+      EXPECT_EQ(expected_matches, matches) << text;
+      EXPECT_EQ(!expected_matches.empty(), matcher.AnyMatch(text)) << text;
+    }
+  }
+}
+
+TEST(SubstringSetMatcherTest, TestSerialization) {
+  ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+
+  // With few patterns, which are prefiltered, and with many, including the
+  // empty pattern.
+  for (size_t num_patterns : {3, 500}) {
+    std::vector<MatcherStringPattern> patterns;
+    std::set<std::string> pattern_strings;
+    while (patterns.size() < num_patterns) {
+      const std::string pattern =
+          GetRandomString(num_patterns > 100 ? 0 : 3, 6, 'h');
+      if (pattern_strings.insert(pattern).second)
+        patterns.emplace_back(pattern, patterns.size());
+    }
+    SubstringSetMatcher matcher;
+    ASSERT_TRUE(matcher.Build(patterns));
+    std::string serialized;
+    matcher.Serialize(&serialized);
+
+    SubstringSetMatcher mapped_matcher;
+    ASSERT_TRUE(mapped_matcher.InitFromMemoryMappedFile(MapData(
+        temp_dir.GetPath().AppendASCII("matcher"), serialized)));
+    EXPECT_FALSE(mapped_matcher.IsEmpty());
+    EXPECT_EQ(0u, mapped_matcher.EstimateMemoryUsage());
+
+    for (int iteration = 0; iteration < 100; ++iteration) {
+      const std::string text = GetRandomString(0, 100, 'z');
+      std::set<MatcherStringPattern::ID> expected_matches;
+      std::set<MatcherStringPattern::ID> matches;
+      EXPECT_EQ(matcher.Match(text, &expected_matches),
+                mapped_matcher.Match(text, &matches));
+      EXPECT_EQ(expected_matches, matches) << text;
+      EXPECT_EQ(matcher.AnyMatch(text), mapped_matcher.AnyMatch(text));
+    }
+
+    // A matcher loaded from a file serializes to the same file.
+    std::string reserialized;
+    mapped_matcher.Serialize(&reserialized);
+    EXPECT_EQ(serialized, reserialized);
+  }
+}
+
+TEST(SubstringSetMatcherTest, TestSerializationEmptyMatcher) {
+  ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  SubstringSetMatcher matcher;
+  ASSERT_TRUE(matcher.Build(std::vector<MatcherStringPattern>()));
+  std::string serialized;
+  matcher.Serialize(&serialized);
+
+  SubstringSetMatcher mapped_matcher;
+  ASSERT_TRUE(mapped_matcher.InitFromMemoryMappedFile(
+      MapData(temp_dir.GetPath().AppendASCII("matcher"), serialized)));
+  EXPECT_TRUE(mapped_matcher.IsEmpty());
+  std::set<MatcherStringPattern::ID> matches;
+  EXPECT_FALSE(mapped_matcher.Match("abc", &matches));
+  EXPECT_FALSE(mapped_matcher.AnyMatch("abc"));
+}
+
+TEST(SubstringSetMatcherTest, TestMalformedSerialization) {
+  ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  const FilePath path = temp_dir.GetPath().AppendASCII("matcher");
+
+  std::vector<MatcherStringPattern> patterns;
+  patterns.emplace_back("abc", 1);
+  patterns.emplace_back("bcd", 2);
+  SubstringSetMatcher matcher;
+  ASSERT_TRUE(matcher.Build(patterns));
+  std::string serialized;
+  matcher.Serialize(&serialized);
+
+  std::string truncated = serialized.substr(0, serialized.size() - 4);
+  std::string bad_magic = serialized;
+  bad_magic[0] ^= 1;
+  // Make the failure edge of the last of the 7 nodes lead to itself, which
+  // would loop forever. The nodes follow a 24-byte header, the prefilter and
+  // the 256 root edges, and have their failure edge at offset 4.
+  std::string bad_failure = serialized;
+  const size_t nodes_offset = 24 + TeddyPrefilter::kSerializedSize + 256 * 4;
+  bad_failure[nodes_offset + 6 * 12 + 4] = 6;
+  // Make the root edge for 'x' kInvalidNodeID, which would loop forever at
+  // the root.
+  std::string bad_root_edge = serialized;
+  const size_t root_edges_offset = 24 + TeddyPrefilter::kSerializedSize;
+  bad_root_edge[root_edges_offset + 'x' * 4] = '\xff';
+  bad_root_edge[root_edges_offset + 'x' * 4 + 1] = '\xff';
+  bad_root_edge[root_edges_offset + 'x' * 4 + 2] = '\x7f';
+  for (const std::string& data :
+       {truncated, bad_magic, bad_failure, bad_root_edge}) {
+    SubstringSetMatcher mapped_matcher;
+    EXPECT_FALSE(mapped_matcher.InitFromMemoryMappedFile(MapData(path, data)));
+    EXPECT_TRUE(mapped_matcher.IsEmpty());
+    std::set<MatcherStringPattern::ID> matches;
+    EXPECT_FALSE(mapped_matcher.Match("abc", &matches));
+    EXPECT_FALSE(mapped_matcher.AnyMatch("abc"));
+  }
+}
+
 TEST(SubstringSetMatcherTest, TestEmptyMatcher) {
   std::vector<MatcherStringPattern> patterns;
   SubstringSetMatcher matcher;
@@ -0,0 +1,226 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/substring_set_matcher/teddy_prefilter.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+
+#include "base/check_op.h"
+#include "build/build_config.h"
+
+#if defined(ARCH_CPU_X86_64)
+#include <immintrin.h>
+
+#include "base/bits.h"
+#include "base/cpu.h"
+#endif
+
+namespace base {
+
+namespace {
+
+// The highest fraction of the positions of a text which may be candidates for
+// the filter to be enabled. Past it, walking the automaton over every byte is
+// cheaper than filtering, then jumping from candidate to candidate.
+constexpr double kMaxCandidateRate = 0.2;
+
+// The candidate rate is estimated from the distribution of the bytes of the
+// patterns. This many occurrences of each printable ASCII character are added
+// to it, so that the estimate stays sensible for a handful of patterns.
+constexpr size_t kPriorCountPerPrintableChar = 4;
+
+#if defined(ARCH_CPU_X86_64)
+
+bool CanUseSSSE3() {
+  static const bool can_use_ssse3 = CPU::GetInstanceNoAllocation().has_ssse3();
+  return can_use_ssse3;
+}
+
+// Checks blocks of 16 positions of |text| starting at |i|, as long as the
+// bytes at |prefix_length| - 1 past the block are in |text|. Returns the first
+// candidate position, or the first position which was not checked.
+__attribute__((target("ssse3"))) size_t FindCandidateSSSE3(
+    const uint8_t* text,
+    size_t size,
+    size_t i,
+    size_t prefix_length,
+    const uint8_t (*low_nibble_masks)[16],
+    const uint8_t (*high_nibble_masks)[16]) {
+  __m128i low_masks[TeddyPrefilter::kMaxPrefixLength];
+  __m128i high_masks[TeddyPrefilter::kMaxPrefixLength];
+  for (size_t j = 0; j < prefix_length; ++j) {
+    low_masks[j] =
+        _mm_load_si128(reinterpret_cast<const __m128i*>(low_nibble_masks[j]));
+    high_masks[j] =
+        _mm_load_si128(reinterpret_cast<const __m128i*>(high_nibble_masks[j]));
+  }
+  const __m128i nibble = _mm_set1_epi8(0x0f);
+  const __m128i zero = _mm_setzero_si128();
+  for (; size - i >= 15 + prefix_length; i += 16) {
+    __m128i buckets = _mm_set1_epi8(-1);
+    for (size_t j = 0; j < prefix_length; ++j) {
+      const __m128i chunk =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + j));
+      const __m128i low = _mm_and_si128(chunk, nibble);
+      const __m128i high = _mm_and_si128(_mm_srli_epi16(chunk, 4), nibble);
+      buckets = _mm_and_si128(
+          buckets, _mm_and_si128(_mm_shuffle_epi8(low_masks[j], low),
+                                 _mm_shuffle_epi8(high_masks[j], high)));
+    }
+    const uint32_t rejected = static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(buckets, zero)));
+    const uint32_t candidates = ~rejected & 0xffff;
+    if (candidates)
+      return i + bits::CountTrailingZeroBits(candidates);
+  }
+  return i;
+}
+
+#endif  // defined(ARCH_CPU_X86_64)
+
+}  // namespace
+
+TeddyPrefilter::TeddyPrefilter() = default;
+
+TeddyPrefilter::~TeddyPrefilter() = default;
+
+bool TeddyPrefilter::Build(
+    const std::vector<const MatcherStringPattern*>& patterns) {
+  prefix_length_ = 0;
+  memset(low_nibble_masks_, 0, sizeof(low_nibble_masks_));
+  memset(high_nibble_masks_, 0, sizeof(high_nibble_masks_));
+
+#if defined(ARCH_CPU_X86_64)
+  if (!CanUseSSSE3() || patterns.empty())
+    return false;
+
+  // Every pattern must be at least as long as the checked prefix, and a
+  // pattern matching the empty string matches at every position.
+  size_t prefix_length = kMaxPrefixLength;
+  for (const MatcherStringPattern* pattern : patterns)
+    prefix_length = std::min(prefix_length, pattern->pattern().size());
+  if (prefix_length == 0)
+    return false;
+
+  // The patterns are sorted, so assigning them to buckets by ranges puts the
+  // patterns sharing their first bytes in the same buckets, which keeps the
+  // masks of each bucket sparse.
+  size_t byte_counts[256] = {};
+  size_t total_byte_count = 0;
+  for (size_t byte = 0x20; byte < 0x7f; ++byte) {
+    byte_counts[byte] = kPriorCountPerPrintableChar;
+    total_byte_count += kPriorCountPerPrintableChar;
+  }
+  for (size_t k = 0; k < patterns.size(); ++k) {
+    const std::string& pattern = patterns[k]->pattern();
+    const uint8_t bucket_bit =
+        static_cast<uint8_t>(1u << (k * kNumBuckets / patterns.size()));
+    for (size_t j = 0; j < prefix_length; ++j) {
+      const uint8_t byte = static_cast<uint8_t>(pattern[j]);
+      low_nibble_masks_[j][byte & 0xf] |= bucket_bit;
+      high_nibble_masks_[j][byte >> 4] |= bucket_bit;
+    }
+    for (char c : pattern)
+      ++byte_counts[static_cast<uint8_t>(c)];
+    total_byte_count += pattern.size();
+  }
+
+  // Estimate the rate of candidate positions, assuming that the bytes of the
+  // text are independent and distributed like those of the patterns.
+  double candidate_rate = 0;
+  for (size_t bucket = 0; bucket < kNumBuckets; ++bucket) {
+    double bucket_rate = 1;
+    for (size_t j = 0; j < prefix_length; ++j) {
+      size_t accepted_byte_count = 0;
+      for (size_t byte = 0; byte < 256; ++byte) {
+        if (low_nibble_masks_[j][byte & 0xf] &
+            high_nibble_masks_[j][byte >> 4] & (1u << bucket)) {
+          accepted_byte_count += byte_counts[byte];
+        }
+      }
+      bucket_rate *=
+          static_cast<double>(accepted_byte_count) / total_byte_count;
+    }
+    candidate_rate += bucket_rate;
+  }
+  if (candidate_rate > kMaxCandidateRate) {
+    memset(low_nibble_masks_, 0, sizeof(low_nibble_masks_));
+    memset(high_nibble_masks_, 0, sizeof(high_nibble_masks_));
+    return false;
+  }
+
+  prefix_length_ = prefix_length;
+  return true;
+#else
+  return false;
+#endif  // defined(ARCH_CPU_X86_64)
+}
+
+void TeddyPrefilter::Serialize(std::string* output) const {
+  const uint32_t prefix_length = static_cast<uint32_t>(prefix_length_);
+  output->append(reinterpret_cast<const char*>(&prefix_length),
+                 sizeof(prefix_length));
+  output->append(reinterpret_cast<const char*>(low_nibble_masks_),
+                 sizeof(low_nibble_masks_));
+  output->append(reinterpret_cast<const char*>(high_nibble_masks_),
+                 sizeof(high_nibble_masks_));
+}
+
+bool TeddyPrefilter::Deserialize(span<const uint8_t> data) {
+  prefix_length_ = 0;
+  memset(low_nibble_masks_, 0, sizeof(low_nibble_masks_));
+  memset(high_nibble_masks_, 0, sizeof(high_nibble_masks_));
+
+  if (data.size() != kSerializedSize)
+    return false;
+  uint32_t prefix_length;
+  memcpy(&prefix_length, data.data(), sizeof(prefix_length));
+  if (prefix_length > kMaxPrefixLength)
+    return false;
+#if defined(ARCH_CPU_X86_64)
+  if (prefix_length == 0 || !CanUseSSSE3())
+    return true;
+  data = data.subspan(sizeof(prefix_length));
+  memcpy(low_nibble_masks_, data.data(), sizeof(low_nibble_masks_));
+  data = data.subspan(sizeof(low_nibble_masks_));
+  memcpy(high_nibble_masks_, data.data(), sizeof(high_nibble_masks_));
+  prefix_length_ = prefix_length;
+#endif  // defined(ARCH_CPU_X86_64)
+  return true;
+}
+
+size_t TeddyPrefilter::FindCandidate(StringPiece text, size_t begin) const {
+  DCHECK(is_enabled());
+  const uint8_t* const bytes = reinterpret_cast<const uint8_t*>(text.data());
+  const size_t size = text.size();
+  if (begin >= size || size - begin < prefix_length_)
+    return size;
+
+  size_t i = begin;
+#if defined(ARCH_CPU_X86_64)
+  i = FindCandidateSSSE3(bytes, size, i, prefix_length_, low_nibble_masks_,
+                         high_nibble_masks_);
+#endif
+  // Check the last positions, at which a whole block would overflow the text.
+  for (; size - i >= prefix_length_; ++i) {
+    if (IsCandidate(bytes, i))
+      return i;
+  }
+  return size;
+}
+
+bool TeddyPrefilter::IsCandidate(const uint8_t* text, size_t i) const {
+  uint8_t buckets = 0xff;
+  for (size_t j = 0; j < prefix_length_; ++j) {
+    const uint8_t byte = text[i + j];
+    buckets &= low_nibble_masks_[j][byte & 0xf] &
+               high_nibble_masks_[j][byte >> 4];
+  }
+  return buckets != 0;
+}
+
+}  // namespace base
@@ -0,0 +1,88 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_SUBSTRING_SET_MATCHER_TEDDY_PREFILTER_H_
+#define BASE_SUBSTRING_SET_MATCHER_TEDDY_PREFILTER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/containers/span.h"
+#include "base/strings/string_piece.h"
+#include "base/substring_set_matcher/matcher_string_pattern.h"
+
+namespace base {
+
+// Finds the positions of a text at which any of a set of patterns may start,
+// so that SubstringSetMatcher only walks its automaton from those positions.
+//
+// This is the "Teddy" algorithm of Hyperscan: the patterns are spread over 8
+// buckets, and for each of the first |prefix_length()| bytes of the patterns,
+// two 16-byte masks map the low and high nibbles of a byte to the set of
+// buckets having a pattern with a byte of that nibble at that position. Using
+// a byte shuffle for each mask, 16 positions of the text are checked at once.
+// A position is a candidate if some bucket accepts all the bytes at its
+// offsets from it, which has false positives but no false negatives.
+//
+// The masks only discriminate between positions if the patterns have few
+// distinct prefixes, so Build() gives up when they would let through too many
+// positions for filtering to pay off. The filter also requires SSSE3.
+class BASE_EXPORT TeddyPrefilter {
+ public:
+  static constexpr size_t kMaxPrefixLength = 3;
+  static constexpr size_t kNumBuckets = 8;
+
+  // The size of the data appended by Serialize().
+  static constexpr size_t kSerializedSize =
+      sizeof(uint32_t) + 2 * kMaxPrefixLength * 16;
+
+  TeddyPrefilter();
+  TeddyPrefilter(const TeddyPrefilter&) = delete;
+  TeddyPrefilter& operator=(const TeddyPrefilter&) = delete;
+  ~TeddyPrefilter();
+
+  // Builds the masks for |patterns|, which must be sorted. Returns false,
+  // leaving the filter disabled, if the filter is not supported on this CPU
+  // or would not be selective enough for |patterns|.
+  bool Build(const std::vector<const MatcherStringPattern*>& patterns);
+
+  // Appends the masks to |output|.
+  void Serialize(std::string* output) const;
+
+  // Initializes the filter from |data| written by Serialize(). Returns false,
+  // leaving the filter disabled, if |data| is malformed. The filter is also
+  // left disabled if it is not supported on this CPU.
+  bool Deserialize(span<const uint8_t> data);
+
+  bool is_enabled() const { return prefix_length_ != 0; }
+
+  // The number of leading bytes of the patterns which are checked.
+  size_t prefix_length() const { return prefix_length_; }
+
+  // Returns the first position of |text| at or after |begin| at which one of
+  // the patterns may start, or |text.size()| if there is none. The filter must
+  // be enabled.
+  size_t FindCandidate(StringPiece text, size_t begin) const;
+
+ private:
+  // Returns whether a pattern may start at position |i| of |text|, which must
+  // be followed by at least |prefix_length_| bytes.
+  bool IsCandidate(const uint8_t* text, size_t i) const;
+
+  size_t prefix_length_ = 0;
+
+  // Bit b of |low_nibble_masks_[j][n]| is set if a pattern of bucket b has a
+  // byte whose low nibble is n at position j, and similarly for the high
+  // nibbles.
+  alignas(16) uint8_t low_nibble_masks_[kMaxPrefixLength][16] = {};
+  alignas(16) uint8_t high_nibble_masks_[kMaxPrefixLength][16] = {};
+};
+
+}  // namespace base
+
+#endif  // BASE_SUBSTRING_SET_MATCHER_TEDDY_PREFILTER_H_
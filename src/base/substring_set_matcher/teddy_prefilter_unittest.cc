@@ -0,0 +1,137 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/substring_set_matcher/teddy_prefilter.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/rand_util.h"
+#include "build/build_config.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+#if defined(ARCH_CPU_X86_64)
+#include "base/cpu.h"
+#endif
+
+namespace base {
+
+namespace {
+
+bool IsPrefilterSupported() {
+#if defined(ARCH_CPU_X86_64)
+  return CPU().has_ssse3();
+#else
+  return false;
+#endif
+}
+
+std::vector<const MatcherStringPattern*> GetSortedPointers(
+    const std::vector<MatcherStringPattern>& patterns) {
+  std::vector<const MatcherStringPattern*> pointers;
+  for (const MatcherStringPattern& pattern : patterns)
+    pointers.push_back(&pattern);
+  std::sort(pointers.begin(), pointers.end(),
+            [](const MatcherStringPattern* a, const MatcherStringPattern* b) {
+              return a->pattern() < b->pattern();
+            });
+  return pointers;
+}
+
+}  // namespace
+
+TEST(TeddyPrefilterTest, FindsAllPatternStarts) {
+  if (!IsPrefilterSupported())
+    GTEST_SKIP() << "Requires SSSE3";
+
+  std::vector<MatcherStringPattern> patterns;
+  patterns.emplace_back("ads.", 0);
+  patterns.emplace_back("track", 1);
+  patterns.emplace_back("/pixel?", 2);
+  patterns.emplace_back("&utm_", 3);
+  TeddyPrefilter prefilter;
+  ASSERT_TRUE(prefilter.Build(GetSortedPointers(patterns)));
+  EXPECT_EQ(TeddyPrefilter::kMaxPrefixLength, prefilter.prefix_length());
+
+  // Texts of all lengths around the block size, with patterns at various
+  // offsets.
+  const std::string filler = "https://www.example.com/index.html";
+  for (size_t length = 0; length < 70; ++length) {
+    for (const MatcherStringPattern& pattern : patterns) {
+      std::string text = filler.substr(0, length % filler.size());
+      text += pattern.pattern();
+      text += filler.substr(0, (length * 7) % filler.size());
+
+      // Every start of a pattern must be a candidate.
+      size_t position = 0;
+      for (size_t start = text.find(pattern.pattern());
+           start != std::string::npos;
+           start = text.find(pattern.pattern(), start + 1)) {
+        position = prefilter.FindCandidate(text, position);
+        EXPECT_LE(position, start) << text;
+        while (position < start)
+          position = prefilter.FindCandidate(text, position + 1);
+        EXPECT_EQ(start, position) << text;
+        ++position;
+      }
+    }
+  }
+}
+
+TEST(TeddyPrefilterTest, SkipsNonCandidates) {
+  if (!IsPrefilterSupported())
+    GTEST_SKIP() << "Requires SSSE3";
+
+  std::vector<MatcherStringPattern> patterns;
+  patterns.emplace_back("xyz", 0);
+  TeddyPrefilter prefilter;
+  ASSERT_TRUE(prefilter.Build(GetSortedPointers(patterns)));
+
+  const std::string text = std::string(100, 'a') + "xyz" + std::string(5, 'a');
+  EXPECT_EQ(100u, prefilter.FindCandidate(text, 0));
+  EXPECT_EQ(100u, prefilter.FindCandidate(text, 100));
+  EXPECT_EQ(text.size(), prefilter.FindCandidate(text, 101));
+  EXPECT_EQ(text.size(), prefilter.FindCandidate(text, text.size()));
+}
+
+TEST(TeddyPrefilterTest, ShortPatterns) {
+  if (!IsPrefilterSupported())
+    GTEST_SKIP() << "Requires SSSE3";
+
+  std::vector<MatcherStringPattern> patterns;
+  patterns.emplace_back("q", 0);
+  patterns.emplace_back("xyz", 1);
+  TeddyPrefilter prefilter;
+  ASSERT_TRUE(prefilter.Build(GetSortedPointers(patterns)));
+  EXPECT_EQ(1u, prefilter.prefix_length());
+
+  const std::string text = std::string(40, 'a') + "q";
+  EXPECT_EQ(40u, prefilter.FindCandidate(text, 0));
+}
+
+TEST(TeddyPrefilterTest, DisabledForUnselectivePatterns) {
+  TeddyPrefilter prefilter;
+  EXPECT_FALSE(prefilter.Build({}));
+  EXPECT_FALSE(prefilter.is_enabled());
+
+  // The empty pattern matches everywhere.
+  std::vector<MatcherStringPattern> patterns;
+  patterns.emplace_back("", 0);
+  patterns.emplace_back("abc", 1);
+  EXPECT_FALSE(prefilter.Build(GetSortedPointers(patterns)));
+
+  // With many random patterns, the masks accept most texts.
+  patterns.clear();
+  for (size_t i = 0; i < 1000; ++i) {
+    std::string pattern;
+    for (int j = 0; j < 10; ++j)
+      pattern.push_back(static_cast<char>(RandInt('a', 'z')));
+    patterns.emplace_back(pattern, i);
+  }
+  EXPECT_FALSE(prefilter.Build(GetSortedPointers(patterns)));
+  EXPECT_FALSE(prefilter.is_enabled());
+}
+
+}  // namespace base
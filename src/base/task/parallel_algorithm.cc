@@ -0,0 +1,147 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/task/parallel_algorithm.h"
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+
+#include "base/memory/ref_counted.h"
+#include "base/system/sys_info.h"
+#include "base/task/post_job.h"
+#include "base/task/scoped_set_task_priority_for_current_thread.h"
+
+namespace base {
+
+namespace {
+
+// A worker claims 1/kChunksPerWorker of its share of the remaining items at
+// once. Chunks get smaller as items run out, which balances the load at the
+// end of the job while keeping the number of claims logarithmic in the size.
+constexpr size_t kChunksPerWorker = 4;
+
+// The minimum number of items sorted in a block by ParallelSort(). Smaller
+// blocks aren't worth the cost of merging them.
+constexpr size_t kMinItemsPerSortBlock = 1024;
+
+size_t GetEffectiveMaxConcurrency(const ParallelOptions& options) {
+  if (options.max_concurrency)
+    return options.max_concurrency;
+  return static_cast<size_t>(SysInfo::NumberOfProcessors());
+}
+
+class ParallelForState : public RefCountedThreadSafe<ParallelForState> {
+ public:
+  ParallelForState(size_t size,
+                   RepeatingCallback<void(size_t, size_t)> function,
+                   size_t min_chunk_size,
+                   size_t max_concurrency)
+      : size_(size),
+        function_(std::move(function)),
+        min_chunk_size_(min_chunk_size),
+        max_concurrency_(max_concurrency) {}
+  ParallelForState(const ParallelForState&) = delete;
+  ParallelForState& operator=(const ParallelForState&) = delete;
+
+  void Run(JobDelegate* delegate) {
+    size_t begin;
+    size_t end;
+    while (!delegate->ShouldYield() && ClaimChunk(&begin, &end))
+      function_.Run(begin, end);
+  }
+
+  size_t GetMaxConcurrency(size_t worker_count) const {
+    const size_t next_index = next_index_.load(std::memory_order_relaxed);
+    if (next_index >= size_)
+      return 0;
+    const size_t remaining_chunks =
+        (size_ - next_index + min_chunk_size_ - 1) / min_chunk_size_;
+    return std::min(max_concurrency_, worker_count + remaining_chunks);
+  }
+
+ private:
+  friend class RefCountedThreadSafe<ParallelForState>;
+  ~ParallelForState() = default;
+
+  // Claims the next range of unprocessed items. Returns false if there are
+  // none left.
+  bool ClaimChunk(size_t* begin, size_t* end) {
+    size_t next_index = next_index_.load(std::memory_order_relaxed);
+    size_t chunk_size;
+    do {
+      if (next_index >= size_)
+        return false;
+      const size_t remaining = size_ - next_index;
+      const size_t share = remaining / (kChunksPerWorker * max_concurrency_);
+      chunk_size = std::min(remaining, std::max(min_chunk_size_, share));
+    } while (!next_index_.compare_exchange_weak(next_index,
+                                                next_index + chunk_size,
+                                                std::memory_order_relaxed));
+    *begin = next_index;
+    *end = next_index + chunk_size;
+    return true;
+  }
+
+  const size_t size_;
+  const RepeatingCallback<void(size_t, size_t)> function_;
+  const size_t min_chunk_size_;
+  const size_t max_concurrency_;
+
+  // The index of the first item which hasn't been claimed yet. Items are
+  // handed to |function_| on the thread which claims them, and JobHandle::Join
+  // synchronizes with the workers, so this doesn't need to order memory.
+  std::atomic<size_t> next_index_{0};
+};
+
+}  // namespace
+
+ParallelOptions::ParallelOptions() = default;
+ParallelOptions::ParallelOptions(const ParallelOptions&) = default;
+ParallelOptions& ParallelOptions::operator=(const ParallelOptions&) = default;
+ParallelOptions::~ParallelOptions() = default;
+
+namespace internal {
+
+void ParallelForRangeImpl(
+    const Location& from_here,
+    size_t size,
+    RepeatingCallback<void(size_t begin, size_t end)> function,
+    const ParallelOptions& options) {
+  if (size == 0)
+    return;
+
+  const size_t min_chunk_size = std::max<size_t>(options.min_chunk_size, 1);
+  const size_t max_concurrency = GetEffectiveMaxConcurrency(options);
+  if (max_concurrency <= 1 || size <= min_chunk_size) {
+    function.Run(0, size);
+    return;
+  }
+
+  // JobHandle::Join() requires the job's priority not to exceed the priority
+  // of the joining thread.
+  const TaskPriority priority =
+      options.priority.value_or(GetTaskPriorityForCurrentThread());
+  const TaskTraits traits = options.may_block
+                                ? TaskTraits(priority, MayBlock())
+                                : TaskTraits(priority);
+
+  auto state = MakeRefCounted<ParallelForState>(
+      size, std::move(function), min_chunk_size, max_concurrency);
+  CreateJob(from_here, traits,
+            BindRepeating(&ParallelForState::Run, state),
+            BindRepeating(&ParallelForState::GetMaxConcurrency, state))
+      .Join();
+}
+
+size_t GetParallelSortBlockCount(size_t size, const ParallelOptions& options) {
+  const size_t min_items_per_block =
+      std::max(options.min_chunk_size, kMinItemsPerSortBlock);
+  return std::min(GetEffectiveMaxConcurrency(options),
+                  size / min_items_per_block);
+}
+
+}  // namespace internal
+
+}  // namespace base
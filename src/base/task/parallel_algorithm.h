@@ -0,0 +1,231 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_TASK_PARALLEL_ALGORITHM_H_
+#define BASE_TASK_PARALLEL_ALGORITHM_H_
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/bind.h"
+#include "base/callback.h"
+#include "base/check_op.h"
+#include "base/containers/span.h"
+#include "base/location.h"
+#include "base/synchronization/lock.h"
+#include "base/task/task_traits.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
+
+// Parallel algorithms built on base::PostJob().
+//
+// Each algorithm splits its input into chunks which are processed by
+// ThreadPool workers and by the calling thread, and returns once all the
+// chunks have been processed. Chunks are claimed dynamically, with a size which
+// decreases as the work runs out (guided self-scheduling), so that workers
+// which run slower than the others, or start late, don't delay completion.
+// The job's max concurrency tracks the number of chunks which are left, so no
+// more workers than useful are scheduled.
+//
+// The functions passed to the algorithms are called concurrently on several
+// threads, and must not call back into the ThreadPool while holding a lock
+// (see PostJob()). Since the calling thread participates, the algorithms make
+// progress even if all workers are busy, and can be nested.
+//
+// Example:
+//   std::vector<float> values = ...;
+//   base::ParallelFor(FROM_HERE, base::make_span(values),
+//                     [](float& value) { value = std::sqrt(value); });
+//   const float sum = base::ParallelReduce(
+//       FROM_HERE, base::make_span(values), 0.0f, std::plus<>());
+
+namespace base {
+
+// Optional parameters of the parallel algorithms.
+struct BASE_EXPORT ParallelOptions {
+  ParallelOptions();
+  ParallelOptions(const ParallelOptions&);
+  ParallelOptions& operator=(const ParallelOptions&);
+  ~ParallelOptions();
+
+  // The priority of the job. Defaults to the priority of the calling thread,
+  // which it may not exceed.
+  absl::optional<TaskPriority> priority;
+
+  // Whether the functions passed to the algorithm may block.
+  bool may_block = false;
+
+  // The minimum number of items processed at once. Increase it when items are
+  // so cheap to process that claiming them would dominate.
+  size_t min_chunk_size = 1;
+
+  // The maximum number of threads, including the calling thread, which may
+  // process items concurrently. 0 means the number of processors.
+  size_t max_concurrency = 0;
+};
+
+namespace internal {
+
+// Calls |function| with disjoint ranges which together cover [0, |size|), in
+// parallel. See ParallelForRange().
+BASE_EXPORT void ParallelForRangeImpl(
+    const Location& from_here,
+    size_t size,
+    RepeatingCallback<void(size_t begin, size_t end)> function,
+    const ParallelOptions& options);
+
+// Returns the number of blocks which ParallelSort() sorts in parallel before
+// merging them.
+BASE_EXPORT size_t GetParallelSortBlockCount(size_t size,
+                                             const ParallelOptions& options);
+
+}  // namespace internal
+
+// Calls |function(begin, end)| for disjoint ranges which together cover
+// [0, |size|). Ranges hold at least |options.min_chunk_size| indices, except
+// possibly the last one.
+template <typename Function>
+void ParallelForRange(const Location& from_here,
+                      size_t size,
+                      const Function& function,
+                      const ParallelOptions& options = ParallelOptions()) {
+  internal::ParallelForRangeImpl(
+      from_here, size,
+      BindRepeating(
+          [](const Function* function, size_t begin, size_t end) {
+            (*function)(begin, end);
+          },
+          Unretained(&function)),
+      options);
+}
+
+// Calls |function(item)| for each item of |data|.
+template <typename T, typename Function>
+void ParallelFor(const Location& from_here,
+                 span<T> data,
+                 const Function& function,
+                 const ParallelOptions& options = ParallelOptions()) {
+  ParallelForRange(
+      from_here, data.size(),
+      [data, &function](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+          function(data[i]);
+      },
+      options);
+}
+
+// Sets each item of |output| to |function| applied to the item of |input| at
+// the same index. |input| and |output| must have the same size.
+template <typename T, typename U, typename Function>
+void ParallelTransform(const Location& from_here,
+                       span<T> input,
+                       span<U> output,
+                       const Function& function,
+                       const ParallelOptions& options = ParallelOptions()) {
+  CHECK_EQ(input.size(), output.size());
+  ParallelForRange(
+      from_here, input.size(),
+      [input, output, &function](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+          output[i] = function(input[i]);
+      },
+      options);
+}
+
+// Returns the reduction of the items of |data| with |reduce|, starting from
+// |identity|. |reduce| must be associative, but not necessarily commutative:
+// partial results are combined in the order of the items they cover.
+// |identity| must be an identity element of |reduce|, since each chunk starts
+// from it. |reduce| is called both with (R, const T&) to accumulate items and
+// with (R, R) to combine partial results.
+template <typename T, typename R, typename ReduceFunction>
+R ParallelReduce(const Location& from_here,
+                 span<T> data,
+                 R identity,
+                 const ReduceFunction& reduce,
+                 const ParallelOptions& options = ParallelOptions()) {
+  Lock lock;
+  // Partial results, keyed by the index of the first item they cover. Guarded
+  // by |lock|.
+  std::vector<std::pair<size_t, R>> partial_results;
+  ParallelForRange(
+      from_here, data.size(),
+      [data, &identity, &reduce, &lock, &partial_results](size_t begin,
+                                                          size_t end) {
+        R partial_result = identity;
+        for (size_t i = begin; i < end; ++i)
+          partial_result = reduce(std::move(partial_result), data[i]);
+        AutoLock auto_lock(lock);
+        partial_results.emplace_back(begin, std::move(partial_result));
+      },
+      options);
+
+  // The job is complete, so |partial_results| is no longer accessed
+  // concurrently.
+  std::sort(partial_results.begin(), partial_results.end(),
+            [](const std::pair<size_t, R>& a, const std::pair<size_t, R>& b) {
+              return a.first < b.first;
+            });
+  R result = std::move(identity);
+  for (auto& partial_result : partial_results)
+    result = reduce(std::move(result), std::move(partial_result.second));
+  return result;
+}
+
+// Sorts |data| with |compare|. The sort isn't stable. Blocks of |data| are
+// sorted in parallel, then merged pairwise, each round of merges running in
+// parallel.
+template <typename T, typename Compare = std::less<>>
+void ParallelSort(const Location& from_here,
+                  span<T> data,
+                  const Compare& compare = Compare(),
+                  const ParallelOptions& options = ParallelOptions()) {
+  const size_t num_blocks =
+      internal::GetParallelSortBlockCount(data.size(), options);
+  if (num_blocks <= 1) {
+    std::sort(data.begin(), data.end(), compare);
+    return;
+  }
+
+  const size_t block_size = (data.size() + num_blocks - 1) / num_blocks;
+  T* const first = data.data();
+  auto block_begin = [first, block_size, &data](size_t block) {
+    return first + std::min(block * block_size, data.size());
+  };
+
+  // Each block is already a unit of work large enough to amortize claiming it.
+  ParallelOptions block_options = options;
+  block_options.min_chunk_size = 1;
+
+  ParallelForRange(
+      from_here, num_blocks,
+      [&block_begin, &compare](size_t begin, size_t end) {
+        for (size_t block = begin; block < end; ++block)
+          std::sort(block_begin(block), block_begin(block + 1), compare);
+      },
+      block_options);
+
+  // Merge sorted runs of |width| blocks pairwise until a single run is left.
+  for (size_t width = 1; width < num_blocks; width *= 2) {
+    const size_t num_merges = (num_blocks + 2 * width - 1) / (2 * width);
+    ParallelForRange(
+        from_here, num_merges,
+        [&block_begin, &compare, width](size_t begin, size_t end) {
+          for (size_t merge = begin; merge < end; ++merge) {
+            const size_t left = 2 * merge * width;
+            std::inplace_merge(block_begin(left), block_begin(left + width),
+                               block_begin(left + 2 * width), compare);
+          }
+        },
+        block_options);
+  }
+}
+
+}  // namespace base
+
+#endif  // BASE_TASK_PARALLEL_ALGORITHM_H_
@@ -0,0 +1,143 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "base/rand_util.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/system/sys_info.h"
+#include "base/task/parallel_algorithm.h"
+#include "base/test/task_environment.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+
+namespace base {
+
+namespace {
+
+// Each algorithm runs with a max concurrency of 1 (which runs inline, as a
+// sequential baseline), 2, 4 and the number of processors, so that the
+// reported throughputs show how it scales with the number of cores.
+
+constexpr char kMetricPrefixParallel[] = "Parallel.";
+constexpr char kMetricThroughput[] = "throughput";
+constexpr char kStoryFor[] = "for_";
+constexpr char kStoryReduce[] = "reduce_";
+constexpr char kStorySort[] = "sort_";
+
+constexpr size_t kNumItems = 1 << 20;
+constexpr int kNumIterations = 10;
+
+perf_test::PerfResultReporter SetUpReporter(const std::string& story_name) {
+  perf_test::PerfResultReporter reporter(kMetricPrefixParallel, story_name);
+  reporter.RegisterImportantMetric(kMetricThroughput, "items/ms");
+  return reporter;
+}
+
+std::vector<size_t> GetMaxConcurrencies() {
+  std::vector<size_t> max_concurrencies = {1, 2, 4};
+  const size_t num_processors =
+      static_cast<size_t>(SysInfo::NumberOfProcessors());
+  if (num_processors > 4)
+    max_concurrencies.push_back(num_processors);
+  return max_concurrencies;
+}
+
+// A moderately expensive function, so that the work outweighs the cost of
+// claiming items.
+uint32_t Mix(uint32_t value) {
+  for (int i = 0; i < 16; ++i) {
+    value ^= value >> 16;
+    value *= 0x7feb352d;
+    value ^= value >> 15;
+  }
+  return value;
+}
+
+struct SumOfMixes {
+  uint64_t operator()(uint64_t sum, uint32_t value) const {
+    return sum + Mix(value);
+  }
+  uint64_t operator()(uint64_t sum, uint64_t other_sum) const {
+    return sum + other_sum;
+  }
+};
+
+}  // namespace
+
+class ParallelAlgorithmPerfTest : public testing::Test {
+ public:
+  ParallelAlgorithmPerfTest() = default;
+  ParallelAlgorithmPerfTest(const ParallelAlgorithmPerfTest&) = delete;
+  ParallelAlgorithmPerfTest& operator=(const ParallelAlgorithmPerfTest&) =
+      delete;
+
+ protected:
+  // Runs |run| kNumIterations times for each max concurrency, and reports the
+  // throughput of each as |story_prefix| followed by the max concurrency.
+  template <typename Run>
+  void RunTest(const std::string& story_prefix, const Run& run) {
+    for (size_t max_concurrency : GetMaxConcurrencies()) {
+      ParallelOptions options;
+      options.max_concurrency = max_concurrency;
+      TimeDelta total_time;
+      for (int i = 0; i < kNumIterations; ++i)
+        total_time += run(options);
+      auto reporter =
+          SetUpReporter(story_prefix + NumberToString(max_concurrency));
+      reporter.AddResult(kMetricThroughput, kNumItems * kNumIterations /
+                                                total_time.InMillisecondsF());
+    }
+  }
+
+  test::TaskEnvironment task_environment_;
+};
+
+TEST_F(ParallelAlgorithmPerfTest, ParallelFor) {
+  std::vector<uint32_t> data(kNumItems);
+  RunTest(kStoryFor, [&](const ParallelOptions& options) {
+    const TimeTicks start = TimeTicks::Now();
+    ParallelFor(
+        FROM_HERE, make_span(data), [](uint32_t& value) { value = Mix(value); },
+        options);
+    return TimeTicks::Now() - start;
+  });
+}
+
+TEST_F(ParallelAlgorithmPerfTest, ParallelReduce) {
+  std::vector<uint32_t> data(kNumItems);
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = static_cast<uint32_t>(i);
+  RunTest(kStoryReduce, [&](const ParallelOptions& options) {
+    const TimeTicks start = TimeTicks::Now();
+    const uint64_t result = ParallelReduce(FROM_HERE, make_span(data),
+                                           uint64_t{0}, SumOfMixes(), options);
+    const TimeDelta elapsed = TimeTicks::Now() - start;
+    EXPECT_NE(result, 0u);
+    return elapsed;
+  });
+}
+
+TEST_F(ParallelAlgorithmPerfTest, ParallelSort) {
+  std::vector<uint64_t> original(kNumItems);
+  for (uint64_t& value : original)
+    value = RandUint64();
+  RunTest(kStorySort, [&](const ParallelOptions& options) {
+    std::vector<uint64_t> data = original;
+    const TimeTicks start = TimeTicks::Now();
+    ParallelSort(FROM_HERE, make_span(data), std::less<>(), options);
+    const TimeDelta elapsed = TimeTicks::Now() - start;
+    EXPECT_TRUE(std::is_sorted(data.begin(), data.end()));
+    return elapsed;
+  });
+}
+
+}  // namespace base
@@ -0,0 +1,212 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/task/parallel_algorithm.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "base/rand_util.h"
+#include "base/synchronization/lock.h"
+#include "base/test/task_environment.h"
+#include "base/threading/platform_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+ParallelOptions WithMaxConcurrency(size_t max_concurrency) {
+  ParallelOptions options;
+  options.max_concurrency = max_concurrency;
+  return options;
+}
+
+}  // namespace
+
+class ParallelAlgorithmTest : public testing::Test {
+ protected:
+  test::TaskEnvironment task_environment_;
+};
+
+TEST_F(ParallelAlgorithmTest, ParallelForRangeCoversAllIndicesOnce) {
+  constexpr size_t kSize = 10000;
+  std::vector<std::atomic<int>> visits(kSize);
+  ParallelOptions options = WithMaxConcurrency(4);
+  options.min_chunk_size = 7;
+  std::atomic<size_t> num_short_ranges{0};
+  ParallelForRange(
+      FROM_HERE, kSize,
+      [&](size_t begin, size_t end) {
+        ASSERT_LT(begin, end);
+        ASSERT_LE(end, kSize);
+        if (end - begin < 7)
+          ++num_short_ranges;
+        for (size_t i = begin; i < end; ++i)
+          ++visits[i];
+      },
+      options);
+  for (size_t i = 0; i < kSize; ++i)
+    EXPECT_EQ(visits[i], 1) << i;
+  // Only the last range may be shorter than |min_chunk_size|.
+  EXPECT_LE(num_short_ranges, 1u);
+}
+
+TEST_F(ParallelAlgorithmTest, EmptyInput) {
+  std::vector<int> data;
+  ParallelFor(FROM_HERE, make_span(data), [](int&) { ADD_FAILURE(); });
+  ParallelForRange(FROM_HERE, 0, [](size_t, size_t) { ADD_FAILURE(); });
+  EXPECT_EQ(ParallelReduce(FROM_HERE, make_span(data), 42, std::plus<>()), 42);
+  ParallelSort(FROM_HERE, make_span(data));
+}
+
+// Inputs no larger than a chunk are processed by the calling thread.
+TEST_F(ParallelAlgorithmTest, SmallInputRunsInline) {
+  const PlatformThreadRef caller = PlatformThread::CurrentRef();
+  ParallelOptions options = WithMaxConcurrency(4);
+  options.min_chunk_size = 16;
+  int num_calls = 0;
+  ParallelForRange(
+      FROM_HERE, 16,
+      [&](size_t begin, size_t end) {
+        EXPECT_EQ(PlatformThread::CurrentRef(), caller);
+        EXPECT_EQ(begin, 0u);
+        EXPECT_EQ(end, 16u);
+        ++num_calls;
+      },
+      options);
+  EXPECT_EQ(num_calls, 1);
+}
+
+TEST_F(ParallelAlgorithmTest, MaxConcurrencyOfOneRunsInline) {
+  const PlatformThreadRef caller = PlatformThread::CurrentRef();
+  int num_calls = 0;
+  ParallelForRange(
+      FROM_HERE, 1000,
+      [&](size_t begin, size_t end) {
+        EXPECT_EQ(PlatformThread::CurrentRef(), caller);
+        ++num_calls;
+      },
+      WithMaxConcurrency(1));
+  EXPECT_EQ(num_calls, 1);
+}
+
+TEST_F(ParallelAlgorithmTest, MaxConcurrencyIsRespected) {
+  constexpr size_t kMaxConcurrency = 2;
+  Lock lock;
+  size_t concurrency = 0;
+  size_t max_observed_concurrency = 0;
+  ParallelForRange(
+      FROM_HERE, 64,
+      [&](size_t begin, size_t end) {
+        {
+          AutoLock auto_lock(lock);
+          ++concurrency;
+          max_observed_concurrency =
+              std::max(max_observed_concurrency, concurrency);
+        }
+        PlatformThread::Sleep(Milliseconds(1));
+        AutoLock auto_lock(lock);
+        --concurrency;
+      },
+      WithMaxConcurrency(kMaxConcurrency));
+  EXPECT_LE(max_observed_concurrency, kMaxConcurrency);
+}
+
+TEST_F(ParallelAlgorithmTest, ParallelFor) {
+  std::vector<int> data(5000);
+  std::iota(data.begin(), data.end(), 0);
+  ParallelFor(
+      FROM_HERE, make_span(data), [](int& value) { value *= 2; },
+      WithMaxConcurrency(4));
+  for (size_t i = 0; i < data.size(); ++i)
+    EXPECT_EQ(data[i], static_cast<int>(2 * i));
+}
+
+TEST_F(ParallelAlgorithmTest, ParallelTransform) {
+  std::vector<int> input(5000);
+  std::iota(input.begin(), input.end(), 0);
+  std::vector<std::string> output(input.size());
+  ParallelTransform(
+      FROM_HERE, make_span(input), make_span(output),
+      [](int value) { return std::to_string(value); }, WithMaxConcurrency(4));
+  for (size_t i = 0; i < input.size(); ++i)
+    EXPECT_EQ(output[i], std::to_string(i));
+}
+
+TEST_F(ParallelAlgorithmTest, ParallelReduce) {
+  std::vector<uint64_t> data(100000);
+  std::iota(data.begin(), data.end(), 1);
+  const uint64_t sum = ParallelReduce(FROM_HERE, make_span(data), uint64_t{0},
+                                      std::plus<>(), WithMaxConcurrency(4));
+  EXPECT_EQ(sum, data.size() * (data.size() + 1) / 2);
+}
+
+// Partial results are combined in order, so an associative but
+// non-commutative operation gives the same result as a sequential reduction.
+TEST_F(ParallelAlgorithmTest, ParallelReduceNonCommutative) {
+  std::vector<char> data(3000);
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = static_cast<char>('a' + i % 26);
+  ParallelOptions options = WithMaxConcurrency(4);
+  options.min_chunk_size = 10;
+  struct Concatenate {
+    std::string operator()(std::string result, char c) const {
+      return result + c;
+    }
+    std::string operator()(std::string result, std::string other) const {
+      return result + other;
+    }
+  };
+  const std::string result = ParallelReduce(FROM_HERE, make_span(data),
+                                            std::string(), Concatenate(),
+                                            options);
+  EXPECT_EQ(result, std::string(data.begin(), data.end()));
+}
+
+TEST_F(ParallelAlgorithmTest, ParallelSort) {
+  for (size_t size : {0u, 1u, 1000u, 4096u, 10001u, 100000u}) {
+    std::vector<int> data(size);
+    for (int& value : data)
+      value = static_cast<int>(RandGenerator(1000));
+    std::vector<int> expected = data;
+    std::sort(expected.begin(), expected.end());
+    ParallelSort(FROM_HERE, make_span(data), std::less<>(),
+                 WithMaxConcurrency(5));
+    EXPECT_EQ(data, expected) << size;
+  }
+}
+
+TEST_F(ParallelAlgorithmTest, ParallelSortWithComparator) {
+  std::vector<int> data(50000);
+  std::iota(data.begin(), data.end(), 0);
+  ParallelSort(FROM_HERE, make_span(data), std::greater<>(),
+               WithMaxConcurrency(4));
+  EXPECT_TRUE(std::is_sorted(data.begin(), data.end(), std::greater<>()));
+  EXPECT_EQ(data.front(), 49999);
+}
+
+TEST_F(ParallelAlgorithmTest, Nested) {
+  constexpr size_t kOuterSize = 8;
+  constexpr size_t kInnerSize = 1000;
+  std::vector<std::vector<int>> data(kOuterSize, std::vector<int>(kInnerSize));
+  ParallelFor(
+      FROM_HERE, make_span(data),
+      [](std::vector<int>& inner) {
+        ParallelFor(
+            FROM_HERE, make_span(inner), [](int& value) { ++value; },
+            WithMaxConcurrency(2));
+      },
+      WithMaxConcurrency(4));
+  for (const auto& inner : data) {
+    EXPECT_TRUE(
+        std::all_of(inner.begin(), inner.end(), [](int v) { return v == 1; }));
+  }
+}
+
+}  // namespace base
@@ -6,11 +6,13 @@
 #ifndef BASE_TASK_SEQUENCE_MANAGER_ENQUEUE_ORDER_GENERATOR_H_
 #define BASE_TASK_SEQUENCE_MANAGER_ENQUEUE_ORDER_GENERATOR_H_
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include <atomic>
 
 #include "base/base_export.h"
+#include "base/check_op.h"
 #include "base/task/sequence_manager/enqueue_order.h"
 
 namespace base {
@@ -26,12 +28,39 @@ class BASE_EXPORT EnqueueOrderGenerator {
   EnqueueOrderGenerator& operator=(const EnqueueOrderGenerator&) = delete;
   ~EnqueueOrderGenerator();
 
+  // A block of consecutive enqueue orders.
+  class Range {
+   public:
+    size_t size() const { return size_; }
+
+    EnqueueOrder operator[](size_t index) const {
+      DCHECK_LT(index, size_);
+      return EnqueueOrder(first_ + index);
+    }
+
+   private:
+    friend class EnqueueOrderGenerator;
+
+    Range(uint64_t first, size_t size) : first_(first), size_(size) {}
+
+    uint64_t first_;
+    size_t size_;
+  };
+
   // Can be called from any thread.
   EnqueueOrder GenerateNext() {
     return EnqueueOrder(std::atomic_fetch_add_explicit(
         &counter_, uint64_t(1), std::memory_order_relaxed));
   }
 
+  // Reserves |count| consecutive enqueue orders at once. Can be called from
+  // any thread.
+  Range GenerateRange(size_t count) {
+    return Range(std::atomic_fetch_add_explicit(&counter_, uint64_t{count},
+                                                std::memory_order_relaxed),
+                 count);
+  }
+
  private:
   std::atomic<uint64_t> counter_;
 };
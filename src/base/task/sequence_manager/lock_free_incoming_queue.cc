@@ -0,0 +1,153 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/task/sequence_manager/lock_free_incoming_queue.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "base/check.h"
+#include "base/check_op.h"
+#include "base/memory/raw_ptr_exclusion.h"
+
+namespace base {
+namespace sequence_manager {
+namespace internal {
+
+struct LockFreeIncomingQueue::Node {
+  explicit Node(Task task) : task(std::move(task)) {}
+
+  Task task;
+
+  // The node pushed before this one, which is older. Not a raw_ptr<...> for
+  // performance reasons: this is written on every cross-thread post.
+  RAW_PTR_EXCLUSION Node* next = nullptr;
+};
+
+LockFreeIncomingQueue::LockFreeIncomingQueue() = default;
+
+LockFreeIncomingQueue::~LockFreeIncomingQueue() {
+  Node* node = reinterpret_cast<Node*>(
+      state_.load(std::memory_order_acquire) & ~kIdleBit);
+  while (node) {
+    Node* next = node->next;
+    delete node;
+    node = next;
+  }
+}
+
+bool LockFreeIncomingQueue::Push(Task task) {
+  DCHECK(!task.enqueue_order_set());
+  Node* node = new Node(std::move(task));
+  return PushNodes(node, node);
+}
+
+bool LockFreeIncomingQueue::PushBatch(std::vector<Task> tasks) {
+  DCHECK(!tasks.empty());
+  // Link the nodes newest on top, like the stack they're pushed onto.
+  Node* bottom = nullptr;
+  Node* top = nullptr;
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    DCHECK(!tasks[i].enqueue_order_set());
+    Node* node = new Node(std::move(tasks[i]));
+    node->next = top;
+    top = node;
+    if (!bottom)
+      bottom = node;
+  }
+  return PushNodes(bottom, top);
+}
+
+bool LockFreeIncomingQueue::PushNodes(Node* bottom, Node* top) {
+  static_assert(alignof(Node) > kIdleBit,
+                "The idle bit must not be part of Node addresses");
+  // Pushing clears the idle bit. Release semantics publish the nodes to the
+  // consumer, and acquire semantics make changes made by the consumer before
+  // it marked the queue idle visible to the producer which ends that state.
+  uintptr_t state = state_.load(std::memory_order_relaxed);
+  do {
+    bottom->next = reinterpret_cast<Node*>(state & ~kIdleBit);
+  } while (!state_.compare_exchange_weak(
+      state, reinterpret_cast<uintptr_t>(top), std::memory_order_acq_rel,
+      std::memory_order_relaxed));
+  return state & kIdleBit;
+}
+
+void LockFreeIncomingQueue::TakeTasks(
+    TaskDeque* queue,
+    EnqueueOrderGenerator* enqueue_order_generator) {
+  if (empty())
+    return;
+
+  // Only the consumer marks the queue idle or takes nodes, so the queue can't
+  // become empty or idle concurrently: this doesn't affect the idle state.
+  Node* node =
+      reinterpret_cast<Node*>(state_.exchange(0, std::memory_order_acquire));
+  DCHECK(node);
+  DCHECK(!(reinterpret_cast<uintptr_t>(node) & kIdleBit));
+
+  // Reverse the stack so that the oldest node comes first.
+  Node* oldest = nullptr;
+  size_t count = 0;
+  while (node) {
+    Node* next = node->next;
+    node->next = oldest;
+    oldest = node;
+    node = next;
+    ++count;
+  }
+
+  // The enqueue orders are generated now, on the consumer's thread, so they
+  // follow both the order of the pushes and those of the tasks taken before.
+  const EnqueueOrderGenerator::Range enqueue_orders =
+      enqueue_order_generator->GenerateRange(count);
+  for (size_t i = 0; i < count; ++i) {
+    DCHECK(oldest);
+    oldest->task.set_enqueue_order(enqueue_orders[i]);
+    queue->push_back(std::move(oldest->task));
+
+    Node* next = oldest->next;
+    delete oldest;
+    oldest = next;
+  }
+}
+
+bool LockFreeIncomingQueue::TryMarkIdle() {
+  uintptr_t expected = 0;
+  if (state_.compare_exchange_strong(expected, kIdleBit,
+                                     std::memory_order_acq_rel)) {
+    return true;
+  }
+  // The queue is either already idle, or not empty.
+  return expected == kIdleBit;
+}
+
+bool LockFreeIncomingQueue::ClearIdle() {
+  return state_.fetch_and(~kIdleBit, std::memory_order_acq_rel) & kIdleBit;
+}
+
+size_t LockFreeIncomingQueue::size() const {
+  size_t size = 0;
+  for (const Node* node = reinterpret_cast<const Node*>(
+           state_.load(std::memory_order_acquire) & ~kIdleBit);
+       node; node = node->next) {
+    ++size;
+  }
+  return size;
+}
+
+std::vector<const Task*> LockFreeIncomingQueue::GetTasksForTracing() const {
+  std::vector<const Task*> tasks;
+  for (const Node* node = reinterpret_cast<const Node*>(
+           state_.load(std::memory_order_acquire) & ~kIdleBit);
+       node; node = node->next) {
+    tasks.push_back(&node->task);
+  }
+  std::reverse(tasks.begin(), tasks.end());
+  return tasks;
+}
+
+}  // namespace internal
+}  // namespace sequence_manager
+}  // namespace base
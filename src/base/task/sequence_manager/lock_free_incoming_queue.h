@@ -0,0 +1,125 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_TASK_SEQUENCE_MANAGER_LOCK_FREE_INCOMING_QUEUE_H_
+#define BASE_TASK_SEQUENCE_MANAGER_LOCK_FREE_INCOMING_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/task/sequence_manager/enqueue_order.h"
+#include "base/task/sequence_manager/enqueue_order_generator.h"
+#include "base/task/sequence_manager/lazily_deallocated_deque.h"
+#include "base/task/sequence_manager/tasks.h"
+#include "base/time/time_override.h"
+
+namespace base {
+namespace sequence_manager {
+namespace internal {
+
+// A multi-producer single-consumer queue of immediate tasks, which
+// TaskQueueImpl uses instead of its lock protected |immediate_incoming_queue|
+// when the LockFreeImmediateIncomingQueue feature is enabled. Any thread can
+// push a task with a single compare-and-swap, which links it at the top of a
+// stack. The consumer takes the whole stack at once and reverses it to
+// restore the order in which the tasks were pushed.
+//
+// The queue also carries the state of the reload handoff. The consumer marks
+// the queue idle when it finds it empty while its immediate work queue is
+// empty too, and the producer whose push ends the idle state is told so by
+// Push(): it's then responsible for requesting a reload of the work queue.
+// Since the idle bit and the top of the stack share a single atomic word, a
+// push can't go unnoticed by both the producer and the consumer.
+//
+// Producers take their sequence number before pushing, so tasks pushed
+// concurrently can be pushed out of sequence number order. The sequence number
+// is therefore only kept as the task's |sequence_num|: tasks are pushed
+// without an enqueue order, and TakeTasks() assigns them fresh ones from a
+// range reserved for the whole batch, in the order in which they were pushed.
+// This keeps enqueue orders unique and strictly increasing, as WorkQueue
+// requires. A task is ordered after every enqueue order generated before it's
+// taken, so the consumer must take the pending tasks before generating an
+// enqueue order which should come after them, like that of a fence.
+//
+// All the methods except Push() and empty() must be called on the consumer's
+// thread, which is the main thread of the TaskQueueImpl.
+class BASE_EXPORT LockFreeIncomingQueue {
+ public:
+  using TaskDeque =
+      LazilyDeallocatedDeque<Task, subtle::TimeTicksNowIgnoringOverride>;
+
+  // The queue is initially idle, like a task queue which has no task.
+  LockFreeIncomingQueue();
+  LockFreeIncomingQueue(const LockFreeIncomingQueue&) = delete;
+  LockFreeIncomingQueue& operator=(const LockFreeIncomingQueue&) = delete;
+  ~LockFreeIncomingQueue();
+
+  // Pushes `task`, which must not have an enqueue order yet. Can be called
+  // from any thread. Returns true if the queue was idle, in which case the
+  // caller must request a reload of the consumer's work queue.
+  bool Push(Task task);
+
+  // Pushes all of `tasks` with a single compare-and-swap, as if by calling
+  // Push() for each of them in order. Returns true if the queue was idle, like
+  // Push().
+  bool PushBatch(std::vector<Task> tasks);
+
+  // Returns true if no task was pushed since the last call to TakeTasks().
+  // Can be called from any thread, but the result is racy unless called on the
+  // consumer's thread and false.
+  bool empty() const {
+    return !(state_.load(std::memory_order_relaxed) & ~kIdleBit);
+  }
+
+  // Appends all the tasks pushed since the last call to `queue`, in the order
+  // in which they were pushed, and assigns them consecutive enqueue orders
+  // reserved from `enqueue_order_generator`. This doesn't affect the idle
+  // state.
+  void TakeTasks(TaskDeque* queue,
+                 EnqueueOrderGenerator* enqueue_order_generator);
+
+  // Marks the queue idle if it's empty, and returns true if the queue is now
+  // idle. Must only be called when the consumer's work queue is empty.
+  bool TryMarkIdle();
+
+  // Clears the idle state, and returns true if the queue was idle. Used when
+  // the consumer's work queue is refilled without taking tasks from this
+  // queue.
+  bool ClearIdle();
+
+  bool is_idle_for_testing() const {
+    return state_.load(std::memory_order_relaxed) & kIdleBit;
+  }
+
+  // Returns the number of tasks pushed since the last call to TakeTasks().
+  // This walks the stack and is O(n).
+  size_t size() const;
+
+  // Returns the tasks pushed since the last call to TakeTasks(), oldest first.
+  // They don't have an enqueue order yet: when taken, they'll be ordered after
+  // every enqueue order generated so far.
+  std::vector<const Task*> GetTasksForTracing() const;
+
+ private:
+  struct Node;
+
+  // The low bit of `state_` is set if the queue is idle. The other bits hold
+  // the address of the most recently pushed Node, or 0 if the queue is empty.
+  static constexpr uintptr_t kIdleBit = 1;
+
+  // Links the chain of nodes from `bottom` to `top` at the top of the stack.
+  // Returns true if the queue was idle.
+  bool PushNodes(Node* bottom, Node* top);
+
+  std::atomic<uintptr_t> state_{kIdleBit};
+};
+
+}  // namespace internal
+}  // namespace sequence_manager
+}  // namespace base
+
+#endif  // BASE_TASK_SEQUENCE_MANAGER_LOCK_FREE_INCOMING_QUEUE_H_
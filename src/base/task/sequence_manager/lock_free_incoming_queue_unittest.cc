@@ -0,0 +1,308 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/task/sequence_manager/lock_free_incoming_queue.h"
+
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/callback_helpers.h"
+#include "base/memory/raw_ptr.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/task/sequence_manager/enqueue_order_generator.h"
+#include "base/test/bind.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace sequence_manager {
+namespace internal {
+
+namespace {
+
+Task MakeTask(int id) {
+  Task task(PostedTask(nullptr, DoNothing(), FROM_HERE),
+            EnqueueOrder::FromIntForTesting(id));
+  return task;
+}
+
+std::vector<uint64_t> GetEnqueueOrders(
+    const LockFreeIncomingQueue::TaskDeque& tasks) {
+  std::vector<uint64_t> enqueue_orders;
+  for (const Task& task : tasks)
+    enqueue_orders.push_back(task.enqueue_order());
+  return enqueue_orders;
+}
+
+std::vector<int> GetSequenceNums(
+    const LockFreeIncomingQueue::TaskDeque& tasks) {
+  std::vector<int> sequence_nums;
+  for (const Task& task : tasks)
+    sequence_nums.push_back(task.sequence_num);
+  return sequence_nums;
+}
+
+}  // namespace
+
+TEST(LockFreeIncomingQueueTest, PushAndTakeInOrder) {
+  EnqueueOrderGenerator enqueue_order_generator;
+  LockFreeIncomingQueue queue;
+  EXPECT_TRUE(queue.empty());
+
+  for (int i = 2; i < 6; ++i)
+    queue.Push(MakeTask(i));
+  EXPECT_FALSE(queue.empty());
+  EXPECT_EQ(queue.size(), 4u);
+
+  // The enqueue orders are generated when the tasks are taken.
+  const EnqueueOrder first = enqueue_order_generator.GenerateNext();
+  LockFreeIncomingQueue::TaskDeque tasks;
+  queue.TakeTasks(&tasks, &enqueue_order_generator);
+  EXPECT_TRUE(queue.empty());
+  EXPECT_EQ(queue.size(), 0u);
+  EXPECT_EQ(GetEnqueueOrders(tasks),
+            (std::vector<uint64_t>{first + 1, first + 2, first + 3,
+                                   first + 4}));
+
+  // Taking from an empty queue does nothing.
+  queue.TakeTasks(&tasks, &enqueue_order_generator);
+  EXPECT_EQ(tasks.size(), 4u);
+  EXPECT_EQ(enqueue_order_generator.GenerateNext(), first + 5);
+}
+
+// Tasks pushed out of sequence number order get fresh, strictly increasing
+// enqueue orders, including across calls to TakeTasks(), and keep their
+// sequence numbers.
+TEST(LockFreeIncomingQueueTest, EnqueueOrdersAreStrictlyIncreasing) {
+  EnqueueOrderGenerator enqueue_order_generator;
+  LockFreeIncomingQueue queue;
+  queue.Push(MakeTask(5));
+  queue.Push(MakeTask(3));
+  queue.Push(MakeTask(7));
+
+  LockFreeIncomingQueue::TaskDeque tasks;
+  queue.TakeTasks(&tasks, &enqueue_order_generator);
+  EXPECT_EQ(GetEnqueueOrders(tasks), (std::vector<uint64_t>{2, 3, 4}));
+  EXPECT_EQ(GetSequenceNums(tasks), (std::vector<int>{5, 3, 7}));
+
+  queue.Push(MakeTask(6));
+  queue.Push(MakeTask(9));
+  queue.TakeTasks(&tasks, &enqueue_order_generator);
+  EXPECT_EQ(GetEnqueueOrders(tasks), (std::vector<uint64_t>{2, 3, 4, 5, 6}));
+}
+
+TEST(LockFreeIncomingQueueTest, PushBatch) {
+  EnqueueOrderGenerator enqueue_order_generator;
+  LockFreeIncomingQueue queue;
+  EXPECT_TRUE(queue.Push(MakeTask(2)));
+
+  std::vector<Task> batch;
+  for (int i = 3; i < 6; ++i)
+    batch.push_back(MakeTask(i));
+  EXPECT_FALSE(queue.PushBatch(std::move(batch)));
+  EXPECT_EQ(queue.size(), 4u);
+
+  LockFreeIncomingQueue::TaskDeque tasks;
+  queue.TakeTasks(&tasks, &enqueue_order_generator);
+  EXPECT_EQ(GetEnqueueOrders(tasks), (std::vector<uint64_t>{2, 3, 4, 5}));
+  EXPECT_EQ(GetSequenceNums(tasks), (std::vector<int>{2, 3, 4, 5}));
+
+  // A batch which ends the idle state reports it.
+  EXPECT_TRUE(queue.TryMarkIdle());
+  batch.clear();
+  for (int i = 6; i < 8; ++i)
+    batch.push_back(MakeTask(i));
+  EXPECT_TRUE(queue.PushBatch(std::move(batch)));
+  EXPECT_EQ(queue.size(), 2u);
+}
+
+TEST(LockFreeIncomingQueueTest, IdleHandoff) {
+  LockFreeIncomingQueue queue;
+  EXPECT_TRUE(queue.is_idle_for_testing());
+
+  // Only the first push after the queue becomes idle reports it.
+  EXPECT_TRUE(queue.Push(MakeTask(2)));
+  EXPECT_FALSE(queue.is_idle_for_testing());
+  EXPECT_FALSE(queue.Push(MakeTask(3)));
+
+  // The queue can't become idle while it has tasks.
+  EXPECT_FALSE(queue.TryMarkIdle());
+  EnqueueOrderGenerator enqueue_order_generator;
+  LockFreeIncomingQueue::TaskDeque tasks;
+  queue.TakeTasks(&tasks, &enqueue_order_generator);
+  EXPECT_FALSE(queue.is_idle_for_testing());
+  EXPECT_TRUE(queue.TryMarkIdle());
+  EXPECT_TRUE(queue.TryMarkIdle());
+  EXPECT_TRUE(queue.is_idle_for_testing());
+  EXPECT_TRUE(queue.empty());
+
+  EXPECT_TRUE(queue.ClearIdle());
+  EXPECT_FALSE(queue.ClearIdle());
+  EXPECT_FALSE(queue.Push(MakeTask(4)));
+}
+
+TEST(LockFreeIncomingQueueTest, DestroyWithTasks) {
+  bool destroyed = false;
+  {
+    ScopedClosureRunner runner(
+        BindLambdaForTesting([&]() { destroyed = true; }));
+    OnceClosure callback =
+        BindOnce([](ScopedClosureRunner) {}, std::move(runner));
+    Task task(PostedTask(nullptr, std::move(callback), FROM_HERE),
+              EnqueueOrder::FromIntForTesting(2));
+    LockFreeIncomingQueue queue;
+    queue.Push(std::move(task));
+    EXPECT_FALSE(destroyed);
+  }
+  EXPECT_TRUE(destroyed);
+}
+
+// Tasks pushed concurrently by several threads are all taken exactly once, in
+// the order in which each thread pushed them, with strictly increasing enqueue
+// orders, and exactly one push per idle period reports the end of the idle
+// state.
+TEST(LockFreeIncomingQueueTest, ConcurrentPushes) {
+  constexpr int kNumThreads = 4;
+  constexpr int kNumTasksPerThread = 10000;
+
+  class PushThread : public SimpleThread {
+   public:
+    PushThread(LockFreeIncomingQueue* queue,
+               int thread_index,
+               WaitableEvent* start,
+               std::atomic<int>* num_idle_pushes)
+        : SimpleThread("PushThread"),
+          queue_(queue),
+          thread_index_(thread_index),
+          start_(start),
+          num_idle_pushes_(num_idle_pushes) {}
+
+    void Run() override {
+      start_->Wait();
+      for (int i = 0; i < kNumTasksPerThread; ++i) {
+        // Encode the thread and the task index in the sequence number.
+        const int id = 2 + thread_index_ * kNumTasksPerThread + i;
+        if (queue_->Push(MakeTask(id)))
+          num_idle_pushes_->fetch_add(1);
+      }
+    }
+
+   private:
+    const raw_ptr<LockFreeIncomingQueue> queue_;
+    const int thread_index_;
+    const raw_ptr<WaitableEvent> start_;
+    const raw_ptr<std::atomic<int>> num_idle_pushes_;
+  };
+
+  EnqueueOrderGenerator enqueue_order_generator;
+  LockFreeIncomingQueue queue;
+  WaitableEvent start;
+  std::atomic<int> num_idle_pushes{0};
+  std::vector<std::unique_ptr<PushThread>> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.push_back(
+        std::make_unique<PushThread>(&queue, i, &start, &num_idle_pushes));
+    threads.back()->Start();
+  }
+  start.Signal();
+
+  std::vector<int> next_index(kNumThreads, 0);
+  int num_taken = 0;
+  bool idle = true;
+  int num_idle_periods = 1;
+  uint64_t last_enqueue_order = 0;
+  while (num_taken < kNumThreads * kNumTasksPerThread) {
+    LockFreeIncomingQueue::TaskDeque tasks;
+    queue.TakeTasks(&tasks, &enqueue_order_generator);
+    if (!tasks.empty())
+      idle = false;
+    for (const Task& task : tasks) {
+      EXPECT_GT(task.enqueue_order(), last_enqueue_order);
+      last_enqueue_order = task.enqueue_order();
+      const int id = task.sequence_num - 2;
+      const int thread_index = id / kNumTasksPerThread;
+      EXPECT_EQ(id % kNumTasksPerThread, next_index[thread_index]++);
+      ++num_taken;
+    }
+    if (tasks.empty() && !idle && queue.TryMarkIdle()) {
+      idle = true;
+      ++num_idle_periods;
+    }
+  }
+  for (auto& thread : threads)
+    thread->Join();
+
+  // Every idle period but the last one was ended by exactly one push.
+  if (queue.is_idle_for_testing())
+    --num_idle_periods;
+  EXPECT_EQ(num_idle_pushes.load(), num_idle_periods);
+  EXPECT_TRUE(queue.empty());
+}
+
+// Two producers race between taking their sequence number from the shared
+// generator and pushing, so their tasks are often pushed out of sequence
+// number order. The enqueue orders must still come out unique and strictly
+// increasing, and after the sequence numbers of the tasks they're assigned to,
+// as WorkQueue and fences require.
+TEST(LockFreeIncomingQueueTest, RacingProducersGetStrictlyIncreasingOrders) {
+  constexpr int kNumTasksPerThread = 20000;
+
+  class ProducerThread : public SimpleThread {
+   public:
+    ProducerThread(LockFreeIncomingQueue* queue,
+                   EnqueueOrderGenerator* enqueue_order_generator,
+                   WaitableEvent* start)
+        : SimpleThread("ProducerThread"),
+          queue_(queue),
+          enqueue_order_generator_(enqueue_order_generator),
+          start_(start) {}
+
+    void Run() override {
+      start_->Wait();
+      for (int i = 0; i < kNumTasksPerThread; ++i) {
+        Task task(PostedTask(nullptr, DoNothing(), FROM_HERE),
+                  enqueue_order_generator_->GenerateNext());
+        queue_->Push(std::move(task));
+      }
+    }
+
+   private:
+    const raw_ptr<LockFreeIncomingQueue> queue_;
+    const raw_ptr<EnqueueOrderGenerator> enqueue_order_generator_;
+    const raw_ptr<WaitableEvent> start_;
+  };
+
+  EnqueueOrderGenerator enqueue_order_generator;
+  LockFreeIncomingQueue queue;
+  WaitableEvent start;
+  ProducerThread first_producer(&queue, &enqueue_order_generator, &start);
+  ProducerThread second_producer(&queue, &enqueue_order_generator, &start);
+  first_producer.Start();
+  second_producer.Start();
+  start.Signal();
+
+  int num_taken = 0;
+  uint64_t last_enqueue_order = 0;
+  while (num_taken < 2 * kNumTasksPerThread) {
+    LockFreeIncomingQueue::TaskDeque tasks;
+    queue.TakeTasks(&tasks, &enqueue_order_generator);
+    for (const Task& task : tasks) {
+      ASSERT_GT(task.enqueue_order(), last_enqueue_order);
+      ASSERT_GT(task.enqueue_order(),
+                static_cast<uint64_t>(task.sequence_num));
+      last_enqueue_order = task.enqueue_order();
+      ++num_taken;
+    }
+  }
+  first_producer.Join();
+  second_producer.Join();
+  EXPECT_TRUE(queue.empty());
+}
+
+}  // namespace internal
+}  // namespace sequence_manager
+}  // namespace base
@@ -1027,6 +1027,11 @@ EnqueueOrder SequenceManagerImpl::GetNextSequenceNumber() {
   return enqueue_order_generator_.GenerateNext();
 }
 
+EnqueueOrderGenerator::Range SequenceManagerImpl::GetNextSequenceNumbers(
+    size_t count) {
+  return enqueue_order_generator_.GenerateRange(count);
+}
+
 std::unique_ptr<trace_event::ConvertableToTraceFormat>
 SequenceManagerImpl::AsValueWithSelectorResultForTracing(
     internal::WorkQueue* selected_work_queue,
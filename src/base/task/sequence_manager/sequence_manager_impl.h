@@ -374,6 +374,15 @@ class BASE_EXPORT SequenceManagerImpl
 
   EnqueueOrder GetNextSequenceNumber();
 
+  // Reserves |count| consecutive sequence numbers at once.
+  EnqueueOrderGenerator::Range GetNextSequenceNumbers(size_t count);
+
+  // Used by lock-free incoming queues to reserve the enqueue orders of the
+  // tasks they hand over.
+  EnqueueOrderGenerator* enqueue_order_generator() {
+    return &enqueue_order_generator_;
+  }
+
   bool GetAddQueueTimeToTasks();
 
   std::unique_ptr<trace_event::ConvertableToTraceFormat>
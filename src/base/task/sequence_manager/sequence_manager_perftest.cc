@@ -22,10 +22,12 @@
 #include "base/task/sequence_manager/test/test_task_time_observer.h"
 #include "base/task/sequence_manager/thread_controller_with_message_pump_impl.h"
 #include "base/task/single_thread_task_runner.h"
+#include "base/task/task_features.h"
 #include "base/task/task_traits.h"
 #include "base/task/thread_pool.h"
 #include "base/task/thread_pool/thread_pool_impl.h"
 #include "base/task/thread_pool/thread_pool_instance.h"
+#include "base/test/scoped_feature_list.h"
 #include "base/threading/thread.h"
 #include "base/threading/thread_task_runner_handle.h"
 #include "base/time/default_tick_clock.h"
@@ -524,6 +526,72 @@ class TwoThreadTestCase : public TestCase {
   int done_count_ = 0;
 };
 
+// Posts immediate tasks from several auxiliary threads at once, to measure
+// contention on the incoming queues.
+class MultiThreadTestCase : public TestCase {
+ public:
+  MultiThreadTestCase(PerfTestDelegate* delegate,
+                      std::vector<scoped_refptr<TaskRunner>> task_runners,
+                      size_t num_threads)
+      : TestCase(delegate), task_runners_(std::move(task_runners)) {
+    for (size_t i = 0; i < num_threads; i++) {
+      auxiliary_threads_.push_back(
+          std::make_unique<Thread>("auxiliary thread"));
+      auxiliary_threads_.back()->Start();
+    }
+  }
+
+  ~MultiThreadTestCase() override {
+    for (auto& thread : auxiliary_threads_)
+      thread->Stop();
+  }
+
+ protected:
+  void Start() override {
+    done_count_ = 0;
+    task_sources_.clear();
+    for (auto& thread : auxiliary_threads_) {
+      task_sources_.push_back(std::make_unique<CrossThreadImmediateTaskSource>(
+          this, task_runners_, kNumTasks / auxiliary_threads_.size()));
+      thread->task_runner()->PostTask(
+          FROM_HERE, base::BindOnce(&CrossThreadImmediateTaskSource::Start,
+                                    Unretained(task_sources_.back().get())));
+    }
+  }
+
+  class CrossThreadImmediateTaskSource : public CrossThreadTaskSource {
+   public:
+    CrossThreadImmediateTaskSource(
+        MultiThreadTestCase* multi_thread_test_case,
+        std::vector<scoped_refptr<TaskRunner>> task_runners,
+        size_t num_tasks)
+        : CrossThreadTaskSource(std::move(task_runners), num_tasks),
+          multi_thread_test_case_(multi_thread_test_case) {}
+
+    ~CrossThreadImmediateTaskSource() override = default;
+
+    void PostTask(unsigned int queue) override {
+      task_runners_[queue]->PostTask(FROM_HERE, task_closure_);
+    }
+
+    // Will be called on the main thread.
+    void SignalDone() override { multi_thread_test_case_->SignalDone(); }
+
+    raw_ptr<MultiThreadTestCase> multi_thread_test_case_;  // NOT OWNED.
+  };
+
+  void SignalDone() {
+    if (++done_count_ == auxiliary_threads_.size())
+      delegate_->SignalDone();
+  }
+
+ private:
+  const std::vector<scoped_refptr<TaskRunner>> task_runners_;
+  std::vector<std::unique_ptr<Thread>> auxiliary_threads_;
+  std::vector<std::unique_ptr<CrossThreadImmediateTaskSource>> task_sources_;
+  size_t done_count_ = 0;
+};
+
 class SequenceManagerPerfTest : public testing::TestWithParam<PerfTestType> {
  public:
   SequenceManagerPerfTest() = default;
@@ -724,6 +792,37 @@ TEST_P(SequenceManagerPerfTest,
             &task_source);
 }
 
+TEST_P(SequenceManagerPerfTest, PostImmediateTasksFromFourThreads_OneQueue) {
+  MultiThreadTestCase task_source(delegate_.get(), CreateTaskRunners(1), 4);
+  Benchmark("post immediate tasks with one queue from four threads",
+            &task_source);
+}
+
+TEST_P(SequenceManagerPerfTest,
+       PostImmediateTasksFromFourThreads_OneQueue_LockFreeIncomingQueue) {
+  // The ThreadPool's single thread task runners aren't backed by a
+  // TaskQueueImpl.
+  if (!delegate_->MultipleQueuesSupported()) {
+    LOG(INFO) << "Unsupported";
+    return;
+  }
+
+  test::ScopedFeatureList scoped_feature_list(
+      kLockFreeImmediateIncomingQueue);
+  internal::TaskQueueImpl::InitializeFeatures();
+  {
+    MultiThreadTestCase task_source(delegate_.get(), CreateTaskRunners(1), 4);
+    Benchmark(
+        "post immediate tasks with one queue from four threads with a "
+        "lock-free incoming queue",
+        &task_source);
+  }
+  // Task queues read the feature when they are created, so the task queue
+  // created above keeps using the lock-free incoming queue until TearDown().
+  scoped_feature_list.Reset();
+  internal::TaskQueueImpl::InitializeFeatures();
+}
+
 // TODO(alexclarke): Add additional tests with different mixes of non-delayed vs
 // delayed tasks.
 
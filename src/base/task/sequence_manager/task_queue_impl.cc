@@ -23,6 +23,7 @@
 #include "base/task/default_delayed_task_handle_delegate.h"
 #include "base/task/sequence_manager/associated_thread_id.h"
 #include "base/task/sequence_manager/delayed_task_handle_delegate.h"
+#include "base/task/sequence_manager/enqueue_order_generator.h"
 #include "base/task/sequence_manager/fence.h"
 #include "base/task/sequence_manager/sequence_manager_impl.h"
 #include "base/task/sequence_manager/task_order.h"
@@ -75,12 +76,14 @@ namespace internal {
 namespace {
 
 // Cache of the state of the kRemoveCanceledTasksInTaskQueue,
-// kSweepCancelledTasks and kExplicitHighResolutionTimerWin features. This
+// kSweepCancelledTasks, kLockFreeImmediateIncomingQueue and
+// kExplicitHighResolutionTimerWin features. This
 // avoids the need to constantly query their enabled state through
 // FeatureList::IsEnabled().
 bool g_is_remove_canceled_tasks_in_task_queue_enabled = false;
 bool g_is_sweep_cancelled_tasks_enabled =
     kSweepCancelledTasks.default_state == FEATURE_ENABLED_BY_DEFAULT;
+bool g_is_lock_free_immediate_incoming_queue_enabled = false;
 #if BUILDFLAG(IS_WIN)
 // An atomic is used here because the flag is queried from other threads when
 // tasks are posted cross-thread, which can race with its initialization.
@@ -107,6 +110,19 @@ bool TaskQueueImpl::GuardedTaskPoster::PostTask(PostedTask task) {
   return true;
 }
 
+bool TaskQueueImpl::GuardedTaskPoster::PostTasks(
+    std::vector<PostedTask> tasks) {
+  // See PostTask().
+  ScopedDeferTaskPosting disallow_task_posting;
+
+  auto token = operations_controller_.TryBeginOperation();
+  if (!token)
+    return false;
+
+  outer_->PostTasks(std::move(tasks));
+  return true;
+}
+
 DelayedTaskHandle TaskQueueImpl::GuardedTaskPoster::PostCancelableTask(
     PostedTask task) {
   // Do not process new PostTasks while we are handling a PostTask (tracing
@@ -196,6 +212,19 @@ bool TaskQueueImpl::TaskRunner::PostNonNestableDelayedTask(
                                            task_type_));
 }
 
+bool TaskQueueImpl::TaskRunner::PostTasks(const Location& location,
+                                          span<OnceClosure> callbacks) {
+  if (callbacks.empty())
+    return true;
+  std::vector<PostedTask> tasks;
+  tasks.reserve(callbacks.size());
+  for (OnceClosure& callback : callbacks) {
+    tasks.emplace_back(this, std::move(callback), location, TimeDelta(),
+                       Nestable::kNestable, task_type_);
+  }
+  return task_poster_->PostTasks(std::move(tasks));
+}
+
 bool TaskQueueImpl::TaskRunner::RunsTasksInCurrentSequence() const {
   return associated_thread_->IsBoundToCurrentThread();
 }
@@ -205,6 +234,8 @@ void TaskQueueImpl::InitializeFeatures() {
   ApplyRemoveCanceledTasksInTaskQueue();
   g_is_sweep_cancelled_tasks_enabled =
       FeatureList::IsEnabled(kSweepCancelledTasks);
+  g_is_lock_free_immediate_incoming_queue_enabled =
+      FeatureList::IsEnabled(kLockFreeImmediateIncomingQueue);
 #if BUILDFLAG(IS_WIN)
   g_explicit_high_resolution_timer_win.store(
       FeatureList::IsEnabled(kExplicitHighResolutionTimerWin),
@@ -249,7 +280,9 @@ TaskQueueImpl::TaskQueueImpl(SequenceManagerImpl* sequence_manager,
               : AtomicFlagSet::AtomicFlag()),
       should_monitor_quiescence_(spec.should_monitor_quiescence),
       should_notify_observers_(spec.should_notify_observers),
-      delayed_fence_allowed_(spec.delayed_fence_allowed) {
+      delayed_fence_allowed_(spec.delayed_fence_allowed),
+      use_lock_free_immediate_incoming_queue_(
+          g_is_lock_free_immediate_incoming_queue_enabled) {
   UpdateCrossThreadQueueStateLocked();
   // SequenceManager can't be set later, so we need to prevent task runners
   // from posting any tasks.
@@ -307,6 +340,7 @@ void TaskQueueImpl::UnregisterTaskQueue() {
   {
     base::internal::CheckedAutoLock lock(any_thread_lock_);
     any_thread_.unregistered = true;
+    TakeLockFreeImmediateIncomingTasksLocked();
     immediate_incoming_queue.swap(any_thread_.immediate_incoming_queue);
 
     for (auto& handler : any_thread_.on_task_posted_handlers)
@@ -372,6 +406,83 @@ void TaskQueueImpl::PostTask(PostedTask task) {
   }
 }
 
+void TaskQueueImpl::PostTasks(std::vector<PostedTask> tasks) {
+  CurrentThread current_thread =
+      associated_thread_->IsBoundToCurrentThread()
+          ? TaskQueueImpl::CurrentThread::kMainThread
+          : TaskQueueImpl::CurrentThread::kNotMainThread;
+
+#if DCHECK_IS_ON()
+  // A delay adjustment turns the tasks into delayed tasks, which aren't
+  // batched.
+  if (!GetTaskDelayAdjustment(current_thread).is_zero()) {
+    for (PostedTask& task : tasks)
+      PostTask(std::move(task));
+    return;
+  }
+#endif  // DCHECK_IS_ON()
+
+  for (const PostedTask& task : tasks) {
+    // Use CHECK instead of DCHECK to crash earlier. See
+    // http://crbug.com/711167 for details.
+    CHECK(task.callback);
+    DCHECK(!task.is_delayed());
+    MaybeLogPostTask(task);
+  }
+
+  if (use_lock_free_immediate_incoming_queue_) {
+    PostImmediateTasksLockFree(std::move(tasks), current_thread);
+    return;
+  }
+
+  bool should_schedule_work = false;
+  {
+    base::internal::CheckedAutoLock lock(any_thread_lock_);
+    bool add_queue_time_to_tasks = sequence_manager_->GetAddQueueTimeToTasks();
+    TimeTicks queue_time;
+    if (add_queue_time_to_tasks || delayed_fence_allowed_)
+      queue_time = sequence_manager_->any_thread_clock()->NowTicks();
+
+    // See PostImmediateTaskImpl() for why the sequence numbers are reserved
+    // under the lock.
+    const EnqueueOrderGenerator::Range sequence_numbers =
+        sequence_manager_->GetNextSequenceNumbers(tasks.size());
+    bool was_immediate_incoming_queue_empty =
+        any_thread_.immediate_incoming_queue.empty();
+    for (size_t i = 0; i < tasks.size(); ++i) {
+      any_thread_.immediate_incoming_queue.push_back(
+          Task(std::move(tasks[i]), sequence_numbers[i], sequence_numbers[i],
+               queue_time));
+      Task& pending_task = any_thread_.immediate_incoming_queue.back();
+#if DCHECK_IS_ON()
+      pending_task.cross_thread_ =
+          (current_thread == TaskQueueImpl::CurrentThread::kNotMainThread);
+#endif
+
+      sequence_manager_->WillQueueTask(&pending_task, name_);
+      MaybeReportIpcTaskQueuedFromAnyThreadLocked(pending_task, name_);
+
+      for (auto& handler : any_thread_.on_task_posted_handlers) {
+        DCHECK(!handler.second.is_null());
+        handler.second.Run(pending_task);
+      }
+    }
+
+    // See PostImmediateTaskImpl().
+    if (was_immediate_incoming_queue_empty &&
+        any_thread_.immediate_work_queue_empty) {
+      empty_queues_to_reload_handle_.SetActive(true);
+      should_schedule_work =
+          any_thread_.post_immediate_task_should_schedule_work;
+    }
+  }
+
+  if (should_schedule_work)
+    sequence_manager_->ScheduleWork();
+
+  TraceQueueSize();
+}
+
 void TaskQueueImpl::RemoveCancelableTask(HeapHandle heap_handle) {
   // Can only cancel from the current thread.
   DCHECK(associated_thread_->IsBoundToCurrentThread());
@@ -426,6 +537,11 @@ void TaskQueueImpl::PostImmediateTaskImpl(PostedTask task,
   // for details.
   CHECK(task.callback);
 
+  if (use_lock_free_immediate_incoming_queue_) {
+    PostImmediateTaskLockFree(std::move(task), current_thread);
+    return;
+  }
+
   bool should_schedule_work = false;
   {
     // TODO(alexclarke): Maybe add a main thread only immediate_incoming_queue
@@ -490,6 +606,91 @@ void TaskQueueImpl::PostImmediateTaskImpl(PostedTask task,
   TraceQueueSize();
 }
 
+void TaskQueueImpl::PostImmediateTaskLockFree(PostedTask task,
+                                              CurrentThread current_thread) {
+  TimeTicks queue_time;
+  if (sequence_manager_->GetAddQueueTimeToTasks() || delayed_fence_allowed_)
+    queue_time = sequence_manager_->any_thread_clock()->NowTicks();
+
+  // Unlike in PostImmediateTaskImpl(), the sequence number isn't taken
+  // atomically with the push, so it isn't used as the enqueue order.
+  // LockFreeIncomingQueue assigns fresh enqueue orders when the task is taken.
+  EnqueueOrder sequence_number = sequence_manager_->GetNextSequenceNumber();
+  Task pending_task(std::move(task), sequence_number, EnqueueOrder(),
+                    queue_time);
+#if DCHECK_IS_ON()
+  pending_task.cross_thread_ =
+      (current_thread == TaskQueueImpl::CurrentThread::kNotMainThread);
+#endif
+
+  sequence_manager_->WillQueueTask(&pending_task, name_);
+  MaybeReportIpcTaskQueuedFromAnyThreadUnlocked(pending_task, name_);
+
+  if (has_on_task_posted_handlers_.load(std::memory_order_relaxed)) {
+    base::internal::CheckedAutoLock lock(any_thread_lock_);
+    for (auto& handler : any_thread_.on_task_posted_handlers) {
+      DCHECK(!handler.second.is_null());
+      handler.second.Run(pending_task);
+    }
+  }
+
+  // If the queue was idle, i.e. this queue was completely empty, then the
+  // SequenceManager needs to be informed so it can reload the work queue, and
+  // it may need to schedule a DoWork. See PostImmediateTaskImpl().
+  if (lock_free_immediate_incoming_queue_.Push(std::move(pending_task))) {
+    empty_queues_to_reload_handle_.SetActive(true);
+    if (post_immediate_task_should_schedule_work_.load())
+      sequence_manager_->ScheduleWork();
+  }
+
+  TraceQueueSize();
+}
+
+void TaskQueueImpl::PostImmediateTasksLockFree(std::vector<PostedTask> tasks,
+                                               CurrentThread current_thread) {
+  TimeTicks queue_time;
+  if (sequence_manager_->GetAddQueueTimeToTasks() || delayed_fence_allowed_)
+    queue_time = sequence_manager_->any_thread_clock()->NowTicks();
+
+  const EnqueueOrderGenerator::Range sequence_numbers =
+      sequence_manager_->GetNextSequenceNumbers(tasks.size());
+  const bool has_on_task_posted_handlers =
+      has_on_task_posted_handlers_.load(std::memory_order_relaxed);
+  std::vector<Task> pending_tasks;
+  pending_tasks.reserve(tasks.size());
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    pending_tasks.emplace_back(std::move(tasks[i]), sequence_numbers[i],
+                               EnqueueOrder(), queue_time);
+    Task& pending_task = pending_tasks.back();
+#if DCHECK_IS_ON()
+    pending_task.cross_thread_ =
+        (current_thread == TaskQueueImpl::CurrentThread::kNotMainThread);
+#endif
+
+    sequence_manager_->WillQueueTask(&pending_task, name_);
+    MaybeReportIpcTaskQueuedFromAnyThreadUnlocked(pending_task, name_);
+  }
+
+  if (has_on_task_posted_handlers) {
+    base::internal::CheckedAutoLock lock(any_thread_lock_);
+    for (const Task& pending_task : pending_tasks) {
+      for (auto& handler : any_thread_.on_task_posted_handlers) {
+        DCHECK(!handler.second.is_null());
+        handler.second.Run(pending_task);
+      }
+    }
+  }
+
+  // See PostImmediateTaskLockFree().
+  if (lock_free_immediate_incoming_queue_.PushBatch(std::move(pending_tasks))) {
+    empty_queues_to_reload_handle_.SetActive(true);
+    if (post_immediate_task_should_schedule_work_.load())
+      sequence_manager_->ScheduleWork();
+  }
+
+  TraceQueueSize();
+}
+
 void TaskQueueImpl::PostDelayedTaskImpl(PostedTask posted_task,
                                         CurrentThread current_thread) {
   // Use CHECK instead of DCHECK to crash earlier. See http://crbug.com/711167
@@ -571,6 +772,13 @@ void TaskQueueImpl::ScheduleDelayedWorkTask(Task pending_task) {
 }
 
 void TaskQueueImpl::ReloadEmptyImmediateWorkQueue() {
+  // With the lock-free incoming queue, a reload can be requested concurrently
+  // with RequeueDeferredNonNestableTask() refilling the immediate work queue.
+  // The incoming tasks are then taken once the work queue is empty again.
+  if (use_lock_free_immediate_incoming_queue_ &&
+      !main_thread_only().immediate_work_queue->Empty()) {
+    return;
+  }
   DCHECK(main_thread_only().immediate_work_queue->Empty());
   main_thread_only().immediate_work_queue->TakeImmediateIncomingQueueTasks();
 
@@ -582,8 +790,20 @@ void TaskQueueImpl::ReloadEmptyImmediateWorkQueue() {
 void TaskQueueImpl::TakeImmediateIncomingQueueTasks(TaskDeque* queue) {
   base::internal::CheckedAutoLock lock(any_thread_lock_);
   DCHECK(queue->empty());
+  TakeLockFreeImmediateIncomingTasksLocked();
   queue->swap(any_thread_.immediate_incoming_queue);
 
+  if (use_lock_free_immediate_incoming_queue_) {
+    // If there is no task to take, the immediate work queue remains empty, so
+    // mark the lock-free queue idle to have the next post request a reload.
+    // That fails if a task was posted in the meantime, which is taken instead.
+    while (queue->empty() &&
+           !lock_free_immediate_incoming_queue_.TryMarkIdle()) {
+      lock_free_immediate_incoming_queue_.TakeTasks(
+          queue, sequence_manager_->enqueue_order_generator());
+    }
+  }
+
   // Since |immediate_incoming_queue| is empty, now is a good time to consider
   // reducing it's capacity if we're wasting memory.
   any_thread_.immediate_incoming_queue.MaybeShrinkQueue();
@@ -622,6 +842,9 @@ bool TaskQueueImpl::IsEmpty() const {
     return false;
   }
 
+  if (HasLockFreeImmediateIncomingTasks())
+    return false;
+
   base::internal::CheckedAutoLock lock(any_thread_lock_);
   return any_thread_.immediate_incoming_queue.empty();
 }
@@ -632,6 +855,9 @@ size_t TaskQueueImpl::GetNumberOfPendingTasks() const {
   task_count += main_thread_only().delayed_incoming_queue.size();
   task_count += main_thread_only().immediate_work_queue->Size();
 
+  if (use_lock_free_immediate_incoming_queue_)
+    task_count += lock_free_immediate_incoming_queue_.size();
+
   base::internal::CheckedAutoLock lock(any_thread_lock_);
   task_count += any_thread_.immediate_incoming_queue.size();
   return task_count;
@@ -653,6 +879,8 @@ bool TaskQueueImpl::HasTaskToRunImmediatelyOrReadyDelayedTask() const {
   }
 
   // Finally tasks on |immediate_incoming_queue| count as immediate work.
+  if (HasLockFreeImmediateIncomingTasks())
+    return true;
   base::internal::CheckedAutoLock lock(any_thread_lock_);
   return !any_thread_.immediate_incoming_queue.empty();
 }
@@ -710,6 +938,16 @@ bool TaskQueueImpl::RemoveAllCanceledDelayedTasksFromFront(LazyNow* lazy_now) {
 void TaskQueueImpl::MoveReadyDelayedTasksToWorkQueue(
     LazyNow* lazy_now,
     EnqueueOrder enqueue_order) {
+  // Tasks in the lock-free queue get their enqueue order when taken. Take them
+  // before ordering the ready tasks, so that those posted before a delayed
+  // fence activated below aren't blocked by it.
+  if (use_lock_free_immediate_incoming_queue_ &&
+      main_thread_only().delayed_fence) {
+    base::internal::CheckedAutoLock lock(any_thread_lock_);
+    TakeLockFreeImmediateIncomingTasksLocked();
+    enqueue_order = sequence_manager_->GetNextSequenceNumber();
+  }
+
   // Enqueue all delayed tasks that should be running now, skipping any that
   // have been canceled.
   WorkQueue::TaskPusher delayed_work_queue_task_pusher(
@@ -771,6 +1009,9 @@ void TaskQueueImpl::TraceQueueSize() const {
   {
     base::internal::CheckedAutoLock lock(any_thread_lock_);
     total_task_count = any_thread_.immediate_incoming_queue.size() +
+                       (use_lock_free_immediate_incoming_queue_
+                            ? lock_free_immediate_incoming_queue_.size()
+                            : 0u) +
                        main_thread_only().immediate_work_queue->Size() +
                        main_thread_only().delayed_work_queue->Size() +
                        main_thread_only().delayed_incoming_queue.size();
@@ -838,6 +1079,10 @@ Value::Dict TaskQueueImpl::AsValue(TimeTicks now, bool force_verbose) const {
   // remove the various static_casts below.
   state.Set("any_thread_.immediate_incoming_queuesize",
             static_cast<int>(any_thread_.immediate_incoming_queue.size()));
+  if (use_lock_free_immediate_incoming_queue_) {
+    state.Set("lock_free_immediate_incoming_queue_size",
+              static_cast<int>(lock_free_immediate_incoming_queue_.size()));
+  }
   state.Set("delayed_incoming_queue_size",
             static_cast<int>(main_thread_only().delayed_incoming_queue.size()));
   state.Set("immediate_work_queue_size",
@@ -881,8 +1126,15 @@ Value::Dict TaskQueueImpl::AsValue(TimeTicks now, bool force_verbose) const {
       &verbose);
 
   if (verbose || force_verbose) {
-    state.Set("immediate_incoming_queue",
-              QueueAsValue(any_thread_.immediate_incoming_queue, now));
+    Value::List immediate_incoming_queue =
+        QueueAsValue(any_thread_.immediate_incoming_queue, now);
+    if (use_lock_free_immediate_incoming_queue_) {
+      for (const Task* task :
+           lock_free_immediate_incoming_queue_.GetTasksForTracing()) {
+        immediate_incoming_queue.Append(TaskAsValue(*task, now));
+      }
+    }
+    state.Set("immediate_incoming_queue", std::move(immediate_incoming_queue));
     state.Set("delayed_work_queue",
               main_thread_only().delayed_work_queue->AsValue(now));
     state.Set("immediate_work_queue",
@@ -926,6 +1178,13 @@ void TaskQueueImpl::SetBlameContext(trace_event::BlameContext* blame_context) {
 }
 
 void TaskQueueImpl::InsertFence(TaskQueue::InsertFencePosition position) {
+  if (position == TaskQueue::InsertFencePosition::kNow &&
+      use_lock_free_immediate_incoming_queue_) {
+    // The tasks already posted must be ordered before the fence, but they only
+    // get their enqueue order when taken.
+    base::internal::CheckedAutoLock lock(any_thread_lock_);
+    TakeLockFreeImmediateIncomingTasksLocked();
+  }
   Fence new_fence = position == TaskQueue::InsertFencePosition::kNow
                         ? Fence::CreateWithEnqueueOrder(
                               sequence_manager_->GetNextSequenceNumber())
@@ -949,6 +1208,7 @@ void TaskQueueImpl::InsertFence(Fence current_fence) {
 
   {
     base::internal::CheckedAutoLock lock(any_thread_lock_);
+    TakeLockFreeImmediateIncomingTasksLocked();
     if (!front_task_unblocked && previous_fence &&
         previous_fence->task_order() < current_fence.task_order()) {
       if (!any_thread_.immediate_incoming_queue.empty() &&
@@ -990,6 +1250,7 @@ void TaskQueueImpl::RemoveFence() {
 
   {
     base::internal::CheckedAutoLock lock(any_thread_lock_);
+    TakeLockFreeImmediateIncomingTasksLocked();
     if (!front_task_unblocked && previous_fence) {
       if (!any_thread_.immediate_incoming_queue.empty() &&
           any_thread_.immediate_incoming_queue.front().task_order() >
@@ -1017,6 +1278,8 @@ bool TaskQueueImpl::BlockedByFence() const {
   }
 
   base::internal::CheckedAutoLock lock(any_thread_lock_);
+  // Tasks which are still in the lock-free queue will get enqueue orders
+  // greater than the fence's when taken, so they're blocked too.
   if (any_thread_.immediate_incoming_queue.empty())
     return true;
 
@@ -1216,6 +1479,8 @@ void TaskQueueImpl::UpdateCrossThreadQueueStateLocked() {
     any_thread_.post_immediate_task_should_schedule_work =
         IsQueueEnabled() && !main_thread_only().current_fence;
   }
+  post_immediate_task_should_schedule_work_.store(
+      any_thread_.post_immediate_task_should_schedule_work);
 
 #if DCHECK_IS_ON()
   any_thread_.queue_set_index =
@@ -1253,9 +1518,18 @@ void TaskQueueImpl::ReclaimMemory(TimeTicks now) {
 
 void TaskQueueImpl::PushImmediateIncomingTaskForTest(Task task) {
   base::internal::CheckedAutoLock lock(any_thread_lock_);
+  TakeLockFreeImmediateIncomingTasksLocked();
   any_thread_.immediate_incoming_queue.push_back(std::move(task));
 }
 
+void TaskQueueImpl::TakeLockFreeImmediateIncomingTasksLocked() {
+  if (use_lock_free_immediate_incoming_queue_) {
+    lock_free_immediate_incoming_queue_.TakeTasks(
+        &any_thread_.immediate_incoming_queue,
+        sequence_manager_->enqueue_order_generator());
+  }
+}
+
 void TaskQueueImpl::RequeueDeferredNonNestableTask(
     DeferredNonNestableTask task) {
   DCHECK(task.task.nestable == Nestable::kNonNestable);
@@ -1274,6 +1548,11 @@ void TaskQueueImpl::RequeueDeferredNonNestableTask(
     // we actually make |immediate_work_queue| non-empty.
     if (main_thread_only().immediate_work_queue->Empty()) {
       base::internal::CheckedAutoLock lock(any_thread_lock_);
+      // With the lock-free queue, a concurrent post which found it idle may
+      // request a reload after the SetActive(false) below. That reload finds
+      // the work queue non-empty and does nothing.
+      if (use_lock_free_immediate_incoming_queue_)
+        lock_free_immediate_incoming_queue_.ClearIdle();
       empty_queues_to_reload_handle_.SetActive(false);
 
       any_thread_.immediate_work_queue_empty = false;
@@ -1332,6 +1611,8 @@ bool TaskQueueImpl::HasTaskToRunImmediately() const {
   }
 
   // Finally tasks on |immediate_incoming_queue| count as immediate work.
+  if (HasLockFreeImmediateIncomingTasks())
+    return true;
   base::internal::CheckedAutoLock lock(any_thread_lock_);
   return !any_thread_.immediate_incoming_queue.empty();
 }
@@ -1339,7 +1620,8 @@ bool TaskQueueImpl::HasTaskToRunImmediately() const {
 bool TaskQueueImpl::HasTaskToRunImmediatelyLocked() const {
   return !main_thread_only().delayed_work_queue->Empty() ||
          !main_thread_only().immediate_work_queue->Empty() ||
-         !any_thread_.immediate_incoming_queue.empty();
+         !any_thread_.immediate_incoming_queue.empty() ||
+         HasLockFreeImmediateIncomingTasks();
 }
 
 void TaskQueueImpl::SetOnTaskStartedHandler(
@@ -1383,6 +1665,7 @@ TaskQueueImpl::AddOnTaskPostedHandler(OnTaskPostedHandler handler) {
                                                        associated_thread_);
   any_thread_.on_task_posted_handlers.insert(
       {handle.get(), std::move(handler)});
+  has_on_task_posted_handlers_.store(true, std::memory_order_relaxed);
   return handle;
 }
 
@@ -1391,6 +1674,8 @@ void TaskQueueImpl::RemoveOnTaskPostedHandler(
         on_task_posted_callback_handle) {
   base::internal::CheckedAutoLock lock(any_thread_lock_);
   any_thread_.on_task_posted_handlers.erase(on_task_posted_callback_handle);
+  has_on_task_posted_handlers_.store(
+      !any_thread_.on_task_posted_handlers.empty(), std::memory_order_relaxed);
 }
 
 void TaskQueueImpl::SetTaskExecutionTraceLogger(
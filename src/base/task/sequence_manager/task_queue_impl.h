@@ -7,6 +7,7 @@
 
 #include <stddef.h>
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <queue>
@@ -18,6 +19,7 @@
 #include "base/callback.h"
 #include "base/containers/flat_map.h"
 #include "base/containers/intrusive_heap.h"
+#include "base/containers/span.h"
 #include "base/dcheck_is_on.h"
 #include "base/memory/raw_ptr.h"
 #include "base/memory/scoped_refptr.h"
@@ -31,6 +33,7 @@
 #include "base/task/sequence_manager/enqueue_order.h"
 #include "base/task/sequence_manager/fence.h"
 #include "base/task/sequence_manager/lazily_deallocated_deque.h"
+#include "base/task/sequence_manager/lock_free_incoming_queue.h"
 #include "base/task/sequence_manager/sequenced_task_source.h"
 #include "base/task/sequence_manager/task_queue.h"
 #include "base/threading/thread_checker.h"
@@ -313,6 +316,7 @@ class BASE_EXPORT TaskQueueImpl {
     explicit GuardedTaskPoster(TaskQueueImpl* outer);
 
     bool PostTask(PostedTask task);
+    bool PostTasks(std::vector<PostedTask> tasks);
     DelayedTaskHandle PostCancelableTask(PostedTask task);
 
     void StartAcceptingOperations() {
@@ -361,6 +365,7 @@ class BASE_EXPORT TaskQueueImpl {
     bool PostNonNestableDelayedTask(const Location& location,
                                     OnceClosure callback,
                                     TimeDelta delay) final;
+    bool PostTasks(const Location& location, span<OnceClosure> tasks) final;
     bool RunsTasksInCurrentSequence() const final;
 
    private:
@@ -482,9 +487,18 @@ class BASE_EXPORT TaskQueueImpl {
   };
 
   void PostTask(PostedTask task);
+  // Posts a batch of immediate tasks, taking |any_thread_lock_| and reserving
+  // sequence numbers once for the whole batch.
+  void PostTasks(std::vector<PostedTask> tasks);
   void RemoveCancelableTask(HeapHandle heap_handle);
 
   void PostImmediateTaskImpl(PostedTask task, CurrentThread current_thread);
+  // Same as PostImmediateTaskImpl(), but pushes onto
+  // |lock_free_immediate_incoming_queue_| without taking |any_thread_lock_|
+  // unless there are OnTaskPostedHandlers.
+  void PostImmediateTaskLockFree(PostedTask task, CurrentThread current_thread);
+  void PostImmediateTasksLockFree(std::vector<PostedTask> tasks,
+                                  CurrentThread current_thread);
   void PostDelayedTaskImpl(PostedTask task, CurrentThread current_thread);
 
   // Push the task onto the |delayed_incoming_queue|. Lock-free main thread
@@ -512,6 +526,19 @@ class BASE_EXPORT TaskQueueImpl {
   // Can be called from any thread.
   void TakeImmediateIncomingQueueTasks(TaskDeque* queue);
 
+  // Moves the tasks of |lock_free_immediate_incoming_queue_|, if used, to
+  // |any_thread_.immediate_incoming_queue|. Must be called on the main thread
+  // before inspecting the latter in ways which depend on all its tasks.
+  void TakeLockFreeImmediateIncomingTasksLocked()
+      EXCLUSIVE_LOCKS_REQUIRED(any_thread_lock_);
+
+  // Returns true if |lock_free_immediate_incoming_queue_| is used and has
+  // tasks.
+  bool HasLockFreeImmediateIncomingTasks() const {
+    return use_lock_free_immediate_incoming_queue_ &&
+           !lock_free_immediate_incoming_queue_.empty();
+  }
+
   void TraceQueueSize() const;
   static Value::List QueueAsValue(const TaskDeque& queue, TimeTicks now);
   static Value::Dict TaskAsValue(const Task& task, TimeTicks now);
@@ -623,6 +650,19 @@ class BASE_EXPORT TaskQueueImpl {
   const bool should_monitor_quiescence_;
   const bool should_notify_observers_;
   const bool delayed_fence_allowed_;
+
+  // Whether immediate tasks are posted to
+  // |lock_free_immediate_incoming_queue_| instead of
+  // |any_thread_.immediate_incoming_queue|. In that case, the reload handoff
+  // relies on the idle state of |lock_free_immediate_incoming_queue_| instead
+  // of |any_thread_.immediate_work_queue_empty|, and the main thread moves the
+  // posted tasks to |any_thread_.immediate_incoming_queue| before inspecting
+  // it. The cross-thread state read when posting is mirrored below, so that
+  // posting doesn't take |any_thread_lock_|.
+  const bool use_lock_free_immediate_incoming_queue_;
+  LockFreeIncomingQueue lock_free_immediate_incoming_queue_;
+  std::atomic<bool> post_immediate_task_should_schedule_work_{true};
+  std::atomic<bool> has_on_task_posted_handlers_{false};
 };
 
 }  // namespace internal
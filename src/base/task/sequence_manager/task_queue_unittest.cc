@@ -4,13 +4,19 @@
 
 #include "base/task/sequence_manager/task_queue.h"
 
+#include <memory>
+#include <vector>
+
 #include "base/message_loop/message_pump.h"
 #include "base/message_loop/message_pump_type.h"
+#include "base/run_loop.h"
 #include "base/task/sequence_manager/sequence_manager.h"
 #include "base/task/sequence_manager/test/sequence_manager_for_test.h"
 #include "base/task/task_features.h"
 #include "base/test/bind.h"
 #include "base/test/scoped_feature_list.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/thread.h"
 #include "base/threading/thread_task_runner_handle.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
@@ -196,6 +202,182 @@ TEST(TaskQueueTest, ValidCancelableTaskIsNotCanceled) {
   delayed_task_handle.CancelTask();
 }
 
+// Tests that tasks posted as a batch run in order, after the tasks posted
+// before the batch.
+void TestPostTasks() {
+  constexpr int kNumTasks = 10;
+  auto sequence_manager = CreateSequenceManagerOnCurrentThreadWithPump(
+      MessagePump::Create(MessagePumpType::DEFAULT));
+  auto queue = sequence_manager->CreateTaskQueue(TaskQueue::Spec("test"));
+  auto task_runner = queue->task_runner();
+  ThreadTaskRunnerHandle thread_task_runner_handle(task_runner);
+
+  std::vector<int> run_order;
+  task_runner->PostTask(
+      FROM_HERE, BindLambdaForTesting([&]() { run_order.push_back(-1); }));
+  std::vector<OnceClosure> tasks;
+  for (int i = 0; i < kNumTasks; ++i) {
+    tasks.push_back(
+        BindLambdaForTesting([&run_order, i]() { run_order.push_back(i); }));
+  }
+  EXPECT_TRUE(task_runner->PostTasks(FROM_HERE, tasks));
+  EXPECT_EQ(queue->GetNumberOfPendingTasks(),
+            static_cast<size_t>(kNumTasks + 1));
+  RunLoop().RunUntilIdle();
+
+  ASSERT_EQ(run_order.size(), static_cast<size_t>(kNumTasks + 1));
+  for (int i = 0; i <= kNumTasks; ++i)
+    EXPECT_EQ(run_order[i], i - 1);
+
+  // A batch posted to a shut down queue isn't run.
+  queue->ShutdownTaskQueue();
+  tasks.clear();
+  tasks.push_back(BindOnce([]() { ADD_FAILURE(); }));
+  EXPECT_FALSE(task_runner->PostTasks(FROM_HERE, tasks));
+  RunLoop().RunUntilIdle();
+}
+
+TEST(TaskQueueTest, PostTasks) {
+  TestPostTasks();
+}
+
+class ScopedLockFreeImmediateIncomingQueue {
+ public:
+  ScopedLockFreeImmediateIncomingQueue() {
+    scoped_feature_list_.InitAndEnableFeature(kLockFreeImmediateIncomingQueue);
+    TaskQueueImpl::InitializeFeatures();
+  }
+
+  ~ScopedLockFreeImmediateIncomingQueue() {
+    scoped_feature_list_.Reset();
+    TaskQueueImpl::InitializeFeatures();
+  }
+
+ private:
+  test::ScopedFeatureList scoped_feature_list_;
+};
+
+// Tests that tasks posted concurrently from several threads through the
+// lock-free incoming queue all run, in the order in which each thread posted
+// them.
+TEST(TaskQueueTest, LockFreeImmediateIncomingQueueCrossThreadPosts) {
+  ScopedLockFreeImmediateIncomingQueue scoped_lock_free_incoming_queue;
+  constexpr int kNumThreads = 4;
+  constexpr int kNumTasksPerThread = 1000;
+
+  auto sequence_manager = CreateSequenceManagerOnCurrentThreadWithPump(
+      MessagePump::Create(MessagePumpType::DEFAULT));
+  auto queue = sequence_manager->CreateTaskQueue(TaskQueue::Spec("test"));
+  auto task_runner = queue->task_runner();
+  ThreadTaskRunnerHandle thread_task_runner_handle(task_runner);
+
+  RunLoop run_loop;
+  std::vector<int> next_index(kNumThreads, 0);
+  int num_tasks_run = 0;
+  std::vector<std::unique_ptr<Thread>> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.push_back(std::make_unique<Thread>("poster"));
+    threads.back()->Start();
+    threads.back()->task_runner()->PostTask(
+        FROM_HERE, BindLambdaForTesting([&, i]() {
+          for (int j = 0; j < kNumTasksPerThread; ++j) {
+            task_runner->PostTask(FROM_HERE, BindLambdaForTesting([&, i, j]() {
+                                    EXPECT_EQ(next_index[i]++, j);
+                                    if (++num_tasks_run ==
+                                        kNumThreads * kNumTasksPerThread) {
+                                      run_loop.Quit();
+                                    }
+                                  }));
+          }
+        }));
+  }
+  run_loop.Run();
+
+  for (auto& thread : threads)
+    thread->Stop();
+  EXPECT_EQ(num_tasks_run, kNumThreads * kNumTasksPerThread);
+  EXPECT_TRUE(queue->IsEmpty());
+}
+
+TEST(TaskQueueTest, LockFreeImmediateIncomingQueuePostTasks) {
+  ScopedLockFreeImmediateIncomingQueue scoped_lock_free_incoming_queue;
+  TestPostTasks();
+}
+
+// Tests that fences apply to the tasks which are still in the lock-free
+// incoming queue.
+TEST(TaskQueueTest, LockFreeImmediateIncomingQueueFence) {
+  ScopedLockFreeImmediateIncomingQueue scoped_lock_free_incoming_queue;
+
+  auto sequence_manager = CreateSequenceManagerOnCurrentThreadWithPump(
+      MessagePump::Create(MessagePumpType::DEFAULT));
+  auto queue = sequence_manager->CreateTaskQueue(TaskQueue::Spec("test"));
+  auto task_runner = queue->task_runner();
+  ThreadTaskRunnerHandle thread_task_runner_handle(task_runner);
+
+  std::vector<int> run_order;
+  task_runner->PostTask(
+      FROM_HERE, BindLambdaForTesting([&]() { run_order.push_back(1); }));
+  EXPECT_EQ(queue->GetNumberOfPendingTasks(), 1u);
+  EXPECT_TRUE(queue->HasTaskToRunImmediatelyOrReadyDelayedTask());
+
+  queue->InsertFence(TaskQueue::InsertFencePosition::kNow);
+  task_runner->PostTask(
+      FROM_HERE, BindLambdaForTesting([&]() { run_order.push_back(2); }));
+  EXPECT_FALSE(queue->BlockedByFence());
+  RunLoop().RunUntilIdle();
+  EXPECT_EQ(run_order, std::vector<int>({1}));
+  EXPECT_TRUE(queue->BlockedByFence());
+  EXPECT_EQ(queue->GetNumberOfPendingTasks(), 1u);
+
+  queue->RemoveFence();
+  RunLoop().RunUntilIdle();
+  EXPECT_EQ(run_order, std::vector<int>({1, 2}));
+  EXPECT_TRUE(queue->IsEmpty());
+}
+
+// Tests that a delayed fence activated by a delayed task doesn't block the
+// tasks posted before it which are still in the lock-free incoming queue.
+TEST(TaskQueueTest, LockFreeImmediateIncomingQueueDelayedFence) {
+  ScopedLockFreeImmediateIncomingQueue scoped_lock_free_incoming_queue;
+  constexpr TimeDelta kDelay = Milliseconds(10);
+
+  auto sequence_manager = CreateSequenceManagerOnCurrentThreadWithPump(
+      MessagePump::Create(MessagePumpType::DEFAULT));
+  auto queue = sequence_manager->CreateTaskQueue(
+      TaskQueue::Spec("test").SetDelayedFencesAllowed(true));
+  auto task_runner = queue->task_runner();
+  ThreadTaskRunnerHandle thread_task_runner_handle(task_runner);
+
+  std::vector<int> run_order;
+  task_runner->PostDelayedTask(
+      FROM_HERE, BindLambdaForTesting([&]() { run_order.push_back(4); }),
+      2 * kDelay);
+  queue->InsertFenceAt(TimeTicks::Now() + kDelay);
+  task_runner->PostTask(FROM_HERE, BindLambdaForTesting([&]() {
+                          run_order.push_back(1);
+                          // Post before the fence, and wait for the delayed
+                          // task to be ready. The immediate work queue isn't
+                          // empty, so the delayed task is moved, activating
+                          // the fence, before this task is taken.
+                          task_runner->PostTask(
+                              FROM_HERE, BindLambdaForTesting([&]() {
+                                run_order.push_back(3);
+                              }));
+                          PlatformThread::Sleep(3 * kDelay);
+                        }));
+  task_runner->PostTask(
+      FROM_HERE, BindLambdaForTesting([&]() { run_order.push_back(2); }));
+
+  RunLoop().RunUntilIdle();
+  EXPECT_EQ(run_order, std::vector<int>({1, 2, 3}));
+  EXPECT_TRUE(queue->HasActiveFence());
+
+  queue->RemoveFence();
+  RunLoop().RunUntilIdle();
+  EXPECT_EQ(run_order, std::vector<int>({1, 2, 3, 4}));
+}
+
 }  // namespace
 }  // namespace task_queue_unittest
 }  // namespace internal
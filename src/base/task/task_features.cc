@@ -37,6 +37,9 @@ const base::FeatureParam<WakeUpStrategy> kWakeUpStrategyParam{
 const Feature kWakeUpAfterGetWork = {"WakeUpAfterGetWork",
                                      base::FEATURE_DISABLED_BY_DEFAULT};
 
+const Feature kThreadGroupWorkStealing = {"ThreadGroupWorkStealing",
+                                          base::FEATURE_DISABLED_BY_DEFAULT};
+
 #if HAS_NATIVE_THREAD_POOL()
 const Feature kUseNativeThreadPool = {"UseNativeThreadPool",
                                       base::FEATURE_DISABLED_BY_DEFAULT};
@@ -65,4 +68,7 @@ const BASE_EXPORT Feature kExplicitHighResolutionTimerWin = {
 const BASE_EXPORT Feature kRunTasksByBatches = {
     "RunTasksByBatches", base::FEATURE_DISABLED_BY_DEFAULT};
 
+const BASE_EXPORT Feature kLockFreeImmediateIncomingQueue = {
+    "LockFreeImmediateIncomingQueue", base::FEATURE_DISABLED_BY_DEFAULT};
+
 }  // namespace base
@@ -27,6 +27,10 @@ extern const BASE_EXPORT Feature kDisableJobUpdatePriority;
 // Under this feature, another WorkerThread is signaled only after the current
 // thread was assigned work.
 extern const BASE_EXPORT Feature kWakeUpAfterGetWork;
+// Under this feature, a ThreadGroupImpl worker that posts a parallel
+// BEST_EFFORT or USER_VISIBLE task while no worker is idle keeps it in a
+// queue of its own, from which other workers steal when they run out of work.
+extern const BASE_EXPORT Feature kThreadGroupWorkStealing;
 
 // Strategy affecting how WorkerThreads are signaled to pick up pending work.
 enum class WakeUpStrategy {
@@ -87,6 +91,11 @@ extern const BASE_EXPORT base::Feature kExplicitHighResolutionTimerWin;
 // Feature to run tasks by batches before pumping out messages.
 extern const BASE_EXPORT base::Feature kRunTasksByBatches;
 
+// Under this feature, immediate tasks are posted to SequenceManager task queues
+// through a lock-free multi-producer single-consumer queue instead of a queue
+// protected by a lock.
+extern const BASE_EXPORT base::Feature kLockFreeImmediateIncomingQueue;
+
 }  // namespace base
 
 #endif  // BASE_TASK_TASK_FEATURES_H_
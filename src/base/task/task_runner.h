@@ -12,6 +12,7 @@
 #include "base/callback.h"
 #include "base/callback_helpers.h"
 #include "base/check.h"
+#include "base/containers/span.h"
 #include "base/location.h"
 #include "base/memory/ref_counted.h"
 #include "base/task/post_task_and_reply_with_result_internal.h"
@@ -67,6 +68,15 @@ class BASE_EXPORT TaskRunner
   // Equivalent to PostDelayedTask(from_here, task, 0).
   bool PostTask(const Location& from_here, OnceClosure task);
 
+  // Posts each of |tasks|, in order, as if by PostTask(). |tasks| are moved
+  // from. Returns false if any of the tasks definitely will not be run.
+  //
+  // The default implementation calls PostTask() for each task. Implementations
+  // may instead post the whole batch at once, taking their locks and waking up
+  // their threads once per batch rather than once per task; such
+  // implementations either post all the tasks or none of them.
+  virtual bool PostTasks(const Location& from_here, span<OnceClosure> tasks);
+
   // Like PostTask, but tries to run the posted task only after |delay_ms|
   // has passed. Implementations should use a tick clock, rather than wall-
   // clock time, to implement |delay|.
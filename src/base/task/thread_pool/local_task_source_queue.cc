@@ -0,0 +1,92 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/task/thread_pool/local_task_source_queue.h"
+
+#include <utility>
+
+#include "base/check_op.h"
+
+namespace base {
+namespace internal {
+
+LocalTaskSourceQueue::LocalTaskSourceQueue(const CheckedLock* predecessor_lock)
+    : lock_(predecessor_lock) {}
+
+LocalTaskSourceQueue::~LocalTaskSourceQueue() {
+  if (!is_flush_task_sources_on_destroy_enabled_)
+    return;
+
+  while (RegisteredTaskSource task_source = Pop()) {
+    auto task = task_source.Clear();
+    std::move(task.task).Run();
+  }
+}
+
+bool LocalTaskSourceQueue::Push(RegisteredTaskSource* task_source) {
+  DCHECK(*task_source);
+  CheckedAutoLock auto_lock(lock_);
+  const size_t size = size_.load(std::memory_order_relaxed);
+  if (size == kCapacity)
+    return false;
+  container_[(front_ + size) % kCapacity] = std::move(*task_source);
+  size_.store(size + 1, std::memory_order_seq_cst);
+  return true;
+}
+
+RegisteredTaskSource LocalTaskSourceQueue::Pop() {
+  CheckedAutoLock auto_lock(lock_);
+  if (IsEmpty())
+    return nullptr;
+  return PopLockRequired();
+}
+
+RegisteredTaskSource LocalTaskSourceQueue::TakeBack(
+    const TaskSource& task_source) {
+  CheckedAutoLock auto_lock(lock_);
+  const size_t size = size_.load(std::memory_order_relaxed);
+  if (size == 0)
+    return nullptr;
+  RegisteredTaskSource& back = container_[(front_ + size - 1) % kCapacity];
+  if (back.get() != &task_source)
+    return nullptr;
+  size_.store(size - 1, std::memory_order_seq_cst);
+  return std::move(back);
+}
+
+RegisteredTaskSource LocalTaskSourceQueue::Remove(
+    const TaskSource& task_source) {
+  CheckedAutoLock auto_lock(lock_);
+  const size_t size = size_.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < size; ++i) {
+    if (container_[(front_ + i) % kCapacity].get() != &task_source)
+      continue;
+    RegisteredTaskSource removed =
+        std::move(container_[(front_ + i) % kCapacity]);
+    for (size_t j = i + 1; j < size; ++j) {
+      container_[(front_ + j - 1) % kCapacity] =
+          std::move(container_[(front_ + j) % kCapacity]);
+    }
+    size_.store(size - 1, std::memory_order_seq_cst);
+    return removed;
+  }
+  return nullptr;
+}
+
+void LocalTaskSourceQueue::EnableFlushTaskSourcesOnDestroyForTesting() {
+  DCHECK(!is_flush_task_sources_on_destroy_enabled_);
+  is_flush_task_sources_on_destroy_enabled_ = true;
+}
+
+RegisteredTaskSource LocalTaskSourceQueue::PopLockRequired() {
+  const size_t size = size_.load(std::memory_order_relaxed);
+  DCHECK_GT(size, 0U);
+  RegisteredTaskSource task_source = std::move(container_[front_]);
+  front_ = (front_ + 1) % kCapacity;
+  size_.store(size - 1, std::memory_order_seq_cst);
+  return task_source;
+}
+
+}  // namespace internal
+}  // namespace base
@@ -0,0 +1,97 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_TASK_THREAD_POOL_LOCAL_TASK_SOURCE_QUEUE_H_
+#define BASE_TASK_THREAD_POOL_LOCAL_TASK_SOURCE_QUEUE_H_
+
+#include <stddef.h>
+
+#include <array>
+#include <atomic>
+
+#include "base/base_export.h"
+#include "base/task/common/checked_lock.h"
+#include "base/task/thread_pool/task_source.h"
+#include "base/thread_annotations.h"
+
+namespace base {
+namespace internal {
+
+// A bounded FIFO queue of TaskSources owned by a single worker. The owner
+// pushes task sources it posts while every worker of its thread group is busy,
+// and runs them when its current task is done; other workers of the group
+// steal from it when they run out of work. Unlike PriorityQueue, this class is
+// thread-safe: it has its own lock, so that neither the owner nor a thief
+// needs the lock of the thread group to use it.
+class BASE_EXPORT LocalTaskSourceQueue {
+ public:
+  static constexpr size_t kCapacity = 64;
+
+  // |predecessor_lock| is a lock that may be held when the lock of this queue
+  // is acquired.
+  explicit LocalTaskSourceQueue(const CheckedLock* predecessor_lock);
+  LocalTaskSourceQueue(const LocalTaskSourceQueue&) = delete;
+  LocalTaskSourceQueue& operator=(const LocalTaskSourceQueue&) = delete;
+  ~LocalTaskSourceQueue();
+
+  // Moves |*task_source| to the back of the queue and returns true, or returns
+  // false without modifying |*task_source| if the queue is full.
+  bool Push(RegisteredTaskSource* task_source);
+
+  // Removes and returns the task source at the front of the queue, or returns
+  // nullptr if the queue is empty.
+  RegisteredTaskSource Pop();
+
+  // Removes and returns the task source at the front of the queue if
+  // |predicate| returns true for it. Returns nullptr otherwise.
+  template <typename Predicate>
+  RegisteredTaskSource PopIf(Predicate predicate) {
+    CheckedAutoLock auto_lock(lock_);
+    if (IsEmpty() || !predicate(*container_[front_].get()))
+      return nullptr;
+    return PopLockRequired();
+  }
+
+  // Removes and returns the task source at the back of the queue if it is
+  // |task_source|, i.e. undoes the last Push() unless that task source was
+  // already popped. Returns nullptr otherwise.
+  RegisteredTaskSource TakeBack(const TaskSource& task_source);
+
+  // Removes and returns |task_source| from anywhere in the queue, keeping the
+  // order of the others. Returns nullptr if it isn't in the queue.
+  RegisteredTaskSource Remove(const TaskSource& task_source);
+
+  // Returns the number of task sources in the queue. The result may be stale
+  // by the time it is used, unless this is called by the only thread that
+  // pushes and pops.
+  size_t Size() const { return size_.load(std::memory_order_seq_cst); }
+  bool IsEmpty() const { return Size() == 0; }
+
+  // Set the queue to empty all its TaskSources of Tasks when it is destroyed;
+  // needed to prevent memory leaks caused by a reference cycle (TaskSource ->
+  // Task -> TaskRunner -> TaskSource...) during test teardown.
+  void EnableFlushTaskSourcesOnDestroyForTesting();
+
+ private:
+  RegisteredTaskSource PopLockRequired() EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  mutable CheckedLock lock_;
+
+  // Ring buffer of |size_| task sources, starting at |front_|.
+  std::array<RegisteredTaskSource, kCapacity> container_ GUARDED_BY(lock_);
+  size_t front_ GUARDED_BY(lock_) = 0;
+
+  // Written under |lock_|. Sequentially consistent, so that a worker that
+  // publishes a task source here and a worker that goes idle and then looks
+  // for task sources to steal can't miss each other.
+  std::atomic<size_t> size_{0};
+
+  // Should only be enabled by EnableFlushTaskSourcesOnDestroyForTesting().
+  bool is_flush_task_sources_on_destroy_enabled_ = false;
+};
+
+}  // namespace internal
+}  // namespace base
+
+#endif  // BASE_TASK_THREAD_POOL_LOCAL_TASK_SOURCE_QUEUE_H_
@@ -0,0 +1,143 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/task/thread_pool/local_task_source_queue.h"
+
+#include <utility>
+#include <vector>
+
+#include "base/callback_helpers.h"
+#include "base/memory/ref_counted.h"
+#include "base/task/task_traits.h"
+#include "base/task/thread_pool/sequence.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace internal {
+
+namespace {
+
+scoped_refptr<TaskSource> MakeSequence(TaskPriority priority) {
+  return MakeRefCounted<Sequence>(TaskTraits(priority), nullptr,
+                                  TaskSourceExecutionMode::kParallel);
+}
+
+bool Push(LocalTaskSourceQueue* queue, scoped_refptr<TaskSource> task_source) {
+  RegisteredTaskSource registered =
+      RegisteredTaskSource::CreateForTesting(std::move(task_source));
+  const bool pushed = queue->Push(&registered);
+  // The task source is only moved on success.
+  EXPECT_NE(pushed, !!registered);
+  return pushed;
+}
+
+}  // namespace
+
+TEST(ThreadPoolLocalTaskSourceQueueTest, PushPopFifo) {
+  LocalTaskSourceQueue queue(nullptr);
+  EXPECT_TRUE(queue.IsEmpty());
+  EXPECT_FALSE(queue.Pop());
+
+  scoped_refptr<TaskSource> a = MakeSequence(TaskPriority::USER_VISIBLE);
+  scoped_refptr<TaskSource> b = MakeSequence(TaskPriority::BEST_EFFORT);
+  scoped_refptr<TaskSource> c = MakeSequence(TaskPriority::USER_VISIBLE);
+  EXPECT_TRUE(Push(&queue, a));
+  EXPECT_TRUE(Push(&queue, b));
+  EXPECT_TRUE(Push(&queue, c));
+  EXPECT_EQ(queue.Size(), 3U);
+
+  EXPECT_EQ(queue.Pop().get(), a.get());
+  EXPECT_EQ(queue.Pop().get(), b.get());
+  EXPECT_EQ(queue.Pop().get(), c.get());
+  EXPECT_TRUE(queue.IsEmpty());
+  EXPECT_FALSE(queue.Pop());
+}
+
+TEST(ThreadPoolLocalTaskSourceQueueTest, Full) {
+  LocalTaskSourceQueue queue(nullptr);
+  std::vector<scoped_refptr<TaskSource>> task_sources;
+  for (size_t i = 0; i < LocalTaskSourceQueue::kCapacity; ++i) {
+    task_sources.push_back(MakeSequence(TaskPriority::USER_VISIBLE));
+    EXPECT_TRUE(Push(&queue, task_sources.back()));
+  }
+  EXPECT_FALSE(Push(&queue, MakeSequence(TaskPriority::USER_VISIBLE)));
+  EXPECT_EQ(queue.Size(), LocalTaskSourceQueue::kCapacity);
+
+  // Popping makes room again, and the ring buffer wraps around.
+  EXPECT_EQ(queue.Pop().get(), task_sources[0].get());
+  scoped_refptr<TaskSource> last = MakeSequence(TaskPriority::USER_VISIBLE);
+  EXPECT_TRUE(Push(&queue, last));
+  for (size_t i = 1; i < LocalTaskSourceQueue::kCapacity; ++i)
+    EXPECT_EQ(queue.Pop().get(), task_sources[i].get());
+  EXPECT_EQ(queue.Pop().get(), last.get());
+  EXPECT_TRUE(queue.IsEmpty());
+}
+
+TEST(ThreadPoolLocalTaskSourceQueueTest, PopIf) {
+  LocalTaskSourceQueue queue(nullptr);
+  scoped_refptr<TaskSource> best_effort =
+      MakeSequence(TaskPriority::BEST_EFFORT);
+  scoped_refptr<TaskSource> user_visible =
+      MakeSequence(TaskPriority::USER_VISIBLE);
+  EXPECT_TRUE(Push(&queue, best_effort));
+  EXPECT_TRUE(Push(&queue, user_visible));
+
+  auto is_user_visible = [](const TaskSource& task_source) {
+    return task_source.priority_racy() == TaskPriority::USER_VISIBLE;
+  };
+  // Only the front of the queue is considered.
+  EXPECT_FALSE(queue.PopIf(is_user_visible));
+  EXPECT_EQ(queue.Size(), 2U);
+  EXPECT_EQ(queue.Pop().get(), best_effort.get());
+  EXPECT_EQ(queue.PopIf(is_user_visible).get(), user_visible.get());
+  EXPECT_TRUE(queue.IsEmpty());
+  EXPECT_FALSE(queue.PopIf(is_user_visible));
+}
+
+TEST(ThreadPoolLocalTaskSourceQueueTest, TakeBack) {
+  LocalTaskSourceQueue queue(nullptr);
+  scoped_refptr<TaskSource> a = MakeSequence(TaskPriority::USER_VISIBLE);
+  scoped_refptr<TaskSource> b = MakeSequence(TaskPriority::USER_VISIBLE);
+  EXPECT_TRUE(Push(&queue, a));
+  EXPECT_TRUE(Push(&queue, b));
+
+  // Only the back of the queue can be taken back.
+  EXPECT_FALSE(queue.TakeBack(*a));
+  EXPECT_EQ(queue.TakeBack(*b).get(), b.get());
+  EXPECT_FALSE(queue.TakeBack(*b));
+  EXPECT_EQ(queue.TakeBack(*a).get(), a.get());
+  EXPECT_TRUE(queue.IsEmpty());
+  EXPECT_FALSE(queue.TakeBack(*a));
+}
+
+TEST(ThreadPoolLocalTaskSourceQueueTest, Remove) {
+  LocalTaskSourceQueue queue(nullptr);
+  scoped_refptr<TaskSource> a = MakeSequence(TaskPriority::USER_VISIBLE);
+  scoped_refptr<TaskSource> b = MakeSequence(TaskPriority::USER_VISIBLE);
+  scoped_refptr<TaskSource> c = MakeSequence(TaskPriority::USER_VISIBLE);
+  scoped_refptr<TaskSource> d = MakeSequence(TaskPriority::USER_VISIBLE);
+  // Start the queue at the end of the ring buffer, so that it wraps around.
+  for (size_t i = 0; i < LocalTaskSourceQueue::kCapacity - 1; ++i) {
+    EXPECT_TRUE(Push(&queue, MakeSequence(TaskPriority::USER_VISIBLE)));
+    EXPECT_TRUE(queue.Pop());
+  }
+  EXPECT_TRUE(Push(&queue, a));
+  EXPECT_TRUE(Push(&queue, b));
+  EXPECT_TRUE(Push(&queue, c));
+
+  EXPECT_FALSE(queue.Remove(*d));
+  EXPECT_EQ(queue.Remove(*b).get(), b.get());
+  EXPECT_FALSE(queue.Remove(*b));
+  EXPECT_EQ(queue.Size(), 2U);
+  EXPECT_TRUE(Push(&queue, d));
+
+  // The others keep their order.
+  EXPECT_EQ(queue.Pop().get(), a.get());
+  EXPECT_EQ(queue.Pop().get(), c.get());
+  EXPECT_EQ(queue.Remove(*d).get(), d.get());
+  EXPECT_TRUE(queue.IsEmpty());
+}
+
+}  // namespace internal
+}  // namespace base
@@ -4,6 +4,9 @@
 
 #include "base/task/thread_pool/pooled_sequenced_task_runner.h"
 
+#include <utility>
+#include <vector>
+
 #include "base/sequence_token.h"
 #include "base/task/default_delayed_task_handle_delegate.h"
 #include "base/task/task_features.h"
@@ -79,6 +82,27 @@ bool PooledSequencedTaskRunner::PostNonNestableDelayedTask(
   return PostDelayedTask(from_here, std::move(closure), delay);
 }
 
+bool PooledSequencedTaskRunner::PostTasks(const Location& from_here,
+                                          span<OnceClosure> closures) {
+  if (!PooledTaskRunnerDelegate::MatchesCurrentDelegate(
+          pooled_task_runner_delegate_)) {
+    return false;
+  }
+
+  const TimeTicks queue_time = TimeTicks::Now();
+  const TimeDelta leeway = g_task_leeway.load(std::memory_order_relaxed);
+  std::vector<Task> tasks;
+  tasks.reserve(closures.size());
+  for (OnceClosure& closure : closures) {
+    tasks.emplace_back(from_here, std::move(closure), queue_time, TimeDelta(),
+                       leeway);
+  }
+
+  // Post the tasks as part of |sequence_|.
+  return pooled_task_runner_delegate_->PostTasksWithSequence(std::move(tasks),
+                                                             sequence_);
+}
+
 bool PooledSequencedTaskRunner::RunsTasksInCurrentSequence() const {
   return sequence_->token() == SequenceToken::GetForCurrentThread();
 }
@@ -7,6 +7,7 @@
 
 #include "base/base_export.h"
 #include "base/callback_forward.h"
+#include "base/containers/span.h"
 #include "base/location.h"
 #include "base/memory/raw_ptr.h"
 #include "base/task/task_traits.h"
@@ -49,6 +50,8 @@ class BASE_EXPORT PooledSequencedTaskRunner
                                   OnceClosure closure,
                                   TimeDelta delay) override;
 
+  bool PostTasks(const Location& from_here, span<OnceClosure> tasks) override;
+
   bool RunsTasksInCurrentSequence() const override;
 
   void UpdatePriority(TaskPriority priority) override;
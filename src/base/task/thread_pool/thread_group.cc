@@ -151,6 +151,7 @@ ThreadGroup::GetNumAdditionalWorkersForForegroundTaskSourcesLockRequired()
 RegisteredTaskSource ThreadGroup::RemoveTaskSource(
     const TaskSource& task_source) {
   CheckedAutoLock auto_lock(lock_);
+  MoveTaskSourceToPriorityQueueLockRequired(task_source);
   return priority_queue_.RemoveTaskSource(task_source);
 }
 
@@ -228,6 +229,7 @@ RegisteredTaskSource ThreadGroup::TakeRegisteredTaskSource(
 void ThreadGroup::UpdateSortKeyImpl(BaseScopedCommandsExecutor* executor,
                                     TaskSource::Transaction transaction) {
   CheckedAutoLock auto_lock(lock_);
+  MoveTaskSourceToPriorityQueueLockRequired(*transaction.task_source());
   priority_queue_.UpdateSortKey(
       *transaction.task_source(),
       transaction.task_source()->GetSortKey(disable_fair_scheduling_));
@@ -259,9 +261,13 @@ void ThreadGroup::PushTaskSourceAndWakeUpWorkersImpl(
 void ThreadGroup::InvalidateAndHandoffAllTaskSourcesToOtherThreadGroup(
     ThreadGroup* destination_thread_group) {
   CheckedAutoLock current_thread_group_lock(lock_);
+  MoveAllTaskSourcesToPriorityQueueLockRequired();
   CheckedAutoLock destination_thread_group_lock(
       destination_thread_group->lock_);
   destination_thread_group->priority_queue_ = std::move(priority_queue_);
+  // A moved-from PriorityQueue keeps its per-priority counts, which workers
+  // still running here would read.
+  priority_queue_ = PriorityQueue();
   replacement_thread_group_ = destination_thread_group;
 }
 
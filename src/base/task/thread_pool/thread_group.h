@@ -65,10 +65,10 @@ class BASE_EXPORT ThreadGroup {
   // Returns true if the thread group is registered in TLS.
   bool IsBoundToCurrentThread() const;
 
-  // Removes |task_source| from |priority_queue_|. Returns a
-  // RegisteredTaskSource that evaluats to true if successful, or false if
-  // |task_source| is not currently in |priority_queue_|, such as when a worker
-  // is running a task from it.
+  // Removes |task_source| from |priority_queue_|, or from wherever else this
+  // thread group queued it. Returns a RegisteredTaskSource that evaluats to
+  // true if successful, or false if |task_source| is not currently queued,
+  // such as when a worker is running a task from it.
   RegisteredTaskSource RemoveTaskSource(const TaskSource& task_source);
 
   // Updates the position of the TaskSource in |transaction| in this
@@ -86,7 +86,7 @@ class BASE_EXPORT ThreadGroup {
   virtual void PushTaskSourceAndWakeUpWorkers(
       TransactionWithRegisteredTaskSource transaction_with_task_source) = 0;
 
-  // Removes all task sources from this ThreadGroup's PriorityQueue and enqueues
+  // Removes all task sources queued in this ThreadGroup and enqueues
   // them in another |destination_thread_group|. After this method is called,
   // any task sources posted to this ThreadGroup will be forwarded to
   // |destination_thread_group|.
@@ -219,6 +219,16 @@ class BASE_EXPORT ThreadGroup {
   RegisteredTaskSource TakeRegisteredTaskSource(
       BaseScopedCommandsExecutor* executor) EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
+  // Moves |task_source| to |priority_queue_| if this thread group queued it
+  // elsewhere, so that it can be found in |priority_queue_|. No-op by default.
+  virtual void MoveTaskSourceToPriorityQueueLockRequired(
+      const TaskSource& task_source) EXCLUSIVE_LOCKS_REQUIRED(lock_) {}
+
+  // Moves all task sources that this thread group queued outside of
+  // |priority_queue_| to |priority_queue_|. No-op by default.
+  virtual void MoveAllTaskSourcesToPriorityQueueLockRequired()
+      EXCLUSIVE_LOCKS_REQUIRED(lock_) {}
+
   // Must be invoked by implementations of the corresponding non-Impl() methods.
   void UpdateSortKeyImpl(BaseScopedCommandsExecutor* executor,
                          TaskSource::Transaction transaction);
@@ -7,6 +7,7 @@
 #include <stddef.h>
 
 #include <algorithm>
+#include <atomic>
 #include <type_traits>
 #include <utility>
 
@@ -17,6 +18,7 @@
 #include "base/compiler_specific.h"
 #include "base/containers/stack_container.h"
 #include "base/feature_list.h"
+#include "base/lazy_instance.h"
 #include "base/location.h"
 #include "base/memory/ptr_util.h"
 #include "base/memory/raw_ptr.h"
@@ -29,11 +31,13 @@
 #include "base/strings/stringprintf.h"
 #include "base/synchronization/waitable_event.h"
 #include "base/task/task_traits.h"
+#include "base/task/thread_pool/local_task_source_queue.h"
 #include "base/task/thread_pool/task_tracker.h"
 #include "base/threading/platform_thread.h"
 #include "base/threading/scoped_blocking_call.h"
 #include "base/threading/scoped_blocking_call_internal.h"
 #include "base/threading/thread_checker.h"
+#include "base/threading/thread_local.h"
 #include "base/threading/thread_restrictions.h"
 #include "base/time/time_override.h"
 #include "build/build_config.h"
@@ -80,6 +84,16 @@ constexpr TimeDelta kForegroundBlockedWorkersPoll = Milliseconds(1200);
 constexpr TimeDelta kBackgroundMayBlockThreshold = Seconds(10);
 constexpr TimeDelta kBackgroundBlockedWorkersPoll = Seconds(12);
 
+// Maximum number of consecutive task sources that a worker takes from its local
+// queue without acquiring the lock of its thread group, which it needs to
+// notice e.g. a CanRunPolicy change.
+constexpr size_t kMaxLocalTaskSourcesWithoutLock = 16;
+
+// The local queue of the current thread, if it is a worker of a ThreadGroupImpl
+// with work stealing enabled, and isn't inside a ScopedBlockingCall.
+LazyInstance<ThreadLocalPointer<LocalTaskSourceQueue>>::Leaky
+    tls_local_task_source_queue = LAZY_INSTANCE_INITIALIZER;
+
 // Only used in DCHECKs.
 bool ContainsWorker(const std::vector<scoped_refptr<WorkerThread>>& workers,
                     const WorkerThread* worker) {
@@ -274,6 +288,10 @@ class ThreadGroupImpl::WorkerThreadDelegateImpl : public WorkerThread::Delegate,
     return outer_->lock_;
   }
 
+  // Task sources posted by this worker while no other worker was idle. Only
+  // used when work stealing is enabled.
+  LocalTaskSourceQueue* local_queue() { return &local_queue_; }
+
  private:
   // Returns true if |worker| is allowed to cleanup and remove itself from the
   // thread group. Called from GetWork() when no work is available.
@@ -291,6 +309,17 @@ class ThreadGroupImpl::WorkerThreadDelegateImpl : public WorkerThread::Delegate,
   void OnWorkerBecomesIdleLockRequired(WorkerThread* worker)
       EXCLUSIVE_LOCKS_REQUIRED(outer_->lock_);
 
+  // Moves the task sources of |local_queue_| to the priority queue of the
+  // thread group, so that other workers can run them.
+  void HandOverLocalQueueLockRequired(ScopedCommandsExecutor* executor)
+      EXCLUSIVE_LOCKS_REQUIRED(outer_->lock_);
+
+  // Called in DidProcessTask(). Takes the next task source to run from
+  // |local_queue_| into |worker_only().next_task_source| if it can run without
+  // updating the running task bookkeeping of the thread group, and returns
+  // true on success.
+  bool TakeLocalTaskSourceWithoutLock();
+
   // Accessed only from the worker thread.
   struct WorkerOnly {
     // Number of tasks executed since the last time the
@@ -300,6 +329,18 @@ class ThreadGroupImpl::WorkerThreadDelegateImpl : public WorkerThread::Delegate,
     // Associated WorkerThread, if any, initialized in OnMainEntry().
     raw_ptr<WorkerThread> worker_thread_;
 
+    // Task source taken from |local_queue_| by DidProcessTask(), to be returned
+    // by the next GetWork() call.
+    RegisteredTaskSource next_task_source;
+
+    // Number of consecutive task sources taken from |local_queue_| by
+    // DidProcessTask().
+    size_t num_local_task_sources_without_lock = 0;
+
+    // |outer_->work_limits_generation_| as of the last GetWork() that got past
+    // CanGetWorkLockRequired().
+    uint32_t work_limits_generation = 0;
+
 #if BUILDFLAG(IS_WIN)
     std::unique_ptr<win::ScopedWindowsThreadEnvironment> win_thread_environment;
 #endif  // BUILDFLAG(IS_WIN)
@@ -345,6 +386,8 @@ class ThreadGroupImpl::WorkerThreadDelegateImpl : public WorkerThread::Delegate,
 
   const TrackedRef<ThreadGroupImpl> outer_;
 
+  LocalTaskSourceQueue local_queue_;
+
   // Whether |outer_->max_tasks_|/|outer_->max_best_effort_tasks_| were
   // incremented due to a ScopedBlockingCall on the thread.
   bool incremented_max_tasks_since_blocked_ GUARDED_BY(outer_->lock_) = false;
@@ -363,8 +406,11 @@ ThreadGroupImpl::ThreadGroupImpl(StringPiece histogram_label,
                                  StringPiece thread_group_label,
                                  ThreadType thread_type_hint,
                                  TrackedRef<TaskTracker> task_tracker,
-                                 TrackedRef<Delegate> delegate)
-    : ThreadGroup(std::move(task_tracker), std::move(delegate)),
+                                 TrackedRef<Delegate> delegate,
+                                 ThreadGroup* predecessor_thread_group)
+    : ThreadGroup(std::move(task_tracker),
+                  std::move(delegate),
+                  predecessor_thread_group),
       thread_group_label_(thread_group_label),
       thread_type_hint_(thread_type_hint),
       idle_workers_stack_cv_for_testing_(lock_.CreateConditionVariable()),
@@ -400,6 +446,7 @@ void ThreadGroupImpl::Start(
   DCHECK(!replacement_thread_group_);
 
   in_start().wakeup_after_getwork = FeatureList::IsEnabled(kWakeUpAfterGetWork);
+  in_start().work_stealing = FeatureList::IsEnabled(kThreadGroupWorkStealing);
   in_start().wakeup_strategy = kWakeUpStrategyParam.Get();
   in_start().may_block_without_delay =
       FeatureList::IsEnabled(kMayBlockWithoutDelay);
@@ -456,6 +503,8 @@ void ThreadGroupImpl::UpdateSortKey(TaskSource::Transaction transaction) {
 
 void ThreadGroupImpl::PushTaskSourceAndWakeUpWorkers(
     TransactionWithRegisteredTaskSource transaction_with_task_source) {
+  if (PushTaskSourceToLocalQueue(&transaction_with_task_source.task_source))
+    return;
   ScopedCommandsExecutor executor(this);
   PushTaskSourceAndWakeUpWorkersImpl(&executor,
                                      std::move(transaction_with_task_source));
@@ -526,6 +575,9 @@ void ThreadGroupImpl::JoinForTesting() {
 
   CheckedAutoLock auto_lock(lock_);
   DCHECK(workers_ == workers_copy);
+  // Move task sources left in local queues to |priority_queue_|, which flushes
+  // them on destruction.
+  MoveAllTaskSourcesToPriorityQueueLockRequired();
   // Release |workers_| to clear their TrackedRef against |this|.
   workers_.clear();
 }
@@ -550,9 +602,139 @@ size_t ThreadGroupImpl::NumberOfIdleWorkersForTesting() const {
   return idle_workers_stack_.Size();
 }
 
+bool ThreadGroupImpl::PushTaskSourceToLocalQueue(
+    RegisteredTaskSource* task_source) {
+  // Null if the current worker is inside a ScopedBlockingCall, since it
+  // wouldn't run the task source until the call returns.
+  LocalTaskSourceQueue* const local_queue =
+      tls_local_task_source_queue.Get().Get();
+  if (!local_queue || !IsBoundToCurrentThread())
+    return false;
+  if ((*task_source)->execution_mode() != TaskSourceExecutionMode::kParallel ||
+      (*task_source)->priority_racy() == TaskPriority::USER_BLOCKING) {
+    return false;
+  }
+  // An idle worker would run the task source sooner than this one.
+  if (num_idle_workers_.load(std::memory_order_seq_cst) != 0)
+    return false;
+
+  const TaskSource* const pushed_task_source = task_source->get();
+  if (!local_queue->Push(task_source))
+    return false;
+
+  // A worker that became idle before the push could have missed the task
+  // source when it looked for work to steal. Take the task source back in that
+  // case, unless someone already took it.
+  if (num_idle_workers_.load(std::memory_order_seq_cst) == 0)
+    return true;
+  *task_source = local_queue->TakeBack(*pushed_task_source);
+  return !*task_source;
+}
+
+RegisteredTaskSource ThreadGroupImpl::PopLocalTaskSourceLockRequired(
+    LocalTaskSourceQueue* queue) {
+  if (queue->IsEmpty())
+    return nullptr;
+
+  // Enforce the CanRunPolicy and |max_best_effort_tasks_| like GetWork() does
+  // for |priority_queue_|, and let task sources of higher priority in
+  // |priority_queue_| run first.
+  TaskPriority min_priority = TaskPriority::BEST_EFFORT;
+  if (!task_tracker_->CanRunPriority(TaskPriority::BEST_EFFORT) ||
+      num_running_best_effort_tasks_ >= max_best_effort_tasks_) {
+    min_priority = TaskPriority::USER_VISIBLE;
+  }
+  if (!task_tracker_->CanRunPriority(min_priority))
+    return nullptr;
+  if (!priority_queue_.IsEmpty())
+    min_priority =
+        std::max(min_priority, priority_queue_.PeekSortKey().priority());
+
+  RegisteredTaskSource task_source =
+      queue->PopIf([min_priority](const TaskSource& candidate) {
+        return candidate.priority_racy() >= min_priority;
+      });
+  if (task_source) {
+    // Only parallel Sequences are pushed to local queues, and they are always
+    // saturated.
+    const TaskSource::RunStatus run_status = task_source.WillRunTask();
+    DCHECK_EQ(run_status, TaskSource::RunStatus::kAllowedSaturated);
+  }
+  return task_source;
+}
+
+RegisteredTaskSource ThreadGroupImpl::StealTaskSourceLockRequired(
+    const WorkerThread* thief) {
+  const size_t num_workers = workers_.size();
+  for (size_t i = 0; i < num_workers; ++i) {
+    WorkerThread* const victim =
+        workers_[(next_worker_to_steal_from_ + i) % num_workers].get();
+    if (victim == thief)
+      continue;
+    RegisteredTaskSource task_source = PopLocalTaskSourceLockRequired(
+        static_cast<WorkerThreadDelegateImpl*>(victim->delegate())
+            ->local_queue());
+    if (task_source) {
+      // Start with the next worker next time, to spread steals evenly.
+      next_worker_to_steal_from_ =
+          (next_worker_to_steal_from_ + i + 1) % num_workers;
+      return task_source;
+    }
+  }
+  return nullptr;
+}
+
+bool ThreadGroupImpl::SpillLocalQueueLockRequired(LocalTaskSourceQueue* queue) {
+  bool spilled = false;
+  while (RegisteredTaskSource task_source = queue->Pop()) {
+    const TaskSourceSortKey sort_key =
+        task_source->GetSortKey(disable_fair_scheduling_);
+    priority_queue_.Push(std::move(task_source), sort_key);
+    spilled = true;
+  }
+  return spilled;
+}
+
+void ThreadGroupImpl::UpdateNumIdleWorkersLockRequired() {
+  num_idle_workers_.store(idle_workers_stack_.Size(),
+                          std::memory_order_seq_cst);
+}
+
+void ThreadGroupImpl::InvalidateLocalTaskSourcesWithoutLockRequired() {
+  work_limits_generation_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ThreadGroupImpl::MoveTaskSourceToPriorityQueueLockRequired(
+    const TaskSource& task_source) {
+  // Local queues are only used with work stealing, but this can be called
+  // before Start().
+  for (const auto& worker : workers_) {
+    LocalTaskSourceQueue* const queue =
+        static_cast<WorkerThreadDelegateImpl*>(worker->delegate())
+            ->local_queue();
+    if (queue->IsEmpty())
+      continue;
+    RegisteredTaskSource removed = queue->Remove(task_source);
+    if (removed) {
+      const TaskSourceSortKey sort_key =
+          removed->GetSortKey(disable_fair_scheduling_);
+      priority_queue_.Push(std::move(removed), sort_key);
+      return;
+    }
+  }
+}
+
+void ThreadGroupImpl::MoveAllTaskSourcesToPriorityQueueLockRequired() {
+  for (const auto& worker : workers_) {
+    SpillLocalQueueLockRequired(
+        static_cast<WorkerThreadDelegateImpl*>(worker->delegate())
+            ->local_queue());
+  }
+}
+
 ThreadGroupImpl::WorkerThreadDelegateImpl::WorkerThreadDelegateImpl(
     TrackedRef<ThreadGroupImpl> outer)
-    : outer_(std::move(outer)) {
+    : outer_(std::move(outer)), local_queue_(&outer_->lock_) {
   // Bound in OnMainEntry().
   DETACH_FROM_THREAD(worker_thread_checker_);
 }
@@ -584,6 +766,8 @@ void ThreadGroupImpl::WorkerThreadDelegateImpl::OnMainEntry(
   outer_->BindToCurrentThread();
   worker_only().worker_thread_ = worker;
   SetBlockingObserverForCurrentThread(this);
+  if (outer_->after_start().work_stealing)
+    tls_local_task_source_queue.Get().Set(&local_queue_);
 
   if (outer_->worker_started_for_testing_) {
     // When |worker_started_for_testing_| is set, the thread that starts workers
@@ -597,6 +781,13 @@ void ThreadGroupImpl::WorkerThreadDelegateImpl::OnMainEntry(
 RegisteredTaskSource ThreadGroupImpl::WorkerThreadDelegateImpl::GetWork(
     WorkerThread* worker) {
   DCHECK_CALLED_ON_VALID_THREAD(worker_thread_checker_);
+
+  // DidProcessTask() already took a task source from the local queue and kept
+  // the running task bookkeeping.
+  if (worker_only().next_task_source)
+    return std::move(worker_only().next_task_source);
+  worker_only().num_local_task_sources_without_lock = 0;
+
   DCHECK(!read_worker().current_task_priority);
   DCHECK(!read_worker().current_shutdown_behavior);
 
@@ -621,9 +812,18 @@ RegisteredTaskSource ThreadGroupImpl::WorkerThreadDelegateImpl::GetWork(
 
   if (!CanGetWorkLockRequired(&executor, worker))
     return nullptr;
+  worker_only().work_limits_generation =
+      outer_->work_limits_generation_.load(std::memory_order_relaxed);
 
   RegisteredTaskSource task_source;
   TaskPriority priority;
+  // Task sources posted by this worker come first, unless the priority queue
+  // holds work of higher priority.
+  if (outer_->after_start().work_stealing) {
+    task_source = outer_->PopLocalTaskSourceLockRequired(&local_queue_);
+    if (task_source)
+      priority = task_source->priority_racy();
+  }
   while (!task_source && !outer_->priority_queue_.IsEmpty()) {
     // Enforce the CanRunPolicy and that no more than |max_best_effort_tasks_|
     // BEST_EFFORT tasks run concurrently.
@@ -638,8 +838,25 @@ RegisteredTaskSource ThreadGroupImpl::WorkerThreadDelegateImpl::GetWork(
     task_source = outer_->TakeRegisteredTaskSource(&executor);
   }
   if (!task_source) {
+    // The local task sources that are left can't run right now. Let them wait
+    // in the priority queue, where any worker can pick them up later.
+    if (outer_->after_start().work_stealing)
+      HandOverLocalQueueLockRequired(&executor);
     OnWorkerBecomesIdleLockRequired(worker);
-    return nullptr;
+    if (!outer_->after_start().work_stealing)
+      return nullptr;
+
+    // Look for work in the local queues of other workers only once on the
+    // idle stack: a worker that pushes to its local queue after this worker
+    // finds it empty then sees an idle worker and takes its task source back
+    // (see PushTaskSourceToLocalQueue()).
+    task_source = outer_->StealTaskSourceLockRequired(worker);
+    if (!task_source)
+      return nullptr;
+    priority = task_source->priority_racy();
+    WorkerThread* const popped_worker = outer_->idle_workers_stack_.Pop();
+    DCHECK_EQ(popped_worker, worker);
+    outer_->UpdateNumIdleWorkersLockRequired();
   }
 
   // Running task bookkeeping.
@@ -665,6 +882,9 @@ void ThreadGroupImpl::WorkerThreadDelegateImpl::DidProcessTask(
 
   ++worker_only().num_tasks_since_last_detach;
 
+  if (!task_source && TakeLocalTaskSourceWithoutLock())
+    return;
+
   // A transaction to the TaskSource to reenqueue, if any. Instantiated here as
   // |TaskSource::lock_| is a UniversalPredecessor and must always be acquired
   // prior to acquiring a second lock
@@ -768,6 +988,7 @@ void ThreadGroupImpl::WorkerThreadDelegateImpl::CleanupLockRequired(
   }
   worker->Cleanup();
   outer_->idle_workers_stack_.Remove(worker);
+  outer_->UpdateNumIdleWorkersLockRequired();
 
   // Remove the worker from |workers_|.
   auto worker_iter = ranges::find(outer_->workers_, worker);
@@ -782,10 +1003,63 @@ void ThreadGroupImpl::WorkerThreadDelegateImpl::OnWorkerBecomesIdleLockRequired(
   // Add the worker to the idle stack.
   DCHECK(!outer_->idle_workers_stack_.Contains(worker));
   outer_->idle_workers_stack_.Push(worker);
+  outer_->UpdateNumIdleWorkersLockRequired();
   DCHECK_LE(outer_->idle_workers_stack_.Size(), outer_->workers_.size());
   outer_->idle_workers_stack_cv_for_testing_->Broadcast();
 }
 
+void ThreadGroupImpl::WorkerThreadDelegateImpl::HandOverLocalQueueLockRequired(
+    ScopedCommandsExecutor* executor) {
+  if (outer_->SpillLocalQueueLockRequired(&local_queue_))
+    outer_->EnsureEnoughWorkersLockRequired(executor);
+}
+
+bool ThreadGroupImpl::WorkerThreadDelegateImpl::
+    TakeLocalTaskSourceWithoutLock() {
+  if (!outer_->after_start().work_stealing || local_queue_.IsEmpty() ||
+      worker_only().num_local_task_sources_without_lock >=
+          kMaxLocalTaskSourcesWithoutLock) {
+    return false;
+  }
+
+  // Max tasks may have decreased, making this worker excess, or shutdown may
+  // have started, requiring DidProcessTask() to revert a max tasks increment.
+  if (outer_->work_limits_generation_.load(std::memory_order_relaxed) !=
+      worker_only().work_limits_generation) {
+    return false;
+  }
+
+  // The next task source inherits the running task bookkeeping of the task
+  // that just ran, which requires the same priority and shutdown behavior. It
+  // must also be allowed to run, and not hold back work of higher priority.
+  const TaskPriority priority = *read_worker().current_task_priority;
+  const TaskShutdownBehavior shutdown_behavior =
+      *read_worker().current_shutdown_behavior;
+  if (!outer_->task_tracker_->CanRunPriority(priority))
+    return false;
+  const YieldSortKey max_allowed_sort_key =
+      TS_UNCHECKED_READ(outer_->max_allowed_sort_key_)
+          .load(std::memory_order_relaxed);
+  if (max_allowed_sort_key.priority > priority)
+    return false;
+
+  RegisteredTaskSource task_source =
+      local_queue_.PopIf([&](const TaskSource& candidate) {
+        return candidate.priority_racy() == priority &&
+               candidate.shutdown_behavior() == shutdown_behavior;
+      });
+  if (!task_source)
+    return false;
+
+  // Only parallel Sequences are pushed to local queues, and they are always
+  // saturated.
+  const TaskSource::RunStatus run_status = task_source.WillRunTask();
+  DCHECK_EQ(run_status, TaskSource::RunStatus::kAllowedSaturated);
+  ++worker_only().num_local_task_sources_without_lock;
+  worker_only().next_task_source = std::move(task_source);
+  return true;
+}
+
 void ThreadGroupImpl::WorkerThreadDelegateImpl::OnMainExit(
     WorkerThread* worker) {
   DCHECK_CALLED_ON_VALID_THREAD(worker_thread_checker_);
@@ -810,6 +1084,16 @@ void ThreadGroupImpl::WorkerThreadDelegateImpl::OnMainExit(
   worker_only().win_thread_environment.reset();
 #endif  // BUILDFLAG(IS_WIN)
 
+  if (outer_->after_start().work_stealing) {
+    tls_local_task_source_queue.Get().Set(nullptr);
+    // The worker may exit between DidProcessTask() and GetWork() when it is
+    // joined. Leave the task source it took for JoinForTesting() to flush.
+    if (worker_only().next_task_source) {
+      const bool pushed = local_queue_.Push(&worker_only().next_task_source);
+      DCHECK(pushed);
+    }
+  }
+
   // Count cleaned up workers for tests. It's important to do this here instead
   // of at the end of CleanupLockRequired() because some side-effects of
   // cleaning up happen outside the lock (e.g. recording histograms) and
@@ -847,6 +1131,14 @@ void ThreadGroupImpl::WorkerThreadDelegateImpl::BlockingStarted(
   DCHECK(read_worker().blocking_start_time.is_null());
   write_worker().blocking_start_time = subtle::TimeTicksNowIgnoringOverride();
 
+  // Task sources posted by this worker shouldn't wait for it to unblock, so
+  // hand over its local queue, and have PushTaskSourceToLocalQueue() reject
+  // those it posts until then.
+  if (outer_->after_start().work_stealing) {
+    HandOverLocalQueueLockRequired(&executor);
+    tls_local_task_source_queue.Get().Set(nullptr);
+  }
+
   if (incremented_max_tasks_for_shutdown_)
     return;
 
@@ -899,6 +1191,8 @@ void ThreadGroupImpl::WorkerThreadDelegateImpl::BlockingEnded() {
   DCHECK(read_worker().current_task_priority);
   DCHECK(!read_worker().blocking_start_time.is_null());
   write_worker().blocking_start_time = TimeTicks();
+  if (outer_->after_start().work_stealing)
+    tls_local_task_source_queue.Get().Set(&local_queue_);
   if (!incremented_max_tasks_for_shutdown_) {
     if (incremented_max_tasks_since_blocked_)
       outer_->DecrementMaxTasksLockRequired();
@@ -954,6 +1248,8 @@ bool ThreadGroupImpl::WorkerThreadDelegateImpl::CanGetWorkLockRequired(
   // thread group, they get a chance to no longer be excess before being cleaned
   // up.
   if (outer_->GetNumAwakeWorkersLockRequired() > outer_->max_tasks_) {
+    if (outer_->after_start().work_stealing)
+      HandOverLocalQueueLockRequired(executor);
     OnWorkerBecomesIdleLockRequired(worker);
     return false;
   }
@@ -1016,6 +1312,7 @@ void ThreadGroupImpl::MaintainAtLeastOneIdleWorkerLockRequired(
       CreateAndRegisterWorkerLockRequired(executor);
   DCHECK(new_worker);
   idle_workers_stack_.Push(new_worker.get());
+  UpdateNumIdleWorkersLockRequired();
 }
 
 scoped_refptr<WorkerThread>
@@ -1097,6 +1394,7 @@ void ThreadGroupImpl::OnShutdownStarted() {
     AnnotateAcquiredLockAlias annotate(lock_, delegate->lock());
     delegate->OnShutdownStartedLockRequired(&executor);
   }
+  InvalidateLocalTaskSourcesWithoutLockRequired();
   EnsureEnoughWorkersLockRequired(&executor);
 
   shutdown_started_ = true;
@@ -1128,6 +1426,7 @@ void ThreadGroupImpl::EnsureEnoughWorkersLockRequired(
   for (size_t i = 0; i < num_workers_to_wake_up; ++i) {
     MaintainAtLeastOneIdleWorkerLockRequired(executor);
     WorkerThread* worker_to_wakeup = idle_workers_stack_.Pop();
+    UpdateNumIdleWorkersLockRequired();
     DCHECK(worker_to_wakeup);
     executor->ScheduleWakeUp(worker_to_wakeup);
   }
@@ -1256,6 +1555,7 @@ void ThreadGroupImpl::DecrementMaxTasksLockRequired() {
   DCHECK_GT(num_running_tasks_, 0U);
   DCHECK_GT(max_tasks_, 0U);
   --max_tasks_;
+  InvalidateLocalTaskSourcesWithoutLockRequired();
   UpdateMinAllowedPriorityLockRequired();
 }
 
@@ -1269,6 +1569,7 @@ void ThreadGroupImpl::DecrementMaxBestEffortTasksLockRequired() {
   DCHECK_GT(num_running_tasks_, 0U);
   DCHECK_GT(max_best_effort_tasks_, 0U);
   --max_best_effort_tasks_;
+  InvalidateLocalTaskSourcesWithoutLockRequired();
   UpdateMinAllowedPriorityLockRequired();
 }
 
@@ -7,6 +7,7 @@
 
 #include <stddef.h>
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <vector>
@@ -38,6 +39,7 @@ class WorkerThreadObserver;
 
 namespace internal {
 
+class LocalTaskSourceQueue;
 class TaskTracker;
 
 // A group of workers that run Tasks.
@@ -56,11 +58,13 @@ class BASE_EXPORT ThreadGroupImpl : public ThreadGroup {
   // group's threads, it must not be empty. |thread_type_hint| is the preferred
   // thread type; the actual thread type depends on shutdown state and platform
   // capabilities. |task_tracker| keeps track of tasks.
+  // |predecessor_thread_group| is described in ThreadGroup.
   ThreadGroupImpl(StringPiece histogram_label,
                   StringPiece thread_group_label,
                   ThreadType thread_type_hint,
                   TrackedRef<TaskTracker> task_tracker,
-                  TrackedRef<Delegate> delegate);
+                  TrackedRef<Delegate> delegate,
+                  ThreadGroup* predecessor_thread_group = nullptr);
 
   // Creates threads, allowing existing and future tasks to run. The thread
   // group runs at most |max_tasks| / `max_best_effort_tasks` unblocked task
@@ -155,6 +159,41 @@ class BASE_EXPORT ThreadGroupImpl : public ThreadGroup {
       override;
   void EnsureEnoughWorkersLockRequired(BaseScopedCommandsExecutor* executor)
       override EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void MoveTaskSourceToPriorityQueueLockRequired(const TaskSource& task_source)
+      override EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void MoveAllTaskSourcesToPriorityQueueLockRequired() override
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Moves |*task_source| to the local queue of the current worker and returns
+  // true if work stealing is enabled, the current thread is a worker of this
+  // thread group, |*task_source| is a parallel BEST_EFFORT/USER_VISIBLE task
+  // source and no worker is idle. Returns false, leaving |*task_source| as is,
+  // if it should be pushed to |priority_queue_| instead.
+  bool PushTaskSourceToLocalQueue(RegisteredTaskSource* task_source);
+
+  // Pops the front of |queue| if the CanRunPolicy and |max_best_effort_tasks_|
+  // allow it to run and no task source of higher priority is waiting in
+  // |priority_queue_|, and returns it ready to run.
+  RegisteredTaskSource PopLocalTaskSourceLockRequired(
+      LocalTaskSourceQueue* queue) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Returns a task source ready to run from the local queue of a worker other
+  // than |thief|, or nullptr if there is none.
+  RegisteredTaskSource StealTaskSourceLockRequired(const WorkerThread* thief)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Moves all task sources of |queue| to |priority_queue_|. Returns true if
+  // any task source was moved.
+  bool SpillLocalQueueLockRequired(LocalTaskSourceQueue* queue)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Must be called after each change to |idle_workers_stack_|.
+  void UpdateNumIdleWorkersLockRequired() EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Must be called after each change that workers can only take into account
+  // with |lock_| held, see |work_limits_generation_|.
+  void InvalidateLocalTaskSourcesWithoutLockRequired()
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
   // Creates a worker and schedules its start, if needed, to maintain one idle
   // worker, |max_tasks_| permitting.
@@ -255,6 +294,7 @@ class BASE_EXPORT ThreadGroupImpl : public ThreadGroup {
 
     WakeUpStrategy wakeup_strategy;
     bool wakeup_after_getwork;
+    bool work_stealing;
     bool may_block_without_delay;
 
     // Threshold after which the max tasks is increased to compensate for a
@@ -310,6 +350,20 @@ class BASE_EXPORT ThreadGroupImpl : public ThreadGroup {
   // is pushed on this stack when it receives nullptr from GetWork().
   WorkerThreadStack idle_workers_stack_ GUARDED_BY(lock_);
 
+  // Size of |idle_workers_stack_|, readable without |lock_|. Workers posting
+  // tasks only keep them local while this is zero.
+  std::atomic<size_t> num_idle_workers_{0};
+
+  // Index in |workers_| of the next worker to steal from.
+  size_t next_worker_to_steal_from_ GUARDED_BY(lock_) = 0;
+
+  // Incremented under |lock_| when |max_tasks_| or |max_best_effort_tasks_|
+  // decreases or shutdown starts. A worker only takes task sources from its
+  // local queue without |lock_| while this is unchanged since its last
+  // GetWork() with |lock_|, so that it otherwise goes through the checks and
+  // bookkeeping of DidProcessTask() and GetWork().
+  std::atomic<uint32_t> work_limits_generation_{0};
+
   // Signaled when a worker is added to the idle workers stack.
   std::unique_ptr<ConditionVariable> idle_workers_stack_cv_for_testing_
       GUARDED_BY(lock_);
@@ -31,6 +31,7 @@
 #include "base/task/task_runner.h"
 #include "base/task/thread_pool/delayed_task_manager.h"
 #include "base/task/thread_pool/environment_config.h"
+#include "base/task/thread_pool/local_task_source_queue.h"
 #include "base/task/thread_pool/pooled_task_runner_delegate.h"
 #include "base/task/thread_pool/sequence.h"
 #include "base/task/thread_pool/task_source_sort_key.h"
@@ -41,6 +42,7 @@
 #include "base/test/bind.h"
 #include "base/test/gtest_util.h"
 #include "base/test/metrics/histogram_tester.h"
+#include "base/test/scoped_feature_list.h"
 #include "base/test/test_simple_task_runner.h"
 #include "base/test/test_timeouts.h"
 #include "base/test/test_waitable_event.h"
@@ -2015,5 +2017,204 @@ TEST_F(ThreadGroupImplImplStartInBodyTest, RacyCleanup) {
   thread_group_.reset();
 }
 
+namespace {
+
+class ThreadGroupImplWorkStealingTest
+    : public ThreadGroupImplImplStartInBodyTest {
+ protected:
+  ThreadGroupImplWorkStealingTest() = default;
+
+  // Pushes a parallel sequence with |traits| running |closure| to
+  // |thread_group_|, and returns it.
+  scoped_refptr<Sequence> PushSequence(OnceClosure closure,
+                                       const TaskTraits& traits) {
+    Task task(FROM_HERE, std::move(closure), TimeTicks::Now(), TimeDelta());
+    EXPECT_TRUE(task_tracker_.WillPostTask(&task, traits.shutdown_behavior()));
+    scoped_refptr<Sequence> sequence =
+        test::CreateSequenceWithTask(std::move(task), traits);
+    static_cast<ThreadGroup*>(thread_group_.get())
+        ->PushTaskSourceAndWakeUpWorkers(
+            TransactionWithRegisteredTaskSource::FromTaskSource(
+                task_tracker_.RegisterTaskSource(sequence)));
+    return sequence;
+  }
+
+  base::test::ScopedFeatureList feature_list_{kThreadGroupWorkStealing};
+};
+
+}  // namespace
+
+// Verify that all tasks posted from workers while every worker is busy run,
+// including those that overflow the local queues.
+TEST_F(ThreadGroupImplWorkStealingTest, FanOut) {
+  constexpr size_t kNumTasksPerWorker = 2 * LocalTaskSourceQueue::kCapacity;
+  StartThreadGroup(TimeDelta::Max(), kMaxTasks);
+  scoped_refptr<TaskRunner> task_runner = test::CreatePooledTaskRunner(
+      {TaskPriority::USER_VISIBLE, WithBaseSyncPrimitives()},
+      &mock_pooled_task_runner_delegate_);
+
+  std::atomic_size_t num_tasks_run{0};
+  TestWaitableEvent threads_running;
+  TestWaitableEvent threads_continue;
+  RepeatingClosure threads_running_barrier = BarrierClosure(
+      kMaxTasks,
+      BindOnce(&TestWaitableEvent::Signal, Unretained(&threads_running)));
+
+  for (size_t i = 0; i < kMaxTasks; ++i) {
+    task_runner->PostTask(FROM_HERE, BindLambdaForTesting([&]() {
+                            threads_running_barrier.Run();
+                            threads_continue.Wait();
+                            for (size_t j = 0; j < kNumTasksPerWorker; ++j) {
+                              task_runner->PostTask(
+                                  FROM_HERE, BindLambdaForTesting([&]() {
+                                    num_tasks_run.fetch_add(1);
+                                  }));
+                            }
+                          }));
+  }
+
+  threads_running.Wait();
+  threads_continue.Signal();
+  task_tracker_.FlushForTesting();
+  EXPECT_EQ(num_tasks_run.load(), kMaxTasks * kNumTasksPerWorker);
+}
+
+// Verify that a worker which blocks hands the tasks it posted over to other
+// workers, instead of keeping them until it unblocks, and doesn't queue the
+// tasks it posts while blocked locally either.
+TEST_F(ThreadGroupImplWorkStealingTest, BlockingHandsOverLocalTasks) {
+  // With a single worker, the nested task is queued locally.
+  StartThreadGroup(TimeDelta::Max(), 1);
+  scoped_refptr<TaskRunner> task_runner = test::CreatePooledTaskRunner(
+      {TaskPriority::USER_VISIBLE, MayBlock(), WithBaseSyncPrimitives()},
+      &mock_pooled_task_runner_delegate_);
+
+  TestWaitableEvent nested_task_ran;
+  TestWaitableEvent task_posted_while_blocked_ran;
+  task_runner->PostTask(
+      FROM_HERE, BindLambdaForTesting([&]() {
+        task_runner->PostTask(
+            FROM_HERE, BindLambdaForTesting([&]() {
+              nested_task_ran.Signal();
+              // Keep the worker which took the nested task busy, so that no
+              // worker is idle when the task below is posted.
+              ScopedBlockingCall scoped_blocking_call(FROM_HERE,
+                                                      BlockingType::WILL_BLOCK);
+              task_posted_while_blocked_ran.Wait();
+            }));
+        ScopedBlockingCall scoped_blocking_call(FROM_HERE,
+                                                BlockingType::WILL_BLOCK);
+        nested_task_ran.Wait();
+        task_runner->PostTask(
+            FROM_HERE, BindOnce(&TestWaitableEvent::Signal,
+                                Unretained(&task_posted_while_blocked_ran)));
+        task_posted_while_blocked_ran.Wait();
+      }));
+
+  task_tracker_.FlushForTesting();
+  EXPECT_TRUE(nested_task_ran.IsSignaled());
+  EXPECT_TRUE(task_posted_while_blocked_ran.IsSignaled());
+}
+
+// Verify that the priority of a task source in a local queue is updated, so
+// that the task which posted it yields to it.
+TEST_F(ThreadGroupImplWorkStealingTest, UpdateSortKeyOfLocalTaskSource) {
+  // With a single worker, the sequence is queued locally.
+  StartThreadGroup(TimeDelta::Max(), 1);
+  scoped_refptr<TaskRunner> task_runner = test::CreatePooledTaskRunner(
+      {TaskPriority::USER_VISIBLE}, &mock_pooled_task_runner_delegate_);
+  const TaskSourceSortKey running_sort_key(TaskPriority::USER_VISIBLE,
+                                           TimeTicks());
+
+  TestWaitableEvent local_task_ran;
+  task_runner->PostTask(
+      FROM_HERE, BindLambdaForTesting([&]() {
+        scoped_refptr<Sequence> sequence = PushSequence(
+            BindOnce(&TestWaitableEvent::Signal, Unretained(&local_task_ran)),
+            {TaskPriority::USER_VISIBLE});
+        EXPECT_FALSE(thread_group_->ShouldYield(running_sort_key));
+
+        auto transaction = sequence->BeginTransaction();
+        transaction.UpdatePriority(TaskPriority::USER_BLOCKING);
+        static_cast<ThreadGroup*>(thread_group_.get())
+            ->UpdateSortKey(std::move(transaction));
+        EXPECT_TRUE(thread_group_->ShouldYield(running_sort_key));
+      }));
+
+  task_tracker_.FlushForTesting();
+  EXPECT_TRUE(local_task_ran.IsSignaled());
+}
+
+// Verify that task sources in local queues are handed off to the replacement
+// thread group.
+TEST_F(ThreadGroupImplWorkStealingTest, HandoffLocalTaskSources) {
+  // With a single worker, the sequence is queued locally.
+  StartThreadGroup(TimeDelta::Max(), 1);
+  scoped_refptr<TaskRunner> task_runner = test::CreatePooledTaskRunner(
+      {TaskPriority::USER_VISIBLE}, &mock_pooled_task_runner_delegate_);
+  auto replacement_thread_group = std::make_unique<ThreadGroupImpl>(
+      "ReplacementThreadGroup", "B", ThreadType::kDefault,
+      task_tracker_.GetTrackedRef(), tracked_ref_factory_.GetTrackedRef(),
+      thread_group_.get());
+
+  TestWaitableEvent local_task_pushed;
+  TestWaitableEvent local_task_ran;
+  task_runner->PostTask(
+      FROM_HERE, BindLambdaForTesting([&]() {
+        PushSequence(
+            BindOnce(&TestWaitableEvent::Signal, Unretained(&local_task_ran)),
+            {TaskPriority::USER_VISIBLE});
+        local_task_pushed.Signal();
+        // Keep the only worker of |thread_group_| busy until the sequence runs
+        // in |replacement_thread_group|.
+        local_task_ran.Wait();
+      }));
+
+  local_task_pushed.Wait();
+  thread_group_->InvalidateAndHandoffAllTaskSourcesToOtherThreadGroup(
+      replacement_thread_group.get());
+  replacement_thread_group->Start(1, 1, TimeDelta::Max(),
+                                  service_thread_.task_runner(), nullptr,
+                                  ThreadGroup::WorkerEnvironment::NONE);
+  local_task_ran.Wait();
+
+  task_tracker_.FlushForTesting();
+  replacement_thread_group->JoinForTesting();
+}
+
+// Verify that a worker doesn't take a task source from its local queue without
+// the lock of its thread group after shutdown started, so that it first reverts
+// the max tasks increment made for its CONTINUE_ON_SHUTDOWN task.
+TEST_F(ThreadGroupImplWorkStealingTest, LocalTaskSourceAfterShutdownStarted) {
+  // With a single worker, the nested task is queued locally.
+  StartThreadGroup(TimeDelta::Max(), 1);
+  scoped_refptr<TaskRunner> task_runner = test::CreatePooledTaskRunner(
+      {TaskPriority::USER_VISIBLE, TaskShutdownBehavior::CONTINUE_ON_SHUTDOWN},
+      &mock_pooled_task_runner_delegate_);
+
+  TestWaitableEvent task_running;
+  TestWaitableEvent shutdown_started;
+  size_t max_tasks_in_nested_task = 0;
+  task_runner->PostTask(
+      FROM_HERE, BindLambdaForTesting([&]() {
+        task_runner->PostTask(FROM_HERE, BindLambdaForTesting([&]() {
+                                max_tasks_in_nested_task =
+                                    thread_group_->GetMaxTasksForTesting();
+                              }));
+        task_running.Signal();
+        shutdown_started.Wait();
+      }));
+
+  task_running.Wait();
+  // Only |thread_group_| is told about shutdown, so that the nested task still
+  // runs.
+  thread_group_->OnShutdownStarted();
+  EXPECT_EQ(thread_group_->GetMaxTasksForTesting(), 2U);
+  shutdown_started.Signal();
+
+  task_tracker_.FlushForTesting();
+  EXPECT_EQ(max_tasks_in_nested_task, 1U);
+}
+
 }  // namespace internal
 }  // namespace base
@@ -472,6 +472,47 @@ bool ThreadPoolImpl::PostTaskWithSequence(Task task,
   return true;
 }
 
+bool ThreadPoolImpl::PostTasksWithSequence(std::vector<Task> tasks,
+                                           scoped_refptr<Sequence> sequence) {
+  DCHECK(sequence);
+  if (tasks.empty())
+    return true;
+
+  for (Task& task : tasks) {
+    // Use CHECK instead of DCHECK to crash earlier. See http://crbug.com/711167
+    // for details.
+    CHECK(task.task);
+    DCHECK(task.delayed_run_time.is_null());
+    if (!task_tracker_->WillPostTask(&task, sequence->shutdown_behavior()))
+      return false;
+  }
+
+  // Push all the tasks in a single transaction, so that |sequence| is queued
+  // in its thread group, and workers are woken up, at most once.
+  auto transaction = sequence->BeginTransaction();
+  const bool sequence_should_be_queued = transaction.WillPushTask();
+  RegisteredTaskSource task_source;
+  if (sequence_should_be_queued) {
+    task_source = task_tracker_->RegisterTaskSource(sequence);
+    // We shouldn't push |tasks| if we're not allowed to queue |task_source|.
+    if (!task_source)
+      return false;
+  }
+  const TaskTraits traits = transaction.traits();
+  for (Task& task : tasks) {
+    // Immediate tasks are never rejected here.
+    const bool will_post_task_now =
+        task_tracker_->WillPostTaskNow(task, traits.priority());
+    DCHECK(will_post_task_now);
+    transaction.PushTask(std::move(task));
+  }
+  if (task_source) {
+    GetThreadGroupForTraits(traits)->PushTaskSourceAndWakeUpWorkers(
+        {std::move(task_source), std::move(transaction)});
+  }
+  return true;
+}
+
 bool ThreadPoolImpl::ShouldYield(const TaskSource* task_source) {
   if (disable_job_yield_)
     return false;
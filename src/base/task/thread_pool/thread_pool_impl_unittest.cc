@@ -880,6 +880,46 @@ TEST_P(ThreadPoolImplTest, SingleThreadRunsTasksInCurrentSequence) {
   task_ran.Wait();
 }
 
+// Verify that tasks posted as a batch to a SequencedTaskRunner run in order,
+// after the tasks posted before the batch.
+TEST_P(ThreadPoolImplTest, SequencedPostTasksRunInOrder) {
+  constexpr int kNumTasks = 100;
+  StartThreadPool();
+  auto sequenced_task_runner = thread_pool_->CreateSequencedTaskRunner({});
+
+  std::vector<int> run_order;
+  TestWaitableEvent tasks_ran;
+  sequenced_task_runner->PostTask(
+      FROM_HERE, BindLambdaForTesting([&]() { run_order.push_back(-1); }));
+  std::vector<OnceClosure> tasks;
+  for (int i = 0; i < kNumTasks; ++i) {
+    tasks.push_back(
+        BindLambdaForTesting([&run_order, i]() { run_order.push_back(i); }));
+  }
+  EXPECT_TRUE(sequenced_task_runner->PostTasks(FROM_HERE, tasks));
+  sequenced_task_runner->PostTask(
+      FROM_HERE, BindOnce(&TestWaitableEvent::Signal, Unretained(&tasks_ran)));
+  tasks_ran.Wait();
+
+  ASSERT_EQ(run_order.size(), static_cast<size_t>(kNumTasks + 1));
+  for (int i = 0; i <= kNumTasks; ++i)
+    EXPECT_EQ(run_order[i], i - 1);
+}
+
+// Verify that no task of a batch posted to a SequencedTaskRunner after
+// shutdown runs.
+TEST_P(ThreadPoolImplTest, SequencedPostTasksAfterShutdown) {
+  StartThreadPool();
+  auto sequenced_task_runner = thread_pool_->CreateSequencedTaskRunner(
+      {TaskShutdownBehavior::SKIP_ON_SHUTDOWN});
+  thread_pool_->Shutdown();
+
+  std::vector<OnceClosure> tasks;
+  for (int i = 0; i < 3; ++i)
+    tasks.push_back(BindOnce([]() { ADD_FAILURE(); }));
+  EXPECT_FALSE(sequenced_task_runner->PostTasks(FROM_HERE, tasks));
+}
+
 #if BUILDFLAG(IS_WIN)
 TEST_P(ThreadPoolImplTest, COMSTATaskRunnersRunWithCOMSTA) {
   StartThreadPool();
@@ -3,6 +3,7 @@
 // found in the LICENSE file.
 
 #include <stddef.h>
+#include <algorithm>
 #include <atomic>
 #include <memory>
 #include <vector>
@@ -13,8 +14,12 @@
 #include "base/callback_helpers.h"
 #include "base/memory/raw_ptr.h"
 #include "base/synchronization/waitable_event.h"
+#include "base/system/sys_info.h"
+#include "base/task/sequenced_task_runner.h"
+#include "base/task/task_features.h"
 #include "base/task/thread_pool.h"
 #include "base/task/thread_pool/thread_pool_instance.h"
+#include "base/test/scoped_feature_list.h"
 #include "base/threading/simple_thread.h"
 #include "base/time/time.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -39,8 +44,14 @@ constexpr char kStoryPostThenRunNoOpMoreThanRunningThreads[] =
 constexpr char kStoryPostRunNoOp[] = "post_run_noop_tasks";
 constexpr char kStoryPostRunNoOpManyThreads[] =
     "post_run_noop_tasks_many_threads";
+constexpr char kStoryPostRunNoOpSequenced[] = "post_run_noop_tasks_sequenced";
+constexpr char kStoryPostRunNoOpSequencedBatched[] =
+    "post_run_noop_tasks_sequenced_batched";
 constexpr char kStoryPostRunBusyManyThreads[] =
     "post_run_busy_tasks_many_threads";
+constexpr char kStoryFanOutNoOpManyCores[] = "fan_out_noop_tasks_many_cores";
+constexpr char kStoryFanOutNoOpManyCoresWorkStealing[] =
+    "fan_out_noop_tasks_many_cores_work_stealing";
 
 perf_test::PerfResultReporter SetUpReporter(const std::string& story_name) {
   perf_test::PerfResultReporter reporter(kMetricPrefixThreadPool, story_name);
@@ -94,6 +105,11 @@ class ThreadPoolPerfTest : public testing::Test {
   ThreadPoolPerfTest(const ThreadPoolPerfTest&) = delete;
   ThreadPoolPerfTest& operator=(const ThreadPoolPerfTest&) = delete;
 
+  // Returns the number of workers for benchmarks that use every core.
+  static size_t GetNumCores() {
+    return std::max(4, SysInfo::NumberOfProcessors());
+  }
+
   // Posting actions:
 
   void ContinuouslyBindAndPostNoOpTasks(size_t num_tasks) {
@@ -122,6 +138,40 @@ class ThreadPoolPerfTest : public testing::Test {
     }
   }
 
+  void ContinuouslyPostNoOpTasksToSequence(size_t num_tasks) {
+    scoped_refptr<SequencedTaskRunner> task_runner =
+        ThreadPool::CreateSequencedTaskRunner({});
+    base::RepeatingClosure closure = base::BindRepeating(
+        [](std::atomic_size_t* num_task_pending) { (*num_task_pending)--; },
+        &num_tasks_pending_);
+    for (size_t i = 0; i < num_tasks; ++i) {
+      ++num_tasks_pending_;
+      ++num_posted_tasks_;
+      task_runner->PostTask(FROM_HERE, closure);
+    }
+  }
+
+  // Same as ContinuouslyPostNoOpTasksToSequence(), but posts the tasks with
+  // PostTasks() in batches of |batch_size|.
+  void ContinuouslyBatchPostNoOpTasksToSequence(size_t num_tasks,
+                                                size_t batch_size) {
+    scoped_refptr<SequencedTaskRunner> task_runner =
+        ThreadPool::CreateSequencedTaskRunner({});
+    base::RepeatingClosure closure = base::BindRepeating(
+        [](std::atomic_size_t* num_task_pending) { (*num_task_pending)--; },
+        &num_tasks_pending_);
+    std::vector<OnceClosure> batch;
+    for (size_t i = 0; i < num_tasks; i += batch_size) {
+      const size_t num_tasks_in_batch = std::min(batch_size, num_tasks - i);
+      batch.clear();
+      for (size_t j = 0; j < num_tasks_in_batch; ++j)
+        batch.push_back(closure);
+      num_tasks_pending_ += num_tasks_in_batch;
+      num_posted_tasks_ += num_tasks_in_batch;
+      task_runner->PostTasks(FROM_HERE, batch);
+    }
+  }
+
   void ContinuouslyPostBusyWaitTasks(size_t num_tasks,
                                      base::TimeDelta duration) {
     scoped_refptr<TaskRunner> task_runner = ThreadPool::CreateTaskRunner({});
@@ -140,6 +190,32 @@ class ThreadPoolPerfTest : public testing::Test {
     }
   }
 
+  // Posts |num_tasks| tasks that each post |num_nested_tasks| no-op tasks from
+  // a worker, like parallel algorithms that split their work recursively.
+  void ContinuouslyPostFanOutNoOpTasks(size_t num_tasks,
+                                       size_t num_nested_tasks) {
+    scoped_refptr<TaskRunner> task_runner =
+        ThreadPool::CreateTaskRunner({TaskPriority::USER_VISIBLE});
+    base::RepeatingClosure nested_closure = base::BindRepeating(
+        [](std::atomic_size_t* num_task_pending) { (*num_task_pending)--; },
+        &num_tasks_pending_);
+    base::RepeatingClosure closure = base::BindRepeating(
+        [](TaskRunner* task_runner, const RepeatingClosure& nested_closure,
+           size_t num_nested_tasks, std::atomic_size_t* num_task_pending) {
+          for (size_t i = 0; i < num_nested_tasks; ++i)
+            task_runner->PostTask(FROM_HERE, nested_closure);
+          (*num_task_pending)--;
+        },
+        RetainedRef(task_runner), nested_closure, num_nested_tasks,
+        &num_tasks_pending_);
+    for (size_t i = 0; i < num_tasks; ++i) {
+      // Count nested tasks upfront, so that no pending task goes unnoticed.
+      num_tasks_pending_ += 1 + num_nested_tasks;
+      num_posted_tasks_ += 1 + num_nested_tasks;
+      task_runner->PostTask(FROM_HERE, closure);
+    }
+  }
+
  protected:
   ThreadPoolPerfTest() { ThreadPoolInstance::Create("PerfTest"); }
 
@@ -258,6 +334,23 @@ TEST_F(ThreadPoolPerfTest, PostRunNoOpTasksManyThreads) {
   Benchmark(kStoryPostRunNoOpManyThreads, ExecutionMode::kPostAndRun);
 }
 
+TEST_F(ThreadPoolPerfTest, PostRunNoOpTasksSequenced) {
+  StartThreadPool(
+      1, 1,
+      BindRepeating(&ThreadPoolPerfTest::ContinuouslyPostNoOpTasksToSequence,
+                    Unretained(this), 10000));
+  Benchmark(kStoryPostRunNoOpSequenced, ExecutionMode::kPostAndRun);
+}
+
+TEST_F(ThreadPoolPerfTest, PostRunNoOpTasksSequencedBatched) {
+  StartThreadPool(
+      1, 1,
+      BindRepeating(
+          &ThreadPoolPerfTest::ContinuouslyBatchPostNoOpTasksToSequence,
+          Unretained(this), 10000, 100));
+  Benchmark(kStoryPostRunNoOpSequencedBatched, ExecutionMode::kPostAndRun);
+}
+
 TEST_F(ThreadPoolPerfTest, PostRunBusyTasksManyThreads) {
   StartThreadPool(
       4, 4,
@@ -266,5 +359,22 @@ TEST_F(ThreadPoolPerfTest, PostRunBusyTasksManyThreads) {
   Benchmark(kStoryPostRunBusyManyThreads, ExecutionMode::kPostAndRun);
 }
 
+TEST_F(ThreadPoolPerfTest, FanOutNoOpTasksManyCores) {
+  StartThreadPool(
+      GetNumCores(), 1,
+      BindRepeating(&ThreadPoolPerfTest::ContinuouslyPostFanOutNoOpTasks,
+                    Unretained(this), 100, 100));
+  Benchmark(kStoryFanOutNoOpManyCores, ExecutionMode::kPostAndRun);
+}
+
+TEST_F(ThreadPoolPerfTest, FanOutNoOpTasksManyCoresWorkStealing) {
+  base::test::ScopedFeatureList feature_list(kThreadGroupWorkStealing);
+  StartThreadPool(
+      GetNumCores(), 1,
+      BindRepeating(&ThreadPoolPerfTest::ContinuouslyPostFanOutNoOpTasks,
+                    Unretained(this), 100, 100));
+  Benchmark(kStoryFanOutNoOpManyCoresWorkStealing, ExecutionMode::kPostAndRun);
+}
+
 }  // namespace internal
 }  // namespace base
@@ -302,6 +302,40 @@ void TraceBufferChunk::EstimateTraceMemoryOverhead(
   overhead->Update(*cached_overhead_estimate_);
 }
 
+TraceBufferChunkRing::TraceBufferChunkRing(size_t capacity)
+    : capacity_(capacity), slots_(new TraceBufferChunk*[capacity]) {
+  DCHECK_GT(capacity, 0u);
+}
+
+TraceBufferChunkRing::~TraceBufferChunkRing() {
+  while (TryPop()) {
+  }
+}
+
+bool TraceBufferChunkRing::TryPush(std::unique_ptr<TraceBufferChunk>* chunk) {
+  DCHECK(*chunk);
+  const size_t tail = tail_.load(std::memory_order_relaxed);
+  if (tail - head_.load(std::memory_order_acquire) == capacity_)
+    return false;
+  slots_[tail % capacity_] = chunk->release();
+  tail_.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+std::unique_ptr<TraceBufferChunk> TraceBufferChunkRing::TryPop() {
+  const size_t head = head_.load(std::memory_order_relaxed);
+  if (head == tail_.load(std::memory_order_acquire))
+    return nullptr;
+  std::unique_ptr<TraceBufferChunk> chunk(slots_[head % capacity_]);
+  head_.store(head + 1, std::memory_order_release);
+  return chunk;
+}
+
+size_t TraceBufferChunkRing::size() const {
+  const size_t head = head_.load(std::memory_order_acquire);
+  return tail_.load(std::memory_order_acquire) - head;
+}
+
 TraceResultBuffer::OutputCallback
 TraceResultBuffer::SimpleOutput::GetCallback() {
   return BindRepeating(&SimpleOutput::Append, Unretained(this));
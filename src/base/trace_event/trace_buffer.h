@@ -8,6 +8,9 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <atomic>
+#include <memory>
+
 #include "base/base_export.h"
 #include "base/check.h"
 #include "base/trace_event/trace_event.h"
@@ -55,6 +58,40 @@ class BASE_EXPORT TraceBufferChunk {
   uint32_t seq_;
 };
 
+// TraceBufferChunkRing is a bounded lock-free queue of chunks, which hands
+// chunks over from a single producer thread to a single consumer thread
+// without either of them blocking the other.
+class BASE_EXPORT TraceBufferChunkRing {
+ public:
+  explicit TraceBufferChunkRing(size_t capacity);
+  TraceBufferChunkRing(const TraceBufferChunkRing&) = delete;
+  TraceBufferChunkRing& operator=(const TraceBufferChunkRing&) = delete;
+  ~TraceBufferChunkRing();
+
+  // Moves |*chunk| to the back of the ring, or returns false and leaves it
+  // untouched if the ring is full. Must only be called by the producer.
+  bool TryPush(std::unique_ptr<TraceBufferChunk>* chunk);
+
+  // Removes the chunk at the front of the ring, or returns null if the ring is
+  // empty. Must only be called by the consumer.
+  std::unique_ptr<TraceBufferChunk> TryPop();
+
+  // Returns the number of chunks in the ring, which is exact only if the other
+  // side isn't running concurrently.
+  size_t size() const;
+  size_t capacity() const { return capacity_; }
+
+ private:
+  const size_t capacity_;
+  const std::unique_ptr<TraceBufferChunk*[]> slots_;
+
+  // The number of chunks popped and pushed so far, written only by the
+  // consumer and the producer respectively. They live on separate cache lines
+  // so that the two sides don't contend on them.
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) std::atomic<size_t> tail_{0};
+};
+
 // TraceBuffer holds the events as they are collected.
 class BASE_EXPORT TraceBuffer {
  public:
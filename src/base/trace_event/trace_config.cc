@@ -34,6 +34,7 @@ const char kEnableSystrace[] = "enable-systrace";
 constexpr int kEnableSystraceLength = sizeof(kEnableSystrace) - 1;
 
 const char kEnableArgumentFilter[] = "enable-argument-filter";
+const char kEnableThreadChunkRings[] = "enable-thread-chunk-rings";
 
 // String parameters that can be used to parse the trace config string.
 const char kRecordModeParam[] = "record_mode";
@@ -42,6 +43,7 @@ const char kTraceBufferSizeInKb[] = "trace_buffer_size_in_kb";
 const char kEnableSystraceParam[] = "enable_systrace";
 const char kSystraceEventsParam[] = "enable_systrace_events";
 const char kEnableArgumentFilterParam[] = "enable_argument_filter";
+const char kEnableThreadChunkRingsParam[] = "enable_thread_chunk_rings";
 const char kEnableEventPackageNameFilterParam[] = "enable_package_name_filter";
 
 // String parameters that is used to parse memory dump config in trace config
@@ -303,6 +305,7 @@ TraceConfig& TraceConfig::operator=(const TraceConfig& rhs) {
   trace_buffer_size_in_kb_ = rhs.trace_buffer_size_in_kb_;
   enable_systrace_ = rhs.enable_systrace_;
   enable_argument_filter_ = rhs.enable_argument_filter_;
+  enable_thread_chunk_rings_ = rhs.enable_thread_chunk_rings_;
   category_filter_ = rhs.category_filter_;
   process_filter_config_ = rhs.process_filter_config_;
   enable_event_package_name_filter_ = rhs.enable_event_package_name_filter_;
@@ -340,6 +343,7 @@ void TraceConfig::Merge(const TraceConfig& config) {
   if (record_mode_ != config.record_mode_ ||
       enable_systrace_ != config.enable_systrace_ ||
       enable_argument_filter_ != config.enable_argument_filter_ ||
+      enable_thread_chunk_rings_ != config.enable_thread_chunk_rings_ ||
       enable_event_package_name_filter_ !=
           config.enable_event_package_name_filter_) {
     DLOG(ERROR) << "Attempting to merge trace config with a different "
@@ -364,6 +368,7 @@ void TraceConfig::Clear() {
   trace_buffer_size_in_kb_ = 0;
   enable_systrace_ = false;
   enable_argument_filter_ = false;
+  enable_thread_chunk_rings_ = false;
   enable_event_package_name_filter_ = false;
   category_filter_.Clear();
   memory_dump_config_.Clear();
@@ -379,6 +384,7 @@ void TraceConfig::InitializeDefault() {
   trace_buffer_size_in_kb_ = 0;
   enable_systrace_ = false;
   enable_argument_filter_ = false;
+  enable_thread_chunk_rings_ = false;
   enable_event_package_name_filter_ = false;
 }
 
@@ -404,6 +410,8 @@ void TraceConfig::InitializeFromConfigDict(const Value& dict) {
   enable_systrace_ = dict.FindBoolKey(kEnableSystraceParam).value_or(false);
   enable_argument_filter_ =
       dict.FindBoolKey(kEnableArgumentFilterParam).value_or(false);
+  enable_thread_chunk_rings_ =
+      dict.FindBoolKey(kEnableThreadChunkRingsParam).value_or(false);
   enable_event_package_name_filter_ =
       dict.FindBoolKey(kEnableEventPackageNameFilterParam).value_or(false);
 
@@ -456,6 +464,7 @@ void TraceConfig::InitializeFromStrings(StringPiece category_filter_string,
   enable_systrace_ = false;
   systrace_events_.clear();
   enable_argument_filter_ = false;
+  enable_thread_chunk_rings_ = false;
   enable_event_package_name_filter_ = false;
   if (!trace_options_string.empty()) {
     std::vector<std::string> split =
@@ -492,6 +501,8 @@ void TraceConfig::InitializeFromStrings(StringPiece category_filter_string,
           systrace_events_.insert(systrace_event);
       } else if (token == kEnableArgumentFilter) {
         enable_argument_filter_ = true;
+      } else if (token == kEnableThreadChunkRings) {
+        enable_thread_chunk_rings_ = true;
       }
     }
   }
@@ -608,6 +619,8 @@ Value TraceConfig::ToValue() const {
   dict.Set(kRecordModeParam, TraceConfig::TraceRecordModeToStr(record_mode_));
   dict.Set(kEnableSystraceParam, enable_systrace_);
   dict.Set(kEnableArgumentFilterParam, enable_argument_filter_);
+  if (enable_thread_chunk_rings_)
+    dict.Set(kEnableThreadChunkRingsParam, true);
   if (trace_buffer_size_in_events_ > 0) {
     dict.Set(kTraceBufferSizeInEvents,
              base::checked_cast<int>(trace_buffer_size_in_events_));
@@ -733,6 +746,10 @@ std::string TraceConfig::ToTraceOptionsString() const {
     ret += ",";
     ret += kEnableArgumentFilter;
   }
+  if (enable_thread_chunk_rings_) {
+    ret += ",";
+    ret += kEnableThreadChunkRings;
+  }
   return ret;
 }
 
@@ -162,16 +162,17 @@ class BASE_EXPORT TraceConfig {
   //
   // |trace_options_string| is a comma-delimited list of trace options.
   // Possible options are: "record-until-full", "record-continuously",
-  // "record-as-much-as-possible", "trace-to-console", "enable-systrace" and
-  // "enable-argument-filter".
+  // "record-as-much-as-possible", "trace-to-console", "enable-systrace",
+  // "enable-argument-filter" and "enable-thread-chunk-rings".
   // The first 4 options are trace recoding modes and hence
   // mutually exclusive. If more than one trace recording modes appear in the
   // options_string, the last one takes precedence. If none of the trace
   // recording mode is specified, recording mode is RECORD_UNTIL_FULL.
   //
   // The trace option will first be reset to the default option
-  // (record_mode set to RECORD_UNTIL_FULL, enable_systrace and
-  // enable_argument_filter set to false) before options parsed from
+  // (record_mode set to RECORD_UNTIL_FULL, enable_systrace,
+  // enable_argument_filter and enable_thread_chunk_rings set to false) before
+  // options parsed from
   // |trace_options_string| are applied on it. If |trace_options_string| is
   // invalid, the final state of trace options is undefined.
   //
@@ -200,6 +201,7 @@ class BASE_EXPORT TraceConfig {
   //     "record_mode": "record-continuously",
   //     "enable_systrace": true,
   //     "enable_argument_filter": true,
+  //     "enable_thread_chunk_rings": true,
   //     "included_categories": ["included",
   //                             "inc_pattern*",
   //                             "disabled-by-default-memory-infra"],
@@ -235,6 +237,10 @@ class BASE_EXPORT TraceConfig {
   size_t GetTraceBufferSizeInKb() const { return trace_buffer_size_in_kb_; }
   bool IsSystraceEnabled() const { return enable_systrace_; }
   bool IsArgumentFilterEnabled() const { return enable_argument_filter_; }
+  // Whether each thread records its events into chunks of its own, which are
+  // moved to the trace buffer by a background thread, instead of taking the
+  // TraceLog lock for every event or chunk.
+  bool IsThreadChunkRingsEnabled() const { return enable_thread_chunk_rings_; }
 
   void SetTraceRecordMode(TraceRecordMode mode) { record_mode_ = mode; }
   void SetTraceBufferSizeInEvents(size_t size) {
@@ -244,6 +250,7 @@ class BASE_EXPORT TraceConfig {
   void EnableSystrace() { enable_systrace_ = true; }
   void EnableSystraceEvent(const std::string& systrace_event);
   void EnableArgumentFilter() { enable_argument_filter_ = true; }
+  void EnableThreadChunkRings() { enable_thread_chunk_rings_ = true; }
   void EnableHistogram(const std::string& histogram_name);
 
   // Writes the string representation of the TraceConfig. The string is JSON
@@ -343,6 +350,7 @@ class BASE_EXPORT TraceConfig {
   size_t trace_buffer_size_in_kb_ = 0;      // 0 specifies default size
   bool enable_systrace_ : 1;
   bool enable_argument_filter_ : 1;
+  bool enable_thread_chunk_rings_ : 1;
 
   TraceConfigCategoryFilter category_filter_;
 
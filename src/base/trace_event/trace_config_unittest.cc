@@ -149,6 +149,14 @@ TEST(TraceConfigTest, TraceConfigFromValidLegacyFormat) {
   EXPECT_STREQ("record-as-much-as-possible,enable-argument-filter",
                config.ToTraceOptionsString().c_str());
 
+  config = TraceConfig("", "enable-thread-chunk-rings,record-continuously");
+  EXPECT_EQ(RECORD_CONTINUOUSLY, config.GetTraceRecordMode());
+  EXPECT_FALSE(config.IsArgumentFilterEnabled());
+  EXPECT_TRUE(config.IsThreadChunkRingsEnabled());
+  EXPECT_STREQ("record-continuously,enable-thread-chunk-rings",
+               config.ToTraceOptionsString().c_str());
+  EXPECT_TRUE(TraceConfig(config.ToString()).IsThreadChunkRingsEnabled());
+
   config = TraceConfig(
     "",
     "enable-systrace,trace-to-console,enable-argument-filter");
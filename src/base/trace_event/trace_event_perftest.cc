@@ -0,0 +1,112 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/memory/raw_ptr.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/simple_thread.h"
+#include "base/time/time.h"
+#include "base/trace_event/trace_config.h"
+#include "base/trace_event/trace_event.h"
+#include "base/trace_event/trace_log.h"
+#include "base/tracing_buildflags.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+
+namespace base {
+namespace trace_event {
+
+#if !BUILDFLAG(USE_PERFETTO_CLIENT_LIBRARY)
+
+namespace {
+
+constexpr char kMetricPrefixTraceEvent[] = "TraceEvent.";
+constexpr char kMetricAddThroughput[] = "add_throughput";
+constexpr char kMetricAddTime[] = "add_time";
+
+constexpr int kNumEventsPerThread = 200000;
+
+perf_test::PerfResultReporter SetUpReporter(const std::string& story_name) {
+  perf_test::PerfResultReporter reporter(kMetricPrefixTraceEvent, story_name);
+  reporter.RegisterImportantMetric(kMetricAddThroughput, "events/ms");
+  reporter.RegisterImportantMetric(kMetricAddTime, "ns/event");
+  return reporter;
+}
+
+// A thread without a message loop, whose events don't go through a
+// thread-local buffer by default.
+class AddEventsThread : public SimpleThread {
+ public:
+  explicit AddEventsThread(WaitableEvent* start)
+      : SimpleThread("AddEventsThread"), start_(start) {}
+
+  void Run() override {
+    start_->Wait();
+    for (int i = 0; i < kNumEventsPerThread; ++i) {
+      TRACE_EVENT_INSTANT1("benchmark", "event", TRACE_EVENT_SCOPE_THREAD, "i",
+                           i);
+    }
+  }
+
+ private:
+  const raw_ptr<WaitableEvent> start_;
+};
+
+}  // namespace
+
+// Measures the cost of adding trace events on 1 to 8 threads, with and without
+// per-thread chunk rings. Recording continuously keeps the trace buffer from
+// filling up.
+class TraceEventPerfTest : public testing::Test {
+ protected:
+  void RunTests(const std::string& story_prefix,
+                const std::string& trace_options) {
+    TraceLog::GetInstance()->SetEnabled(TraceConfig("benchmark", trace_options),
+                                        TraceLog::RECORDING_MODE);
+    for (int num_threads : {1, 2, 4, 8})
+      RunTest(story_prefix, num_threads);
+    TraceLog::GetInstance()->SetDisabled();
+  }
+
+ private:
+  void RunTest(const std::string& story_prefix, int num_threads) {
+    WaitableEvent start;
+    std::vector<std::unique_ptr<AddEventsThread>> threads;
+    for (int i = 0; i < num_threads; ++i) {
+      threads.push_back(std::make_unique<AddEventsThread>(&start));
+      threads.back()->Start();
+    }
+
+    const TimeTicks start_time = TimeTicks::Now();
+    start.Signal();
+    for (auto& thread : threads)
+      thread->Join();
+    const TimeDelta elapsed = TimeTicks::Now() - start_time;
+
+    auto reporter =
+        SetUpReporter(story_prefix + "_" + NumberToString(num_threads));
+    reporter.AddResult(kMetricAddThroughput, num_threads * kNumEventsPerThread /
+                                                 elapsed.InMillisecondsF());
+    reporter.AddResult(kMetricAddTime,
+                       elapsed.InMicrosecondsF() * 1000 / kNumEventsPerThread);
+  }
+};
+
+TEST_F(TraceEventPerfTest, AddEvents) {
+  RunTests("shared_chunk", "record-continuously");
+}
+
+TEST_F(TraceEventPerfTest, AddEventsWithThreadChunkRings) {
+  RunTests("thread_chunk_rings",
+           "record-continuously,enable-thread-chunk-rings");
+}
+
+#endif  // !BUILDFLAG(USE_PERFETTO_CLIENT_LIBRARY)
+
+}  // namespace trace_event
+}  // namespace base
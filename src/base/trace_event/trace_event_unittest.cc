@@ -1470,6 +1470,54 @@ TEST_F(TraceEventTestFixture, DataCapturedManyThreads) {
   }
 }
 
+#if !BUILDFLAG(USE_PERFETTO_CLIENT_LIBRARY)
+// Test that events are captured from multiple threads recording into chunk
+// rings, including from threads which exit before the flush.
+TEST_F(TraceEventTestFixture, DataCapturedManyThreadsWithThreadChunkRings) {
+  TraceLog::GetInstance()->SetEnabled(
+      TraceConfig("*", "enable-thread-chunk-rings"), TraceLog::RECORDING_MODE);
+
+  // Enough events for the chunk rings to fill up.
+  const int num_threads = 4;
+  const int num_events = 4000;
+  std::vector<std::unique_ptr<Thread>> threads;
+  for (int i = 0; i < num_threads; i++) {
+    threads.push_back(std::make_unique<Thread>(StringPrintf("Thread %d", i)));
+    threads.back()->Start();
+    threads.back()->task_runner()->PostTask(
+        FROM_HERE,
+        base::BindOnce(&TraceManyInstantEvents, i, num_events, nullptr));
+  }
+
+  // Let half of the threads end before flush.
+  for (int i = 0; i < num_threads / 2; i++)
+    threads[i]->Stop();
+  for (int i = num_threads / 2; i < num_threads; i++)
+    threads[i]->FlushForTesting();
+
+  EndTraceAndFlush();
+  ValidateInstantEventPresentOnEveryThread(trace_parsed_, num_threads,
+                                           num_events);
+}
+
+// Test that scoped events recorded into chunk rings are recorded as BEGIN and
+// END events.
+TEST_F(TraceEventTestFixture, ScopedEventsWithThreadChunkRings) {
+  TraceLog::GetInstance()->SetEnabled(
+      TraceConfig("*", "enable-thread-chunk-rings"), TraceLog::RECORDING_MODE);
+  {
+    TRACE_EVENT0("test_all", "scoped event");
+    TRACE_EVENT_INSTANT0("test_all", "instant event", TRACE_EVENT_SCOPE_THREAD);
+  }
+  EndTraceAndFlush();
+
+  EXPECT_TRUE(FindNamePhase("scoped event", "B"));
+  EXPECT_TRUE(FindNamePhase("scoped event", "E"));
+  EXPECT_FALSE(FindNamePhase("scoped event", "X"));
+  EXPECT_TRUE(FindNamePhase("instant event", "I"));
+}
+#endif  // !BUILDFLAG(USE_PERFETTO_CLIENT_LIBRARY)
+
 // Test that thread and process names show up in the trace
 TEST_F(TraceEventTestFixture, ThreadNames) {
   // Create threads before we enable tracing to make sure
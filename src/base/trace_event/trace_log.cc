@@ -14,6 +14,7 @@
 #include "base/bind.h"
 #include "base/command_line.h"
 #include "base/containers/contains.h"
+#include "base/containers/cxx20_erase_vector.h"
 #include "base/debug/leak_annotations.h"
 #include "base/format_macros.h"
 #include "base/location.h"
@@ -31,6 +32,7 @@
 #include "base/strings/string_split.h"
 #include "base/strings/string_tokenizer.h"
 #include "base/strings/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
 #include "base/system/sys_info.h"
 #include "base/task/current_thread.h"
 #include "base/task/thread_pool.h"
@@ -174,6 +176,20 @@ void MakeHandle(uint32_t chunk_seq,
   handle->event_index = static_cast<uint16_t>(event_index);
 }
 
+// The handle of the COMPLETE events recorded by a ThreadChunkRecorder as BEGIN
+// events. No chunk has this index, and the events are ended by END events
+// instead of having their durations updated.
+void MakeThreadChunkRecorderHandle(TraceEventHandle* handle) {
+  handle->chunk_seq = 1;
+  handle->chunk_index = TraceBufferChunk::kMaxChunkIndex;
+  handle->event_index = 0;
+}
+
+bool IsThreadChunkRecorderHandle(TraceEventHandle handle) {
+  return handle.chunk_seq &&
+         handle.chunk_index == TraceBufferChunk::kMaxChunkIndex;
+}
+
 template <typename Function>
 void ForEachCategoryFilter(const unsigned char* category_group_enabled,
                            Function filter_fn) {
@@ -615,6 +631,184 @@ void TraceLog::ThreadLocalEventBuffer::FlushWhileLocked() {
   // find the generation mismatch and delete this buffer soon.
 }
 
+// Records the trace events of a thread with kInternalEnableThreadChunkRings.
+// The thread fills chunks of its own, and hands the full ones over to the
+// ThreadChunkFlusher through a lock-free ring, so that adding an event never
+// takes |lock_| unless the flusher falls behind. Emptied chunks come back
+// through another ring to be reused.
+//
+// Threads holding |lock_| may also take the chunks of a recorder. Taking the
+// chunk being filled requires detaching the recorder first, which waits for
+// the event being added, if any, and makes the thread drop the events it adds
+// until the recorder is attached again.
+class TraceLog::ThreadChunkRecorder {
+ public:
+  ThreadChunkRecorder(TraceLog* trace_log, ThreadChunkFlusher* flusher)
+      : trace_log_(trace_log), flusher_(flusher) {}
+  ThreadChunkRecorder(const ThreadChunkRecorder&) = delete;
+  ThreadChunkRecorder& operator=(const ThreadChunkRecorder&) = delete;
+  ~ThreadChunkRecorder() = default;
+
+  // Returns an event to fill in, or null if the recorder is detached. If an
+  // event is returned, EndAddTraceEvent() must be called once it is filled in.
+  // Must be called on the thread owning the recorder.
+  TraceEvent* BeginAddTraceEvent();
+  void EndAddTraceEvent() {
+    writing_.store(false, std::memory_order_release);
+  }
+
+  // Moves the full chunks to the trace buffer.
+  void DrainWhileLocked();
+
+  // Moves all the chunks to the trace buffer, or discards them if
+  // |discard_events| is true.
+  void FlushWhileLocked(bool discard_events);
+
+  TraceLog* trace_log() const { return trace_log_; }
+
+ private:
+  // The number of full chunks which can wait for the flusher, and the number
+  // of emptied chunks kept for reuse.
+  static constexpr size_t kNumFullChunks = 32;
+  static constexpr size_t kNumFreeChunks = 32;
+
+  bool StartWriting() {
+    // Pairs with Detach(): either this sees |detached_|, or Detach() sees
+    // |writing_| and waits until the event is added.
+    writing_.store(true, std::memory_order_seq_cst);
+    if (!detached_.load(std::memory_order_seq_cst))
+      return true;
+    writing_.store(false, std::memory_order_release);
+    return false;
+  }
+
+  void Detach() {
+    detached_.store(true, std::memory_order_seq_cst);
+    while (writing_.load(std::memory_order_seq_cst))
+      PlatformThread::YieldCurrentThread();
+  }
+
+  void Attach() { detached_.store(false, std::memory_order_release); }
+
+  // Makes |chunk| available for reuse, unless enough chunks already are.
+  void RecycleChunk(std::unique_ptr<TraceBufferChunk> chunk) {
+    chunk->Reset(0);
+    free_chunks_.TryPush(&chunk);
+  }
+
+  const raw_ptr<TraceLog> trace_log_;
+  const raw_ptr<ThreadChunkFlusher> flusher_;
+
+  // The chunk being filled. Owned by the thread unless the recorder is
+  // detached.
+  std::unique_ptr<TraceBufferChunk> chunk_;
+
+  // Full chunks, pushed by the thread and popped under |lock_|.
+  TraceBufferChunkRing full_chunks_{kNumFullChunks};
+  // Emptied chunks, pushed under |lock_| and popped by the thread.
+  TraceBufferChunkRing free_chunks_{kNumFreeChunks};
+
+  std::atomic_bool writing_{false};
+  std::atomic_bool detached_{false};
+};
+
+// The thread moving the chunks of ThreadChunkRecorders to the trace buffer.
+// It only runs when a recorder wakes it up, once half of its full chunk ring
+// is in use.
+class TraceLog::ThreadChunkFlusher : public PlatformThread::Delegate {
+ public:
+  explicit ThreadChunkFlusher(TraceLog* trace_log) : trace_log_(trace_log) {
+    CHECK(PlatformThread::Create(0, this, &thread_handle_));
+  }
+  ThreadChunkFlusher(const ThreadChunkFlusher&) = delete;
+  ThreadChunkFlusher& operator=(const ThreadChunkFlusher&) = delete;
+
+  ~ThreadChunkFlusher() override {
+    stopping_.store(true, std::memory_order_relaxed);
+    wake_up_.Signal();
+    PlatformThread::Join(thread_handle_);
+  }
+
+  void WakeUp() { wake_up_.Signal(); }
+
+ private:
+  // PlatformThread::Delegate:
+  void ThreadMain() override {
+    PlatformThread::SetName("TraceChunkFlusher");
+    while (true) {
+      wake_up_.Wait();
+      if (stopping_.load(std::memory_order_relaxed))
+        return;
+      trace_log_->DrainThreadChunkRecorders();
+    }
+  }
+
+  const raw_ptr<TraceLog> trace_log_;
+  WaitableEvent wake_up_{WaitableEvent::ResetPolicy::AUTOMATIC};
+  std::atomic_bool stopping_{false};
+  PlatformThreadHandle thread_handle_;
+};
+
+TraceEvent* TraceLog::ThreadChunkRecorder::BeginAddTraceEvent() {
+  if (!StartWriting())
+    return nullptr;
+
+  if (chunk_ && chunk_->IsFull()) {
+    if (!full_chunks_.TryPush(&chunk_)) {
+      // The flusher is falling behind, so move the chunks to the trace buffer
+      // on this thread, which must not hold up Detach() while waiting for
+      // |lock_|.
+      EndAddTraceEvent();
+      {
+        AutoLock lock(trace_log_->lock_);
+        DrainWhileLocked();
+        trace_log_->CheckIfBufferIsFullWhileLocked();
+      }
+      if (!StartWriting())
+        return nullptr;
+      // The ring was emptied, and the chunk replaced by an empty one if it was
+      // taken while the recorder was detached.
+      if (chunk_->IsFull())
+        CHECK(full_chunks_.TryPush(&chunk_));
+    } else if (full_chunks_.size() == kNumFullChunks / 2) {
+      flusher_->WakeUp();
+    }
+  }
+  if (!chunk_) {
+    chunk_ = free_chunks_.TryPop();
+    if (!chunk_) {
+      HEAP_PROFILER_SCOPED_IGNORE;
+      // Chunks of recorders have the sequence number 0, which no handle has.
+      chunk_ = std::make_unique<TraceBufferChunk>(0);
+    }
+  }
+
+  size_t event_index;
+  return chunk_->AddTraceEvent(&event_index);
+}
+
+void TraceLog::ThreadChunkRecorder::DrainWhileLocked() {
+  trace_log_->lock_.AssertAcquired();
+  while (std::unique_ptr<TraceBufferChunk> chunk = full_chunks_.TryPop())
+    RecycleChunk(trace_log_->AddThreadChunkWhileLocked(std::move(chunk)));
+}
+
+void TraceLog::ThreadChunkRecorder::FlushWhileLocked(bool discard_events) {
+  trace_log_->lock_.AssertAcquired();
+  Detach();
+  if (discard_events) {
+    while (std::unique_ptr<TraceBufferChunk> chunk = full_chunks_.TryPop())
+      RecycleChunk(std::move(chunk));
+  } else {
+    DrainWhileLocked();
+  }
+  if (chunk_ && chunk_->size() && !discard_events)
+    chunk_ = trace_log_->AddThreadChunkWhileLocked(std::move(chunk_));
+  if (chunk_)
+    chunk_->Reset(0);
+  Attach();
+}
+
 void TraceLog::SetAddTraceEventOverrides(
     const AddTraceEventOverrideFunction& add_event_override,
     const OnFlushFunction& on_flush_override,
@@ -708,6 +902,20 @@ TraceLog::~TraceLog() {
 #if BUILDFLAG(USE_PERFETTO_CLIENT_LIBRARY)
   perfetto::TrackEvent::RemoveSessionObserver(this);
 #endif  // BUILDFLAG(USE_PERFETTO_CLIENT_LIBRARY)
+
+  // Only reached in tests, through ResetForTesting(). The recorders of threads
+  // which are still alive are deleted here, since freeing
+  // |thread_chunk_recorder_slot_| keeps them from being deleted on exit.
+  std::unique_ptr<ThreadChunkFlusher> thread_chunk_flusher;
+  std::vector<ThreadChunkRecorder*> thread_chunk_recorders;
+  {
+    AutoLock lock(lock_);
+    thread_chunk_flusher = std::move(thread_chunk_flusher_);
+    thread_chunk_recorders.swap(thread_chunk_recorders_);
+  }
+  thread_chunk_flusher.reset();
+  for (ThreadChunkRecorder* recorder : thread_chunk_recorders)
+    delete recorder;
 }
 
 void TraceLog::InitializeThreadLocalEventBufferIfSupported() {
@@ -1128,6 +1336,8 @@ TraceLog::InternalTraceOptions TraceLog::GetInternalOptionsFromTraceConfig(
   InternalTraceOptions ret = config.IsArgumentFilterEnabled()
                                  ? kInternalEnableArgumentFilter
                                  : kInternalNone;
+  if (config.IsThreadChunkRingsEnabled())
+    ret |= kInternalEnableThreadChunkRings;
   switch (config.GetTraceRecordMode()) {
     case RECORD_UNTIL_FULL:
       return ret | kInternalRecordUntilFull;
@@ -1449,6 +1659,7 @@ void TraceLog::FlushInternal(const TraceLog::OutputCallback& cb,
       logged_events_->ReturnChunk(thread_shared_chunk_index_,
                                   std::move(thread_shared_chunk_));
     }
+    FlushThreadChunkRecordersWhileLocked(/*discard_events=*/false);
 
     for (const auto& it : thread_task_runners_)
       task_runners.push_back(it.second);
@@ -1647,12 +1858,65 @@ void TraceLog::OnFlushTimeout(int generation, bool discard_events) {
 }
 
 void TraceLog::UseNextTraceBuffer() {
+  // The events of the ThreadChunkRecorders belong to the previous buffer.
+  FlushThreadChunkRecordersWhileLocked(/*discard_events=*/true);
   logged_events_.reset(CreateTraceBuffer());
   generation_.fetch_add(1, std::memory_order_relaxed);
   thread_shared_chunk_.reset();
   thread_shared_chunk_index_ = 0;
 }
 
+TraceLog::ThreadChunkRecorder* TraceLog::GetOrCreateThreadChunkRecorder() {
+  auto* recorder =
+      static_cast<ThreadChunkRecorder*>(thread_chunk_recorder_slot_.Get());
+  if (recorder)
+    return recorder;
+
+  {
+    AutoLock lock(lock_);
+    if (!thread_chunk_flusher_)
+      thread_chunk_flusher_ = std::make_unique<ThreadChunkFlusher>(this);
+    recorder = new ThreadChunkRecorder(this, thread_chunk_flusher_.get());
+    thread_chunk_recorders_.push_back(recorder);
+  }
+  thread_chunk_recorder_slot_.Set(recorder);
+  return recorder;
+}
+
+// static
+void TraceLog::DeleteThreadChunkRecorder(void* recorder) {
+  auto* thread_chunk_recorder = static_cast<ThreadChunkRecorder*>(recorder);
+  TraceLog* trace_log = thread_chunk_recorder->trace_log();
+  {
+    AutoLock lock(trace_log->lock_);
+    thread_chunk_recorder->FlushWhileLocked(/*discard_events=*/false);
+    Erase(trace_log->thread_chunk_recorders_, thread_chunk_recorder);
+  }
+  delete thread_chunk_recorder;
+}
+
+void TraceLog::DrainThreadChunkRecorders() {
+  AutoLock lock(lock_);
+  for (ThreadChunkRecorder* recorder : thread_chunk_recorders_)
+    recorder->DrainWhileLocked();
+  // Not checked while draining, since it may release |lock_|.
+  CheckIfBufferIsFullWhileLocked();
+}
+
+void TraceLog::FlushThreadChunkRecordersWhileLocked(bool discard_events) {
+  for (ThreadChunkRecorder* recorder : thread_chunk_recorders_)
+    recorder->FlushWhileLocked(discard_events);
+}
+
+std::unique_ptr<TraceBufferChunk> TraceLog::AddThreadChunkWhileLocked(
+    std::unique_ptr<TraceBufferChunk> chunk) {
+  size_t chunk_index;
+  std::unique_ptr<TraceBufferChunk> empty_chunk =
+      logged_events_->GetChunk(&chunk_index);
+  logged_events_->ReturnChunk(chunk_index, std::move(chunk));
+  return empty_chunk;
+}
+
 bool TraceLog::ShouldAddAfterUpdatingState(
     char phase,
     const unsigned char* category_group_enabled,
@@ -1839,11 +2103,16 @@ TraceEventHandle TraceLog::AddTraceEventWithThreadIdAndTimestamps(
   TimeTicks offset_event_timestamp = OffsetTimestamp(timestamp);
 
   ThreadLocalEventBuffer* thread_local_event_buffer = nullptr;
+  bool use_thread_chunk_recorder = false;
   if (*category_group_enabled & RECORDING_MODE) {
-    // |thread_local_event_buffer_| can be null if the current thread doesn't
-    // have a message loop or the message loop is blocked.
-    InitializeThreadLocalEventBufferIfSupported();
-    thread_local_event_buffer = thread_local_event_buffer_.Get();
+    if (trace_options() & kInternalEnableThreadChunkRings) {
+      use_thread_chunk_recorder = true;
+    } else {
+      // |thread_local_event_buffer_| can be null if the current thread doesn't
+      // have a message loop or the message loop is blocked.
+      InitializeThreadLocalEventBufferIfSupported();
+      thread_local_event_buffer = thread_local_event_buffer_.Get();
+    }
   }
 
   if (*category_group_enabled & RECORDING_MODE) {
@@ -1861,6 +2130,14 @@ TraceEventHandle TraceLog::AddTraceEventWithThreadIdAndTimestamps(
     }
   }
 
+  // The chunk holding an event of a ThreadChunkRecorder may be moved to the
+  // trace buffer at any time, so COMPLETE events are recorded as BEGIN events
+  // and ended by END events rather than having their durations updated.
+  const bool record_complete_as_begin =
+      use_thread_chunk_recorder && phase == TRACE_EVENT_PHASE_COMPLETE;
+  if (record_complete_as_begin)
+    phase = TRACE_EVENT_PHASE_BEGIN;
+
   std::string console_message;
   std::unique_ptr<TraceEvent> filtered_trace_event;
   bool disabled_by_filters = false;
@@ -1886,8 +2163,14 @@ TraceEventHandle TraceLog::AddTraceEventWithThreadIdAndTimestamps(
       !disabled_by_filters) {
     OptionalAutoLock lock(&lock_);
 
+    ThreadChunkRecorder* thread_chunk_recorder = nullptr;
     TraceEvent* trace_event = nullptr;
-    if (thread_local_event_buffer) {
+    if (use_thread_chunk_recorder) {
+      thread_chunk_recorder = GetOrCreateThreadChunkRecorder();
+      trace_event = thread_chunk_recorder->BeginAddTraceEvent();
+      if (trace_event && record_complete_as_begin)
+        MakeThreadChunkRecorderHandle(&handle);
+    } else if (thread_local_event_buffer) {
       trace_event = thread_local_event_buffer->AddTraceEvent(&handle);
     } else {
       lock.EnsureAcquired();
@@ -1914,6 +2197,9 @@ TraceEventHandle TraceLog::AddTraceEventWithThreadIdAndTimestamps(
           phase == TRACE_EVENT_PHASE_COMPLETE ? TRACE_EVENT_PHASE_BEGIN : phase,
           timestamp, trace_event);
     }
+
+    if (thread_chunk_recorder && trace_event)
+      thread_chunk_recorder->EndAddTraceEvent();
   }
 
   if (!console_message.empty())
@@ -2053,20 +2339,44 @@ void TraceLog::UpdateTraceEventDurationExplicit(
   if (*category_group_enabled & TraceCategory::ENABLED_FOR_RECORDING) {
     OptionalAutoLock lock(&lock_);
 
-    TraceEvent* trace_event = GetEventByHandleInternal(handle, &lock);
-    if (trace_event) {
-      DCHECK(trace_event->phase() == TRACE_EVENT_PHASE_COMPLETE);
+    ThreadChunkRecorder* thread_chunk_recorder = nullptr;
+    TraceEvent* trace_event = nullptr;
+    if (IsThreadChunkRecorderHandle(handle)) {
+      // The event was recorded as a BEGIN event, which an END event ends.
+      if (trace_options() & kInternalEnableThreadChunkRings) {
+        thread_chunk_recorder = GetOrCreateThreadChunkRecorder();
+        trace_event = thread_chunk_recorder->BeginAddTraceEvent();
+      }
+      if (trace_event) {
+        trace_event->Reset(thread_id, now, thread_now, TRACE_EVENT_PHASE_END,
+                           category_group_enabled, name,
+                           trace_event_internal::kGlobalScope,
+                           trace_event_internal::kNoId,
+                           trace_event_internal::kNoId, nullptr,
+                           TRACE_EVENT_FLAG_NONE);
+#if BUILDFLAG(IS_ANDROID)
+        trace_event->SendToATrace();
+#endif
+      }
+    } else {
+      trace_event = GetEventByHandleInternal(handle, &lock);
+      if (trace_event) {
+        DCHECK(trace_event->phase() == TRACE_EVENT_PHASE_COMPLETE);
 
-      trace_event->UpdateDuration(now, thread_now);
+        trace_event->UpdateDuration(now, thread_now);
 #if BUILDFLAG(IS_ANDROID)
-      trace_event->SendToATrace();
+        trace_event->SendToATrace();
 #endif
+      }
     }
 
     if (trace_options() & kInternalEchoToConsole) {
       console_message =
           EventToConsoleMessage(TRACE_EVENT_PHASE_END, now, trace_event);
     }
+
+    if (thread_chunk_recorder && trace_event)
+      thread_chunk_recorder->EndAddTraceEvent();
   }
 
   if (!console_message.empty())
@@ -23,6 +23,7 @@
 #include "base/task/single_thread_task_runner.h"
 #include "base/threading/platform_thread.h"
 #include "base/threading/thread_local.h"
+#include "base/threading/thread_local_storage.h"
 #include "base/time/time_override.h"
 #include "base/trace_event/category_registry.h"
 #include "base/trace_event/memory_dump_provider.h"
@@ -499,6 +500,8 @@ class BASE_EXPORT TraceLog :
       const TraceConfig& config);
 
   class ThreadLocalEventBuffer;
+  class ThreadChunkRecorder;
+  class ThreadChunkFlusher;
   class OptionalAutoLock;
   struct RegisteredAsyncObserver;
 
@@ -532,6 +535,23 @@ class BASE_EXPORT TraceLog :
   TraceEvent* GetEventByHandleInternal(TraceEventHandle handle,
                                        OptionalAutoLock* lock);
 
+  // Returns the ThreadChunkRecorder of the current thread, creating it and the
+  // ThreadChunkFlusher if needed.
+  ThreadChunkRecorder* GetOrCreateThreadChunkRecorder();
+  // The destructor of |thread_chunk_recorder_slot_|, which runs when a thread
+  // exits.
+  static void DeleteThreadChunkRecorder(void* recorder);
+  // Moves the full chunks of all the ThreadChunkRecorders to the trace buffer.
+  // Called by the ThreadChunkFlusher.
+  void DrainThreadChunkRecorders();
+  // Moves all the chunks of all the ThreadChunkRecorders, including the ones
+  // being filled, to the trace buffer or discards them.
+  void FlushThreadChunkRecordersWhileLocked(bool discard_events)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  // Moves |chunk| to the trace buffer, and returns an empty chunk to recycle.
+  std::unique_ptr<TraceBufferChunk> AddThreadChunkWhileLocked(
+      std::unique_ptr<TraceBufferChunk> chunk) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   void FlushInternal(const OutputCallback& cb,
                      bool use_worker_thread,
                      bool discard_events);
@@ -558,7 +578,7 @@ class BASE_EXPORT TraceLog :
   bool CheckGeneration(int generation) const {
     return generation == this->generation();
   }
-  void UseNextTraceBuffer();
+  void UseNextTraceBuffer() EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
   TimeTicks OffsetNow() const {
     // This should be TRACE_TIME_TICKS_NOW but include order makes that hard.
@@ -576,6 +596,7 @@ class BASE_EXPORT TraceLog :
   static const InternalTraceOptions kInternalEchoToConsole;
   static const InternalTraceOptions kInternalRecordAsMuchAsPossible;
   static const InternalTraceOptions kInternalEnableArgumentFilter;
+  static const InternalTraceOptions kInternalEnableThreadChunkRings;
 
   // This lock protects TraceLog member accesses (except for members protected
   // by thread_info_lock_) from arbitrary threads.
@@ -641,6 +662,14 @@ class BASE_EXPORT TraceLog :
   std::unique_ptr<TraceBufferChunk> thread_shared_chunk_;
   size_t thread_shared_chunk_index_;
 
+  // With kInternalEnableThreadChunkRings, each thread records its events into
+  // chunks of its own without taking |lock_|. The ThreadChunkFlusher thread
+  // moves them to the trace buffer.
+  ThreadLocalStorage::Slot thread_chunk_recorder_slot_{
+      &DeleteThreadChunkRecorder};
+  std::vector<ThreadChunkRecorder*> thread_chunk_recorders_ GUARDED_BY(lock_);
+  std::unique_ptr<ThreadChunkFlusher> thread_chunk_flusher_ GUARDED_BY(lock_);
+
   // Set when asynchronous Flush is in progress.
   OutputCallback flush_output_callback_;
   scoped_refptr<SequencedTaskRunner> flush_task_runner_;
@@ -36,15 +36,24 @@
 
 #include "url/third_party/mozilla/url_parse.h"
 
+#include <stdint.h>
 #include <stdlib.h>
 
 #include <ostream>
 
+#include "base/bits.h"
 #include "base/check_op.h"
+#include "build/build_config.h"
 #include "url/url_parse_internal.h"
 #include "url/url_util.h"
 #include "url/url_util_internal.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#elif defined(ARCH_CPU_ARM64)
+#include <arm_neon.h>
+#endif
+
 namespace url {
 
 namespace {
@@ -54,18 +63,57 @@ inline bool IsPortDigit(char16_t ch) {
   return ch >= '0' && ch <= '9';
 }
 
+// Returns the offset of the first of |kDelimiters| in the input between
+// |begin| and |end|, or |end| if there is none. The delimiters of a URL are
+// rare, so 8-bit input is compared against all of them 16 characters at a
+// time where SIMD is available, and only the tail is scanned one character at
+// a time.
+template <char... kDelimiters, typename CHAR>
+int FindFirstOf(const CHAR* spec, int begin, int end) {
+  int i = begin;
+  if constexpr (sizeof(CHAR) == 1) {
+#ifdef __SSE2__
+    for (; end - i >= 16; i += 16) {
+      const __m128i chunk =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(spec + i));
+      __m128i matches = _mm_setzero_si128();
+      ((matches = _mm_or_si128(
+            matches, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(kDelimiters)))),
+       ...);
+      const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(matches));
+      if (mask)
+        return i + static_cast<int>(base::bits::CountTrailingZeroBits(mask));
+    }
+#elif defined(ARCH_CPU_ARM64)
+    for (; end - i >= 16; i += 16) {
+      const uint8x16_t chunk =
+          vld1q_u8(reinterpret_cast<const uint8_t*>(spec + i));
+      uint8x16_t matches = vdupq_n_u8(0);
+      ((matches = vorrq_u8(
+            matches,
+            vceqq_u8(chunk, vdupq_n_u8(static_cast<uint8_t>(kDelimiters))))),
+       ...);
+      // The scalar loop below finds the delimiter within this chunk.
+      if (vmaxvq_u8(matches))
+        break;
+    }
+#endif
+  }
+  for (; i < end; i++) {
+    if (((spec[i] == kDelimiters) || ...))
+      return i;
+  }
+  return end;  // Not found.
+}
+
 // Returns the offset of the next authority terminator in the input starting
 // from start_offset. If no terminator is found, the return value will be equal
-// to spec_len.
+// to spec_len. This matches IsAuthorityTerminator().
 template<typename CHAR>
 int FindNextAuthorityTerminator(const CHAR* spec,
                                 int start_offset,
                                 int spec_len) {
-  for (int i = start_offset; i < spec_len; i++) {
-    if (IsAuthorityTerminator(spec[i]))
-      return i;
-  }
-  return spec_len;  // Not found.
+  return FindFirstOf<'/', '\\', '?', '#'>(spec, start_offset, spec_len);
 }
 
 template<typename CHAR>
@@ -75,9 +123,8 @@ void ParseUserInfo(const CHAR* spec,
                    Component* password) {
   // Find the first colon in the user section, which separates the username and
   // password.
-  int colon_offset = 0;
-  while (colon_offset < user.len && spec[user.begin + colon_offset] != ':')
-    colon_offset++;
+  int colon_offset =
+      FindFirstOf<':'>(spec, user.begin, user.begin + user.len) - user.begin;
 
   if (colon_offset < user.len) {
     // Found separator: <username>:<password>
@@ -183,23 +230,16 @@ inline void FindQueryAndRefParts(const CHAR* spec,
                           int* query_separator,
                           int* ref_separator) {
   int path_end = path.begin + path.len;
-  for (int i = path.begin; i < path_end; i++) {
-    switch (spec[i]) {
-      case '?':
-        // Only match the query string if it precedes the reference fragment
-        // and when we haven't found one already.
-        if (*query_separator < 0)
-          *query_separator = i;
-        break;
-      case '#':
-        // Record the first # sign only.
-        if (*ref_separator < 0) {
-          *ref_separator = i;
-          return;
-        }
-        break;
-    }
+  int i = FindFirstOf<'?', '#'>(spec, path.begin, path_end);
+  if (i < path_end && spec[i] == '?') {
+    // Only match the query string if it precedes the reference fragment.
+    // Later question marks are part of the query.
+    *query_separator = i;
+    i = FindFirstOf<'#'>(spec, i + 1, path_end);
   }
+  // Record the first # sign only.
+  if (i < path_end)
+    *ref_separator = i;
 }
 
 template<typename CHAR>
@@ -267,13 +307,11 @@ bool DoExtractScheme(const CHAR* url,
     return false;  // Input is empty or all whitespace.
 
   // Find the first colon character.
-  for (int i = begin; i < url_len; i++) {
-    if (url[i] == ':') {
-      *scheme = MakeRange(begin, i);
-      return true;
-    }
-  }
-  return false;  // No colon found: no scheme
+  int colon = FindFirstOf<':'>(url, begin, url_len);
+  if (colon == url_len)
+    return false;  // No colon found: no scheme
+  *scheme = MakeRange(begin, colon);
+  return true;
 }
 
 // Fills in all members of the Parsed structure except for the scheme.
@@ -0,0 +1,113 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "url/url_canon_batch.h"
+
+#include <algorithm>
+
+#include "base/check_op.h"
+#include "base/memory/raw_ptr.h"
+#include "base/numerics/safe_conversions.h"
+#include "url/url_canon.h"
+#include "url/url_util.h"
+
+namespace url {
+
+namespace {
+
+// CanonOutput cannot describe buffers longer than this; see
+// CanonOutputT::Grow().
+constexpr size_t kMaxOutputLength = 1 << 30;
+
+}  // namespace
+
+// Writes into the unused tail of the batch's buffer, growing the buffer
+// geometrically when the tail is too short. Since the buffer is never shrunk,
+// later outputs usually find enough room without growing it at all.
+class CanonicalizedURLBatch::Output : public CanonOutput {
+ public:
+  // Writes starting at byte |start| of |buffer|.
+  Output(std::vector<char>* buffer, size_t start)
+      : batch_buffer_(buffer), start_(start) {
+    UseTail();
+  }
+  Output(const Output&) = delete;
+  Output& operator=(const Output&) = delete;
+  ~Output() override = default;
+
+  void Resize(int sz) override {
+    const size_t needed = start_ + static_cast<size_t>(sz);
+    if (needed > batch_buffer_->size())
+      batch_buffer_->resize(std::max(needed, batch_buffer_->size() * 2));
+    UseTail();
+  }
+
+ private:
+  void UseTail() {
+    buffer_ = batch_buffer_->data() + start_;
+    buffer_len_ = static_cast<int>(
+        std::min(batch_buffer_->size() - start_, kMaxOutputLength));
+  }
+
+  const raw_ptr<std::vector<char>> batch_buffer_;
+  const size_t start_;
+};
+
+CanonicalizedURLBatch::CanonicalizedURLBatch() = default;
+
+CanonicalizedURLBatch::~CanonicalizedURLBatch() = default;
+
+size_t CanonicalizedURLBatch::Add(base::StringPiece spec, bool trim_path_end) {
+  return AddImpl(spec.data(), spec.size(), trim_path_end);
+}
+
+size_t CanonicalizedURLBatch::Add(base::StringPiece16 spec,
+                                  bool trim_path_end) {
+  return AddImpl(spec.data(), spec.size(), trim_path_end);
+}
+
+void CanonicalizedURLBatch::AddAll(base::span<const base::StringPiece> specs,
+                                   bool trim_path_end) {
+  entries_.reserve(entries_.size() + specs.size());
+  for (base::StringPiece spec : specs)
+    AddImpl(spec.data(), spec.size(), trim_path_end);
+}
+
+base::StringPiece CanonicalizedURLBatch::spec(size_t index) const {
+  DCHECK_LT(index, entries_.size());
+  const Entry& entry = entries_[index];
+  return base::StringPiece(buffer_.data() + entry.offset, entry.length);
+}
+
+const Parsed& CanonicalizedURLBatch::parsed(size_t index) const {
+  DCHECK_LT(index, entries_.size());
+  return entries_[index].parsed;
+}
+
+bool CanonicalizedURLBatch::is_valid(size_t index) const {
+  DCHECK_LT(index, entries_.size());
+  return entries_[index].is_valid;
+}
+
+void CanonicalizedURLBatch::Clear() {
+  entries_.clear();
+  buffer_size_ = 0;
+}
+
+template <typename CHAR>
+size_t CanonicalizedURLBatch::AddImpl(const CHAR* spec,
+                                      size_t spec_len,
+                                      bool trim_path_end) {
+  // Canonicalize straight into the new entry, since Parsed is costly to copy.
+  Entry& entry = entries_.emplace_back();
+  entry.offset = buffer_size_;
+  Output output(&buffer_, buffer_size_);
+  entry.is_valid = Canonicalize(spec, base::checked_cast<int>(spec_len),
+                                trim_path_end, nullptr, &output, &entry.parsed);
+  entry.length = static_cast<size_t>(output.length());
+  buffer_size_ += entry.length;
+  return entries_.size() - 1;
+}
+
+}  // namespace url
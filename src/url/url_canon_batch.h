@@ -0,0 +1,95 @@
+// Copyright 2022 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef URL_URL_CANON_BATCH_H_
+#define URL_URL_CANON_BATCH_H_
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "base/component_export.h"
+#include "base/containers/span.h"
+#include "base/strings/string_piece.h"
+#include "url/third_party/mozilla/url_parse.h"
+
+namespace url {
+
+// Canonicalizes many URLs into one contiguous buffer, recording the parsed
+// components of each. Every GURL, and every Canonicalize() call with a
+// StdStringCanonOutput, allocates a string of its own; a batch appends all
+// canonical specs to a single buffer instead, and keeps its capacity when it
+// is cleared, so that normalizing a large number of URLs (e.g. from logs)
+// costs almost no allocations once the buffers have grown.
+//
+// Example:
+//   url::CanonicalizedURLBatch batch;
+//   for (base::StringPiece line : lines)
+//     batch.Add(line);
+//   for (size_t i = 0; i < batch.size(); ++i) {
+//     if (batch.is_valid(i))
+//       Use(batch.spec(i), batch.parsed(i));
+//   }
+//   batch.Clear();  // Ready for the next batch.
+class COMPONENT_EXPORT(URL) CanonicalizedURLBatch {
+ public:
+  CanonicalizedURLBatch();
+  CanonicalizedURLBatch(const CanonicalizedURLBatch&) = delete;
+  CanonicalizedURLBatch& operator=(const CanonicalizedURLBatch&) = delete;
+  ~CanonicalizedURLBatch();
+
+  // Canonicalizes |spec| like url::Canonicalize(), with the same result as
+  // GURL when |trim_path_end| is true, and appends it to the batch. Invalid
+  // URLs are appended too, so that entries line up with the input. Returns
+  // the index of the new entry.
+  size_t Add(base::StringPiece spec, bool trim_path_end = true);
+  size_t Add(base::StringPiece16 spec, bool trim_path_end = true);
+
+  // Appends all of |specs| in order.
+  void AddAll(base::span<const base::StringPiece> specs,
+              bool trim_path_end = true);
+
+  size_t size() const { return entries_.size(); }
+  bool empty() const { return entries_.empty(); }
+
+  // Returns the canonical spec of an entry. Like
+  // GURL::possibly_invalid_spec(), it is not necessarily usable when the
+  // entry is invalid. The result points into the batch and is invalidated by
+  // Add() and Clear().
+  base::StringPiece spec(size_t index) const;
+
+  // Returns the components of spec(index), relative to its start.
+  const Parsed& parsed(size_t index) const;
+
+  bool is_valid(size_t index) const;
+
+  // Removes all entries. The buffers keep their capacity for the next batch.
+  void Clear();
+
+  // Returns the combined length of all canonical specs.
+  size_t buffer_size() const { return buffer_size_; }
+
+ private:
+  class Output;
+
+  struct Entry {
+    size_t offset;
+    size_t length;
+    Parsed parsed;
+    bool is_valid;
+  };
+
+  template <typename CHAR>
+  size_t AddImpl(const CHAR* spec, size_t spec_len, bool trim_path_end);
+
+  // Holds the canonical specs back to back. Only the first |buffer_size_|
+  // bytes are in use; the rest is capacity reused by later entries.
+  std::vector<char> buffer_;
+  size_t buffer_size_ = 0;
+  std::vector<Entry> entries_;
+};
+
+}  // namespace url
+
+#endif  // URL_URL_CANON_BATCH_H_
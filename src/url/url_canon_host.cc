@@ -2,11 +2,17 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <stdint.h>
+
 #include "base/check.h"
 #include "base/cpu_reduction_experiment.h"
 #include "url/url_canon.h"
 #include "url/url_canon_internal.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 namespace url {
 
 namespace {
@@ -102,6 +108,54 @@ void ScanHostname(const CHAR* spec,
   }
 }
 
+// Appends |host| to |output| and returns true if it is already canonical, so
+// that DoSimpleHost() would only copy it. Otherwise returns false without
+// writing anything. This is the case for most hosts in practice, which are made
+// of lowercase letters, digits, dots and dashes; with SSE2 those are recognized
+// 16 characters at a time. May return false for other canonical hosts, which
+// then take the regular path.
+bool CopyCanonicalASCIIHost(const char* host,
+                            size_t host_len,
+                            CanonOutput* output) {
+  size_t i = 0;
+#ifdef __SSE2__
+  const __m128i before_a = _mm_set1_epi8('a' - 1);
+  const __m128i after_z = _mm_set1_epi8('z' + 1);
+  const __m128i before_dash = _mm_set1_epi8('-' - 1);
+  const __m128i after_nine = _mm_set1_epi8('9' + 1);
+  const __m128i slash = _mm_set1_epi8('/');
+  for (; host_len - i >= 16; i += 16) {
+    const __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(host + i));
+    // The comparisons are signed, so non-ASCII bytes are never in range.
+    const __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(chunk, before_a),
+                                         _mm_cmplt_epi8(chunk, after_z));
+    // '-', '.', '/' and the digits are contiguous; '/' is excluded below.
+    const __m128i dash_dot_or_digit =
+        _mm_andnot_si128(_mm_cmpeq_epi8(chunk, slash),
+                         _mm_and_si128(_mm_cmpgt_epi8(chunk, before_dash),
+                                       _mm_cmplt_epi8(chunk, after_nine)));
+    if (_mm_movemask_epi8(_mm_or_si128(letter, dash_dot_or_digit)) != 0xffff)
+      return false;
+  }
+#endif
+  for (; i < host_len; ++i) {
+    const unsigned char c = static_cast<unsigned char>(host[i]);
+    // kHostCharLookup[0] is 0, so NUL has to be rejected explicitly.
+    if (c == 0 || c >= 0x80 || kHostCharLookup[c] != c)
+      return false;
+  }
+  output->Append(host, static_cast<int>(host_len));
+  return true;
+}
+
+// Wide hosts always take the regular path.
+bool CopyCanonicalASCIIHost(const char16_t* host,
+                            size_t host_len,
+                            CanonOutput* output) {
+  return false;
+}
+
 // Canonicalizes a host name that is entirely 8-bit characters (even though
 // the type holding them may be 16 bits. Escaped characters will be unescaped.
 // Non-7-bit characters (for example, UTF-8) will be passed unchanged.
@@ -341,6 +395,11 @@ bool DoHostSubstring(const CHAR* spec,
                      CanonOutput* output) {
   DCHECK(host.is_valid());
 
+  if (CopyCanonicalASCIIHost(&spec[host.begin], static_cast<size_t>(host.len),
+                             output)) {
+    return true;
+  }
+
   bool has_non_ascii, has_escaped;
   ScanHostname<CHAR, UCHAR>(spec, host, &has_non_ascii, &has_escaped);
 
@@ -608,6 +608,68 @@ TEST(URLCanonTest, Host) {
   }
 }
 
+// Hosts that are already canonical are copied many characters at a time, so
+// check that a character needing work is noticed at every position of the
+// first few blocks, by comparing against the wide version.
+TEST(URLCanonTest, HostCharacterPositions) {
+  const std::string kReplacements[] = {
+      "", "A", "_", "%41", " ", "\xc3\xa9", std::string(1, '\0')};
+  for (size_t host_len = 1; host_len < 40; host_len++) {
+    for (size_t pos = 0; pos < host_len; pos++) {
+      for (const std::string& replacement : kReplacements) {
+        std::string host(host_len, 'a');
+        host.replace(pos, 1, replacement);
+
+        std::string out_str;
+        StdStringCanonOutput output(&out_str);
+        Component out_comp;
+        bool success = CanonicalizeHost(
+            host.c_str(), Component(0, static_cast<int>(host.size())), &output,
+            &out_comp);
+        output.Complete();
+
+        const std::u16string host16 = base::UTF8ToUTF16(host);
+        std::string out_str16;
+        StdStringCanonOutput output16(&out_str16);
+        Component out_comp16;
+        bool success16 = CanonicalizeHost(
+            host16.c_str(), Component(0, static_cast<int>(host16.size())),
+            &output16, &out_comp16);
+        output16.Complete();
+
+        SCOPED_TRACE(host);
+        EXPECT_EQ(success16, success);
+        EXPECT_EQ(out_str16, out_str);
+        EXPECT_EQ(out_comp16.len, out_comp.len);
+        if (replacement.empty())
+          EXPECT_EQ(host, out_str);
+      }
+    }
+  }
+}
+
+// A NUL byte is never part of a canonical host, wherever it is.
+TEST(URLCanonTest, HostWithNul) {
+  const std::string kHosts[] = {
+      std::string("a\0b", 3),
+      std::string("www.example.com.a\0", 19),
+      std::string("www.example.com.\0", 17),
+  };
+  for (const std::string& host : kHosts) {
+    std::string out_str;
+    StdStringCanonOutput output(&out_str);
+    Component out_comp;
+    bool success = CanonicalizeHost(
+        host.data(), Component(0, static_cast<int>(host.size())), &output,
+        &out_comp);
+    output.Complete();
+
+    SCOPED_TRACE(host);
+    EXPECT_FALSE(success);
+    EXPECT_NE(std::string::npos, out_str.find("%00"));
+  }
+}
+
 TEST(URLCanonTest, IPv4) {
   // clang-format off
   IPAddressCase cases[] = {
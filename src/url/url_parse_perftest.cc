@@ -2,12 +2,15 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <vector>
+
 #include "base/strings/string_piece.h"
 #include "base/test/perf_time_logger.h"
 #include "testing/gtest/include/gtest/gtest.h"
 #include "url/gurl.h"
 #include "url/third_party/mozilla/url_parse.h"
 #include "url/url_canon.h"
+#include "url/url_canon_batch.h"
 #include "url/url_canon_stdstring.h"
 
 namespace {
@@ -122,6 +125,37 @@ TEST(URLParse, TypicalURLParseCanonStdString) {
   canon_timer.Done();
 }
 
+// A URL whose host and path are long enough for the delimiter and host scans
+// to dominate.
+constexpr base::StringPiece kLongUrl =
+    "https://static-content.assets.subdomain.example-cdn-network.com/"
+    "images/2022/10/article-headers/very-long-descriptive-file-name/"
+    "header-image-large.webp?width=1280&height=720&format=webp&quality=85";
+
+TEST(URLParse, LongURLParse) {
+  url::Parsed parsed;
+  base::PerfTimeLogger parse_timer("Long_URL_Parse_AMillion");
+  for (int i = 0; i < 1000000; i++)
+    url::ParseStandardURL(kLongUrl.data(), kLongUrl.size(), &parsed);
+  parse_timer.Done();
+}
+
+TEST(URLParse, LongURLParseCanon) {
+  url::Parsed parsed;
+  url::RawCanonOutput<1024> output;
+  url::Parsed out_parsed;
+  base::PerfTimeLogger canon_timer("Long_URL_Parse_Canon_AMillion");
+  for (int i = 0; i < 1000000; i++) {
+    url::ParseStandardURL(kLongUrl.data(), kLongUrl.size(), &parsed);
+    output.set_length(0);
+    url::CanonicalizeStandardURL(
+        kLongUrl.data(), kLongUrl.size(), parsed,
+        url::SCHEME_WITH_HOST_PORT_AND_USER_INFORMATION, nullptr, &output,
+        &out_parsed);
+  }
+  canon_timer.Done();
+}
+
 TEST(URLParse, GURL) {
   base::PerfTimeLogger gurl_timer("Typical_GURL_AMillion");
   for (int i = 0; i < 333333; i++) {  // divide by 3 so we get 1M
@@ -132,4 +166,33 @@ TEST(URLParse, GURL) {
   gurl_timer.Done();
 }
 
+// Keeps the canonical URLs around in batches of 3000, as a log processor
+// would, with one string allocation per URL.
+TEST(URLParse, TypicalGURLBatch) {
+  std::vector<GURL> batch;
+  base::PerfTimeLogger gurl_timer("Typical_GURL_Batch_AMillion");
+  for (int i = 0; i < 333333; i++) {  // divide by 3 so we get 1M
+    if (batch.size() >= 3000)
+      batch.clear();
+    batch.emplace_back(kTypicalUrl1);
+    batch.emplace_back(kTypicalUrl2);
+    batch.emplace_back(kTypicalUrl3);
+  }
+  gurl_timer.Done();
+}
+
+// As above, but canonicalizing into a reused CanonicalizedURLBatch.
+TEST(URLParse, TypicalCanonicalizedURLBatch) {
+  url::CanonicalizedURLBatch batch;
+  base::PerfTimeLogger batch_timer("Typical_Canonicalized_Batch_AMillion");
+  for (int i = 0; i < 333333; i++) {  // divide by 3 so we get 1M
+    if (batch.size() >= 3000)
+      batch.Clear();
+    batch.Add(kTypicalUrl1);
+    batch.Add(kTypicalUrl2);
+    batch.Add(kTypicalUrl3);
+  }
+  batch_timer.Done();
+}
+
 }  // namespace
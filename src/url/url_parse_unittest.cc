@@ -4,6 +4,8 @@
 
 #include <stddef.h>
 
+#include <string>
+
 #include "testing/gtest/include/gtest/gtest.h"
 #include "url/third_party/mozilla/url_parse.h"
 
@@ -327,6 +329,29 @@ TEST(URLParser, Standard) {
   }
 }
 
+// The delimiters are searched for many characters at a time, so move them
+// across every position of the first few blocks.
+TEST(URLParser, StandardDelimiterPositions) {
+  for (size_t host_len = 1; host_len < 40; host_len++) {
+    for (size_t path_len = 0; path_len < 40; path_len++) {
+      const std::string host(host_len, 'h');
+      const std::string path = "/" + std::string(path_len, 'p');
+      const std::string url = "http://u:pw@" + host + ":8" + path + "?q?#r#";
+
+      Parsed parsed;
+      ParseStandardURL(url.data(), static_cast<int>(url.size()), &parsed);
+      EXPECT_TRUE(ComponentMatches(url.c_str(), "http", parsed.scheme));
+      EXPECT_TRUE(ComponentMatches(url.c_str(), "u", parsed.username));
+      EXPECT_TRUE(ComponentMatches(url.c_str(), "pw", parsed.password));
+      EXPECT_TRUE(ComponentMatches(url.c_str(), host.c_str(), parsed.host));
+      EXPECT_EQ(8, ParsePort(url.c_str(), parsed.port));
+      EXPECT_TRUE(ComponentMatches(url.c_str(), path.c_str(), parsed.path));
+      EXPECT_TRUE(ComponentMatches(url.c_str(), "q?", parsed.query));
+      EXPECT_TRUE(ComponentMatches(url.c_str(), "r#", parsed.ref));
+    }
+  }
+}
+
 // PathURL --------------------------------------------------------------------
 
 // Various incarnations of path URLs.